@@ -0,0 +1,622 @@
+//////////////////////////////////////////////////////////////
+//                                                          //
+// Spin IDE code editor text buffer                         //
+// See end of file for terms of use.                        //
+//                                                          //
+//////////////////////////////////////////////////////////////
+//
+// TextBuffer.cpp
+//
+// the tree is a treap ordered by offset, split and merge make new
+// nodes for the ones they would change and take references to the
+// rest, a function that is handed a node pointer borrows it unless
+// it says it takes it, a node pointer returned is a new reference
+//
+// reference counts are changed with atomic operations since a
+// snapshot can be let go of on another thread
+//
+
+#include <string.h>
+#include "TextBuffer.h"
+
+#define text_undo_initial           64          // grows as needed
+
+struct TextChunk
+{
+    int             refs;
+    int             used;
+    char            text[text_chunk_size];
+};
+
+struct TextPiece
+{
+    int             refs;
+    unsigned int    priority;
+    TextPiece*      pLeft;
+    TextPiece*      pRight;
+    TextChunk*      pChunk;
+    const char*     pText;                      // in pChunk
+    int             length;
+    int             lines;                      // \n in this piece
+    int             totalLength;                // of the subtree
+    int             totalLines;
+};
+
+static void RetainChunk(TextChunk* pChunk)
+{
+    __sync_add_and_fetch(&pChunk->refs, 1);
+}
+
+static void ReleaseChunk(TextChunk* pChunk)
+{
+    if (pChunk != 0 && __sync_sub_and_fetch(&pChunk->refs, 1) == 0)
+    {
+        delete pChunk;
+    }
+}
+
+static TextPiece* Retain(TextPiece* pPiece)
+{
+    if (pPiece != 0)
+    {
+        __sync_add_and_fetch(&pPiece->refs, 1);
+    }
+    return pPiece;
+}
+
+static void Release(TextPiece* pPiece)
+{
+    if (pPiece != 0 && __sync_sub_and_fetch(&pPiece->refs, 1) == 0)
+    {
+        Release(pPiece->pLeft);
+        Release(pPiece->pRight);
+        ReleaseChunk(pPiece->pChunk);
+        delete pPiece;
+    }
+}
+
+static int TotalLength(const TextPiece* pPiece)
+{
+    return (pPiece != 0) ? pPiece->totalLength : 0;
+}
+
+static int TotalLines(const TextPiece* pPiece)
+{
+    return (pPiece != 0) ? pPiece->totalLines : 0;
+}
+
+static int CountLines(const char* pText, int length)
+{
+    int lines = 0;
+    for (int i = 0; i < length; i++)
+    {
+        if (pText[i] == '\n')
+        {
+            lines++;
+        }
+    }
+    return lines;
+}
+
+static unsigned int NextPriority(unsigned int& seed)
+{
+    // xorshift
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+// a node for the text, takes the references to pLeft and pRight
+static TextPiece* NewPiece(TextChunk* pChunk, const char* pText, int length, int lines, unsigned int priority, TextPiece* pLeft, TextPiece* pRight)
+{
+    TextPiece* pPiece = new TextPiece;
+    pPiece->refs = 1;
+    pPiece->priority = priority;
+    pPiece->pLeft = pLeft;
+    pPiece->pRight = pRight;
+    pPiece->pChunk = pChunk;
+    RetainChunk(pChunk);
+    pPiece->pText = pText;
+    pPiece->length = length;
+    pPiece->lines = lines;
+    pPiece->totalLength = TotalLength(pLeft) + length + TotalLength(pRight);
+    pPiece->totalLines = TotalLines(pLeft) + lines + TotalLines(pRight);
+    return pPiece;
+}
+
+// a copy of pPiece with new children, takes the references to pLeft and pRight
+static TextPiece* CopyPiece(const TextPiece* pPiece, TextPiece* pLeft, TextPiece* pRight)
+{
+    return NewPiece(pPiece->pChunk, pPiece->pText, pPiece->length, pPiece->lines, pPiece->priority, pLeft, pRight);
+}
+
+// takes the references to pLeft and pRight
+static TextPiece* Merge(TextPiece* pLeft, TextPiece* pRight)
+{
+    if (pLeft == 0)
+    {
+        return pRight;
+    }
+    if (pRight == 0)
+    {
+        return pLeft;
+    }
+    TextPiece* pResult;
+    if (pLeft->priority > pRight->priority)
+    {
+        pResult = CopyPiece(pLeft, Retain(pLeft->pLeft), Merge(Retain(pLeft->pRight), pRight));
+        Release(pLeft);
+    }
+    else
+    {
+        pResult = CopyPiece(pRight, Merge(pLeft, Retain(pRight->pLeft)), Retain(pRight->pRight));
+        Release(pRight);
+    }
+    return pResult;
+}
+
+// pLeft gets the text before offset, pRight the rest
+static void Split(TextPiece* pPiece, int offset, unsigned int& seed, TextPiece*& pLeft, TextPiece*& pRight)
+{
+    if (pPiece == 0)
+    {
+        pLeft = 0;
+        pRight = 0;
+        return;
+    }
+    int leftLength = TotalLength(pPiece->pLeft);
+    if (offset <= leftLength)
+    {
+        TextPiece* pInner;
+        Split(pPiece->pLeft, offset, seed, pLeft, pInner);
+        pRight = CopyPiece(pPiece, pInner, Retain(pPiece->pRight));
+    }
+    else if (offset >= leftLength + pPiece->length)
+    {
+        TextPiece* pInner;
+        Split(pPiece->pRight, offset - leftLength - pPiece->length, seed, pInner, pRight);
+        pLeft = CopyPiece(pPiece, Retain(pPiece->pLeft), pInner);
+    }
+    else
+    {
+        // in the middle of this piece, so it becomes two
+        int firstLength = offset - leftLength;
+        int firstLines = CountLines(pPiece->pText, firstLength);
+        TextPiece* pFirst = NewPiece(pPiece->pChunk, pPiece->pText, firstLength, firstLines, pPiece->priority, 0, 0);
+        TextPiece* pSecond = NewPiece(pPiece->pChunk, pPiece->pText + firstLength, pPiece->length - firstLength, pPiece->lines - firstLines, NextPriority(seed), 0, 0);
+        pLeft = Merge(Retain(pPiece->pLeft), pFirst);
+        pRight = Merge(pSecond, Retain(pPiece->pRight));
+    }
+}
+
+// the last piece of the tree (not a new reference)
+static const TextPiece* LastPiece(const TextPiece* pPiece)
+{
+    while (pPiece != 0 && pPiece->pRight != 0)
+    {
+        pPiece = pPiece->pRight;
+    }
+    return pPiece;
+}
+
+static void CopyText(const TextPiece* pPiece, int offset, int length, char* pText)
+{
+    while (pPiece != 0 && length > 0)
+    {
+        int leftLength = TotalLength(pPiece->pLeft);
+        if (offset < leftLength)
+        {
+            int count = leftLength - offset;
+            if (count > length)
+            {
+                count = length;
+            }
+            CopyText(pPiece->pLeft, offset, count, pText);
+            pText += count;
+            length -= count;
+            offset = leftLength;
+        }
+        offset -= leftLength;
+        if (length > 0 && offset < pPiece->length)
+        {
+            int count = pPiece->length - offset;
+            if (count > length)
+            {
+                count = length;
+            }
+            memcpy(pText, pPiece->pText + offset, count);
+            pText += count;
+            length -= count;
+            offset = pPiece->length;
+        }
+        offset -= pPiece->length;
+        pPiece = pPiece->pRight;
+    }
+}
+
+//////////////////////////////////////////
+// TextSnapshot
+//
+
+TextSnapshot::TextSnapshot()
+    : m_pRoot(0)
+{
+}
+
+TextSnapshot::TextSnapshot(TextPiece* pRoot)
+    : m_pRoot(pRoot)
+{
+}
+
+TextSnapshot::TextSnapshot(const TextSnapshot& other)
+    : m_pRoot(Retain(other.m_pRoot))
+{
+}
+
+TextSnapshot& TextSnapshot::operator=(const TextSnapshot& other)
+{
+    TextPiece* pRoot = Retain(other.m_pRoot);
+    Release(m_pRoot);
+    m_pRoot = pRoot;
+    return *this;
+}
+
+TextSnapshot::~TextSnapshot()
+{
+    Release(m_pRoot);
+}
+
+int TextSnapshot::GetLength() const
+{
+    return TotalLength(m_pRoot);
+}
+
+int TextSnapshot::GetLineCount() const
+{
+    return TotalLines(m_pRoot) + 1;
+}
+
+int TextSnapshot::GetLineStart(int line) const
+{
+    if (line <= 0)
+    {
+        return (line == 0) ? 0 : -1;
+    }
+    if (line > TotalLines(m_pRoot))
+    {
+        return -1;
+    }
+
+    // find the piece with the \n that ends the line before
+    int base = 0;
+    const TextPiece* pPiece = m_pRoot;
+    while (pPiece != 0)
+    {
+        int leftLines = TotalLines(pPiece->pLeft);
+        if (line <= leftLines)
+        {
+            pPiece = pPiece->pLeft;
+            continue;
+        }
+        base += TotalLength(pPiece->pLeft);
+        line -= leftLines;
+        if (line <= pPiece->lines)
+        {
+            for (int i = 0; i < pPiece->length; i++)
+            {
+                if (pPiece->pText[i] == '\n' && --line == 0)
+                {
+                    return base + i + 1;
+                }
+            }
+        }
+        line -= pPiece->lines;
+        base += pPiece->length;
+        pPiece = pPiece->pRight;
+    }
+    return -1;
+}
+
+int TextSnapshot::GetLineOfOffset(int offset) const
+{
+    if (offset > TotalLength(m_pRoot))
+    {
+        offset = TotalLength(m_pRoot);
+    }
+
+    // count the \n before offset
+    int line = 0;
+    const TextPiece* pPiece = m_pRoot;
+    while (pPiece != 0 && offset > 0)
+    {
+        int leftLength = TotalLength(pPiece->pLeft);
+        if (offset <= leftLength)
+        {
+            pPiece = pPiece->pLeft;
+            continue;
+        }
+        line += TotalLines(pPiece->pLeft);
+        offset -= leftLength;
+        if (offset < pPiece->length)
+        {
+            return line + CountLines(pPiece->pText, offset);
+        }
+        line += pPiece->lines;
+        offset -= pPiece->length;
+        pPiece = pPiece->pRight;
+    }
+    return line;
+}
+
+char TextSnapshot::GetChar(int offset) const
+{
+    const TextPiece* pPiece = m_pRoot;
+    if (offset < 0 || offset >= TotalLength(pPiece))
+    {
+        return 0;
+    }
+    while (pPiece != 0)
+    {
+        int leftLength = TotalLength(pPiece->pLeft);
+        if (offset < leftLength)
+        {
+            pPiece = pPiece->pLeft;
+            continue;
+        }
+        offset -= leftLength;
+        if (offset < pPiece->length)
+        {
+            return pPiece->pText[offset];
+        }
+        offset -= pPiece->length;
+        pPiece = pPiece->pRight;
+    }
+    return 0;
+}
+
+int TextSnapshot::GetText(int offset, int length, char* pText) const
+{
+    int textLength = TotalLength(m_pRoot);
+    if (offset < 0 || length <= 0 || offset >= textLength)
+    {
+        return 0;
+    }
+    if (length > textLength - offset)
+    {
+        length = textLength - offset;
+    }
+    CopyText(m_pRoot, offset, length, pText);
+    return length;
+}
+
+//////////////////////////////////////////
+// TextBuffer
+//
+
+TextBuffer::TextBuffer()
+    : m_pChunk(0)
+    , m_seed(0x2545F491)
+    , m_pUndo(0)
+    , m_undoCount(0)
+    , m_undoTop(0)
+    , m_undoSize(0)
+    , m_bNewUndoGroup(true)
+{
+}
+
+TextBuffer::~TextBuffer()
+{
+    m_undoCount = 0;
+    ClearRedo();
+    delete [] m_pUndo;
+    ReleaseChunk(m_pChunk);
+}
+
+// copies the text into the chunks, returns a tree of pieces for it
+TextPiece* TextBuffer::AddText(const char* pText, int length)
+{
+    TextPiece* pRoot = 0;
+    while (length > 0)
+    {
+        if (m_pChunk == 0 || m_pChunk->used == text_chunk_size)
+        {
+            ReleaseChunk(m_pChunk);
+            m_pChunk = new TextChunk;
+            m_pChunk->refs = 1;
+            m_pChunk->used = 0;
+        }
+        int count = text_chunk_size - m_pChunk->used;
+        if (count > text_piece_limit)
+        {
+            count = text_piece_limit;
+        }
+        if (count > length)
+        {
+            count = length;
+        }
+        char* pCopy = &m_pChunk->text[m_pChunk->used];
+        memcpy(pCopy, pText, count);
+        m_pChunk->used += count;
+        pRoot = Merge(pRoot, NewPiece(m_pChunk, pCopy, count, CountLines(pCopy, count), NextPriority(m_seed), 0, 0));
+        pText += count;
+        length -= count;
+    }
+    return pRoot;
+}
+
+void TextBuffer::ClearRedo()
+{
+    for (int i = m_undoCount; i < m_undoTop; i++)
+    {
+        Release(m_pUndo[i].pBefore);
+        Release(m_pUndo[i].pAfter);
+    }
+    m_undoTop = m_undoCount;
+}
+
+// makes pRoot the current text (taking the reference), and adds the edit to the undo history
+void TextBuffer::SetRoot(TextPiece* pRoot, int offset, int removedLength, int insertedLength)
+{
+    ClearRedo();
+
+    TextUndo* pUndo = (m_undoCount > 0) ? &m_pUndo[m_undoCount - 1] : 0;
+    if (pUndo != 0 && !m_bNewUndoGroup && pUndo->pAfter == m_current.m_pRoot)
+    {
+        // widen the range of the group to take in this edit, the parts taken in that were outside
+        // it before are unchanged from the text before the group
+        int start = (offset < pUndo->start) ? offset : pUndo->start;
+        int finish = (offset + removedLength > pUndo->finish) ? offset + removedLength : pUndo->finish;
+        pUndo->removedLength += (finish - start) - (pUndo->finish - pUndo->start);
+        pUndo->start = start;
+        pUndo->finish = finish + insertedLength - removedLength;
+        Release(pUndo->pAfter);
+        pUndo->pAfter = Retain(pRoot);
+    }
+    else
+    {
+        if (m_undoCount == m_undoSize)
+        {
+            int newSize = (m_undoSize > 0) ? m_undoSize * 2 : text_undo_initial;
+            TextUndo* pNewUndo = new TextUndo[newSize];
+            if (m_pUndo)
+            {
+                memcpy(pNewUndo, m_pUndo, m_undoCount * sizeof(TextUndo));
+                delete [] m_pUndo;
+            }
+            m_pUndo = pNewUndo;
+            m_undoSize = newSize;
+        }
+        pUndo = &m_pUndo[m_undoCount++];
+        pUndo->pBefore = Retain(m_current.m_pRoot);
+        pUndo->pAfter = Retain(pRoot);
+        pUndo->start = offset;
+        pUndo->finish = offset + insertedLength;
+        pUndo->removedLength = removedLength;
+        m_undoTop = m_undoCount;
+        m_bNewUndoGroup = false;
+    }
+
+    m_current = TextSnapshot(pRoot);
+}
+
+void TextBuffer::SetText(const char* pText, int length)
+{
+    for (int i = 0; i < m_undoTop; i++)
+    {
+        Release(m_pUndo[i].pBefore);
+        Release(m_pUndo[i].pAfter);
+    }
+    m_undoCount = 0;
+    m_undoTop = 0;
+    m_bNewUndoGroup = true;
+    m_current = TextSnapshot(AddText(pText, length));
+}
+
+bool TextBuffer::Insert(int offset, const char* pText, int length)
+{
+    return Replace(offset, 0, pText, length);
+}
+
+bool TextBuffer::Delete(int offset, int length)
+{
+    return Replace(offset, length, 0, 0);
+}
+
+bool TextBuffer::Replace(int offset, int removedLength, const char* pText, int insertedLength)
+{
+    if (offset < 0 || removedLength < 0 || insertedLength < 0 || offset + removedLength > GetLength())
+    {
+        return false;
+    }
+    if (removedLength == 0 && insertedLength == 0)
+    {
+        return true;
+    }
+
+    TextPiece* pBefore;
+    TextPiece* pRest;
+    TextPiece* pRemoved;
+    TextPiece* pAfter;
+    Split(m_current.m_pRoot, offset, m_seed, pBefore, pRest);
+    Split(pRest, removedLength, m_seed, pRemoved, pAfter);
+    Release(pRest);
+    Release(pRemoved);
+
+    if (insertedLength > 0)
+    {
+        // typing goes on the end of the piece before if that was the last text added
+        const TextPiece* pLast = LastPiece(pBefore);
+        if (pLast != 0 && pLast->pChunk == m_pChunk && pLast->pText + pLast->length == &m_pChunk->text[m_pChunk->used] &&
+            pLast->length + insertedLength <= text_piece_limit && m_pChunk->used + insertedLength <= text_chunk_size)
+        {
+            char* pCopy = &m_pChunk->text[m_pChunk->used];
+            memcpy(pCopy, pText, insertedLength);
+            m_pChunk->used += insertedLength;
+
+            TextPiece* pRemaining;
+            TextPiece* pOld;
+            Split(pBefore, TotalLength(pBefore) - pLast->length, m_seed, pRemaining, pOld);
+            TextPiece* pNew = NewPiece(m_pChunk, pOld->pText, pOld->length + insertedLength, pOld->lines + CountLines(pCopy, insertedLength), pOld->priority, 0, 0);
+            Release(pOld);
+            Release(pBefore);
+            pBefore = Merge(pRemaining, pNew);
+        }
+        else
+        {
+            pBefore = Merge(pBefore, AddText(pText, insertedLength));
+        }
+    }
+
+    SetRoot(Merge(pBefore, pAfter), offset, removedLength, insertedLength);
+    return true;
+}
+
+bool TextBuffer::Undo(int& offset, int& length)
+{
+    if (m_undoCount == 0)
+    {
+        return false;
+    }
+    TextUndo& undo = m_pUndo[--m_undoCount];
+    m_current = TextSnapshot(Retain(undo.pBefore));
+    m_bNewUndoGroup = true;
+    offset = undo.start;
+    length = undo.removedLength;
+    return true;
+}
+
+bool TextBuffer::Redo(int& offset, int& length)
+{
+    if (m_undoCount == m_undoTop)
+    {
+        return false;
+    }
+    TextUndo& undo = m_pUndo[m_undoCount++];
+    m_current = TextSnapshot(Retain(undo.pAfter));
+    m_bNewUndoGroup = true;
+    offset = undo.start;
+    length = undo.finish - undo.start;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
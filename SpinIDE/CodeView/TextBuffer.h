@@ -0,0 +1,133 @@
+//////////////////////////////////////////////////////////////
+//                                                          //
+// Spin IDE code editor text buffer                         //
+// See end of file for terms of use.                        //
+//                                                          //
+//////////////////////////////////////////////////////////////
+//
+// TextBuffer.h
+//
+// piece table text buffer for the code editor, the text is never
+// moved or copied once it is in, edits only rearrange pieces that
+// point into it, kept in a balanced tree by offset with the length
+// and line count of each subtree, so finding an offset or a line is
+// O(log n) no matter how big the file is
+//
+// the tree is never changed in place (an edit makes new nodes on the
+// path to the change and shares the rest), so a TextSnapshot of it
+// stays as it was however the buffer is edited afterwards, and can be
+// read on another thread (for compiling or highlighting), the undo and
+// redo history is just the trees from before and after each edit
+//
+// lines end at \n (CodeView turns CR and CR LF into \n), offsets are
+// byte offsets
+//
+
+#ifndef _TEXT_BUFFER_H_
+#define _TEXT_BUFFER_H_
+
+#define text_piece_limit            2048        // longest piece, so splitting one to count its lines is cheap
+#define text_chunk_size             0x10000     // the added text is kept in chunks this big
+
+struct TextChunk;
+struct TextPiece;
+
+// the text as it was when the snapshot was taken
+class TextSnapshot
+{
+    friend class TextBuffer;
+
+    TextPiece*      m_pRoot;
+
+    explicit TextSnapshot(TextPiece* pRoot);    // takes a reference to pRoot
+
+public:
+    TextSnapshot();
+    TextSnapshot(const TextSnapshot& other);
+    TextSnapshot& operator=(const TextSnapshot& other);
+    ~TextSnapshot();
+
+    int GetLength() const;
+    int GetLineCount() const;                   // a text with no \n is one line
+    int GetLineStart(int line) const;           // offset of line (from 0), -1 if there isn't one
+    int GetLineOfOffset(int offset) const;      // line (from 0) holding offset
+    char GetChar(int offset) const;             // 0 if offset is outside the text
+    int GetText(int offset, int length, char* pText) const; // copies what there is of the range, returns the length copied
+};
+
+class TextBuffer
+{
+    struct TextUndo
+    {
+        TextPiece*  pBefore;                    // the tree before and after the edits of the group
+        TextPiece*  pAfter;
+        int         start;                      // range that changed, in the text after
+        int         finish;
+        int         removedLength;              // what the range was in the text before
+    };
+
+    TextSnapshot    m_current;
+    TextChunk*      m_pChunk;                   // added text goes here until it is full
+    unsigned int    m_seed;                     // for the tree priorities
+    TextUndo*       m_pUndo;
+    int             m_undoCount;                // undo entries, redo entries follow up to m_undoTop
+    int             m_undoTop;
+    int             m_undoSize;
+    bool            m_bNewUndoGroup;
+
+    TextPiece* AddText(const char* pText, int length);
+    void SetRoot(TextPiece* pRoot, int offset, int removedLength, int insertedLength);
+    void ClearRedo();
+
+public:
+    TextBuffer();
+    ~TextBuffer();
+
+    // replaces the whole text, and forgets the undo history
+    void SetText(const char* pText, int length);
+
+    // the edits return false if the range isn't in the text
+    bool Insert(int offset, const char* pText, int length);
+    bool Delete(int offset, int length);
+    bool Replace(int offset, int removedLength, const char* pText, int insertedLength);
+
+    // edits go into the same undo group until this is called, so a run of typing undoes in one step
+    void BeginUndoGroup()                       { m_bNewUndoGroup = true; }
+
+    // offset/length are the range to select afterwards, the restored or redone text
+    bool CanUndo()                              { return m_undoCount > 0; }
+    bool CanRedo()                              { return m_undoCount < m_undoTop; }
+    bool Undo(int& offset, int& length);
+    bool Redo(int& offset, int& length);
+
+    TextSnapshot GetSnapshot() const            { return m_current; }
+    int GetLength() const                       { return m_current.GetLength(); }
+    int GetLineCount() const                    { return m_current.GetLineCount(); }
+    int GetLineStart(int line) const            { return m_current.GetLineStart(line); }
+    int GetLineOfOffset(int offset) const       { return m_current.GetLineOfOffset(offset); }
+    char GetChar(int offset) const              { return m_current.GetChar(offset); }
+    int GetText(int offset, int length, char* pText) const { return m_current.GetText(offset, length, pText); }
+};
+
+#endif // _TEXT_BUFFER_H_
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
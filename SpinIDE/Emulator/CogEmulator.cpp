@@ -0,0 +1,742 @@
+//////////////////////////////////////////////////////////////
+//                                                          //
+// Propeller Cog (PASM) Emulator                            //
+// (c)2012 Parallax Inc. DBA Parallax Semiconductor.        //
+// See end of file for terms of use.                        //
+//                                                          //
+//////////////////////////////////////////////////////////////
+//
+// CogEmulator.cpp
+//
+// Every cog register is kept decoded as an instruction (and decoded again
+// when it is written), so running an instruction is a table jump on its op.
+// GCC and clang jump straight to the handler through a table of label
+// addresses, other compilers go through the switch the handlers sit in.
+//
+// Timing follows the chip: 4 clocks an instruction (and for one whose
+// condition fails), 8 for djnz/tjz/tjnz when they don't jump, and hub
+// instructions wait for the cog's hub window, which comes around every 16
+// clocks with cog n's at clocks where (clock & 15) == 2n, then take 8 more
+// (8..23 in all). WAITCNT waits for CNT to reach the target.
+//
+// The instruction after the one running has already been fetched, so an
+// instruction that modifies the next one doesn't change what runs next.
+//
+// Counters and video aren't modeled, CTRx/FRQx/PHSx/VCFG/VSCL are plain
+// registers.
+//
+
+#include <string.h>
+#include "SpinInterpreter.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define COG_COMPUTED_GOTO   1
+#define COG_OP(op, name)    case op: op_##name:
+#else
+#define COG_COMPUTED_GOTO   0
+#define COG_OP(op, name)    case op:
+#endif
+
+#define cog_clocks_hub_window       16
+#define cog_clocks_hub              8
+#define cog_clocks_wait             6
+
+static inline unsigned int Parity(unsigned int value)
+{
+    value ^= value >> 16;
+    value ^= value >> 8;
+    value ^= value >> 4;
+    value ^= value >> 2;
+    value ^= value >> 1;
+    return value & 1;
+}
+
+// clocks for a hub instruction started at time, waiting for the cog's window
+static inline int HubClocks(long long time, int id)
+{
+    return cog_clocks_hub + (int)((cog_clocks_hub_window - ((time - (id << 1)) & (cog_clocks_hub_window - 1))) & (cog_clocks_hub_window - 1));
+}
+
+static inline unsigned int Reverse(unsigned int value)
+{
+    value = ((value >> 1) & 0x55555555) | ((value & 0x55555555) << 1);
+    value = ((value >> 2) & 0x33333333) | ((value & 0x33333333) << 2);
+    value = ((value >> 4) & 0x0F0F0F0F) | ((value & 0x0F0F0F0F) << 4);
+    value = ((value >> 8) & 0x00FF00FF) | ((value & 0x00FF00FF) << 8);
+    return (value >> 16) | (value << 16);
+}
+
+void CogEmulator::Decode(unsigned int instruction, CogInstruction& decoded)
+{
+    decoded.op = (unsigned char)(instruction >> 26);
+    decoded.flags = ((instruction & 0x02000000) ? cog_flag_wz : 0) |
+                    ((instruction & 0x01000000) ? cog_flag_wc : 0) |
+                    ((instruction & 0x00800000) ? cog_flag_wr : 0) |
+                    ((instruction & 0x00400000) ? cog_flag_imm : 0);
+    decoded.cond = (unsigned char)((instruction >> 18) & 0x0F);
+    decoded.unused = 0;
+    decoded.dest = (unsigned short)((instruction >> 9) & 0x1FF);
+    decoded.src = (unsigned short)(instruction & 0x1FF);
+
+    if (decoded.op <= 0x02 && (decoded.flags & cog_flag_wr) == 0)
+    {
+        decoded.op += cog_op_wrbyte;
+    }
+}
+
+void CogEmulator::Load(int id, const unsigned char* pHub, unsigned int codeAddress)
+{
+    NativeCog& native = m_cogs[id];
+    memset(native.ram, 0, sizeof(native.ram));
+    for (int i = 0; i < cog_load_size; i++)
+    {
+        int address = (codeAddress + (i << 2)) & (hub_size - 4);
+        native.ram[i] = pHub[address] | (pHub[address + 1] << 8) | (pHub[address + 2] << 16) | ((unsigned int)pHub[address + 3] << 24);
+    }
+    for (int i = 0; i < cog_ram_size; i++)
+    {
+        Decode(native.ram[i], native.decoded[i]);
+    }
+    native.pc = 0;
+    native.current = native.decoded[0];
+    native.bCarry = false;
+    native.bZero = false;
+}
+
+// $1F0-$1FF as a source operand (as a destination PAR/CNT/INA/INB read their shadow registers)
+unsigned int CogEmulator::ReadSpecial(SpinInterpreter& chip, SpinCog& cog, int reg, long long time)
+{
+    switch (reg)
+    {
+        case cog_reg_par:
+            return cog.regs[0];
+        case cog_reg_cnt:
+            return (unsigned int)time;
+        case cog_reg_ina:
+            return chip.PortA();
+        case cog_reg_inb:
+            return 0;
+    }
+    return cog.regs[reg - cog_reg_par];
+}
+
+// returns true when OUTA or DIRA changed
+bool CogEmulator::WriteRegister(SpinInterpreter& chip, SpinCog& cog, NativeCog& native, int reg, unsigned int value, long long time)
+{
+    if (reg < cog_reg_outa)
+    {
+        native.ram[reg] = value;
+        Decode(value, native.decoded[reg]);
+        return false;
+    }
+    unsigned int& current = cog.regs[reg - cog_reg_par];
+    if ((reg == cog_reg_outa || reg == cog_reg_dira) && current != value)
+    {
+        current = value;
+        chip.m_pinTime = time;
+        return true;
+    }
+    current = value;
+    return false;
+}
+
+void CogEmulator::Run(SpinInterpreter& chip, int id, long long limit)
+{
+#if COG_COMPUTED_GOTO
+    static void* s_dispatch[cog_op_count] =
+    {
+        &&op_rdbyte,  &&op_rdword,  &&op_rdlong,  &&op_hubop,   &&op_nop,     &&op_nop,     &&op_nop,     &&op_nop,
+        &&op_ror,     &&op_rol,     &&op_shr,     &&op_shl,     &&op_rcr,     &&op_rcl,     &&op_sar,     &&op_rev,
+        &&op_mins,    &&op_maxs,    &&op_min,     &&op_max,     &&op_movs,    &&op_movd,    &&op_movi,    &&op_jmpret,
+        &&op_and,     &&op_andn,    &&op_or,      &&op_xor,     &&op_muxc,    &&op_muxnc,   &&op_muxz,    &&op_muxnz,
+        &&op_add,     &&op_sub,     &&op_addabs,  &&op_subabs,  &&op_sumc,    &&op_sumnc,   &&op_sumz,    &&op_sumnz,
+        &&op_mov,     &&op_neg,     &&op_abs,     &&op_absneg,  &&op_negc,    &&op_negnc,   &&op_negz,    &&op_negnz,
+        &&op_cmps,    &&op_cmpsx,   &&op_addx,    &&op_subx,    &&op_adds,    &&op_subs,    &&op_addsx,   &&op_subsx,
+        &&op_cmpsub,  &&op_djnz,    &&op_tjnz,    &&op_tjz,     &&op_waitpeq, &&op_waitpne, &&op_waitcnt, &&op_waitvid,
+        &&op_wrbyte,  &&op_wrword,  &&op_wrlong
+    };
+#endif
+
+    SpinCog& cog = chip.m_cogs[id];
+    NativeCog& native = m_cogs[id];
+    unsigned char* pHub = chip.m_hub;
+    long long time = cog.time;
+    int pc = native.pc;
+    CogInstruction inst = native.current;
+    bool bCarry = native.bCarry;
+    bool bZero = native.bZero;
+    bool bStop = false;
+
+    unsigned int d = 0;
+    unsigned int s = 0;
+    unsigned int result = 0;
+    unsigned int address = 0;
+    unsigned long long wide = 0;
+    long long clocks = 0;
+    int jump = 0;
+    bool c = false;
+    bool z = false;
+
+    do
+    {
+        CogInstruction next = native.decoded[(pc + 1) & (cog_ram_size - 1)];
+        clocks = 4;
+        jump = -1;
+
+        if (((inst.cond >> ((bCarry << 1) | bZero)) & 1) == 0)
+        {
+            pc = (pc + 1) & (cog_ram_size - 1);
+            inst = next;
+            time += clocks;
+            continue;
+        }
+
+        d = (inst.dest < cog_reg_outa) ? native.ram[inst.dest] : cog.regs[inst.dest - cog_reg_par];
+        if (inst.flags & cog_flag_imm)
+        {
+            s = inst.src;
+        }
+        else
+        {
+            s = (inst.src < cog_reg_par) ? native.ram[inst.src] : ReadSpecial(chip, cog, inst.src, time);
+        }
+        result = d;
+        c = bCarry;
+        z = bZero;
+
+#if COG_COMPUTED_GOTO
+        goto *s_dispatch[inst.op];
+#endif
+        switch (inst.op)
+        {
+            // hub
+
+            COG_OP(0x00, rdbyte)
+                clocks = HubClocks(time, id);
+                result = pHub[s & (hub_size - 1)];
+                z = (result == 0);
+                break;
+            COG_OP(0x01, rdword)
+                clocks = HubClocks(time, id);
+                address = s & (hub_size - 2);
+                result = pHub[address] | (pHub[address + 1] << 8);
+                z = (result == 0);
+                break;
+            COG_OP(0x02, rdlong)
+                clocks = HubClocks(time, id);
+                address = s & (hub_size - 4);
+                result = pHub[address] | (pHub[address + 1] << 8) | (pHub[address + 2] << 16) | ((unsigned int)pHub[address + 3] << 24);
+                z = (result == 0);
+                break;
+            COG_OP(cog_op_wrbyte, wrbyte)
+                clocks = HubClocks(time, id);
+                address = s & (hub_size - 1);
+                if (address < hub_ram_size)
+                {
+                    pHub[address] = (unsigned char)d;
+                }
+                break;
+            COG_OP(cog_op_wrword, wrword)
+                clocks = HubClocks(time, id);
+                address = s & (hub_size - 2);
+                if (address < hub_ram_size)
+                {
+                    pHub[address] = (unsigned char)d;
+                    pHub[address + 1] = (unsigned char)(d >> 8);
+                }
+                break;
+            COG_OP(cog_op_wrlong, wrlong)
+                clocks = HubClocks(time, id);
+                address = s & (hub_size - 4);
+                if (address < hub_ram_size)
+                {
+                    pHub[address] = (unsigned char)d;
+                    pHub[address + 1] = (unsigned char)(d >> 8);
+                    pHub[address + 2] = (unsigned char)(d >> 16);
+                    pHub[address + 3] = (unsigned char)(d >> 24);
+                }
+                break;
+            COG_OP(0x03, hubop)
+                clocks = HubClocks(time, id);
+                c = false;
+                switch (s & 0x07)
+                {
+                    case 0: // clkset
+                        if (d & 0x80)
+                        {
+                            chip.m_bRebooted = true;
+                            bStop = true;
+                        }
+                        break;
+                    case 1: // cogid
+                        result = id;
+                        break;
+                    case 2: // coginit
+                        {
+                            cog.time = time + clocks;
+                            int newId = chip.CogInit(cog, d & 0x0F, (d >> 2) & 0xFFFC, (d >> 16) & 0xFFFC);
+                            if (newId == id)
+                            {
+                                return; // restarted itself
+                            }
+                            c = (newId < 0);
+                            result = (newId < 0) ? 7 : newId;
+                        }
+                        break;
+                    case 3: // cogstop
+                        chip.m_cogs[d & 0x07].state = spin_cog_stopped;
+                        bStop = ((int)(d & 0x07) == id);
+                        break;
+                    case 4: // locknew
+                        result = 7;
+                        c = true;
+                        for (int i = 0; i < lock_count; i++)
+                        {
+                            if (!chip.m_lockUsed[i])
+                            {
+                                chip.m_lockUsed[i] = true;
+                                result = i;
+                                c = false;
+                                break;
+                            }
+                        }
+                        break;
+                    case 5: // lockret
+                        chip.m_lockUsed[d & 0x07] = false;
+                        break;
+                    case 6: // lockset
+                    case 7: // lockclr
+                        c = chip.m_locks[d & 0x07];
+                        chip.m_locks[d & 0x07] = ((s & 0x07) == 6);
+                        break;
+                }
+                z = (result == 0);
+                break;
+
+            // rotates and shifts
+
+            COG_OP(0x08, ror)
+                result = (d >> (s & 0x1F)) | (d << ((32 - (s & 0x1F)) & 0x1F));
+                c = (d & 1) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x09, rol)
+                result = (d << (s & 0x1F)) | (d >> ((32 - (s & 0x1F)) & 0x1F));
+                c = (d >> 31) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x0A, shr)
+                result = d >> (s & 0x1F);
+                c = (d & 1) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x0B, shl)
+                result = d << (s & 0x1F);
+                c = (d >> 31) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x0C, rcr)
+                result = d >> (s & 0x1F);
+                if (bCarry && (s & 0x1F))
+                {
+                    result |= 0xFFFFFFFF << (32 - (s & 0x1F));
+                }
+                c = (d & 1) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x0D, rcl)
+                result = d << (s & 0x1F);
+                if (bCarry)
+                {
+                    result |= (1u << (s & 0x1F)) - 1;
+                }
+                c = (d >> 31) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x0E, sar)
+                result = (unsigned int)((int)d >> (s & 0x1F));
+                c = (d & 1) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x0F, rev)
+                result = (s & 0x1F) ? Reverse(d) >> (s & 0x1F) : Reverse(d);
+                c = (d & 1) != 0;
+                z = (result == 0);
+                break;
+
+            // limits and moves of instruction fields
+
+            COG_OP(0x10, mins)
+                c = ((int)d < (int)s);
+                result = c ? s : d;
+                z = (result == 0);
+                break;
+            COG_OP(0x11, maxs)
+                c = ((int)d < (int)s);
+                result = c ? d : s;
+                z = (result == 0);
+                break;
+            COG_OP(0x12, min)
+                c = (d < s);
+                result = c ? s : d;
+                z = (result == 0);
+                break;
+            COG_OP(0x13, max)
+                c = (d < s);
+                result = c ? d : s;
+                z = (result == 0);
+                break;
+            COG_OP(0x14, movs)
+                result = (d & ~0x000001FF) | (s & 0x1FF);
+                z = (result == 0);
+                break;
+            COG_OP(0x15, movd)
+                result = (d & ~0x0003FE00) | ((s & 0x1FF) << 9);
+                z = (result == 0);
+                break;
+            COG_OP(0x16, movi)
+                result = (d & ~0xFF800000) | ((s & 0x1FF) << 23);
+                z = (result == 0);
+                break;
+            COG_OP(0x17, jmpret)
+                result = (d & ~0x000001FF) | ((pc + 1) & 0x1FF);
+                z = (result == 0);
+                jump = s & 0x1FF;
+                break;
+
+            // logic
+
+            COG_OP(0x18, and)
+                result = d & s;
+                c = Parity(result) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x19, andn)
+                result = d & ~s;
+                c = Parity(result) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x1A, or)
+                result = d | s;
+                c = Parity(result) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x1B, xor)
+                result = d ^ s;
+                c = Parity(result) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x1C, muxc)
+                result = bCarry ? (d | s) : (d & ~s);
+                c = Parity(result) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x1D, muxnc)
+                result = !bCarry ? (d | s) : (d & ~s);
+                c = Parity(result) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x1E, muxz)
+                result = bZero ? (d | s) : (d & ~s);
+                c = Parity(result) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x1F, muxnz)
+                result = !bZero ? (d | s) : (d & ~s);
+                c = Parity(result) != 0;
+                z = (result == 0);
+                break;
+
+            // add and subtract
+
+            COG_OP(0x20, add)
+                result = d + s;
+                c = (result < d);
+                z = (result == 0);
+                break;
+            COG_OP(0x21, sub)
+                result = d - s;
+                c = (d < s);
+                z = (result == 0);
+                break;
+            COG_OP(0x22, addabs)
+                if ((int)s < 0)
+                {
+                    s = 0 - s;
+                    result = d - s;
+                    c = (d < s);
+                }
+                else
+                {
+                    result = d + s;
+                    c = (result < d);
+                }
+                z = (result == 0);
+                break;
+            COG_OP(0x23, subabs)
+                if ((int)s < 0)
+                {
+                    s = 0 - s;
+                    result = d + s;
+                    c = (result < d);
+                }
+                else
+                {
+                    result = d - s;
+                    c = (d < s);
+                }
+                z = (result == 0);
+                break;
+            COG_OP(0x24, sumc)
+                s = bCarry ? 0 - s : s;
+                result = d + s;
+                c = (((~(d ^ s)) & (d ^ result)) >> 31) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x25, sumnc)
+                s = !bCarry ? 0 - s : s;
+                result = d + s;
+                c = (((~(d ^ s)) & (d ^ result)) >> 31) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x26, sumz)
+                s = bZero ? 0 - s : s;
+                result = d + s;
+                c = (((~(d ^ s)) & (d ^ result)) >> 31) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x27, sumnz)
+                s = !bZero ? 0 - s : s;
+                result = d + s;
+                c = (((~(d ^ s)) & (d ^ result)) >> 31) != 0;
+                z = (result == 0);
+                break;
+
+            // moves and negates
+
+            COG_OP(0x28, mov)
+                result = s;
+                c = (s >> 31) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x29, neg)
+                result = 0 - s;
+                c = (s >> 31) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x2A, abs)
+                result = ((int)s < 0) ? 0 - s : s;
+                c = (s >> 31) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x2B, absneg)
+                result = ((int)s < 0) ? s : 0 - s;
+                c = (s >> 31) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x2C, negc)
+                result = bCarry ? 0 - s : s;
+                c = (s >> 31) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x2D, negnc)
+                result = !bCarry ? 0 - s : s;
+                c = (s >> 31) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x2E, negz)
+                result = bZero ? 0 - s : s;
+                c = (s >> 31) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x2F, negnz)
+                result = !bZero ? 0 - s : s;
+                c = (s >> 31) != 0;
+                z = (result == 0);
+                break;
+
+            // signed and extended
+
+            COG_OP(0x30, cmps)
+                result = d - s;
+                c = ((int)d < (int)s);
+                z = (d == s);
+                break;
+            COG_OP(0x31, cmpsx)
+                result = d - s - bCarry;
+                c = ((long long)(int)d < (long long)(int)s + bCarry);
+                z = bZero && (result == 0);
+                break;
+            COG_OP(0x32, addx)
+                wide = (unsigned long long)d + s + bCarry;
+                result = (unsigned int)wide;
+                c = (wide >> 32) != 0;
+                z = bZero && (result == 0);
+                break;
+            COG_OP(0x33, subx)
+                result = d - s - bCarry;
+                c = ((unsigned long long)d < (unsigned long long)s + bCarry);
+                z = bZero && (result == 0);
+                break;
+            COG_OP(0x34, adds)
+                result = d + s;
+                c = (((~(d ^ s)) & (d ^ result)) >> 31) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x35, subs)
+                result = d - s;
+                c = (((d ^ s) & (d ^ result)) >> 31) != 0;
+                z = (result == 0);
+                break;
+            COG_OP(0x36, addsx)
+                wide = (unsigned long long)((long long)(int)d + (int)s + bCarry);
+                result = (unsigned int)wide;
+                c = ((long long)wide != (long long)(int)result);
+                z = bZero && (result == 0);
+                break;
+            COG_OP(0x37, subsx)
+                wide = (unsigned long long)((long long)(int)d - (int)s - bCarry);
+                result = (unsigned int)wide;
+                c = ((long long)wide != (long long)(int)result);
+                z = bZero && (result == 0);
+                break;
+            COG_OP(0x38, cmpsub)
+                c = (d >= s);
+                z = (d == s);
+                if (c)
+                {
+                    result = d - s;
+                }
+                break;
+
+            // loops
+
+            COG_OP(0x39, djnz)
+                result = d - 1;
+                c = (d == 0);
+                z = (result == 0);
+                if (result != 0)
+                {
+                    jump = s & 0x1FF;
+                }
+                else
+                {
+                    clocks = 8;
+                }
+                break;
+            COG_OP(0x3A, tjnz)
+                c = false;
+                z = (d == 0);
+                if (d != 0)
+                {
+                    jump = s & 0x1FF;
+                }
+                else
+                {
+                    clocks = 8;
+                }
+                break;
+            COG_OP(0x3B, tjz)
+                c = false;
+                z = (d == 0);
+                if (d == 0)
+                {
+                    jump = s & 0x1FF;
+                }
+                else
+                {
+                    clocks = 8;
+                }
+                break;
+
+            // waits
+
+            COG_OP(0x3C, waitpeq)
+            COG_OP(0x3D, waitpne)
+                cog.waitState = d;
+                cog.waitMask = s;
+                cog.waitPort = (inst.flags & cog_flag_wc) ? 1 : 0;
+                cog.bWaitEqual = (inst.op == 0x3C);
+                if (!chip.CheckPins(cog))
+                {
+                    // the scheduler runs this again once the pins match
+                    cog.bWaitPins = true;
+                    cog.time = time;
+                    native.pc = pc;
+                    native.current = inst;
+                    native.bCarry = bCarry;
+                    native.bZero = bZero;
+                    return;
+                }
+                clocks = cog_clocks_wait;
+                break;
+            COG_OP(0x3E, waitcnt)
+                // CNT is compared from the end of the first 4 clocks, a target that has gone by waits for it to wrap around
+                clocks = cog_clocks_wait + (unsigned int)(d - (unsigned int)(time + 4));
+                result = d + s;
+                c = (result < d);
+                z = (result == 0);
+                break;
+            COG_OP(0x3F, waitvid)
+                clocks = 5;
+                break;
+
+            COG_OP(0x04, nop) // MUL, MULS, ENC and ONES aren't in the chip
+            default:
+                break;
+        }
+
+        if (inst.flags & cog_flag_wz)
+        {
+            bZero = z;
+        }
+        if (inst.flags & cog_flag_wc)
+        {
+            bCarry = c;
+        }
+        if ((inst.flags & cog_flag_wr) && WriteRegister(chip, cog, native, inst.dest, result, time + clocks))
+        {
+            bStop = true; // the pins changed, let cogs waiting on them go
+        }
+
+        if (jump >= 0)
+        {
+            pc = jump;
+            inst = native.decoded[jump];
+        }
+        else
+        {
+            pc = (pc + 1) & (cog_ram_size - 1);
+            inst = next;
+        }
+        time += clocks;
+    }
+    while (time < limit && !bStop);
+
+    cog.time = time;
+    native.pc = pc;
+    native.current = inst;
+    native.bCarry = bCarry;
+    native.bZero = bZero;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
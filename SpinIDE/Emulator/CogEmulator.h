@@ -0,0 +1,102 @@
+//////////////////////////////////////////////////////////////
+//                                                          //
+// Propeller Cog (PASM) Emulator                            //
+// (c)2012 Parallax Inc. DBA Parallax Semiconductor.        //
+// See end of file for terms of use.                        //
+//                                                          //
+//////////////////////////////////////////////////////////////
+//
+// CogEmulator.h
+//
+// runs the cogs started with PASM for SpinInterpreter, which owns the
+// hub, the pins and the scheduling of the cogs (included by SpinInterpreter.h)
+//
+
+#ifndef _COG_EMULATOR_H_
+#define _COG_EMULATOR_H_
+
+#define cog_ram_size                0x200
+#define cog_load_size               0x1F0       // coginit loads $000-$1EF from the hub
+#define cog_reg_par                 0x1F0
+#define cog_reg_cnt                 0x1F1
+#define cog_reg_ina                 0x1F2
+#define cog_reg_inb                 0x1F3
+#define cog_reg_outa                0x1F4
+#define cog_reg_dira                0x1F6
+
+#define cog_flag_wz                 0x01
+#define cog_flag_wc                 0x02
+#define cog_flag_wr                 0x04
+#define cog_flag_imm                0x08
+
+class SpinInterpreter;
+struct SpinCog;
+
+// a cog register decoded as an instruction, redone whenever the register is written
+struct CogInstruction
+{
+    unsigned char   op;                 // the instruction field, or one of the extra ops below
+    unsigned char   cond;               // the IF_ field, bit (C << 1 | Z) says whether it runs
+    unsigned char   flags;              // cog_flag_*
+    unsigned char   unused;
+    unsigned short  dest;
+    unsigned short  src;
+};
+
+// the instruction field is 6 bits, these pick out the forms that are handled separately
+#define cog_op_wrbyte               0x40        // rdbyte/rdword/rdlong without R
+#define cog_op_wrword               0x41
+#define cog_op_wrlong               0x42
+#define cog_op_count                0x43
+
+struct NativeCog
+{
+    unsigned int    ram[cog_ram_size];
+    CogInstruction  decoded[cog_ram_size];
+    CogInstruction  current;            // already fetched, so writing the next instruction doesn't change it
+    int             pc;
+    bool            bCarry;
+    bool            bZero;
+};
+
+class CogEmulator
+{
+    NativeCog       m_cogs[cog_count];
+
+    static void Decode(unsigned int instruction, CogInstruction& decoded);
+    unsigned int ReadSpecial(SpinInterpreter& chip, SpinCog& cog, int reg, long long time);
+    bool WriteRegister(SpinInterpreter& chip, SpinCog& cog, NativeCog& native, int reg, unsigned int value, long long time);
+
+public:
+    // loads $000-$1EF of cog id from the hub image at codeAddress, as coginit does
+    void Load(int id, const unsigned char* pHub, unsigned int codeAddress);
+
+    // runs cog id until its clock reaches limit (at least one instruction), until it waits on pins,
+    // changes OUTA/DIRA, or is stopped/restarted
+    void Run(SpinInterpreter& chip, int id, long long limit);
+
+    const NativeCog* GetCog(int id)     { return &m_cogs[id & 7]; }
+};
+
+#endif // _COG_EMULATOR_H_
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,1384 @@
+//////////////////////////////////////////////////////////////
+//                                                          //
+// Propeller Spin Interpreter (host side)                   //
+// (c)2012 Parallax Inc. DBA Parallax Semiconductor.        //
+// See end of file for terms of use.                        //
+//                                                          //
+//////////////////////////////////////////////////////////////
+//
+// SpinInterpreter.cpp
+//
+// Each cog keeps its own clock and the one that is furthest behind
+// runs the next bytecode, so cogs interleave the way they would on
+// the chip. The clocks for a bytecode are an estimate made up of a
+// fixed cost and a cost for each hub access it makes, the ROM
+// interpreter's exact timing isn't modeled.
+//
+// Stack frames are laid out in hub RAM exactly as the ROM interpreter
+// does it, so code that looks at its own stack (cognew, @result, etc.)
+// sees the same thing:
+//
+//      word    pbase | flags       ;flags: bit 0 = don't push result, bit 1 = abort trap
+//      word    vbase
+//      word    dbase
+//      word    pcurr               ;return address (dcall until the call is made)
+//  dbase:
+//      long    result
+//      long    parameters...
+//      long    locals...
+//
+// The boot frame (and the one built by cognew) is $FFF9FFFF, $FFF9FFFF,
+// which returns to the ROM at $FFF9 where the cog stops itself.
+//
+// Cogs started with anything other than the interpreter's address run
+// PASM in CogEmulator. Those run a batch of instructions at a time, up to
+// the clock of the next cog in line, so hub accesses still happen in
+// clock order.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include "SpinInterpreter.h"
+#include "../PropellerCompiler/SpinBytecode.h"
+
+#define spin_clocks_bytecode        32      // fetch and dispatch
+#define spin_clocks_hub             16      // each hub access the bytecode makes
+#define spin_clocks_long_math       400     // *, **, /, //, ^^ loop over the bits
+#define spin_clocks_coginit         8208    // loading a cog's 496 longs
+#define spin_boot_frame             0xFFF9FFFF
+
+// interpreter registers ($1E0-$1EF) reachable with the register bytecodes
+#define spin_reg_id                 0x09
+#define spin_reg_dcurr              0x0F
+
+#define spr_par                     0x0
+#define spr_cnt                     0x1
+#define spr_ina                     0x2
+#define spr_inb                     0x3
+#define spr_outa                    0x4
+#define spr_dira                    0x6
+
+SpinInterpreter::SpinInterpreter()
+{
+    memset(m_hub, 0, sizeof(m_hub));
+    memset(m_cogs, 0, sizeof(m_cogs));
+    memset(m_locks, 0, sizeof(m_locks));
+    memset(m_lockUsed, 0, sizeof(m_lockUsed));
+    m_inputs = 0;
+    m_clock = 0;
+    m_bytecodes = 0;
+    m_hubAccesses = 0;
+    m_extraClocks = 0;
+    m_bRebooted = false;
+    m_pinTime = 0;
+    m_error[0] = 0;
+}
+
+///////////////////////////////////////////
+// hub access
+
+unsigned int SpinInterpreter::ReadByte(int address)
+{
+    m_hubAccesses++;
+    return m_hub[address & (hub_size - 1)];
+}
+
+unsigned int SpinInterpreter::ReadWord(int address)
+{
+    m_hubAccesses++;
+    address &= (hub_size - 2);
+    return m_hub[address] | (m_hub[address + 1] << 8);
+}
+
+unsigned int SpinInterpreter::ReadLong(int address)
+{
+    m_hubAccesses++;
+    address &= (hub_size - 4);
+    return m_hub[address] | (m_hub[address + 1] << 8) | (m_hub[address + 2] << 16) | ((unsigned int)m_hub[address + 3] << 24);
+}
+
+void SpinInterpreter::WriteByte(int address, unsigned int value)
+{
+    m_hubAccesses++;
+    address &= (hub_size - 1);
+    if (address < hub_ram_size)
+    {
+        m_hub[address] = (unsigned char)value;
+    }
+}
+
+void SpinInterpreter::WriteWord(int address, unsigned int value)
+{
+    m_hubAccesses++;
+    address &= (hub_size - 2);
+    if (address < hub_ram_size)
+    {
+        m_hub[address] = (unsigned char)value;
+        m_hub[address + 1] = (unsigned char)(value >> 8);
+    }
+}
+
+void SpinInterpreter::WriteLong(int address, unsigned int value)
+{
+    m_hubAccesses++;
+    address &= (hub_size - 4);
+    if (address < hub_ram_size)
+    {
+        m_hub[address] = (unsigned char)value;
+        m_hub[address + 1] = (unsigned char)(value >> 8);
+        m_hub[address + 2] = (unsigned char)(value >> 16);
+        m_hub[address + 3] = (unsigned char)(value >> 24);
+    }
+}
+
+unsigned int SpinInterpreter::Read(int address, int size)
+{
+    return (size == 0) ? ReadByte(address) : ((size == 1) ? ReadWord(address) : ReadLong(address));
+}
+
+void SpinInterpreter::Write(int address, int size, unsigned int value)
+{
+    if (size == 0)
+    {
+        WriteByte(address, value);
+    }
+    else if (size == 1)
+    {
+        WriteWord(address, value);
+    }
+    else
+    {
+        WriteLong(address, value);
+    }
+}
+
+void SpinInterpreter::Push(SpinCog& cog, unsigned int value)
+{
+    WriteLong(cog.dcurr, value);
+    cog.dcurr = (cog.dcurr + 4) & (hub_size - 1);
+}
+
+unsigned int SpinInterpreter::Pop(SpinCog& cog)
+{
+    cog.dcurr = (cog.dcurr - 4) & (hub_size - 1);
+    return ReadLong(cog.dcurr);
+}
+
+unsigned int SpinInterpreter::Top(SpinCog& cog)
+{
+    return ReadLong(cog.dcurr - 4);
+}
+
+// relative address as compiled by CompileAddress(), returns the target
+int SpinInterpreter::ReadCodeAddress(SpinCog& cog)
+{
+    int offset = ReadByte(cog.pcurr++);
+    if (offset & 0x80)
+    {
+        offset = ((offset & 0x7F) << 8) | ReadByte(cog.pcurr++);
+        if (offset & 0x4000)
+        {
+            offset -= 0x8000;
+        }
+    }
+    else if (offset & 0x40)
+    {
+        offset -= 0x80;
+    }
+    return (cog.pcurr + offset) & (hub_size - 1);
+}
+
+///////////////////////////////////////////
+// registers and pins
+
+unsigned int SpinInterpreter::PortA()
+{
+    // driven pins read back what is driven, the rest read the inputs
+    unsigned int directions = GetDirections();
+    return (m_inputs & ~directions) | (GetOutputs() & directions);
+}
+
+unsigned int SpinInterpreter::GetOutputs()
+{
+    unsigned int outputs = 0;
+    for (int i = 0; i < cog_count; i++)
+    {
+        if (m_cogs[i].state != spin_cog_stopped)
+        {
+            outputs |= m_cogs[i].regs[spr_outa] & m_cogs[i].regs[spr_dira];
+        }
+    }
+    return outputs;
+}
+
+unsigned int SpinInterpreter::GetDirections()
+{
+    unsigned int directions = 0;
+    for (int i = 0; i < cog_count; i++)
+    {
+        if (m_cogs[i].state != spin_cog_stopped)
+        {
+            directions |= m_cogs[i].regs[spr_dira];
+        }
+    }
+    return directions;
+}
+
+// reg is $1E0-$1FF less $1E0
+unsigned int SpinInterpreter::ReadRegister(SpinCog& cog, int reg)
+{
+    if (reg < 0x10)
+    {
+        if (reg == spin_reg_id)
+        {
+            return (unsigned int)(&cog - m_cogs);
+        }
+        if (reg == spin_reg_dcurr)
+        {
+            return cog.dcurr;
+        }
+        return 0;
+    }
+    reg &= 0x0F;
+    switch (reg)
+    {
+        case spr_cnt:
+            return (unsigned int)cog.time;
+        case spr_ina:
+            return PortA();
+        case spr_inb:
+            return 0;
+    }
+    return cog.regs[reg];
+}
+
+void SpinInterpreter::WriteRegister(SpinCog& cog, int reg, unsigned int value)
+{
+    if (reg < 0x10)
+    {
+        return; // the interpreter's own registers are left alone
+    }
+    reg &= 0x0F;
+    if (reg == spr_par || reg == spr_cnt || reg == spr_ina || reg == spr_inb)
+    {
+        return; // read only
+    }
+    if ((reg == spr_outa || reg == spr_dira) && cog.regs[reg] != value)
+    {
+        m_pinTime = cog.time;
+    }
+    cog.regs[reg] = value;
+}
+
+bool SpinInterpreter::CheckPins(SpinCog& cog)
+{
+    unsigned int pins = (cog.waitPort == 0) ? PortA() : 0;
+    bool bEqual = ((pins & cog.waitMask) == cog.waitState);
+    return bEqual == cog.bWaitEqual;
+}
+
+///////////////////////////////////////////
+// variables
+
+unsigned int SpinInterpreter::ReadTarget(SpinCog& cog, const SpinTarget& target)
+{
+    if (!target.bRegister)
+    {
+        return Read(target.address, target.size);
+    }
+    unsigned int value = ReadRegister(cog, target.address);
+    if (target.width == 32)
+    {
+        return value;
+    }
+    value = (value >> target.lowBit) & ((1u << target.width) - 1);
+    if (target.bReverse)
+    {
+        unsigned int reversed = 0;
+        for (int i = 0; i < target.width; i++)
+        {
+            reversed = (reversed << 1) | ((value >> i) & 1);
+        }
+        value = reversed;
+    }
+    return value;
+}
+
+void SpinInterpreter::WriteTarget(SpinCog& cog, const SpinTarget& target, unsigned int value)
+{
+    if (!target.bRegister)
+    {
+        Write(target.address, target.size, value);
+        return;
+    }
+    if (target.width == 32)
+    {
+        WriteRegister(cog, target.address, value);
+        return;
+    }
+    unsigned int fieldMask = (1u << target.width) - 1;
+    value &= fieldMask;
+    if (target.bReverse)
+    {
+        unsigned int reversed = 0;
+        for (int i = 0; i < target.width; i++)
+        {
+            reversed = (reversed << 1) | ((value >> i) & 1);
+        }
+        value = reversed;
+    }
+    unsigned int current = ReadRegister(cog, target.address);
+    current = (current & ~(fieldMask << target.lowBit)) | (value << target.lowBit);
+    WriteRegister(cog, target.address, current);
+}
+
+// operation is the bottom two bits of a variable bytecode (push, pop, using, reference)
+bool SpinInterpreter::Access(SpinCog& cog, const SpinTarget& target, int operation)
+{
+    switch (operation)
+    {
+        case 0: // push
+            Push(cog, ReadTarget(cog, target));
+            return true;
+        case 1: // pop
+            WriteTarget(cog, target, Pop(cog));
+            return true;
+        case 2: // using, an assign operator follows
+            return UsingOp(cog, target);
+    }
+    // reference
+    if (target.bRegister)
+    {
+        return Fail(cog, "can't take the address of a register");
+    }
+    Push(cog, target.address);
+    return true;
+}
+
+// forward (?var) and reverse (var?) pseudo-random, a 32 bit LFSR run 32 times
+static unsigned int RandomForward(unsigned int value)
+{
+    if (value == 0)
+    {
+        value = 1;
+    }
+    for (int i = 0; i < 32; i++)
+    {
+        unsigned int taps = value & 0x00000017;
+        taps ^= taps >> 4;
+        taps ^= taps >> 2;
+        taps ^= taps >> 1;
+        value = (value >> 1) | ((taps & 1) << 31);
+    }
+    return value;
+}
+
+static unsigned int RandomReverse(unsigned int value)
+{
+    if (value == 0)
+    {
+        value = 1;
+    }
+    for (int i = 0; i < 32; i++)
+    {
+        unsigned int taps = value & 0x8000000B;
+        taps ^= taps >> 16;
+        taps ^= taps >> 8;
+        taps ^= taps >> 4;
+        taps ^= taps >> 2;
+        taps ^= taps >> 1;
+        value = (value << 1) | (taps & 1);
+    }
+    return value;
+}
+
+// assign operator after a using access
+bool SpinInterpreter::UsingOp(SpinCog& cog, const SpinTarget& target)
+{
+    unsigned char assignOp = (unsigned char)ReadByte(cog.pcurr++);
+    bool bPush = (assignOp & 0x80) != 0;
+    unsigned char op = assignOp & 0x7F;
+    unsigned int value = 0;
+    unsigned int result = 0;
+
+    if (op >= 0x40)
+    {
+        // var := var op value (or op var for the unary ones)
+        unsigned int operand = IsUnaryMathOp(op) ? 0 : Pop(cog);
+        value = ReadTarget(cog, target);
+        if (!MathOp(op, value, operand, result))
+        {
+            return Fail(cog, "bad assign operator");
+        }
+        WriteTarget(cog, target, result);
+        if (bPush)
+        {
+            Push(cog, result);
+        }
+        return true;
+    }
+
+    if (op >= 0x20)
+    {
+        // ++/--, the size bits give the width to wrap at
+        int sizeBits = (op >> 1) & 0x03;
+        unsigned int mask = (sizeBits == 1) ? 0xFF : ((sizeBits == 2) ? 0xFFFF : 0xFFFFFFFF);
+        value = ReadTarget(cog, target);
+        result = ((op & 0x10) ? value - 1 : value + 1) & mask;
+        WriteTarget(cog, target, result);
+        if (bPush)
+        {
+            Push(cog, (op & 0x08) ? value : result); // post or pre
+        }
+        return true;
+    }
+
+    if (op == 0x02 || op == 0x06)
+    {
+        // repeat-var, the step's sign is ignored, the direction comes from the range
+        int jumpAddress = ReadCodeAddress(cog);
+        int to = (int)Pop(cog);
+        int from = (int)Pop(cog);
+        int step = 1;
+        if (op == 0x06)
+        {
+            step = (int)Pop(cog);
+            if (step < 0)
+            {
+                step = -step;
+            }
+        }
+        int counter = (int)ReadTarget(cog, target);
+        bool bLoop = false;
+        if (from <= to)
+        {
+            counter += step;
+            bLoop = (counter >= from && counter <= to);
+        }
+        else
+        {
+            counter -= step;
+            bLoop = (counter <= from && counter >= to);
+        }
+        WriteTarget(cog, target, (unsigned int)counter);
+        if (bLoop)
+        {
+            cog.pcurr = jumpAddress;
+        }
+        return true;
+    }
+
+    switch (op & 0x1C)
+    {
+        case 0x00: // write
+            result = Pop(cog);
+            WriteTarget(cog, target, result);
+            break;
+        case 0x08: // ?var
+            result = RandomForward(ReadTarget(cog, target));
+            WriteTarget(cog, target, result);
+            break;
+        case 0x0C: // var?
+            result = RandomReverse(ReadTarget(cog, target));
+            WriteTarget(cog, target, result);
+            break;
+        case 0x10: // ~var
+            result = (unsigned int)(int)(signed char)ReadTarget(cog, target);
+            WriteTarget(cog, target, result);
+            break;
+        case 0x14: // ~~var
+            result = (unsigned int)(int)(short)ReadTarget(cog, target);
+            WriteTarget(cog, target, result);
+            break;
+        case 0x18: // var~
+            result = ReadTarget(cog, target);
+            WriteTarget(cog, target, 0);
+            break;
+        case 0x1C: // var~~
+            result = ReadTarget(cog, target);
+            WriteTarget(cog, target, 0xFFFFFFFF);
+            break;
+    }
+    if (bPush)
+    {
+        Push(cog, result);
+    }
+    return true;
+}
+
+///////////////////////////////////////////
+// math
+
+bool SpinInterpreter::MathOp(unsigned char mathOp, unsigned int value1, unsigned int value2, unsigned int& result)
+{
+    int signedResult = 0;
+    if (EvaluateMathOp(mathOp, (int)value1, (int)value2, signedResult))
+    {
+        if ((mathOp & 0x1F) == 0x14)
+        {
+            m_extraClocks += spin_clocks_long_math; // *
+        }
+        result = (unsigned int)signedResult;
+        return true;
+    }
+
+    switch (mathOp & 0x1F)
+    {
+        case 0x0F: // ><
+            {
+                unsigned int reversed = 0;
+                for (int i = 0; i < 32; i++)
+                {
+                    reversed = (reversed << 1) | ((value1 >> i) & 1);
+                }
+                result = reversed >> ((32 - value2) & 0x1F);
+            }
+            break;
+        case 0x15: // **
+            m_extraClocks += spin_clocks_long_math;
+            result = (unsigned int)(((long long)(int)value1 * (long long)(int)value2) >> 32);
+            break;
+        case 0x16: // /
+        case 0x17: // //
+            {
+                // unsigned divide of the magnitudes, the quotient is all ones when dividing by zero
+                m_extraClocks += spin_clocks_long_math;
+                unsigned int dividend = ((int)value1 < 0) ? 0 - value1 : value1;
+                unsigned int divisor = ((int)value2 < 0) ? 0 - value2 : value2;
+                unsigned int quotient = (divisor != 0) ? dividend / divisor : 0xFFFFFFFF;
+                unsigned int remainder = (divisor != 0) ? dividend % divisor : dividend;
+                if ((mathOp & 0x1F) == 0x16)
+                {
+                    result = (((int)value1 < 0) != ((int)value2 < 0)) ? 0 - quotient : quotient;
+                }
+                else
+                {
+                    result = ((int)value1 < 0) ? 0 - remainder : remainder;
+                }
+            }
+            break;
+        case 0x18: // ^^
+            {
+                m_extraClocks += spin_clocks_long_math;
+                unsigned int root = 0;
+                for (unsigned int bit = 1u << 15; bit != 0; bit >>= 1)
+                {
+                    unsigned int trial = root | bit;
+                    if ((unsigned long long)trial * trial <= value1)
+                    {
+                        root = trial;
+                    }
+                }
+                result = root;
+            }
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+///////////////////////////////////////////
+// cogs
+
+void SpinInterpreter::StartSpinCog(int id, unsigned int par, long long time)
+{
+    SpinCog& cog = m_cogs[id];
+    memset(&cog, 0, sizeof(SpinCog));
+    cog.state = spin_cog_spin;
+    cog.time = time;
+    cog.regs[spr_par] = par;
+    cog.codeAddress = spin_interpreter_address;
+
+    // the same five words the boot loader leaves at $0006
+    cog.pbase = ReadWord(par + 2);
+    cog.vbase = ReadWord(par + 4);
+    cog.dbase = ReadWord(par + 6);
+    cog.pcurr = ReadWord(par + 8);
+    cog.dcurr = ReadWord(par + 10);
+}
+
+int SpinInterpreter::CogInit(SpinCog& cog, unsigned int id, unsigned int code, unsigned int par)
+{
+    if (id & 0x08)
+    {
+        // cognew, the first free cog
+        id = cog_count;
+        for (int i = 0; i < cog_count; i++)
+        {
+            if (m_cogs[i].state == spin_cog_stopped)
+            {
+                id = i;
+                break;
+            }
+        }
+        if (id == cog_count)
+        {
+            return -1;
+        }
+    }
+    id &= 0x07;
+    par &= 0xFFFC;
+    code &= 0xFFFC;
+
+    long long startTime = cog.time + spin_clocks_coginit;
+    if (code == spin_interpreter_address)
+    {
+        StartSpinCog(id, par, startTime);
+    }
+    else
+    {
+        SpinCog& newCog = m_cogs[id];
+        memset(&newCog, 0, sizeof(SpinCog));
+        newCog.state = spin_cog_native;
+        newCog.time = startTime;
+        newCog.regs[spr_par] = par;
+        newCog.codeAddress = code;
+        m_native.Load(id, m_hub, code);
+    }
+    return id;
+}
+
+bool SpinInterpreter::Fail(SpinCog& cog, const char* pMessage)
+{
+    sprintf(m_error, "cog %d at $%04X: %s", (int)(&cog - m_cogs), cog.pcurr, pMessage);
+    cog.state = spin_cog_stopped;
+    return false;
+}
+
+// pops stack frames back to the caller (or to the nearest abort trap)
+bool SpinInterpreter::Return(SpinCog& cog, unsigned int value, bool bAbort)
+{
+    unsigned int flags = 0;
+    while (1)
+    {
+        int frame = cog.dbase - 8;
+        flags = ReadWord(frame);
+        cog.pbase = flags & 0xFFFC;
+        cog.vbase = ReadWord(frame + 2);
+        cog.dbase = ReadWord(frame + 4);
+        cog.pcurr = ReadWord(frame + 6);
+        cog.dcurr = frame & (hub_size - 1);
+        if (!bAbort || (flags & 0x02) || cog.pcurr >= spin_exit_address)
+        {
+            break;
+        }
+    }
+
+    if (cog.pcurr >= spin_exit_address)
+    {
+        // back into the ROM, which stops the cog
+        cog.bExited = true;
+        cog.bAborted = bAbort;
+        cog.exitValue = (int)value;
+        cog.state = spin_cog_stopped;
+        return true;
+    }
+
+    if ((flags & 0x01) == 0)
+    {
+        Push(cog, value);
+    }
+    return true;
+}
+
+///////////////////////////////////////////
+// bytecodes
+
+bool SpinInterpreter::Step(SpinCog& cog)
+{
+    m_hubAccesses = 0;
+    m_extraClocks = 0;
+    int opcodeAddress = cog.pcurr;
+    unsigned char op = (unsigned char)ReadByte(cog.pcurr++);
+    unsigned int x = 0;
+    unsigned int y = 0;
+    unsigned int z = 0;
+    bool bResult = true;
+
+    if (op >= 0xE0)
+    {
+        // math operator
+        if (IsUnaryMathOp(op))
+        {
+            x = Pop(cog);
+        }
+        else
+        {
+            y = Pop(cog);
+            x = Pop(cog);
+        }
+        if (!MathOp(op, x, y, z))
+        {
+            return Fail(cog, "bad math operator");
+        }
+        Push(cog, z);
+    }
+    else if (op >= 0x40)
+    {
+        // variables
+        SpinTarget target;
+        memset(&target, 0, sizeof(target));
+        target.size = 2;
+        if (op < 0x80)
+        {
+            // compact long VAR or local
+            target.address = ((op & 0x20) ? cog.dbase : cog.vbase) + (op & 0x1C);
+        }
+        else
+        {
+            target.size = (op >> 5) & 0x03;
+            int base = (op >> 2) & 0x03;
+            unsigned int index = (op & 0x10) ? Pop(cog) : 0;
+            if (base == 0)
+            {
+                target.address = Pop(cog);
+            }
+            else
+            {
+                int offset = ReadByte(cog.pcurr++);
+                if (offset & 0x80)
+                {
+                    offset = ((offset & 0x7F) << 8) | ReadByte(cog.pcurr++);
+                }
+                target.address = ((base == 1) ? cog.pbase : ((base == 2) ? cog.vbase : cog.dbase)) + offset;
+            }
+            target.address += index << target.size;
+        }
+        target.address &= (hub_size - 1);
+        bResult = Access(cog, target, op & 0x03);
+    }
+    else
+    {
+        switch (op)
+        {
+            case 0x00: // drop anchor
+            case 0x01:
+            case 0x02:
+            case 0x03:
+                WriteWord(cog.dcurr, cog.pbase | op);
+                WriteWord(cog.dcurr + 2, cog.vbase);
+                WriteWord(cog.dcurr + 4, cog.dbase);
+                WriteWord(cog.dcurr + 6, cog.dcall);
+                cog.dcall = cog.dcurr + 6;
+                cog.dcurr += 8;
+                Push(cog, 0); // result
+                break;
+
+            case 0x04: // jmp
+                cog.pcurr = ReadCodeAddress(cog);
+                break;
+
+            case 0x05: // call sub
+            case 0x06: // call obj.sub
+            case 0x07: // call obj[].sub
+                {
+                    if (op != 0x05)
+                    {
+                        x = ReadByte(cog.pcurr++);
+                        if (op == 0x07)
+                        {
+                            x += Pop(cog);
+                        }
+                        y = ReadLong(cog.pbase + (x << 2));
+                        cog.pbase = (cog.pbase + (y & 0xFFFF)) & (hub_size - 1);
+                        cog.vbase = (cog.vbase + (y >> 16)) & (hub_size - 1);
+                    }
+                    x = ReadByte(cog.pcurr++);
+                    int frame = cog.dcall;
+                    cog.dcall = ReadWord(frame);
+                    WriteWord(frame, cog.pcurr);
+                    cog.dbase = frame + 2;
+                    y = ReadLong(cog.pbase + (x << 2));
+                    cog.pcurr = (cog.pbase + (y & 0xFFFF)) & (hub_size - 1);
+                    cog.dcurr += y >> 16;
+                }
+                break;
+
+            case 0x08: // tjz
+                x = ReadCodeAddress(cog);
+                if (Top(cog) == 0)
+                {
+                    Pop(cog);
+                    cog.pcurr = x;
+                }
+                break;
+
+            case 0x09: // djnz
+                x = ReadCodeAddress(cog);
+                y = Pop(cog) - 1;
+                if (y != 0)
+                {
+                    Push(cog, y);
+                    cog.pcurr = x;
+                }
+                break;
+
+            case 0x0A: // jz
+            case 0x0B: // jnz
+                x = ReadCodeAddress(cog);
+                y = Pop(cog);
+                if ((y == 0) == (op == 0x0A))
+                {
+                    cog.pcurr = x;
+                }
+                break;
+
+            case 0x0C: // casedone
+                Pop(cog);
+                cog.pcurr = (cog.pbase + Pop(cog)) & (hub_size - 1);
+                break;
+
+            case 0x0D: // case value
+                x = ReadCodeAddress(cog);
+                y = Pop(cog);
+                if (y == Top(cog))
+                {
+                    cog.pcurr = x;
+                }
+                break;
+
+            case 0x0E: // case range
+                {
+                    x = ReadCodeAddress(cog);
+                    int high = (int)Pop(cog);
+                    int low = (int)Pop(cog);
+                    int value = (int)Top(cog);
+                    if (low > high)
+                    {
+                        int temp = low;
+                        low = high;
+                        high = temp;
+                    }
+                    if (value >= low && value <= high)
+                    {
+                        cog.pcurr = x;
+                    }
+                }
+                break;
+
+            case 0x0F: // lookdone, not found
+                cog.dcurr -= 12;
+                Push(cog, 0);
+                break;
+
+            case 0x10: // lookupval
+            case 0x11: // lookdownval
+            case 0x12: // lookuprng
+            case 0x13: // lookdnrng
+                {
+                    // stack is counter, end address, target
+                    int high = (int)Pop(cog);
+                    int low = high;
+                    if (op & 0x02)
+                    {
+                        low = (int)Pop(cog);
+                    }
+                    int target = (int)Top(cog);
+                    int counter = (int)ReadLong(cog.dcurr - 12);
+                    int count = ((high > low) ? high - low : low - high) + 1;
+                    bool bFound = false;
+                    int result = 0;
+                    if (op & 0x01)
+                    {
+                        // lookdown, is the target in the range?
+                        if ((target >= low && target <= high) || (target <= low && target >= high))
+                        {
+                            bFound = true;
+                            result = counter + ((target > low) ? target - low : low - target);
+                        }
+                    }
+                    else if (target >= counter && target < counter + count)
+                    {
+                        // lookup, is the index in the range?
+                        bFound = true;
+                        result = (high >= low) ? low + (target - counter) : low - (target - counter);
+                    }
+                    if (bFound)
+                    {
+                        x = ReadLong(cog.dcurr - 8);
+                        cog.dcurr -= 12;
+                        Push(cog, result);
+                        cog.pcurr = (cog.pbase + x) & (hub_size - 1);
+                    }
+                    else
+                    {
+                        WriteLong(cog.dcurr - 12, counter + count);
+                    }
+                }
+                break;
+
+            case 0x14: // pop
+                x = Pop(cog);
+                cog.dcurr = (cog.dcurr - x) & (hub_size - 1);
+                break;
+
+            case 0x15: // run, set up a new stack for cognew/coginit of a method
+                {
+                    unsigned int stack = Pop(cog) & 0xFFFC;
+                    unsigned int sub = Pop(cog);
+                    int params = (sub >> 8) & 0xFF;
+                    cog.dcurr -= params << 2;
+                    WriteLong(stack, spin_boot_frame);
+                    WriteLong(stack + 4, spin_boot_frame);
+                    int dbase = stack + 8;
+                    WriteLong(dbase, 0);
+                    for (int i = 0; i < params; i++)
+                    {
+                        WriteLong(dbase + 4 + (i << 2), ReadLong(cog.dcurr + (i << 2)));
+                    }
+                    y = ReadLong(cog.pbase + ((sub & 0xFF) << 2));
+                    int dcurr = dbase + 4 + (params << 2) + (y >> 16);
+                    // the words the new interpreter starts from go just past its stack
+                    WriteWord(dcurr + 2, cog.pbase);
+                    WriteWord(dcurr + 4, cog.vbase);
+                    WriteWord(dcurr + 6, dbase);
+                    WriteWord(dcurr + 8, cog.pbase + (y & 0xFFFF));
+                    WriteWord(dcurr + 10, dcurr);
+                    Push(cog, 0xFFFFFFFF); // new cog (coginit replaces this with its id)
+                    Push(cog, spin_interpreter_address);
+                    Push(cog, dcurr);
+                }
+                break;
+
+            case 0x16: // strsize
+                x = Pop(cog);
+                y = 0;
+                while (ReadByte(x + y) != 0 && y < hub_size)
+                {
+                    y++;
+                }
+                Push(cog, y);
+                break;
+
+            case 0x17: // strcomp
+                {
+                    y = Pop(cog);
+                    x = Pop(cog);
+                    unsigned int result = 0xFFFFFFFF;
+                    for (int i = 0; i < hub_size; i++)
+                    {
+                        unsigned int a = ReadByte(x + i);
+                        if (a != ReadByte(y + i))
+                        {
+                            result = 0;
+                            break;
+                        }
+                        if (a == 0)
+                        {
+                            break;
+                        }
+                    }
+                    Push(cog, result);
+                }
+                break;
+
+            case 0x18: // bytefill
+            case 0x19: // wordfill
+            case 0x1A: // longfill
+                {
+                    int size = op - 0x18;
+                    z = Pop(cog);
+                    y = Pop(cog);
+                    x = Pop(cog);
+                    for (unsigned int i = 0; i < z && i < hub_size; i++)
+                    {
+                        Write(x + (i << size), size, y);
+                    }
+                }
+                break;
+
+            case 0x1C: // bytemove
+            case 0x1D: // wordmove
+            case 0x1E: // longmove
+                {
+                    int size = op - 0x1C;
+                    z = Pop(cog);
+                    y = Pop(cog);
+                    x = Pop(cog);
+                    if (z >= hub_size)
+                    {
+                        z = hub_size;
+                    }
+                    if (x <= y)
+                    {
+                        for (unsigned int i = 0; i < z; i++)
+                        {
+                            Write(x + (i << size), size, Read(y + (i << size), size));
+                        }
+                    }
+                    else
+                    {
+                        for (unsigned int i = z; i > 0; i--)
+                        {
+                            Write(x + ((i - 1) << size), size, Read(y + ((i - 1) << size), size));
+                        }
+                    }
+                }
+                break;
+
+            case 0x1B: // waitpeq
+            case 0x1F: // waitpne
+                cog.waitPort = Pop(cog) & 1;
+                cog.waitMask = Pop(cog);
+                cog.waitState = Pop(cog);
+                cog.bWaitEqual = (op == 0x1B);
+                cog.bWaitPins = !CheckPins(cog);
+                break;
+
+            case 0x20: // clkset
+                y = Pop(cog);
+                x = Pop(cog);
+                if (x & 0x80)
+                {
+                    m_bRebooted = true;
+                }
+                else
+                {
+                    WriteLong(0, y);
+                    WriteByte(4, x);
+                }
+                break;
+
+            case 0x21: // cogstop
+                x = Pop(cog) & 0x07;
+                m_cogs[x].state = spin_cog_stopped;
+                break;
+
+            case 0x22: // lockret
+                x = Pop(cog) & 0x07;
+                m_lockUsed[x] = false;
+                break;
+
+            case 0x23: // waitcnt, a target that has gone by waits for CNT to wrap around
+                x = Pop(cog);
+                cog.time += (unsigned int)(x - (unsigned int)cog.time);
+                break;
+
+            case 0x24: // spr[x]
+            case 0x25:
+            case 0x26:
+                {
+                    SpinTarget target;
+                    memset(&target, 0, sizeof(target));
+                    target.bRegister = true;
+                    target.address = 0x10 | (Pop(cog) & 0x0F);
+                    target.width = 32;
+                    bResult = Access(cog, target, op & 0x03);
+                }
+                break;
+
+            case 0x27: // waitvid
+                Pop(cog);
+                Pop(cog);
+                break;
+
+            case 0x28: // coginit
+            case 0x2C:
+                z = Pop(cog);
+                y = Pop(cog);
+                x = Pop(cog);
+                x = (unsigned int)CogInit(cog, x, y, z);
+                if (op == 0x28)
+                {
+                    Push(cog, x);
+                }
+                break;
+
+            case 0x29: // locknew
+            case 0x2D:
+                x = 0xFFFFFFFF;
+                for (int i = 0; i < lock_count; i++)
+                {
+                    if (!m_lockUsed[i])
+                    {
+                        m_lockUsed[i] = true;
+                        x = i;
+                        break;
+                    }
+                }
+                if (op == 0x29)
+                {
+                    Push(cog, x);
+                }
+                break;
+
+            case 0x2A: // lockset
+            case 0x2E:
+            case 0x2B: // lockclr
+            case 0x2F:
+                x = Pop(cog) & 0x07;
+                y = m_locks[x] ? 0xFFFFFFFF : 0;
+                m_locks[x] = ((op & 0x01) == 0);
+                if (op < 0x2C)
+                {
+                    Push(cog, y);
+                }
+                break;
+
+            case 0x30: // abort
+            case 0x31: // abort value
+            case 0x32: // return
+            case 0x33: // return value
+                if (op & 0x01)
+                {
+                    x = Pop(cog);
+                    if (op == 0x33)
+                    {
+                        WriteLong(cog.dbase, x);
+                    }
+                }
+                else
+                {
+                    x = ReadLong(cog.dbase);
+                }
+                bResult = Return(cog, x, op < 0x32);
+                break;
+
+            case 0x34: // constant -1, 0, 1
+            case 0x35:
+            case 0x36:
+                Push(cog, (unsigned int)((int)op - 0x35));
+                break;
+
+            case 0x37: // constant mask
+                x = ReadByte(cog.pcurr++);
+                y = 2u << (x & 0x1F);
+                if (x & 0x20)
+                {
+                    y--;
+                }
+                if (x & 0x40)
+                {
+                    y = ~y;
+                }
+                Push(cog, y);
+                break;
+
+            case 0x38: // constant 1..4 bytes
+            case 0x39:
+            case 0x3A:
+            case 0x3B:
+                y = 0;
+                for (int i = 0x37; i < op; i++)
+                {
+                    y = (y << 8) | ReadByte(cog.pcurr++);
+                }
+                Push(cog, y);
+                break;
+
+            case 0x3D: // register[bit]
+            case 0x3E: // register[bit..bit]
+            case 0x3F: // register
+                {
+                    x = ReadByte(cog.pcurr++);
+                    SpinTarget target;
+                    memset(&target, 0, sizeof(target));
+                    target.bRegister = true;
+                    target.address = x & 0x1F;
+                    target.width = 32;
+                    if (op == 0x3D)
+                    {
+                        target.lowBit = Pop(cog) & 0x1F;
+                        target.width = 1;
+                    }
+                    else if (op == 0x3E)
+                    {
+                        int second = Pop(cog) & 0x1F;
+                        int first = Pop(cog) & 0x1F;
+                        target.lowBit = (first < second) ? first : second;
+                        target.width = ((first < second) ? second - first : first - second) + 1;
+                        target.bReverse = (first < second);
+                    }
+                    bResult = Access(cog, target, (x >> 5) & 0x03);
+                }
+                break;
+
+            default:
+                return Fail(cog, "bad bytecode");
+        }
+    }
+
+    if (!bResult)
+    {
+        if (m_error[0] == 0)
+        {
+            cog.pcurr = opcodeAddress;
+            return Fail(cog, "bad bytecode");
+        }
+        return false;
+    }
+
+    cog.pcurr &= (hub_size - 1);
+    cog.time += spin_clocks_bytecode + (m_hubAccesses * spin_clocks_hub) + m_extraClocks;
+    m_bytecodes++;
+    return true;
+}
+
+///////////////////////////////////////////
+// public
+
+bool SpinInterpreter::Load(const unsigned char* pImage, int imageSize)
+{
+    if (imageSize < 16)
+    {
+        strcpy(m_error, "image is not a Propeller RAM image");
+        return false;
+    }
+
+    // only the first 32K of a larger eeprom image is loaded
+    memset(m_hub, 0, sizeof(m_hub));
+    memcpy(m_hub, pImage, (imageSize < hub_ram_size) ? imageSize : hub_ram_size);
+    memset(m_cogs, 0, sizeof(m_cogs));
+    memset(m_locks, 0, sizeof(m_locks));
+    memset(m_lockUsed, 0, sizeof(m_lockUsed));
+    m_clock = 0;
+    m_bytecodes = 0;
+    m_bRebooted = false;
+    m_pinTime = 0;
+    m_error[0] = 0;
+
+    // the boot loader puts the boot frame under dbase (an eeprom image already has it)
+    int dbase = ReadWord(0x000A);
+    WriteLong(dbase - 8, spin_boot_frame);
+    WriteLong(dbase - 4, spin_boot_frame);
+
+    StartSpinCog(0, 0x0004, 0);
+    return true;
+}
+
+bool SpinInterpreter::CallMethod(int subIndex, const int* pParams, int paramCount)
+{
+    int pbase = ReadWord(0x0006);
+    int dbase = ReadWord(0x000A);
+    int subCount = ReadByte(pbase + 2) - 1;
+    if (subIndex < 1 || subIndex > subCount)
+    {
+        sprintf(m_error, "there is no method %d", subIndex);
+        return false;
+    }
+
+    memset(m_cogs, 0, sizeof(m_cogs));
+    m_bRebooted = false;
+    m_error[0] = 0;
+
+    StartSpinCog(0, 0x0004, m_clock);
+    SpinCog& cog = m_cogs[0];
+    WriteLong(dbase - 8, spin_boot_frame);
+    WriteLong(dbase - 4, spin_boot_frame);
+    WriteLong(dbase, 0);
+    for (int i = 0; i < paramCount; i++)
+    {
+        WriteLong(dbase + 4 + (i << 2), (unsigned int)pParams[i]);
+    }
+    unsigned int entry = ReadLong(pbase + (subIndex << 2));
+    cog.pcurr = (pbase + (entry & 0xFFFF)) & (hub_size - 1);
+    cog.dcurr = dbase + 4 + (paramCount << 2) + (entry >> 16);
+    return true;
+}
+
+int SpinInterpreter::Run(long long clocks)
+{
+    long long end = m_clock + clocks;
+    while (1)
+    {
+        if (m_bRebooted)
+        {
+            return spin_run_rebooted;
+        }
+
+        // the cog furthest behind goes next, a native cog can run until it catches up with the one after it
+        SpinCog* pNext = 0;
+        long long following = end;
+        bool bWaiting = false;
+        for (int i = 0; i < cog_count; i++)
+        {
+            SpinCog& cog = m_cogs[i];
+            if (cog.state == spin_cog_stopped)
+            {
+                continue;
+            }
+            if (cog.bWaitPins)
+            {
+                if (!CheckPins(cog))
+                {
+                    bWaiting = true;
+                    continue;
+                }
+                cog.bWaitPins = false;
+                if (cog.time < m_pinTime)
+                {
+                    cog.time = m_pinTime;
+                }
+            }
+            if (pNext == 0 || cog.time < pNext->time)
+            {
+                if (pNext != 0 && pNext->time < following)
+                {
+                    following = pNext->time;
+                }
+                pNext = &cog;
+            }
+            else if (cog.time < following)
+            {
+                following = cog.time;
+            }
+        }
+
+        if (pNext == 0)
+        {
+            return bWaiting ? spin_run_stalled : spin_run_stopped;
+        }
+        if (pNext->time >= end)
+        {
+            m_clock = end;
+            return spin_run_limit;
+        }
+        m_clock = pNext->time;
+        if (pNext->state == spin_cog_native)
+        {
+            m_native.Run(*this, (int)(pNext - m_cogs), following);
+        }
+        else if (!Step(*pNext))
+        {
+            return spin_run_error;
+        }
+    }
+}
+
+bool SpinInterpreter::GetExitValue(int cog, int& value, bool& bAborted)
+{
+    if (cog < 0 || cog >= cog_count || !m_cogs[cog].bExited)
+    {
+        return false;
+    }
+    value = m_cogs[cog].exitValue;
+    bAborted = m_cogs[cog].bAborted;
+    return true;
+}
+
+const SpinCog* SpinInterpreter::GetCog(int cog)
+{
+    return (cog >= 0 && cog < cog_count) ? &m_cogs[cog] : 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
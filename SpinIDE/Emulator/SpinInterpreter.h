@@ -0,0 +1,175 @@
+//////////////////////////////////////////////////////////////
+//                                                          //
+// Propeller Spin Interpreter (host side)                   //
+// (c)2012 Parallax Inc. DBA Parallax Semiconductor.        //
+// See end of file for terms of use.                        //
+//                                                          //
+//////////////////////////////////////////////////////////////
+//
+// SpinInterpreter.h
+//
+// runs the image written by ComposeRAM() on the host, the way
+// the ROM interpreter would run it on the chip
+//
+
+#ifndef _SPIN_INTERPRETER_H_
+#define _SPIN_INTERPRETER_H_
+
+#define hub_size                    0x10000     // hub addresses are 16 bits
+#define hub_ram_size                0x8000      // the rest is ROM (reads as 0 here)
+#define cog_count                   8
+#define lock_count                  8
+#define spin_interpreter_address    0xF004      // coginit of this address starts a Spin cog
+#define spin_exit_address           0x8000      // returning to ROM (the boot frame returns to $FFF9) stops the cog
+
+enum spinRunResult
+{
+    spin_run_limit = 0,         // ran for the number of clocks asked for
+    spin_run_stopped,           // every cog has stopped
+    spin_run_stalled,           // every running cog is waiting for pins that can't change
+    spin_run_rebooted,          // clkset with the reset bit
+    spin_run_error              // bad bytecode, see GetError()
+};
+
+enum spinCogState
+{
+    spin_cog_stopped = 0,
+    spin_cog_spin,              // running the Spin interpreter
+    spin_cog_native             // running PASM (CogEmulator)
+};
+
+struct SpinCog
+{
+    int             state;
+    long long       time;               // clocks, each cog runs ahead on its own and the one furthest behind goes next
+    unsigned int    regs[16];           // $1F0-$1FF (PAR, CNT, INA, INB, OUTA, OUTB, DIRA, DIRB, CTRA, CTRB, FRQA, FRQB, PHSA, PHSB, VCFG, VSCL)
+    unsigned int    codeAddress;        // where coginit loaded a native cog from
+    int             pbase;
+    int             vbase;
+    int             dbase;
+    int             pcurr;
+    int             dcurr;
+    int             dcall;
+    bool            bWaitPins;          // in WAITPEQ/WAITPNE
+    bool            bWaitEqual;
+    unsigned int    waitMask;
+    unsigned int    waitState;
+    int             waitPort;
+    bool            bExited;            // returned (or aborted) out of its first method
+    bool            bAborted;
+    int             exitValue;
+};
+
+// a variable, register, or register bit field being read/written/modified
+struct SpinTarget
+{
+    bool            bRegister;
+    int             address;            // hub address, or cog register
+    int             size;               // 0 = byte, 1 = word, 2 = long
+    int             lowBit;             // register bit field
+    int             width;
+    bool            bReverse;           // reg[low..high] has its bits reversed
+};
+
+#include "CogEmulator.h"
+
+class SpinInterpreter
+{
+    friend class CogEmulator;
+
+    unsigned char   m_hub[hub_size];
+    SpinCog         m_cogs[cog_count];
+    bool            m_locks[lock_count];
+    bool            m_lockUsed[lock_count];
+    unsigned int    m_inputs;           // what the outside world drives onto port A
+    long long       m_clock;
+    long long       m_bytecodes;
+    int             m_hubAccesses;      // during the current bytecode
+    int             m_extraClocks;      // multiply/divide/square root loops during the current bytecode
+    bool            m_bRebooted;
+    long long       m_pinTime;          // clock of the last change to OUTA/DIRA/inputs, cogs waiting on pins carry on from here
+    char            m_error[128];
+    CogEmulator     m_native;
+
+    unsigned int ReadByte(int address);
+    unsigned int ReadWord(int address);
+    unsigned int ReadLong(int address);
+    void WriteByte(int address, unsigned int value);
+    void WriteWord(int address, unsigned int value);
+    void WriteLong(int address, unsigned int value);
+    unsigned int Read(int address, int size);
+    void Write(int address, int size, unsigned int value);
+
+    void Push(SpinCog& cog, unsigned int value);
+    unsigned int Pop(SpinCog& cog);
+    unsigned int Top(SpinCog& cog);
+    int ReadCodeAddress(SpinCog& cog);
+
+    unsigned int ReadRegister(SpinCog& cog, int reg);
+    void WriteRegister(SpinCog& cog, int reg, unsigned int value);
+    unsigned int PortA();
+    bool CheckPins(SpinCog& cog);
+
+    bool MathOp(unsigned char mathOp, unsigned int value1, unsigned int value2, unsigned int& result);
+    unsigned int ReadTarget(SpinCog& cog, const SpinTarget& target);
+    void WriteTarget(SpinCog& cog, const SpinTarget& target, unsigned int value);
+    bool Access(SpinCog& cog, const SpinTarget& target, int operation);
+    bool UsingOp(SpinCog& cog, const SpinTarget& target);
+    bool Return(SpinCog& cog, unsigned int value, bool bAbort);
+    int CogInit(SpinCog& cog, unsigned int id, unsigned int code, unsigned int par);
+    void StartSpinCog(int id, unsigned int par, long long time);
+    bool Fail(SpinCog& cog, const char* pMessage);
+    bool Step(SpinCog& cog);
+
+public:
+    SpinInterpreter();
+
+    // image is the binary or eeprom image from ComposeRAM(), starts cog 0 the way the boot loader does
+    bool Load(const unsigned char* pImage, int imageSize);
+
+    // stops every cog and calls a method of the top object on cog 0 (the hub is left as it is)
+    // subIndex is the 1 based index of the method (PUBs then PRIs, in source order)
+    bool CallMethod(int subIndex, const int* pParams, int paramCount);
+
+    // runs for up to the given number of clocks, returns a spinRunResult
+    int Run(long long clocks);
+
+    bool GetExitValue(int cog, int& value, bool& bAborted);
+    const SpinCog* GetCog(int cog);
+    const NativeCog* GetNativeCog(int cog)  { return m_native.GetCog(cog); }
+
+    unsigned char* GetHub()                 { return m_hub; }
+    unsigned int ReadHubLong(int address)   { return ReadLong(address); }
+    void WriteHubLong(int address, unsigned int value) { WriteLong(address, value); }
+
+    void SetInputs(unsigned int inputs)     { m_inputs = inputs; m_pinTime = m_clock; }
+    unsigned int GetOutputs();              // OR of OUTA of the cogs, where DIRA is set
+    unsigned int GetDirections();           // OR of DIRA of the cogs
+
+    long long GetClock()                    { return m_clock; }
+    long long GetBytecodeCount()            { return m_bytecodes; }
+    const char* GetError()                  { return m_error; }
+};
+
+#endif // _SPIN_INTERPRETER_H_
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,465 @@
+///////////////////////////////////////////////////////////////
+//                                                           //
+// Propeller Spin/PASM Compiler Command Line Tool 'OpenSpin' //
+// (c)2012-2013 Parallax Inc. DBA Parallax Semiconductor.    //
+// See end of file for terms of use.                         //
+//                                                           //
+///////////////////////////////////////////////////////////////
+//
+// batch.cpp
+//
+// The heap holds one compile of each object name, so each object it holds
+// has a key: a hash of the defines in effect when its source was
+// preprocessed and of the preprocessed source. Within a build the first
+// compile of an object is the one the heap keeps (as in a build on its
+// own). An object from a build before is only used if its key is the same
+// and so are the keys of the objects in it that this build has already
+// settled on, otherwise it is compiled again and replaces the old one.
+// The DAT files an object includes aren't in its source, so it also keeps
+// a hash of the path each FILE name resolved to and of that file's bytes,
+// and the names are resolved again (in this build's path) to check them.
+//
+#include <stdio.h>
+#include <string.h>
+
+#include "../PropellerCompiler/PropellerCompiler.h"
+#include "../PropellerCompiler/Utilities.h"
+#include "objectheap.h"
+#include "depfile.h"
+#include "preprocess.h"
+#include "pathentry.h"
+#include "datcache.h"
+#include "batch.h"
+
+// an object in the heap, with the keys of the sub-objects it was compiled with
+class BatchObject : public Hashable
+{
+public:
+    char*               m_pName;
+    unsigned long long  m_key;
+    int                 m_target;           // the last build that used it
+    char*               m_pObjFilenames;    // 256 bytes each
+    unsigned long long* m_pObjKeys;
+    int                 m_nObjFiles;
+    char*               m_pDatFilenames;    // 256 bytes each
+    unsigned long long* m_pDatKeys;
+    int                 m_nDatFiles;
+
+    BatchObject(const char* pName)
+        : m_key(0)
+        , m_target(-1)
+        , m_pObjFilenames(NULL)
+        , m_pObjKeys(NULL)
+        , m_nObjFiles(0)
+        , m_pDatFilenames(NULL)
+        , m_pDatKeys(NULL)
+        , m_nDatFiles(0)
+    {
+        m_pName = new char[strlen(pName) + 1];
+        strcpy(m_pName, pName);
+    }
+    virtual ~BatchObject()
+    {
+        delete [] m_pName;
+        delete [] m_pObjFilenames;
+        delete [] m_pObjKeys;
+        delete [] m_pDatFilenames;
+        delete [] m_pDatKeys;
+    }
+};
+
+static BatchTarget* s_targets = NULL;
+static int s_nTargets = 0;
+static int s_nTargetsSize = 0;
+static HashTable* s_pObjects = NULL;    // case folded name -> BatchObject (names are only entered once)
+static int s_nTarget = -1;              // the build running now
+
+static char* CopyString(const char* pString)
+{
+    char* pCopy = new char[strlen(pString) + 1];
+    strcpy(pCopy, pString);
+    return pCopy;
+}
+
+static BatchTarget* NewBatchTarget(const char* pFilename)
+{
+    if (s_nTargets >= s_nTargetsSize)
+    {
+        int newSize = (s_nTargetsSize > 0) ? s_nTargetsSize * 2 : BatchTargetInitialSize;
+        BatchTarget* pNewTargets = new BatchTarget[newSize];
+        if (s_targets)
+        {
+            memcpy(pNewTargets, s_targets, s_nTargets * sizeof(BatchTarget));
+            delete [] s_targets;
+        }
+        s_targets = pNewTargets;
+        s_nTargetsSize = newSize;
+    }
+
+    BatchTarget& target = s_targets[s_nTargets++];
+    target.pFilename = CopyString(pFilename);
+    target.pOutputFilename = NULL;
+    target.ppDefines = NULL;
+    target.defineCount = 0;
+    return &target;
+}
+
+bool AddBatchTarget(const char* pFilename)
+{
+    return NewBatchTarget(pFilename) != NULL;
+}
+
+static bool IsSpace(char ch)
+{
+    return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+// the next word of the line (NULL at the end or at a # comment), double quotes can go around spaces
+static char* NextWord(char*& pLine)
+{
+    while (IsSpace(*pLine))
+    {
+        pLine++;
+    }
+    if (*pLine == 0 || *pLine == '#')
+    {
+        return NULL;
+    }
+
+    char* pWord = pLine;
+    char* pOut = pLine;
+    bool bQuoted = false;
+    for (; *pLine && (bQuoted || !IsSpace(*pLine)); pLine++)
+    {
+        if (*pLine == '"')
+        {
+            bQuoted = !bQuoted;
+        }
+        else
+        {
+            *pOut++ = *pLine;
+        }
+    }
+    if (*pLine)
+    {
+        pLine++;
+    }
+    *pOut = 0;
+    return pWord;
+}
+
+bool ReadBatchResponseFile(const char* pPath)
+{
+    FILE* pFile = fopen(pPath, "r");
+    if (!pFile)
+    {
+        fprintf(GetStdout(), "%s : error : Can not find/open file.\n", pPath);
+        return false;
+    }
+
+    char line[BatchLineLimit];
+    int lineNumber = 0;
+    bool bOk = true;
+    while (bOk && fgets(line, sizeof(line), pFile) != NULL)
+    {
+        lineNumber++;
+        if (strchr(line, '\n') == NULL)
+        {
+            // no newline is only fine at the end of the file, otherwise the rest of the line didn't fit
+            int c = fgetc(pFile);
+            if (c != EOF)
+            {
+                fprintf(GetStdout(), "%s(%d) : error : Line is longer than %d characters.\n", pPath, lineNumber, BatchLineLimit - 2);
+                bOk = false;
+                break;
+            }
+        }
+        char* pLine = line;
+        char* pToken = NextWord(pLine);
+        if (!pToken)
+        {
+            continue;
+        }
+        if (pToken[0] == '-')
+        {
+            fprintf(GetStdout(), "%s(%d) : error : Expected a spin file before %s.\n", pPath, lineNumber, pToken);
+            bOk = false;
+            break;
+        }
+
+        BatchTarget* pTarget = NewBatchTarget(pToken);
+        char* defines[BatchLineLimit / 2];
+        while (bOk && (pToken = NextWord(pLine)) != NULL)
+        {
+            // -D<define> or -D <define>, -o<path> or -o <path>
+            char* pValue = NULL;
+            if (pToken[0] == '-' && (pToken[1] == 'D' || pToken[1] == 'o'))
+            {
+                pValue = pToken[2] ? &pToken[2] : NextWord(pLine);
+            }
+            if (!pValue)
+            {
+                fprintf(GetStdout(), "%s(%d) : error : Expected -D <define> or -o <path>, not %s.\n", pPath, lineNumber, pToken);
+                bOk = false;
+            }
+            else if (pToken[1] == 'D')
+            {
+                defines[pTarget->defineCount++] = pValue;
+            }
+            else
+            {
+                delete [] pTarget->pOutputFilename;
+                pTarget->pOutputFilename = CopyString(pValue);
+            }
+        }
+
+        if (pTarget->defineCount > 0)
+        {
+            pTarget->ppDefines = new char*[pTarget->defineCount];
+            for (int i = 0; i < pTarget->defineCount; i++)
+            {
+                pTarget->ppDefines[i] = CopyString(defines[i]);
+            }
+        }
+    }
+
+    fclose(pFile);
+    return bOk;
+}
+
+int GetBatchTargetCount()
+{
+    return s_nTargets;
+}
+
+const BatchTarget* GetBatchTarget(int index)
+{
+    return (index >= 0 && index < s_nTargets) ? &s_targets[index] : NULL;
+}
+
+void BeginBatchTarget()
+{
+    s_nTarget++;
+}
+
+unsigned long long GetBatchDefinesKey(void* definestate)
+{
+    // the defines are in the order they were made, shadowed ones and #undefs (no def) included
+    unsigned long long key = FNVOffsetBasis;
+    for (struct predef* pDefine = (struct predef*)definestate; pDefine != NULL; pDefine = pDefine->next)
+    {
+        char bDefined = (pDefine->def != NULL);
+        key = HashBytes(key, pDefine->name, strlen(pDefine->name) + 1);
+        key = HashBytes(key, &bDefined, 1);
+        if (bDefined)
+        {
+            key = HashBytes(key, pDefine->def, strlen(pDefine->def) + 1);
+        }
+    }
+    return key;
+}
+
+unsigned long long GetBatchObjectKey(unsigned long long definesKey, const char* pSource)
+{
+    return HashBytes(definesKey, pSource, strlen(pSource));
+}
+
+static BatchObject* FindBatchObject(const char* pName)
+{
+    if (!s_pObjects)
+    {
+        return NULL;
+    }
+
+    int hash = s_pObjects->GetStringHashUppercase(pName);
+    for (HashNode* pNode = s_pObjects->FindFirst(hash); pNode != 0; pNode = pNode->pNext)
+    {
+        if (pNode->key == hash && _stricmp(((BatchObject*)pNode->pValue)->m_pName, pName) == 0)
+        {
+            return (BatchObject*)pNode->pValue;
+        }
+    }
+    return NULL;
+}
+
+// the path a FILE name resolves to and the bytes there, 0 if it can't be read
+static unsigned long long GetDatFileKey(const char* pName)
+{
+    const char* pPath = FindFileInPath(pName);
+    const unsigned char* pData = NULL;
+    int length = 0;
+    if (!pPath || !GetDatFileFromCache(pPath, &pData, &length))
+    {
+        return 0;
+    }
+    unsigned long long key = HashBytes(FNVOffsetBasis, pPath, strlen(pPath) + 1);
+    return HashBytes(key, pData, length);
+}
+
+// true if each FILE of pObject is still the one it was compiled with
+static bool CheckDatFiles(BatchObject* pObject)
+{
+    for (int i = 0; i < pObject->m_nDatFiles; i++)
+    {
+        unsigned long long key = GetDatFileKey(&pObject->m_pDatFilenames[i<<8]);
+        if (key == 0 || key != pObject->m_pDatKeys[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// the object is in the heap, compiled with this key
+static bool IsInHeap(BatchObject* pObject, unsigned long long key)
+{
+    return pObject && pObject->m_key == key && IndexOfObjectInHeap(pObject->m_pName) != -1;
+}
+
+// true if each sub-object in the heap is the one compiled into pObject
+static bool CheckSubObjects(BatchObject* pObject)
+{
+    for (int i = 0; i < pObject->m_nObjFiles; i++)
+    {
+        BatchObject* pSubObject = FindBatchObject(&pObject->m_pObjFilenames[i<<8]);
+        if (!IsInHeap(pSubObject, pObject->m_pObjKeys[i]))
+        {
+            return false;
+        }
+        if (pSubObject->m_target != s_nTarget && (!CheckDatFiles(pSubObject) || !CheckSubObjects(pSubObject)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void UseSubObjects(BatchObject* pObject)
+{
+    pObject->m_target = s_nTarget;
+    for (int i = 0; i < pObject->m_nObjFiles; i++)
+    {
+        BatchObject* pSubObject = FindBatchObject(&pObject->m_pObjFilenames[i<<8]);
+        if (pSubObject->m_target != s_nTarget)
+        {
+            UseSubObjects(pSubObject);
+        }
+    }
+}
+
+bool UseBatchObject(const char* pName, unsigned long long key)
+{
+    BatchObject* pObject = FindBatchObject(pName);
+    if (!pObject || IndexOfObjectInHeap(pObject->m_pName) == -1)
+    {
+        return false;
+    }
+
+    // this build already has it, a build on its own would only keep the first compile too
+    if (pObject->m_target == s_nTarget)
+    {
+        return true;
+    }
+
+    if (pObject->m_key == key && CheckDatFiles(pObject) && CheckSubObjects(pObject))
+    {
+        UseSubObjects(pObject);
+        return true;
+    }
+
+    RemoveObjectFromHeap(pObject->m_pName);
+    return false;
+}
+
+void ForgetBatchObject(const char* pName)
+{
+    BatchObject* pObject = FindBatchObject(pName);
+    if (pObject && pObject->m_target != s_nTarget)
+    {
+        RemoveObjectFromHeap(pObject->m_pName);
+    }
+}
+
+void EnterBatchObject(const char* pName, unsigned long long key, const char* pObjFilenames, int objFileCount, const char* pDatFilenames, int datFileCount)
+{
+    BatchObject* pObject = FindBatchObject(pName);
+    if (!pObject)
+    {
+        if (!s_pObjects)
+        {
+            s_pObjects = new HashTable(BatchIndexSize);
+        }
+        pObject = new BatchObject(pName);
+        s_pObjects->Insert(s_pObjects->GetStringHashUppercase(pName), pObject);
+    }
+
+    delete [] pObject->m_pObjFilenames;
+    delete [] pObject->m_pObjKeys;
+    delete [] pObject->m_pDatFilenames;
+    delete [] pObject->m_pDatKeys;
+    pObject->m_key = key;
+    pObject->m_target = s_nTarget;
+    pObject->m_nObjFiles = objFileCount;
+    pObject->m_pObjFilenames = new char[(objFileCount << 8) + 1];
+    memcpy(pObject->m_pObjFilenames, pObjFilenames, objFileCount << 8);
+    pObject->m_pObjKeys = new unsigned long long[objFileCount + 1];
+    for (int i = 0; i < objFileCount; i++)
+    {
+        // the sub-objects were all settled on by this build before their parent was compiled
+        BatchObject* pSubObject = FindBatchObject(&pObjFilenames[i<<8]);
+        pObject->m_pObjKeys[i] = pSubObject ? pSubObject->m_key : 0;
+    }
+    pObject->m_nDatFiles = datFileCount;
+    pObject->m_pDatFilenames = new char[(datFileCount << 8) + 1];
+    memcpy(pObject->m_pDatFilenames, pDatFilenames, datFileCount << 8);
+    pObject->m_pDatKeys = new unsigned long long[datFileCount + 1];
+    for (int i = 0; i < datFileCount; i++)
+    {
+        // the files were just loaded for this compile, so this finds them in the DAT file cache
+        pObject->m_pDatKeys[i] = GetDatFileKey(&pDatFilenames[i<<8]);
+    }
+}
+
+void CleanBatch()
+{
+    for (int i = 0; i < s_nTargets; i++)
+    {
+        delete [] s_targets[i].pFilename;
+        delete [] s_targets[i].pOutputFilename;
+        for (int j = 0; j < s_targets[i].defineCount; j++)
+        {
+            delete [] s_targets[i].ppDefines[j];
+        }
+        delete [] s_targets[i].ppDefines;
+    }
+    delete [] s_targets;
+    s_targets = NULL;
+    s_nTargets = 0;
+    s_nTargetsSize = 0;
+    delete s_pObjects;
+    s_pObjects = NULL;
+    s_nTarget = -1;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
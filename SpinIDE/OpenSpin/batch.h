@@ -0,0 +1,67 @@
+///////////////////////////////////////////////////////////////
+//                                                           //
+// Propeller Spin/PASM Compiler Command Line Tool 'OpenSpin' //
+// (c)2012-2013 Parallax Inc. DBA Parallax Semiconductor.    //
+// See end of file for terms of use.                         //
+//                                                           //
+///////////////////////////////////////////////////////////////
+//
+// batch.h
+//
+
+//
+// batch mode (more than one spin file, or @ response files, on the command line): each spin file is built
+// the way a build of it alone would be, but the object heap is kept from one build to the next, and a
+// sub-object is used from it as it is when it was compiled from the same preprocessed source and defines
+//
+
+#define BatchIndexSize          256
+#define BatchTargetInitialSize  16      // grows as needed
+#define BatchLineLimit          1024
+
+struct BatchTarget
+{
+    char*   pFilename;
+    char*   pOutputFilename;    // NULL to name it after the spin file
+    char**  ppDefines;          // -D names from its response file line
+    int     defineCount;
+};
+
+bool AddBatchTarget(const char* pFilename);
+bool ReadBatchResponseFile(const char* pPath);          // a line for each spin file: name.spin [-D <define>]... [-o <path>]
+                                                        // ("quotes" around spaces, # starts a comment)
+int GetBatchTargetCount();
+const BatchTarget* GetBatchTarget(int index);
+
+// the recording is done as each build runs
+void BeginBatchTarget();                                            // the objects from the builds before have to be checked before they are used
+unsigned long long GetBatchDefinesKey(void* definestate);           // taken before the source is preprocessed (that clears the defines)
+unsigned long long GetBatchObjectKey(unsigned long long definesKey, const char* pSource);
+bool UseBatchObject(const char* pName, unsigned long long key);     // true if the heap's pName, and every object in it, is what compiling it would give
+void ForgetBatchObject(const char* pName);                          // takes pName out of the heap if it is from a build before this one
+void EnterBatchObject(const char* pName, unsigned long long key, const char* pObjFilenames, int objFileCount, const char* pDatFilenames, int datFileCount);
+void CleanBatch();
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
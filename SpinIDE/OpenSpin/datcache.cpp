@@ -0,0 +1,226 @@
+///////////////////////////////////////////////////////////////
+//                                                           //
+// Propeller Spin/PASM Compiler Command Line Tool 'OpenSpin' //
+// (c)2012-2013 Parallax Inc. DBA Parallax Semiconductor.    //
+// See end of file for terms of use.                         //
+//                                                           //
+///////////////////////////////////////////////////////////////
+//
+// datcache.cpp
+//
+// DAT files are memory mapped (read in on WIN32) the first time they are
+// used, and shared by every object that includes them for the rest of the
+// build. An entry is reloaded if the file's size or modification time
+// (to the nanosecond, where the platform has it) changes, or if another
+// file now has its path (the device or inode differ).
+//
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifndef WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "../PropellerCompiler/Utilities.h"
+#include "datcache.h"
+
+// the sub-second part of the modification time, saves within the same second still count
+static long GetModifiedNanoseconds(const struct stat& statBuffer)
+{
+#if defined(WIN32)
+    (void)statBuffer;
+    return 0;
+#elif defined(__APPLE__)
+    return statBuffer.st_mtimespec.tv_nsec;
+#else
+    return statBuffer.st_mtim.tv_nsec;
+#endif
+}
+
+class DatFile : public Hashable
+{
+public:
+    char*           m_pPath;
+    dev_t           m_dev;
+    ino_t           m_ino;
+    time_t          m_mtime;
+    long            m_mtimeNsec;
+    off_t           m_size;
+    unsigned char*  m_pData;
+    bool            m_bMapped;
+
+    DatFile(const char* pPath)
+        : m_dev(0)
+        , m_ino(0)
+        , m_mtime(0)
+        , m_mtimeNsec(0)
+        , m_size(0)
+        , m_pData(NULL)
+        , m_bMapped(false)
+    {
+        m_pPath = new char[strlen(pPath) + 1];
+        strcpy(m_pPath, pPath);
+    }
+    virtual ~DatFile()
+    {
+        Unload();
+        delete [] m_pPath;
+    }
+
+    bool Load(const struct stat& statBuffer)
+    {
+        Unload();
+        m_size = statBuffer.st_size;
+        if (m_size > 0 && !MapOrRead())
+        {
+            // leave the entry looking stale so the next lookup tries again
+            Unload();
+            m_mtime = 0;
+            return false;
+        }
+        m_dev = statBuffer.st_dev;
+        m_ino = statBuffer.st_ino;
+        m_mtime = statBuffer.st_mtime;
+        m_mtimeNsec = GetModifiedNanoseconds(statBuffer);
+        return true;
+    }
+
+    // a different file at the path (renamed over it) or a different time or size
+    bool IsStale(const struct stat& statBuffer) const
+    {
+        return m_dev != statBuffer.st_dev || m_ino != statBuffer.st_ino ||
+               m_mtime != statBuffer.st_mtime || m_mtimeNsec != GetModifiedNanoseconds(statBuffer) ||
+               m_size != statBuffer.st_size;
+    }
+
+private:
+    bool MapOrRead()
+    {
+#ifndef WIN32
+        int fd = open(m_pPath, O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+        void* pMap = mmap(NULL, (size_t)m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (pMap != MAP_FAILED)
+        {
+            m_pData = (unsigned char*)pMap;
+            m_bMapped = true;
+            return true;
+        }
+#endif
+        // no mapping available, so read it in
+        FILE* pFile = fopen(m_pPath, "rb");
+        if (!pFile)
+        {
+            return false;
+        }
+        m_pData = new unsigned char[m_size];
+        bool bResult = (fread(m_pData, 1, (size_t)m_size, pFile) == (size_t)m_size);
+        fclose(pFile);
+        return bResult;
+    }
+
+    void Unload()
+    {
+        if (m_pData)
+        {
+#ifndef WIN32
+            if (m_bMapped)
+            {
+                munmap(m_pData, (size_t)m_size);
+            }
+            else
+#endif
+            {
+                delete [] m_pData;
+            }
+        }
+        m_pData = NULL;
+        m_bMapped = false;
+        m_size = 0;
+    }
+};
+
+static HashTable* s_pDatFiles = NULL;
+
+bool GetDatFileFromCache(const char* pPath, const unsigned char** ppData, int* pnLength)
+{
+    struct stat statBuffer;
+    if (stat(pPath, &statBuffer) != 0)
+    {
+        return false;
+    }
+
+    if (!s_pDatFiles)
+    {
+        s_pDatFiles = new HashTable(DatFileCacheIndexSize);
+    }
+
+    DatFile* pDatFile = NULL;
+    int hash = s_pDatFiles->GetStringHash(pPath);
+    for (HashNode* pNode = s_pDatFiles->FindFirst(hash); pNode != 0; pNode = pNode->pNext)
+    {
+        if (pNode->key == hash && strcmp(((DatFile*)pNode->pValue)->m_pPath, pPath) == 0)
+        {
+            pDatFile = (DatFile*)pNode->pValue;
+            break;
+        }
+    }
+
+    if (!pDatFile)
+    {
+        pDatFile = new DatFile(pPath);
+        if (!pDatFile->Load(statBuffer))
+        {
+            delete pDatFile;
+            return false;
+        }
+        s_pDatFiles->Insert(hash, pDatFile);
+    }
+    else if (pDatFile->IsStale(statBuffer))
+    {
+        // the file changed since it was cached
+        if (!pDatFile->Load(statBuffer))
+        {
+            return false;
+        }
+    }
+
+    *ppData = pDatFile->m_pData;
+    *pnLength = (int)pDatFile->m_size;
+    return true;
+}
+
+void CleanDatFileCache()
+{
+    delete s_pDatFiles;
+    s_pDatFiles = NULL;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,220 @@
+///////////////////////////////////////////////////////////////
+//                                                           //
+// Propeller Spin/PASM Compiler Command Line Tool 'OpenSpin' //
+// (c)2012-2013 Parallax Inc. DBA Parallax Semiconductor.    //
+// See end of file for terms of use.                         //
+//                                                           //
+///////////////////////////////////////////////////////////////
+//
+// depfile.cpp
+//
+// The dependency file is in the form make and ninja read (what gcc -MD
+// writes), the target is the output file and it depends on every file
+// the build opened: the spin files, #includes and DAT files.
+//
+// The manifest is text, a line with the version and the hash of the
+// command line, then a line for each file:
+//
+//      in <hash> <path>        a file the build read
+//      out <hash> <path>       a file the build wrote
+//
+// The hashes are 64 bit FNV-1a of the file's contents, a missing file is
+// written as - so a file that turns up where there wasn't one is a change.
+//
+#include <stdio.h>
+#include <string.h>
+
+#include "pathentry.h"
+#include "depfile.h"
+
+#define HashReadSize        0x10000
+
+unsigned long long HashBytes(unsigned long long hash, const void* pData, size_t length)
+{
+    const unsigned char* pBytes = (const unsigned char*)pData;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ pBytes[i]) * FNVPrime;
+    }
+    return hash;
+}
+
+// false if the file can't be read
+static bool HashFile(const char* pPath, unsigned long long& hash)
+{
+    FILE* pFile = fopen(pPath, "rb");
+    if (!pFile)
+    {
+        return false;
+    }
+
+    static unsigned char buffer[HashReadSize];
+    hash = FNVOffsetBasis;
+    size_t length;
+    while ((length = fread(buffer, 1, HashReadSize, pFile)) > 0)
+    {
+        hash = HashBytes(hash, buffer, length);
+    }
+    bool bError = ferror(pFile) != 0;
+    fclose(pFile);
+    return !bError;
+}
+
+unsigned long long HashOptions(int argc, char* argv[])
+{
+    unsigned long long hash = FNVOffsetBasis;
+    for (int i = 0; i < argc; i++)
+    {
+        // the terminating zero keeps "-a b" apart from "-ab"
+        hash = HashBytes(hash, argv[i], strlen(argv[i]) + 1);
+    }
+    return hash;
+}
+
+static void WriteDepFilePath(FILE* pFile, const char* pPath)
+{
+    for (const char* p = pPath; *p; p++)
+    {
+        if (*p == ' ' || *p == '#')
+        {
+            fputc('\\', pFile);
+        }
+        else if (*p == '$')
+        {
+            fputc('$', pFile);
+        }
+        fputc(*p, pFile);
+    }
+}
+
+bool WriteDepFile(const char* pDepFilename, const char* pTarget, const char** ppFiles, int fileCount)
+{
+    FILE* pFile = fopen(pDepFilename, "w");
+    if (!pFile)
+    {
+        return false;
+    }
+
+    WriteDepFilePath(pFile, pTarget);
+    fputc(':', pFile);
+    for (int i = 0; i < fileCount; i++)
+    {
+        fputs(" \\\n  ", pFile);
+        WriteDepFilePath(pFile, ppFiles[i]);
+    }
+    fputc('\n', pFile);
+
+    bool bError = ferror(pFile) != 0;
+    return (fclose(pFile) == 0) && !bError;
+}
+
+static void WriteManifestFile(FILE* pFile, const char* pKind, const char* pPath)
+{
+    unsigned long long hash;
+    if (HashFile(pPath, hash))
+    {
+        fprintf(pFile, "%s %016llx %s\n", pKind, hash, pPath);
+    }
+    else
+    {
+        fprintf(pFile, "%s - %s\n", pKind, pPath);
+    }
+}
+
+bool WriteManifest(const char* pManifestFilename, unsigned long long optionsHash,
+                   const char** ppInputs, int inputCount, const char** ppOutputs, int outputCount)
+{
+    FILE* pFile = fopen(pManifestFilename, "w");
+    if (!pFile)
+    {
+        return false;
+    }
+
+    fprintf(pFile, "openspin manifest %d %016llx\n", ManifestVersion, optionsHash);
+    for (int i = 0; i < inputCount; i++)
+    {
+        WriteManifestFile(pFile, "in", ppInputs[i]);
+    }
+    for (int i = 0; i < outputCount; i++)
+    {
+        WriteManifestFile(pFile, "out", ppOutputs[i]);
+    }
+
+    bool bError = ferror(pFile) != 0;
+    return (fclose(pFile) == 0) && !bError;
+}
+
+bool IsUpToDate(const char* pManifestFilename, unsigned long long optionsHash)
+{
+    FILE* pFile = fopen(pManifestFilename, "r");
+    if (!pFile)
+    {
+        return false;
+    }
+
+    char line[PATH_MAX + 64];
+    int version = 0;
+    unsigned long long manifestOptionsHash = 0;
+    bool bUpToDate = fgets(line, sizeof(line), pFile) != NULL &&
+                     sscanf(line, "openspin manifest %d %llx", &version, &manifestOptionsHash) == 2 &&
+                     version == ManifestVersion && manifestOptionsHash == optionsHash;
+
+    bool bHasOutput = false;
+    while (bUpToDate && fgets(line, sizeof(line), pFile) != NULL)
+    {
+        // <kind> <hash> <path>, the path is the rest of the line
+        char* pEnd = line + strcspn(line, "\r\n");
+        *pEnd = 0;
+        char* pHash = strchr(line, ' ');
+        char* pPath = pHash ? strchr(pHash + 1, ' ') : NULL;
+        if (!pPath)
+        {
+            bUpToDate = false;
+            break;
+        }
+        *pHash++ = 0;
+        *pPath++ = 0;
+
+        unsigned long long hash;
+        if (HashFile(pPath, hash))
+        {
+            char hashText[32];
+            sprintf(hashText, "%016llx", hash);
+            bUpToDate = strcmp(pHash, hashText) == 0;
+        }
+        else
+        {
+            bUpToDate = strcmp(pHash, "-") == 0;
+        }
+        if (strcmp(line, "out") == 0)
+        {
+            bHasOutput = true;
+        }
+    }
+
+    fclose(pFile);
+    return bUpToDate && bHasOutput;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
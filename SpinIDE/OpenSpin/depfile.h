@@ -0,0 +1,56 @@
+///////////////////////////////////////////////////////////////
+//                                                           //
+// Propeller Spin/PASM Compiler Command Line Tool 'OpenSpin' //
+// (c)2012-2013 Parallax Inc. DBA Parallax Semiconductor.    //
+// See end of file for terms of use.                         //
+//                                                           //
+///////////////////////////////////////////////////////////////
+//
+// depfile.h
+//
+
+//
+// incremental build support: a make/ninja dependency file (-MD/-MF options) and a manifest
+// of content hashes (-MH option) that lets a build be skipped when nothing it read has changed
+//
+
+#define ManifestVersion     1
+#define FNVOffsetBasis      0xCBF29CE484222325ULL
+#define FNVPrime            0x100000001B3ULL
+
+unsigned long long HashBytes(unsigned long long hash, const void* pData, size_t length);    // 64 bit FNV-1a, start with FNVOffsetBasis
+unsigned long long HashOptions(int argc, char* argv[]);    // the command line, a different one means a different build
+
+// pTarget depends on every file in ppFiles (paths with spaces, $ and # are escaped)
+bool WriteDepFile(const char* pDepFilename, const char* pTarget, const char** ppFiles, int fileCount);
+
+// the manifest holds the content hash of each file the build read and each file it wrote
+bool WriteManifest(const char* pManifestFilename, unsigned long long optionsHash,
+                   const char** ppInputs, int inputCount, const char** ppOutputs, int outputCount);
+
+// true if the manifest is from a build with the same options, and none of its files have changed (or gone missing)
+bool IsUpToDate(const char* pManifestFilename, unsigned long long optionsHash);
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
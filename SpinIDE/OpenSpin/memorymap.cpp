@@ -0,0 +1,649 @@
+///////////////////////////////////////////////////////////////
+//                                                           //
+// Propeller Spin/PASM Compiler Command Line Tool 'OpenSpin' //
+// (c)2012-2013 Parallax Inc. DBA Parallax Semiconductor.    //
+// See end of file for terms of use.                         //
+//                                                           //
+///////////////////////////////////////////////////////////////
+//
+// memorymap.cpp
+//
+// The sizes all come from the final (distilled) image, so objects shared
+// by the distiller are only counted once. Each Compile2() leaves the
+// method names and the file of each OBJ entry behind, those are recorded
+// per filename and used to name what is found in the image.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../PropellerCompiler/PropellerCompiler.h"
+#include "../PropellerCompiler/Utilities.h"
+#include "../PropellerCompiler/SpinBytecode.h"
+#include "memorymap.h"
+
+#define MemoryMapDepthLimit     16      // same as the object nesting limit
+#define MemoryMapSubLimit       256     // sub index is a byte
+
+// what a Compile2() of one object file left behind
+class MapObjectInfo : public Hashable
+{
+public:
+    char*   m_pFilename;
+    char*   m_pMethodNames[MemoryMapSubLimit];  // by sub index - 1 (PUBs then PRIs)
+    bool    m_bMethodPub[MemoryMapSubLimit];
+    int     m_methodCount;
+    char*   m_pEntryFiles[MemoryMapSubLimit];   // filename of each OBJ entry
+    int     m_entryCount;
+    int     m_stackLongs;
+    int     m_distilledLongs;
+    int     m_foldedLongs;
+
+    MapObjectInfo(const char* pFilename)
+        : m_methodCount(0)
+        , m_entryCount(0)
+        , m_stackLongs(0)
+        , m_distilledLongs(0)
+        , m_foldedLongs(0)
+    {
+        m_pFilename = new char[strlen(pFilename) + 1];
+        strcpy(m_pFilename, pFilename);
+        memset(m_pMethodNames, 0, sizeof(m_pMethodNames));
+    }
+    virtual ~MapObjectInfo()
+    {
+        Clear();
+        delete [] m_pFilename;
+    }
+
+    void Clear()
+    {
+        for (int i = 0; i < MemoryMapSubLimit; i++)
+        {
+            delete [] m_pMethodNames[i];
+            m_pMethodNames[i] = NULL;
+        }
+        for (int i = 0; i < m_entryCount; i++)
+        {
+            delete [] m_pEntryFiles[i];
+        }
+        m_methodCount = 0;
+        m_entryCount = 0;
+    }
+};
+
+// an object in the final image (each one is only there once)
+struct MapObject
+{
+    MapObjectInfo*  pInfo;          // may be NULL if the names weren't recorded
+    int             base;           // offset of the object in the image (after the vsize/psize long)
+    int             instances;
+    int             objectBytes;    // everything up to the sub-objects
+    int             indexBytes;     // header, PUB/PRI index, and OBJ index
+    int             datBytes;
+    int             codeBytes;      // PUB/PRI bytecode
+    int             stringBytes;    // string constants (after the bytecode of each method)
+    int             varBytes;       // own VAR bytes per instance (not counting sub-objects)
+    int             firstMethod;    // into s_pMethods
+    int             methodCount;
+};
+
+struct MapMethod
+{
+    int     object;         // into s_pObjects
+    int     subIndex;
+    int     start;
+    int     bytes;          // bytecode and strings
+    int     stringBytes;
+    bool    bShared;        // body lives in another object (method folding)
+};
+
+struct MapInstance
+{
+    int     object;         // into s_pObjects
+    int     parent;         // into s_pInstances, -1 for the top
+    int     depth;
+    int     varAddress;     // in VAR space
+    int     varBytes;       // including sub-objects
+};
+
+static HashTable* s_pObjectInfos = NULL;
+static MapObject* s_pObjects = NULL;
+static int s_nObjects = 0;
+static int s_nObjectsSize = 0;
+static MapMethod* s_pMethods = NULL;
+static int s_nMethods = 0;
+static int s_nMethodsSize = 0;
+static MapInstance* s_pInstances = NULL;
+static int s_nInstances = 0;
+static int s_nInstancesSize = 0;
+
+static const unsigned char* s_pImage = NULL;
+static int s_imageEnd = 0;
+static char s_topFilename[256];
+static int s_programBytes = 0;
+static int s_variableBytes = 0;
+static int s_stackLongs = 0;
+static int s_freeBytes = 0;
+static int s_eepromSize = 0;
+
+static MapObjectInfo* FindObjectInfo(const char* pFilename, bool bCreate)
+{
+    if (!s_pObjectInfos)
+    {
+        if (!bCreate)
+        {
+            return NULL;
+        }
+        s_pObjectInfos = new HashTable(MemoryMapIndexSize);
+    }
+
+    int hash = s_pObjectInfos->GetStringHashUppercase(pFilename);
+    for (HashNode* pNode = s_pObjectInfos->FindFirst(hash); pNode != 0; pNode = pNode->pNext)
+    {
+        if (pNode->key == hash && _stricmp(((MapObjectInfo*)pNode->pValue)->m_pFilename, pFilename) == 0)
+        {
+            return (MapObjectInfo*)pNode->pValue;
+        }
+    }
+
+    if (!bCreate)
+    {
+        return NULL;
+    }
+    MapObjectInfo* pInfo = new MapObjectInfo(pFilename);
+    s_pObjectInfos->Insert(hash, pInfo);
+    return pInfo;
+}
+
+static char* CopyString(const char* pString, int length)
+{
+    char* pCopy = new char[length + 1];
+    memcpy(pCopy, pString, length);
+    pCopy[length] = 0;
+    return pCopy;
+}
+
+void EnterObjectIntoMemoryMap(const char* pFilename, CompilerData* pCompilerData)
+{
+    MapObjectInfo* pInfo = FindObjectInfo(pFilename, true);
+    pInfo->Clear();
+
+    for (int i = 0; i < pCompilerData->info_count; i++)
+    {
+        if (pCompilerData->info_type[i] != info_pub && pCompilerData->info_type[i] != info_pri)
+        {
+            continue;
+        }
+        int index = pCompilerData->info_data4[i] & 0xFFFF;
+        if (index < 0 || index >= MemoryMapSubLimit)
+        {
+            continue;
+        }
+        delete [] pInfo->m_pMethodNames[index];
+        pInfo->m_pMethodNames[index] = CopyString(&pCompilerData->source[pCompilerData->info_data2[i]], pCompilerData->info_data3[i] - pCompilerData->info_data2[i]);
+        pInfo->m_bMethodPub[index] = (pCompilerData->info_type[i] == info_pub);
+        if (index >= pInfo->m_methodCount)
+        {
+            pInfo->m_methodCount = index + 1;
+        }
+    }
+
+    for (int i = 0; i < pCompilerData->obj_entry_count && i < MemoryMapSubLimit; i++)
+    {
+        // same name the caller gives the sub-object
+        char filename[256+8];
+        strcpy(filename, &(pCompilerData->obj_filenames[pCompilerData->obj_entry_files[i]<<8]));
+        if (strstr(filename, ".spin") == NULL)
+        {
+            strcat(filename, ".spin");
+        }
+        pInfo->m_pEntryFiles[i] = CopyString(filename, (int)strlen(filename));
+        pInfo->m_entryCount++;
+    }
+
+    pInfo->m_stackLongs = pCompilerData->stack_requirement;
+    pInfo->m_distilledLongs = pCompilerData->distilled_longs;
+    pInfo->m_foldedLongs = pCompilerData->folded_longs;
+}
+
+static int ReadWord(int offset)
+{
+    return (int)s_pImage[offset] | ((int)s_pImage[offset + 1] << 8);
+}
+
+// index table entries are added to the object base, wrapping at 16 bits like hub addresses do
+static int MethodStart(int base, int offset)
+{
+    return 4 + (((base - 4) + offset) & 0xFFFF);
+}
+
+// string constants go after the bytecode of the method that uses them, and are
+// the only 2 byte pbase relative byte references that point inside a method
+static int CountStringBytes(int base, int start, int end)
+{
+    int stringStart = end;
+    int pos = start;
+    while (pos < stringStart)
+    {
+        SpinInstruction instruction;
+        if (!DecodeSpinInstruction(s_pImage, pos, stringStart, instruction))
+        {
+            break;
+        }
+        if (instruction.opcode == 0x87 && instruction.varBytes == 3)
+        {
+            int target = base + instruction.varAddress;
+            if (target > pos && target < stringStart)
+            {
+                stringStart = target;
+            }
+        }
+        pos += instruction.length;
+    }
+    return end - stringStart;
+}
+
+template <typename T> static T* GrowArray(T* pArray, int count, int& size)
+{
+    if (count < size)
+    {
+        return pArray;
+    }
+    int newSize = (size > 0) ? size * 2 : 32;
+    T* pNewArray = new T[newSize];
+    if (pArray)
+    {
+        memcpy(pNewArray, pArray, count * sizeof(T));
+        delete [] pArray;
+    }
+    size = newSize;
+    return pNewArray;
+}
+
+static int EnterObject(int base, MapObjectInfo* pInfo)
+{
+    for (int i = 0; i < s_nObjects; i++)
+    {
+        if (s_pObjects[i].base == base)
+        {
+            s_pObjects[i].instances++;
+            return i;
+        }
+    }
+
+    s_pObjects = GrowArray(s_pObjects, s_nObjects, s_nObjectsSize);
+    MapObject& object = s_pObjects[s_nObjects];
+    memset(&object, 0, sizeof(MapObject));
+    object.pInfo = pInfo;
+    object.base = base;
+    object.instances = 1;
+    object.objectBytes = ReadWord(base);
+    int subCount = s_pImage[base + 2] - 1;
+    int objCount = s_pImage[base + 3];
+    object.indexBytes = 4 + ((subCount + objCount) * 4);
+    object.firstMethod = s_nMethods;
+    object.methodCount = subCount;
+
+    int objectEnd = base + object.objectBytes;
+    int firstStart = objectEnd;
+    for (int i = 1; i <= subCount; i++)
+    {
+        s_pMethods = GrowArray(s_pMethods, s_nMethods, s_nMethodsSize);
+        MapMethod& method = s_pMethods[s_nMethods++];
+        memset(&method, 0, sizeof(MapMethod));
+        method.object = s_nObjects;
+        method.subIndex = i;
+        method.start = MethodStart(base, ReadWord(base + (i * 4)));
+        method.bShared = (method.start < base || method.start >= objectEnd);
+        if (!method.bShared && method.start < firstStart)
+        {
+            firstStart = method.start;
+        }
+    }
+
+    // each method runs up to the next one (the last one to the end of the object)
+    for (int i = object.firstMethod; i < s_nMethods; i++)
+    {
+        MapMethod& method = s_pMethods[i];
+        if (method.bShared)
+        {
+            continue;
+        }
+        int end = objectEnd;
+        for (int j = object.firstMethod; j < s_nMethods; j++)
+        {
+            if (!s_pMethods[j].bShared && s_pMethods[j].start > method.start && s_pMethods[j].start < end)
+            {
+                end = s_pMethods[j].start;
+            }
+        }
+        method.bytes = end - method.start;
+        method.stringBytes = CountStringBytes(base, method.start, end);
+        object.codeBytes += method.bytes - method.stringBytes;
+        object.stringBytes += method.stringBytes;
+    }
+
+    object.datBytes = firstStart - (base + object.indexBytes);
+    if (object.datBytes < 0)
+    {
+        object.datBytes = 0;
+    }
+    return s_nObjects++;
+}
+
+static bool EnterInstance(int base, MapObjectInfo* pInfo, int parent, int depth, int varAddress, int varBytes)
+{
+    if (depth > MemoryMapDepthLimit || base < 4 || base + 4 > s_imageEnd)
+    {
+        return false;
+    }
+
+    int object = EnterObject(base, pInfo);
+
+    s_pInstances = GrowArray(s_pInstances, s_nInstances, s_nInstancesSize);
+    int instance = s_nInstances++;
+    s_pInstances[instance].object = object;
+    s_pInstances[instance].parent = parent;
+    s_pInstances[instance].depth = depth;
+    s_pInstances[instance].varAddress = varAddress;
+    s_pInstances[instance].varBytes = varBytes;
+
+    // each OBJ entry gives the sub-object and where its VAR starts, the object's own VAR is
+    // everything before the first one
+    int objIndex = s_pImage[base + 2] * 4;
+    int objCount = s_pImage[base + 3];
+    int ownVarBytes = varBytes;
+    for (int i = 0; i < objCount; i++)
+    {
+        int entry = base + objIndex + (i * 4);
+        int childBase = base + ReadWord(entry);
+        int childVar = ReadWord(entry + 2);
+        int childVarEnd = (i + 1 < objCount) ? ReadWord(entry + 6) : varBytes;
+        if (i == 0)
+        {
+            ownVarBytes = childVar;
+        }
+
+        MapObjectInfo* pChildInfo = NULL;
+        if (pInfo && i < pInfo->m_entryCount)
+        {
+            pChildInfo = FindObjectInfo(pInfo->m_pEntryFiles[i], false);
+        }
+        if (!EnterInstance(childBase, pChildInfo, instance, depth + 1, varAddress + childVar, childVarEnd - childVar))
+        {
+            return false;
+        }
+    }
+    s_pObjects[object].varBytes = ownVarBytes;
+    return true;
+}
+
+static void ClearMap()
+{
+    delete [] s_pObjects;
+    s_pObjects = NULL;
+    s_nObjects = 0;
+    s_nObjectsSize = 0;
+    delete [] s_pMethods;
+    s_pMethods = NULL;
+    s_nMethods = 0;
+    s_nMethodsSize = 0;
+    delete [] s_pInstances;
+    s_pInstances = NULL;
+    s_nInstances = 0;
+    s_nInstancesSize = 0;
+}
+
+bool BuildMemoryMap(const char* pTopFilename, CompilerData* pCompilerData)
+{
+    ClearMap();
+    strncpy(s_topFilename, pTopFilename, sizeof(s_topFilename) - 1);
+    s_topFilename[sizeof(s_topFilename) - 1] = 0;
+
+    // the image is the vsize/psize long followed by the top object and its sub-objects
+    s_pImage = pCompilerData->obj;
+    s_programBytes = pCompilerData->psize;
+    s_variableBytes = pCompilerData->vsize;
+    s_imageEnd = 4 + s_programBytes;
+    s_stackLongs = pCompilerData->stack_requirement;
+    s_eepromSize = pCompilerData->eeprom_size;
+    s_freeBytes = s_eepromSize - (0x10 + s_programBytes + s_variableBytes + (s_stackLongs << 2));
+
+    bool bResult = EnterInstance(4, FindObjectInfo(pTopFilename, false), -1, 0, 0, s_variableBytes);
+    s_pImage = NULL;
+    return bResult;
+}
+
+static const char* ObjectName(int object)
+{
+    return s_pObjects[object].pInfo ? s_pObjects[object].pInfo->m_pFilename : "?";
+}
+
+// the text table leaves the path off (the top object is usually given with one)
+static const char* ObjectTitle(int object)
+{
+    const char* pName = ObjectName(object);
+    const char* pSeparator = strrchr(pName, '/');
+    if (pSeparator == NULL)
+    {
+        pSeparator = strrchr(pName, '\\');
+    }
+    return pSeparator ? pSeparator + 1 : pName;
+}
+
+static const char* MethodName(const MapMethod& method, bool& bPub)
+{
+    MapObjectInfo* pInfo = s_pObjects[method.object].pInfo;
+    bPub = (method.subIndex == 1);
+    if (pInfo && method.subIndex <= pInfo->m_methodCount && pInfo->m_pMethodNames[method.subIndex - 1])
+    {
+        bPub = pInfo->m_bMethodPub[method.subIndex - 1];
+        return pInfo->m_pMethodNames[method.subIndex - 1];
+    }
+    return "?";
+}
+
+static int CompareObjects(const void* pA, const void* pB)
+{
+    const MapObject& a = s_pObjects[*(const int*)pA];
+    const MapObject& b = s_pObjects[*(const int*)pB];
+    if (a.objectBytes != b.objectBytes)
+    {
+        return b.objectBytes - a.objectBytes;
+    }
+    return a.base - b.base;
+}
+
+static int CompareMethods(const void* pA, const void* pB)
+{
+    const MapMethod& a = s_pMethods[*(const int*)pA];
+    const MapMethod& b = s_pMethods[*(const int*)pB];
+    if (a.bytes != b.bytes)
+    {
+        return b.bytes - a.bytes;
+    }
+    return a.start - b.start;
+}
+
+void PrintMemoryMap(FILE* pFile)
+{
+    int codeBytes = 0;
+    int datBytes = 0;
+    int stringBytes = 0;
+    int indexBytes = 0;
+    for (int i = 0; i < s_nObjects; i++)
+    {
+        codeBytes += s_pObjects[i].codeBytes;
+        datBytes += s_pObjects[i].datBytes;
+        stringBytes += s_pObjects[i].stringBytes;
+        indexBytes += s_pObjects[i].indexBytes;
+    }
+    MapObjectInfo* pTopInfo = s_nObjects > 0 ? s_pObjects[0].pInfo : NULL;
+
+    fprintf(pFile, "Memory map of %s\n", s_topFilename);
+    fprintf(pFile, "  Program     %6d bytes (code %d, DAT %d, strings %d, index %d)\n", s_programBytes, codeBytes, datBytes, stringBytes, indexBytes);
+    fprintf(pFile, "  Variables   %6d bytes\n", s_variableBytes);
+    fprintf(pFile, "  Stack       %6d bytes (%d longs)\n", s_stackLongs << 2, s_stackLongs);
+    fprintf(pFile, "  Free        %6d bytes (of %d)\n", s_freeBytes, s_eepromSize);
+    if (pTopInfo)
+    {
+        fprintf(pFile, "  Distilled   %6d bytes", pTopInfo->m_distilledLongs << 2);
+        if (pTopInfo->m_foldedLongs > 0)
+        {
+            fprintf(pFile, " (and %d bytes of shared methods)", pTopInfo->m_foldedLongs << 2);
+        }
+        fprintf(pFile, "\n");
+    }
+
+    int* pOrder = new int[(s_nObjects > s_nMethods ? s_nObjects : s_nMethods) + 1];
+
+    fprintf(pFile, "\n%-32s %5s %6s %6s %6s %7s %6s %8s %6s\n", "Object", "Inst", "Bytes", "Code", "DAT", "Strings", "Index", "VAR/inst", "Stack");
+    for (int i = 0; i < s_nObjects; i++)
+    {
+        pOrder[i] = i;
+    }
+    qsort(pOrder, s_nObjects, sizeof(int), CompareObjects);
+    for (int i = 0; i < s_nObjects; i++)
+    {
+        const MapObject& object = s_pObjects[pOrder[i]];
+        fprintf(pFile, "%-32s %5d %6d %6d %6d %7d %6d %8d %6d\n", ObjectTitle(pOrder[i]), object.instances, object.objectBytes,
+                object.codeBytes, object.datBytes, object.stringBytes, object.indexBytes, object.varBytes, object.pInfo ? object.pInfo->m_stackLongs : 0);
+    }
+
+    fprintf(pFile, "\n%-32s %-32s %4s %6s %7s\n", "Method", "Object", "Type", "Bytes", "Strings");
+    for (int i = 0; i < s_nMethods; i++)
+    {
+        pOrder[i] = i;
+    }
+    qsort(pOrder, s_nMethods, sizeof(int), CompareMethods);
+    for (int i = 0; i < s_nMethods; i++)
+    {
+        const MapMethod& method = s_pMethods[pOrder[i]];
+        bool bPub = false;
+        const char* pName = MethodName(method, bPub);
+        if (method.bShared)
+        {
+            fprintf(pFile, "%-32s %-32s %4s %6s %7s\n", pName, ObjectTitle(method.object), bPub ? "PUB" : "PRI", "shared", "");
+        }
+        else
+        {
+            fprintf(pFile, "%-32s %-32s %4s %6d %7d\n", pName, ObjectTitle(method.object), bPub ? "PUB" : "PRI", method.bytes, method.stringBytes);
+        }
+    }
+
+    fprintf(pFile, "\n%-40s %8s %8s\n", "Instance", "VAR addr", "VAR");
+    for (int i = 0; i < s_nInstances; i++)
+    {
+        const MapInstance& instance = s_pInstances[i];
+        char name[256];
+        int indent = instance.depth * 2;
+        snprintf(name, sizeof(name), "%*s%s", indent, "", ObjectTitle(instance.object));
+        fprintf(pFile, "%-40s %8d %8d\n", name, instance.varAddress, instance.varBytes);
+    }
+
+    delete [] pOrder;
+}
+
+void WriteJsonString(FILE* pFile, const char* pString)
+{
+    fputc('"', pFile);
+    for (; *pString; pString++)
+    {
+        unsigned char theChar = (unsigned char)*pString;
+        if (theChar == '"' || theChar == '\\')
+        {
+            fprintf(pFile, "\\%c", theChar);
+        }
+        else if (theChar < 0x20 || theChar >= 0x80) // the source is PASCII, so anything past ASCII is escaped as is
+        {
+            fprintf(pFile, "\\u%04x", theChar);
+        }
+        else
+        {
+            fputc(theChar, pFile);
+        }
+    }
+    fputc('"', pFile);
+}
+
+bool WriteMemoryMapJson(const char* pPath)
+{
+    FILE* pFile = fopen(pPath, "w");
+    if (!pFile)
+    {
+        return false;
+    }
+
+    MapObjectInfo* pTopInfo = s_nObjects > 0 ? s_pObjects[0].pInfo : NULL;
+    fprintf(pFile, "{\n  \"top\": ");
+    WriteJsonString(pFile, s_topFilename);
+    fprintf(pFile, ",\n  \"eeprom_size\": %d,\n  \"program_bytes\": %d,\n  \"variable_bytes\": %d,\n  \"stack_longs\": %d,\n  \"free_bytes\": %d,\n",
+            s_eepromSize, s_programBytes, s_variableBytes, s_stackLongs, s_freeBytes);
+    fprintf(pFile, "  \"distilled_bytes\": %d,\n  \"folded_bytes\": %d,\n",
+            pTopInfo ? pTopInfo->m_distilledLongs << 2 : 0, pTopInfo ? pTopInfo->m_foldedLongs << 2 : 0);
+
+    fprintf(pFile, "  \"objects\": [");
+    for (int i = 0; i < s_nObjects; i++)
+    {
+        const MapObject& object = s_pObjects[i];
+        fprintf(pFile, "%s\n    {\"name\": ", i > 0 ? "," : "");
+        WriteJsonString(pFile, ObjectName(i));
+        fprintf(pFile, ", \"offset\": %d, \"instances\": %d, \"bytes\": %d, \"code_bytes\": %d, \"dat_bytes\": %d, \"string_bytes\": %d, \"index_bytes\": %d, \"var_bytes\": %d, \"stack_longs\": %d, \"distilled_bytes\": %d,\n     \"methods\": [",
+                object.base - 4, object.instances, object.objectBytes, object.codeBytes, object.datBytes, object.stringBytes, object.indexBytes, object.varBytes,
+                object.pInfo ? object.pInfo->m_stackLongs : 0, object.pInfo ? object.pInfo->m_distilledLongs << 2 : 0);
+        for (int j = 0; j < object.methodCount; j++)
+        {
+            const MapMethod& method = s_pMethods[object.firstMethod + j];
+            bool bPub = false;
+            const char* pName = MethodName(method, bPub);
+            fprintf(pFile, "%s\n       {\"name\": ", j > 0 ? "," : "");
+            WriteJsonString(pFile, pName);
+            fprintf(pFile, ", \"type\": \"%s\", \"index\": %d, \"offset\": %d, \"bytes\": %d, \"string_bytes\": %d, \"shared\": %s}",
+                    bPub ? "PUB" : "PRI", method.subIndex, method.start - 4, method.bytes, method.stringBytes, method.bShared ? "true" : "false");
+        }
+        fprintf(pFile, "]}");
+    }
+    fprintf(pFile, "\n  ],\n");
+
+    fprintf(pFile, "  \"instances\": [");
+    for (int i = 0; i < s_nInstances; i++)
+    {
+        const MapInstance& instance = s_pInstances[i];
+        fprintf(pFile, "%s\n    {\"object\": %d, \"parent\": %d, \"depth\": %d, \"var_address\": %d, \"var_bytes\": %d}",
+                i > 0 ? "," : "", instance.object, instance.parent, instance.depth, instance.varAddress, instance.varBytes);
+    }
+    fprintf(pFile, "\n  ]\n}\n");
+
+    fclose(pFile);
+    return true;
+}
+
+void CleanMemoryMap()
+{
+    ClearMap();
+    delete s_pObjectInfos;
+    s_pObjectInfos = NULL;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
@@ -12,18 +12,93 @@
 #include <string.h>
 
 #include "../PropellerCompiler/PropellerCompiler.h"
+#include "../PropellerCompiler/Utilities.h"
 #include "objectheap.h"
 
 // Object heap (compile-time objects)
 struct ObjHeap
 {
     char*   ObjFilename;    // Full filename of object
-    char*   Obj;            // Object binary
+    char*   Obj;            // Object binary (may be shared with other entries)
     int     ObjSize;        // Size of object
+    int     ObjHash;        // Hash of object binary
+    bool    bOwnsObj;       // true if this entry allocated Obj
 };
 
-ObjHeap s_ObjHeap[MaxObjInHeap];
-int     s_nObjHeapIndex = 0;
+// hash index entry, refers to a slot in s_ObjHeap
+class ObjHeapIndexEntry : public Hashable
+{
+public:
+    int m_index;
+
+    ObjHeapIndexEntry(int index)
+        : m_index(index)
+    {
+    }
+};
+
+ObjHeap*    s_ObjHeap = NULL;
+int         s_nObjHeapIndex = 0;
+int         s_nObjHeapSize = 0;
+HashTable*  s_pObjHeapNames = NULL;     // case folded filename -> heap index
+HashTable*  s_pObjHeapBinaries = NULL;  // binary contents -> heap index of owning entry
+
+// Jenkins One-at-a-time hash of the object binary (same as HashTable::GetStringHash)
+static int GetObjHash(const char* pObj, int size)
+{
+    // mixed unsigned, so the shifts and adds wrap instead of overflowing
+    unsigned int hash = 0;
+    for (int i = 0; i < size; i++)
+    {
+        hash += (unsigned char)pObj[i];
+        hash += (hash << 10);
+        hash ^= (hash >> 6);
+    }
+    hash += (hash << 3);
+    hash ^= (hash >> 11);
+    hash += (hash << 15);
+    return (int)hash;
+}
+
+static bool GrowObjectHeap()
+{
+    int newSize = (s_nObjHeapSize > 0) ? s_nObjHeapSize * 2 : ObjHeapInitialSize;
+    ObjHeap* pNewHeap = new ObjHeap[newSize];
+    if (!pNewHeap)
+    {
+        return false;
+    }
+    if (s_ObjHeap)
+    {
+        memcpy(pNewHeap, s_ObjHeap, s_nObjHeapIndex * sizeof(ObjHeap));
+        delete [] s_ObjHeap;
+    }
+    s_ObjHeap = pNewHeap;
+    s_nObjHeapSize = newSize;
+    return true;
+}
+
+// returns a heap entry that already holds an identical binary, or -1 if none
+static int FindObjectBinaryInHeap(const char* pObj, int size, int hash)
+{
+    if (!s_pObjHeapBinaries)
+    {
+        return -1;
+    }
+    for (HashNode* pNode = s_pObjHeapBinaries->FindFirst(hash); pNode != 0; pNode = pNode->pNext)
+    {
+        if (pNode->key != hash)
+        {
+            continue;
+        }
+        int i = ((ObjHeapIndexEntry*)pNode->pValue)->m_index;
+        if (s_ObjHeap[i].ObjSize == size && memcmp(s_ObjHeap[i].Obj, pObj, size) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
 
 bool AddObjectToHeap(char* name, CompilerData* pCompilerData)
 {
@@ -33,27 +108,61 @@ bool AddObjectToHeap(char* name, CompilerData* pCompilerData)
         return true;
     }
 
-    // add the object to the heap
-    if (s_nObjHeapIndex < MaxObjInHeap)
+    if (!s_pObjHeapNames)
     {
-        int nNameBufferLength = (int)strlen(name)+1;
-        s_ObjHeap[s_nObjHeapIndex].ObjFilename = new char[nNameBufferLength];
-        strcpy(s_ObjHeap[s_nObjHeapIndex].ObjFilename, name);
-        s_ObjHeap[s_nObjHeapIndex].ObjSize = pCompilerData->obj_ptr;
-        s_ObjHeap[s_nObjHeapIndex].Obj = new char[pCompilerData->obj_ptr];
-        memcpy(s_ObjHeap[s_nObjHeapIndex].Obj, &(pCompilerData->obj[0]), pCompilerData->obj_ptr);
-        s_nObjHeapIndex++;
-        return true;
+        s_pObjHeapNames = new HashTable(ObjHeapIndexSize);
+        s_pObjHeapBinaries = new HashTable(ObjHeapIndexSize);
+    }
+
+    // make room for the object in the heap
+    if (s_nObjHeapIndex >= s_nObjHeapSize && !GrowObjectHeap())
+    {
+        return false;
+    }
+
+    ObjHeap& entry = s_ObjHeap[s_nObjHeapIndex];
+    int nNameBufferLength = (int)strlen(name)+1;
+    entry.ObjFilename = new char[nNameBufferLength];
+    strcpy(entry.ObjFilename, name);
+    entry.ObjSize = pCompilerData->obj_ptr;
+    entry.ObjHash = GetObjHash((char*)&(pCompilerData->obj[0]), pCompilerData->obj_ptr);
+
+    // the same object compiled from a different path only needs to be held once
+    int nSameObjIdx = FindObjectBinaryInHeap((char*)&(pCompilerData->obj[0]), entry.ObjSize, entry.ObjHash);
+    if (nSameObjIdx != -1)
+    {
+        entry.Obj = s_ObjHeap[nSameObjIdx].Obj;
+        entry.bOwnsObj = false;
+    }
+    else
+    {
+        entry.Obj = new char[pCompilerData->obj_ptr];
+        memcpy(entry.Obj, &(pCompilerData->obj[0]), pCompilerData->obj_ptr);
+        entry.bOwnsObj = true;
+        s_pObjHeapBinaries->Insert(entry.ObjHash, new ObjHeapIndexEntry(s_nObjHeapIndex));
     }
 
-    return false;
+    s_pObjHeapNames->Insert(s_pObjHeapNames->GetStringHashUppercase(name), new ObjHeapIndexEntry(s_nObjHeapIndex));
+    s_nObjHeapIndex++;
+
+    return true;
 }
 
 // Returns index of object of Name in Object Heap.  Returns -1 if not found.
 int IndexOfObjectInHeap(char* name)
 {
-    for (int i = s_nObjHeapIndex-1; i >= 0; i--)
+    if (!s_pObjHeapNames)
     {
+        return -1;
+    }
+    int hash = s_pObjHeapNames->GetStringHashUppercase(name);
+    for (HashNode* pNode = s_pObjHeapNames->FindFirst(hash); pNode != 0; pNode = pNode->pNext)
+    {
+        if (pNode->key != hash)
+        {
+            continue;
+        }
+        int i = ((ObjHeapIndexEntry*)pNode->pValue)->m_index;
         if (_stricmp(s_ObjHeap[i].ObjFilename, name) == 0)
         {
             return i;
@@ -62,34 +171,93 @@ int IndexOfObjectInHeap(char* name)
     return -1;
 }
 
+// the filename and binary indexes refer to heap slots, so they are made again when entries move
+static void IndexObjectHeap()
+{
+    delete s_pObjHeapNames;
+    delete s_pObjHeapBinaries;
+    s_pObjHeapNames = new HashTable(ObjHeapIndexSize);
+    s_pObjHeapBinaries = new HashTable(ObjHeapIndexSize);
+    for (int i = 0; i < s_nObjHeapIndex; i++)
+    {
+        s_pObjHeapNames->Insert(s_pObjHeapNames->GetStringHashUppercase(s_ObjHeap[i].ObjFilename), new ObjHeapIndexEntry(i));
+        if (s_ObjHeap[i].bOwnsObj)
+        {
+            s_pObjHeapBinaries->Insert(s_ObjHeap[i].ObjHash, new ObjHeapIndexEntry(i));
+        }
+    }
+}
+
+// takes an object out of the heap so it gets compiled again (watch mode)
+void RemoveObjectFromHeap(char* name)
+{
+    int index = IndexOfObjectInHeap(name);
+    if (index == -1)
+    {
+        return;
+    }
+
+    ObjHeap removed = s_ObjHeap[index];
+    memmove(&s_ObjHeap[index], &s_ObjHeap[index + 1], (s_nObjHeapIndex - index - 1) * sizeof(ObjHeap));
+    s_nObjHeapIndex--;
+    delete [] removed.ObjFilename;
+
+    // an entry sharing the binary takes it over
+    if (removed.bOwnsObj)
+    {
+        int i = 0;
+        while (i < s_nObjHeapIndex && s_ObjHeap[i].Obj != removed.Obj)
+        {
+            i++;
+        }
+        if (i < s_nObjHeapIndex)
+        {
+            s_ObjHeap[i].bOwnsObj = true;
+        }
+        else
+        {
+            delete [] removed.Obj;
+        }
+    }
+
+    IndexObjectHeap();
+}
+
 void CleanObjectHeap()
 {
     for (int i = 0; i < s_nObjHeapIndex; i++)
     {
         delete [] s_ObjHeap[i].ObjFilename;
         s_ObjHeap[i].ObjFilename = NULL;
-        delete [] s_ObjHeap[i].Obj;
+        if (s_ObjHeap[i].bOwnsObj)
+        {
+            delete [] s_ObjHeap[i].Obj;
+        }
         s_ObjHeap[i].Obj = NULL;
         s_ObjHeap[i].ObjSize = 0;
     }
     s_nObjHeapIndex = 0;
+    delete [] s_ObjHeap;
+    s_ObjHeap = NULL;
+    s_nObjHeapSize = 0;
+    delete s_pObjHeapNames;
+    s_pObjHeapNames = NULL;
+    delete s_pObjHeapBinaries;
+    s_pObjHeapBinaries = NULL;
 }
 
 bool CopyObjectsFromHeap(CompilerData* pCompilerData, char* filenames)
 {
-    // load sub-objects from heap into obj_data for Compile2()
-    int p = 0;
+    // point Compile2() at the sub-object binaries in the heap, they are only copied when entered into obj
     for (int i = 0; i < pCompilerData->obj_files; i++)
     {
         int nObjIdx = IndexOfObjectInHeap(&filenames[i<<8]);
-        if (p + s_ObjHeap[nObjIdx].ObjSize > data_limit)
+        if (nObjIdx == -1)
         {
             return false;
         }
-        memcpy(&pCompilerData->obj_data[p], s_ObjHeap[nObjIdx].Obj, s_ObjHeap[nObjIdx].ObjSize);
-        pCompilerData->obj_offsets[i] = p;
+        pCompilerData->obj_binaries[i] = (const unsigned char*)s_ObjHeap[nObjIdx].Obj;
         pCompilerData->obj_lengths[i] = s_ObjHeap[nObjIdx].ObjSize;
-        p += s_ObjHeap[nObjIdx].ObjSize;
     }
 
     return true;
@@ -10,10 +10,12 @@
 // objectheap.h
 //
 
-#define MaxObjInHeap        256
+#define ObjHeapInitialSize  64      // heap grows as needed, this is just the starting capacity
+#define ObjHeapIndexSize    1024    // buckets in the filename and binary hash indexes
 
 bool AddObjectToHeap(char* name, CompilerData* pCompilerData);
 int IndexOfObjectInHeap(char* name);
+void RemoveObjectFromHeap(char* name);
 void CleanObjectHeap();
 bool CopyObjectsFromHeap(CompilerData* pCompilerData, char* filenames);
 
@@ -11,14 +11,25 @@
 //
 
 #include <unistd.h>
+#include <sys/time.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "../PropellerCompiler/PropellerCompiler.h"
 #include "../PropellerCompiler/Utilities.h"
+#include "../Emulator/SpinInterpreter.h"
 #include "objectheap.h"
 #include "pathentry.h"
+#include "datcache.h"
+#include "memorymap.h"
+#include "pasmtiming.h"
+#include "profile.h"
+#include "symbolindex.h"
+#include "textsearch.h"
+#include "watch.h"
+#include "depfile.h"
+#include "batch.h"
 #include "textconvert.h"
 #include "preprocess.h"
 #include "Utilities.h"
@@ -28,15 +39,65 @@
 #define ListLimit           2000000
 #define DocLimit            2000000
 
-#define MAX_FILES           2048    // an object can only reference 32 other objects and only 32 dat files, so the worst case is 32*32*2 files
+#define FilesAccessedInitialSize    64      // grows as needed
+#define FilesAccessedIndexSize      256
 
 static struct preprocess s_preprocessor;
 static CompilerData* s_pCompilerData = NULL;
 static bool s_bUsePreprocessor = false;
 static bool s_bAlternatePreprocessorMode  = false;
+static bool s_bFoldMethods = false;
+static bool s_bMemoryMap = false;
+static bool s_bSymbolIndex = false;
+static bool s_bWatch = false;
+static bool s_bBatch = false;
 static int  s_nObjStackPtr = 0;
 static int  s_nFilesAccessed = 0;
-static char s_filesAccessed[MAX_FILES][PATH_MAX];
+static int  s_nFilesAccessedSize = 0;
+static const char** s_filesAccessed = NULL;     // unique accessed paths in order of first access (owned by s_pFilesAccessedIndex)
+static HashTable* s_pFilesAccessedIndex = NULL; // interned accessed paths
+static HashTable* s_pScannedObjects = NULL;     // objects already scanned for -t/-f
+
+// an interned accessed file path
+class AccessedFile : public Hashable
+{
+public:
+    char* m_pPath;
+
+    AccessedFile(const char* pPath)
+    {
+        m_pPath = new char[strlen(pPath) + 1];
+        strcpy(m_pPath, pPath);
+    }
+    virtual ~AccessedFile()
+    {
+        delete [] m_pPath;
+    }
+};
+
+// an object the dependency scan (-t/-f) has been through, with the filenames of its sub-objects
+// so each repeat of it in the tree can be printed without reading it again
+class ScannedObject : public Hashable
+{
+public:
+    char* m_pName;
+    char* m_pObjFilenames;  // 256 bytes each
+    int   m_nObjFiles;
+
+    ScannedObject(const char* pName, const char* pObjFilenames, int nObjFiles)
+    {
+        m_pName = new char[strlen(pName) + 1];
+        strcpy(m_pName, pName);
+        m_pObjFilenames = new char[(nObjFiles << 8) + 1];
+        memcpy(m_pObjFilenames, pObjFilenames, nObjFiles << 8);
+        m_nObjFiles = nObjFiles;
+    }
+    virtual ~ScannedObject()
+    {
+        delete [] m_pName;
+        delete [] m_pObjFilenames;
+    }
+};
 
 static void Banner(void)
 {
@@ -68,63 +129,89 @@ usage: openspin\n\
          [ -r <path> ]          redirect stdout output\n\
          [ -R <path> ]          redirect stderr output\n\
          [ -s ]                 dump PUB & CON symbol information for top object\n\
-         <name.spin>            spin file to compile\n\
+         [ -u ]                 remove PUB/PRI methods that are never called\n\
+         [ -S ]                 work out the stack needed from the compiled methods\n\
+         [ -m ]                 print a hub memory map of the final image\n\
+         [ -j <path> ]          write the hub memory map as JSON\n\
+         [ -P ]                 estimate PASM cycles (added to the -v listing)\n\
+         [ -T <path> ]          write the PASM cycle estimates as JSON\n\
+         [ -X <clocks> ]        run the image on the host Spin interpreter\n\
+         [ -Q ]                 count the calls and clocks of each PUB/PRI (read back by -X or -H)\n\
+         [ -H <path> ]          print the method profile from a hub RAM dump of the -Q image\n\
+         [ -G <path> ]          write the method profile as folded stacks (for flame graphs)\n\
+         [ -i <path> ]          write an index of the PUB/PRI, CON and DAT symbols of every object\n\
+         [ -k <prefix> ]        list the symbols in the -i index starting with prefix (no spin file needed)\n\
+         [ -l ]                 print the block/method outline of the spin file (no compiling)\n\
+         [ -F <text> ]          list where text is in the spin files of the build (case doesn't matter)\n\
+         [ -w ]                 only find -F text as a whole word\n\
+         [ -W ]                 watch the files of the build and build again when one changes (Linux)\n\
+         [ -MD ]                write a make/ninja dependency file next to the output (.d)\n\
+         [ -MF <path> ]         write a make/ninja dependency file to path\n\
+         [ -MH <path> ]         keep a manifest of file hashes in path, and skip the build if nothing changed\n\
+         [ @<path> ]            build each spin file listed in path (a line each: name.spin [-D <define>]... [-o <path>])\n\
+         [ -O <letters> ]       enable optimizations:\n\
+                                  v = reorder VAR longs and locals by use count\n\
+                                  p = peephole optimize PUB/PRI bytecode\n\
+                                  f = share identical PUB/PRI bodies between objects\n\
+         <name.spin>...         spin file(s) to compile, more than one (or @) builds each in turn sharing the objects\n\
 \n");
 }
 
-FILE* OpenFileInPath(const char *name, const char *mode)
+// add a path to the list of accessed files (for -f), each path is only recorded once
+static void RecordFileAccess(const char* pPath)
 {
-    const char* pTryPath = NULL;
+    if (!s_pFilesAccessedIndex)
+    {
+        s_pFilesAccessedIndex = new HashTable(FilesAccessedIndexSize);
+    }
 
-    FILE* file = fopen(name, mode);
-    if (!file)
+    int hash = s_pFilesAccessedIndex->GetStringHash(pPath);
+    for (HashNode* pNode = s_pFilesAccessedIndex->FindFirst(hash); pNode != 0; pNode = pNode->pNext)
     {
-        PathEntry* entry = NULL;
-        while(!file)
+        if (pNode->key == hash && strcmp(((AccessedFile*)pNode->pValue)->m_pPath, pPath) == 0)
         {
-            pTryPath = MakeNextPath(&entry, name);
-            if (pTryPath)
-            {
-                file = fopen(pTryPath, mode);
-                if (file != NULL)
-                {
-                    break;
-                }
-            }
-            else
-            {
-                break;
-            }
+            return;
         }
     }
 
-    if (s_nFilesAccessed < MAX_FILES)
+    if (s_nFilesAccessed >= s_nFilesAccessedSize)
     {
-        if (!pTryPath)
-        {
-#ifdef WIN32
-            if (_fullpath(s_filesAccessed[s_nFilesAccessed], name, PATH_MAX) == NULL)
-#else
-            if (realpath(name, s_filesAccessed[s_nFilesAccessed]) == NULL)
-#endif
-            {
-                strcpy(s_filesAccessed[s_nFilesAccessed], name);
-            }
-            s_nFilesAccessed++;
-        }
-        else
+        int newSize = (s_nFilesAccessedSize > 0) ? s_nFilesAccessedSize * 2 : FilesAccessedInitialSize;
+        const char** pNewFiles = new const char*[newSize];
+        if (s_filesAccessed)
         {
-            strcpy(s_filesAccessed[s_nFilesAccessed++], pTryPath);
+            memcpy(pNewFiles, s_filesAccessed, s_nFilesAccessed * sizeof(const char*));
+            delete [] s_filesAccessed;
         }
+        s_filesAccessed = pNewFiles;
+        s_nFilesAccessedSize = newSize;
     }
-    else
+
+    AccessedFile* pFile = new AccessedFile(pPath);
+    s_pFilesAccessedIndex->Insert(hash, pFile);
+    s_filesAccessed[s_nFilesAccessed++] = pFile->m_pPath;
+}
+
+// returns the path to open name with, or NULL if not found
+// the resolved and accessed paths are cached, so repeat lookups of the same name don't search again
+const char* FindFileInPath(const char *name)
+{
+    const char* pAccessedPath = NULL;
+    const char* pPath = ResolvePath(name, &pAccessedPath);
+
+    RecordFileAccess(pAccessedPath);
+    if (s_bWatch)
     {
-        // should never hit this, but just in case
-        fprintf(GetStdout(), "Too many files!\n");
-        exit(-2);
+        WatchFile(pAccessedPath, s_nObjStackPtr);
     }
 
-    return file;
+    return pPath;
+}
+
+FILE* OpenFileInPath(const char *name, const char *mode)
+{
+    const char* pPath = FindFileInPath(name);
+    return pPath ? fopen(pPath, mode) : NULL;
 }
 
 // returns NULL if the file failed to open or is 0 length
@@ -169,26 +256,17 @@ char* LoadFile(char* pFilename, int* pnLength)
     return pBuffer;
 }
 
-int GetData(unsigned char* pDest, char* pFileName, int nMaxSize)
+// the data is shared through the DAT file cache, so each file is only read once per build
+bool GetData(char* pFileName, const unsigned char** ppData, int* pnLength)
 {
-    int nBytesRead = 0;
-    FILE* pFile = OpenFileInPath(pFileName, "rb");
-
-    if (pFile)
-    {
-        if (pDest)
-        {
-            nBytesRead = (int)fread(pDest, 1, nMaxSize, pFile);
-        }
-        fclose(pFile);
-    }
-    else
+    const char* pPath = FindFileInPath(pFileName);
+    if (!pPath || !GetDatFileFromCache(pPath, ppData, pnLength))
     {
         fprintf(GetStdout(), "Cannot find/open dat file: %s \n", pFileName);
-        return -1;
+        return false;
     }
 
-    return nBytesRead;
+    return true;
 }
 
 bool GetPASCIISource(char* pFilename)
@@ -257,9 +335,172 @@ void PrintError(const char* pFilename, const char* pErrorString)
     fprintf(GetStdout(), "Line:\n%s\nOffending Item: %s\n", errorLine, errorItem);
 }
 
-bool CompileRecursively(char* pFilename, bool bQuiet, bool bFileTreeOutputOnly)
+// print the per method stack usage worked out by the compiler (-S)
+static void PrintStackReport(const char* pFilename)
+{
+    fprintf(GetStdout(), "%s : stack requirement %d longs\n", pFilename, s_pCompilerData->stack_requirement);
+    for (int i = 0; i < s_pCompilerData->info_count; i++)
+    {
+        if (s_pCompilerData->info_type[i] != info_pub_stack && s_pCompilerData->info_type[i] != info_pri_stack)
+        {
+            continue;
+        }
+
+        char name[256];
+        int length = s_pCompilerData->info_finish[i] - s_pCompilerData->info_start[i];
+        if (length <= 0 || length >= (int)sizeof(name))
+        {
+            strcpy(name, "?");
+        }
+        else
+        {
+            strncpy(name, &s_pCompilerData->source[s_pCompilerData->info_start[i]], length);
+            name[length] = 0;
+        }
+
+        const char* pType = (s_pCompilerData->info_type[i] == info_pub_stack) ? "PUB" : "PRI";
+        int longs = s_pCompilerData->info_data1[i];
+        if (longs == -1)
+        {
+            fprintf(GetStdout(), "    %s %s : unbounded (recursive)\n", pType, name);
+        }
+        else if (longs == -2)
+        {
+            fprintf(GetStdout(), "    %s %s : not analyzed\n", pType, name);
+        }
+        else if (longs < 0)
+        {
+            fprintf(GetStdout(), "    %s %s : unbounded (calls a recursive or unanalyzed method)\n", pType, name);
+        }
+        else
+        {
+            fprintf(GetStdout(), "    %s %s : %d longs (%d params, %d locals, %d deepest)\n", pType, name, longs,
+                    s_pCompilerData->info_data2[i], s_pCompilerData->info_data3[i], s_pCompilerData->info_data4[i]);
+        }
+    }
+}
+
+// print source text, with each run of spaces, tabs and line ends as one space
+static void PrintSource(int start, int finish)
+{
+    bool bSpace = false;
+    for (int i = start; i < finish; i++)
+    {
+        if (s_pCompilerData->source[i] <= ' ')
+        {
+            bSpace = true;
+            continue;
+        }
+        if (bSpace)
+        {
+            fputc(' ', GetStdout());
+            bSpace = false;
+        }
+        fputc(s_pCompilerData->source[i], GetStdout());
+    }
+}
+
+// print the block/method outline of the file (-l), it is only elementized, not compiled
+static bool PrintOutline(char* pFilename)
+{
+    if (!GetPASCIISource(pFilename))
+    {
+        fprintf(GetStdout(), "%s : error : Can not find/open file.\n", pFilename);
+        return false;
+    }
+
+    // whatever was found before an error is still printed
+    const char* pErrorString = CompileOutline();
+
+    static const char* s_blockNames[] = { "CON", "VAR", "DAT", "OBJ", "PUB", "PRI", "DEV" };
+    for (int i = 0; i < Outline_GetEntryCount(); i++)
+    {
+        const OutlineEntry* pEntry = Outline_GetEntry(i);
+        if (pEntry->type == outline_block)
+        {
+            fprintf(GetStdout(), "%6d  %s", pEntry->line, s_blockNames[pEntry->blockType]);
+        }
+        else
+        {
+            fprintf(GetStdout(), "%6d     ", pEntry->line);
+        }
+        if (pEntry->type == outline_obj)
+        {
+            fputs("  ", GetStdout());
+            PrintSource(pEntry->nameStart, pEntry->nameFinish);
+            fputs(" : ", GetStdout());
+            PrintSource(pEntry->detailStart, pEntry->detailFinish);
+        }
+        else if (pEntry->nameFinish > pEntry->nameStart)
+        {
+            // the name and signature as they are in the source
+            fputs("  ", GetStdout());
+            PrintSource(pEntry->nameStart, (pEntry->detailFinish > 0) ? pEntry->detailFinish : pEntry->nameFinish);
+        }
+        fputc('\n', GetStdout());
+    }
+
+    if (pErrorString != 0)
+    {
+        PrintError(pFilename, pErrorString);
+        return false;
+    }
+    return true;
+}
+
+// prints a -F match, with the line it is on
+static bool PrintSearchMatch(void* /*pContext*/, const char* pPath, const char* pSource, int length, int offset, int line, int column)
+{
+    int start = 0;
+    int finish = 0;
+    GetSearchLine(pSource, length, offset, &start, &finish);
+    fprintf(GetStdout(), "%s(%d:%d) : %.*s\n", pPath, line, column, finish - start, &pSource[start]);
+    return true;
+}
+
+// search the spin files the build read (-F), they are read again as they are on disk, not as preprocessed
+static void SearchAccessedFiles(const char* pText, bool bWholeWord)
+{
+    if (!SetSearchPattern(pText, (int)strlen(pText), bWholeWord ? SearchWholeWord : 0))
+    {
+        return;
+    }
+    const char** ppPaths = new const char*[s_nFilesAccessed];
+    int pathCount = 0;
+    for (int i = 0; i < s_nFilesAccessed; i++)
+    {
+        int length = (int)strlen(s_filesAccessed[i]);
+        if (length > 5 && _stricmp(&s_filesAccessed[i][length - 5], ".spin") == 0)
+        {
+            ppPaths[pathCount++] = s_filesAccessed[i];
+        }
+    }
+    SearchFiles(ppPaths, pathCount, PrintSearchMatch, NULL);
+    delete [] ppPaths;
+}
+
+// print the symbols in the index starting with pPrefix (-k)
+static bool LookupSymbols(const char* pIndexFilename, const char* pPrefix)
+{
+    if (!OpenSymbolIndex(pIndexFilename))
+    {
+        fprintf(GetStdout(), "%s : error : Can not read the symbol index.\n", pIndexFilename);
+        return false;
+    }
+    int first = 0;
+    int count = FindSymbolIndexPrefix(pPrefix, first);
+    for (int i = first; i < first + count; i++)
+    {
+        PrintSymbolIndexEntry(GetStdout(), i);
+    }
+    CloseSymbolIndex();
+    return true;
+}
+
+// prints the -t line of an object and goes down a level in the tree
+static bool EnterObject(const char* pFilename, bool bPrintTree)
 {
-    if (s_nObjStackPtr > 0 && (!bQuiet || bFileTreeOutputOnly))
+    if (s_nObjStackPtr > 0 && bPrintTree)
     {
         char spaces[] = "                              \0";
         fprintf(GetStdout(), "%s|-%s\n", &spaces[32-(s_nObjStackPtr<<1)], pFilename);
@@ -271,6 +512,82 @@ bool CompileRecursively(char* pFilename, bool bQuiet, bool bFileTreeOutputOnly)
         return false;
     }
 
+    return true;
+}
+
+// copies the obj filenames of the object just compiled, appending .spin if they don't have it
+static int GetObjFilenames(char* pFilenames)
+{
+    int numObjects = s_pCompilerData->obj_files;
+    for (int i = 0; i < numObjects; i++)
+    {
+        strcpy(&pFilenames[i<<8], &(s_pCompilerData->obj_filenames[i<<8]));
+        if (strstr(&pFilenames[i<<8], ".spin") == NULL)
+        {
+            strcat(&pFilenames[i<<8], ".spin");
+        }
+    }
+    return numObjects;
+}
+
+static ScannedObject* FindScannedObject(const char* pFilename)
+{
+    if (!s_pScannedObjects)
+    {
+        return NULL;
+    }
+
+    int hash = s_pScannedObjects->GetStringHash(pFilename);
+    for (HashNode* pNode = s_pScannedObjects->FindFirst(hash); pNode != 0; pNode = pNode->pNext)
+    {
+        if (pNode->key == hash && strcmp(((ScannedObject*)pNode->pValue)->m_pName, pFilename) == 0)
+        {
+            return (ScannedObject*)pNode->pValue;
+        }
+    }
+    return NULL;
+}
+
+// walks the sub-objects of an object that was already scanned, the same as scanning it again would
+static bool RescanObject(ScannedObject* pObject, bool bPrintTree)
+{
+    for (int i = 0; i < pObject->m_nObjFiles; i++)
+    {
+        char* pFilename = &pObject->m_pObjFilenames[i<<8];
+        if (!EnterObject(pFilename, bPrintTree))
+        {
+            return false;
+        }
+        ScannedObject* pSubObject = FindScannedObject(pFilename);
+        if (pSubObject && !RescanObject(pSubObject, bPrintTree))
+        {
+            return false;
+        }
+        s_nObjStackPtr--;
+    }
+    return true;
+}
+
+// -t and -f only need the files the build reads, so instead of compiling the tree this only finds
+// the OBJ and FILE references of each object (CompileDependencies), and visits each object once
+static bool ScanRecursively(char* pFilename, bool bPrintTree)
+{
+    if (!EnterObject(pFilename, bPrintTree))
+    {
+        return false;
+    }
+
+    ScannedObject* pScanned = FindScannedObject(pFilename);
+    if (pScanned)
+    {
+        if (!RescanObject(pScanned, bPrintTree))
+        {
+            return false;
+        }
+        s_nObjStackPtr--;
+        return true;
+    }
+
     void *definestate = 0;
     if (s_bUsePreprocessor)
     {
@@ -282,28 +599,113 @@ bool CompileRecursively(char* pFilename, bool bQuiet, bool bFileTreeOutputOnly)
         return false;
     }
 
-    // first pass on object
-    const char* pErrorString = Compile1();
+    const char* pErrorString = CompileDependencies();
     if (pErrorString != 0)
     {
         PrintError(pFilename, pErrorString);
         return false;
     }
 
-    if (s_pCompilerData->obj_files > 0)
+    // the sub-objects overwrite the compiler data, so keep the names
+    char filenames[file_limit*256];
+    char datFilenames[file_limit*256];
+    int numObjects = GetObjFilenames(filenames);
+    int numDatFiles = s_pCompilerData->dat_files;
+    memcpy(datFilenames, s_pCompilerData->dat_filenames, numDatFiles << 8);
+
+    for (int i = 0; i < numObjects; i++)
+    {
+        if (!ScanRecursively(&filenames[i<<8], bPrintTree))
+        {
+            return false;
+        }
+    }
+    if (numObjects > 0 && s_bUsePreprocessor)
     {
-        char filenames[file_limit*256];
+        // undo any defines in sub-objects
+        pp_restore_define_state(&s_preprocessor, definestate);
+    }
 
-        int numObjects = s_pCompilerData->obj_files;
-        for (int i = 0; i < numObjects; i++)
+    // DAT files only need to be found, not read
+    for (int i = 0; i < numDatFiles; i++)
+    {
+        if (!FindFileInPath(&datFilenames[i<<8]))
         {
-            // copy the obj filename appending .spin if it doesn't have it.
-            strcpy(&filenames[i<<8], &(s_pCompilerData->obj_filenames[i<<8]));
-            if (strstr(&filenames[i<<8], ".spin") == NULL)
-            {
-                strcat(&filenames[i<<8], ".spin");
-            }
+            fprintf(GetStdout(), "Cannot find/open dat file: %s \n", &datFilenames[i<<8]);
+            return false;
         }
+    }
+
+    if (!s_pScannedObjects)
+    {
+        s_pScannedObjects = new HashTable(FilesAccessedIndexSize);
+    }
+    s_pScannedObjects->Insert(s_pScannedObjects->GetStringHash(pFilename), new ScannedObject(pFilename, filenames, numObjects));
+    s_nObjStackPtr--;
+
+    return true;
+}
+
+bool CompileRecursively(char* pFilename, bool bQuiet, bool bFileTreeOutputOnly)
+{
+    if (!EnterObject(pFilename, !bQuiet || bFileTreeOutputOnly))
+    {
+        return false;
+    }
+
+    if (s_bWatch)
+    {
+        // a sub-object that hasn't changed since it was compiled is used from the heap as it is
+        if (s_nObjStackPtr > 1 && IndexOfObjectInHeap(pFilename) != -1)
+        {
+            WatchObjectFromHeap(pFilename, s_nObjStackPtr);
+            s_nObjStackPtr--;
+            return true;
+        }
+        WatchObject(pFilename, s_nObjStackPtr);
+    }
+
+    void *definestate = 0;
+    if (s_bUsePreprocessor)
+    {
+        definestate = pp_get_define_state(&s_preprocessor);
+    }
+    unsigned long long batchKey = s_bBatch ? GetBatchDefinesKey(definestate) : 0;
+    if (!GetPASCIISource(pFilename))
+    {
+        fprintf(GetStdout(), "%s : error : Can not find/open file.\n", pFilename);
+        return false;
+    }
+
+    if (s_bBatch)
+    {
+        // a sub-object an earlier build compiled from the same source and defines is used from the heap as it is
+        batchKey = GetBatchObjectKey(batchKey, s_pCompilerData->source);
+        if (s_nObjStackPtr > 1 && UseBatchObject(pFilename, batchKey))
+        {
+            s_nObjStackPtr--;
+            return true;
+        }
+        if (s_nObjStackPtr == 1)
+        {
+            ForgetBatchObject(pFilename);
+        }
+    }
+
+    // first pass on object
+    UnusedMethods_SetObject(pFilename);
+    const char* pErrorString = Compile1();
+    if (pErrorString != 0)
+    {
+        PrintError(pFilename, pErrorString);
+        return false;
+    }
+
+    char filenames[file_limit*256];
+    int numObjects = 0;
+    if (s_pCompilerData->obj_files > 0)
+    {
+        numObjects = GetObjFilenames(filenames);
 
         for (int i = 0; i < numObjects; i++)
         {
@@ -325,6 +727,7 @@ bool CompileRecursively(char* pFilename, bool bQuiet, bool bFileTreeOutputOnly)
             return false;
         }
 
+        UnusedMethods_SetObject(pFilename);
         pErrorString = Compile1();
         if (pErrorString != 0)
         {
@@ -334,7 +737,7 @@ bool CompileRecursively(char* pFilename, bool bQuiet, bool bFileTreeOutputOnly)
 
         if (!CopyObjectsFromHeap(s_pCompilerData, filenames))
         {
-            fprintf(GetStdout(), "%s : error : Object files exceed 128k.\n", pFilename);
+            fprintf(GetStdout(), "%s : error : Sub-object missing from object heap.\n", pFilename);
             return false;
         }
     }
@@ -342,7 +745,6 @@ bool CompileRecursively(char* pFilename, bool bQuiet, bool bFileTreeOutputOnly)
     // load all DAT files
     if (s_pCompilerData->dat_files > 0)
     {
-        int p = 0;
         for (int i = 0; i < s_pCompilerData->dat_files; i++)
         {
             // Get DAT's Files
@@ -351,24 +753,20 @@ bool CompileRecursively(char* pFilename, bool bQuiet, bool bFileTreeOutputOnly)
             char filename[256];
             strcpy(&filename[0], &(s_pCompilerData->dat_filenames[i<<8]));
 
-            // Load file and add to dat_data buffer
-            s_pCompilerData->dat_lengths[i] = GetData(&(s_pCompilerData->dat_data[p]), &filename[0], data_limit - p);
-            if (s_pCompilerData->dat_lengths[i] == -1)
+            // Load file (or find it in the cache) and point dat_binaries at it
+            if (!GetData(&filename[0], &(s_pCompilerData->dat_binaries[i]), &(s_pCompilerData->dat_lengths[i])))
             {
+                s_pCompilerData->dat_binaries[i] = NULL;
                 s_pCompilerData->dat_lengths[i] = 0;
                 return false;
             }
-            if (p + s_pCompilerData->dat_lengths[i] > data_limit)
-            {
-                fprintf(GetStdout(), "%s : error : Object files exceed 128k.\n", pFilename);
-                return false;
-            }
-            s_pCompilerData->dat_offsets[i] = p;
-            p += s_pCompilerData->dat_lengths[i];
         }
     }
 
     // second pass of object
+    // the shared bodies are addressed across objects, so that can only be done once the whole tree is in place
+    s_pCompilerData->bFoldMethods = s_bFoldMethods && (s_nObjStackPtr == 1);
+    s_pCompilerData->profile_first_method = GetNextProfileMethod();
     pErrorString = Compile2();
     if (pErrorString != 0)
     {
@@ -376,23 +774,111 @@ bool CompileRecursively(char* pFilename, bool bQuiet, bool bFileTreeOutputOnly)
         return false;
     }
 
-    // Check to make sure object fits into 32k (or eeprom size if specified as larger than 32k)
-    unsigned int i = 0x10 + s_pCompilerData->psize + s_pCompilerData->vsize + (s_pCompilerData->stack_requirement << 2);
-    if ((s_pCompilerData->compile_mode == 0) && (i > s_pCompilerData->eeprom_size))
+    if (s_pCompilerData->bPeephole && !bQuiet)
     {
-        fprintf(GetStdout(), "%s : error : Object exceeds runtime memory limit by %d longs.\n", pFilename, (i - s_pCompilerData->eeprom_size) >> 2);
-        return false;
+        fprintf(GetStdout(), "%s : peephole optimizer saved %d bytes\n", pFilename, s_pCompilerData->peephole_saved);
     }
-
-    // save this object in the heap
-    if (!AddObjectToHeap(pFilename, s_pCompilerData))
+    if (s_pCompilerData->bFoldMethods && !bQuiet)
     {
-        fprintf(GetStdout(), "%s : error : Object Heap Overflow.\n", pFilename);
-        return false;
+        fprintf(GetStdout(), "%s : method folding saved %d longs (%d longs distilled)\n", pFilename, s_pCompilerData->folded_longs, s_pCompilerData->distilled_longs);
     }
-    s_nObjStackPtr--;
-
-    return true;
+    if (s_pCompilerData->bStackAnalysis && !bQuiet)
+    {
+        PrintStackReport(pFilename);
+    }
+    if (s_bMemoryMap)
+    {
+        EnterObjectIntoMemoryMap(pFilename, s_pCompilerData);
+    }
+    if (s_pCompilerData->bProfile)
+    {
+        EnterObjectIntoProfile(pFilename, s_pCompilerData);
+    }
+    if (s_bSymbolIndex)
+    {
+        const char* pPath = FindFileInPath(pFilename);
+        EnterObjectIntoSymbolIndex(pPath ? pPath : pFilename, s_pCompilerData);
+    }
+    if (s_pCompilerData->bAsmTiming)
+    {
+        EnterObjectIntoPasmTiming(pFilename, s_pCompilerData);
+        if (!bQuiet)
+        {
+            PrintPasmTiming(GetStdout(), pFilename);
+        }
+    }
+
+    // Check to make sure object fits into 32k (or eeprom size if specified as larger than 32k)
+    unsigned int i = 0x10 + s_pCompilerData->psize + s_pCompilerData->vsize + (s_pCompilerData->stack_requirement << 2);
+    if ((s_pCompilerData->compile_mode == 0) && (i > s_pCompilerData->eeprom_size))
+    {
+        fprintf(GetStdout(), "%s : error : Object exceeds runtime memory limit by %d longs.\n", pFilename, (i - s_pCompilerData->eeprom_size) >> 2);
+        return false;
+    }
+
+    // save this object in the heap
+    if (!AddObjectToHeap(pFilename, s_pCompilerData))
+    {
+        fprintf(GetStdout(), "%s : error : Object Heap Overflow.\n", pFilename);
+        return false;
+    }
+    if (s_bBatch)
+    {
+        EnterBatchObject(pFilename, batchKey, filenames, numObjects, s_pCompilerData->dat_filenames, s_pCompilerData->dat_files);
+    }
+    s_nObjStackPtr--;
+
+    return true;
+}
+
+// runs the composed image for up to the given number of clocks (-X) and reports how it went
+static bool RunImage(const char* pFilename, unsigned char* pBuffer, int bufferSize, long long clocks)
+{
+    SpinInterpreter* pInterpreter = new SpinInterpreter();
+    if (!pInterpreter->Load(pBuffer, bufferSize))
+    {
+        fprintf(GetStdout(), "%s : error : %s.\n", pFilename, pInterpreter->GetError());
+        delete pInterpreter;
+        return false;
+    }
+
+    int result = pInterpreter->Run(clocks);
+    if (result == spin_run_error)
+    {
+        fprintf(GetStdout(), "%s : error : %s.\n", pFilename, pInterpreter->GetError());
+        delete pInterpreter;
+        return false;
+    }
+
+    static const char* s_runResults[] = { "clock limit reached", "all cogs stopped", "waiting on pins", "rebooted" };
+    fprintf(GetStdout(), "Ran %lld clocks, %lld bytecodes: %s\n", pInterpreter->GetClock(), pInterpreter->GetBytecodeCount(), s_runResults[result]);
+    for (int i = 0; i < cog_count; i++)
+    {
+        const SpinCog* pCog = pInterpreter->GetCog(i);
+        int value = 0;
+        bool bAborted = false;
+        if (pInterpreter->GetExitValue(i, value, bAborted))
+        {
+            fprintf(GetStdout(), "  cog %d %s %d\n", i, bAborted ? "aborted with" : "returned", value);
+        }
+        else if (pCog->state == spin_cog_spin)
+        {
+            fprintf(GetStdout(), "  cog %d running Spin at $%04X%s\n", i, pCog->pcurr, pCog->bWaitPins ? " (waiting on pins)" : "");
+        }
+        else if (pCog->state == spin_cog_native)
+        {
+            fprintf(GetStdout(), "  cog %d running PASM (loaded from $%04X) at $%03X%s\n", i, pCog->codeAddress, pInterpreter->GetNativeCog(i)->pc, pCog->bWaitPins ? " (waiting on pins)" : "");
+        }
+    }
+    fprintf(GetStdout(), "  OUTA $%08X DIRA $%08X\n", pInterpreter->GetOutputs(), pInterpreter->GetDirections());
+
+    if (s_pCompilerData->bProfile)
+    {
+        ReadProfile(pInterpreter->GetHub(), hub_ram_size);
+    }
+
+    delete pInterpreter;
+    return true;
 }
 
 bool ComposeRAM(unsigned char** ppBuffer, int& bufferSize, bool bDATonly, bool bBinary, unsigned int eeprom_size)
@@ -409,6 +895,14 @@ bool ComposeRAM(unsigned char** ppBuffer, int& bufferSize, bool bDATonly, bool b
         unsigned int pcurr = pbase + pubaddr;                                                         // Current program start = object base + public address (first public method)
         unsigned int dcurr = dbase + 4 + (s_pCompilerData->first_pub_parameters << 2) + publocs;      // current data stack pointer = data base + 4 + FirstParams*4 + publocs
 
+        // the profile table is at the top of hub RAM, the stack has to stay under it
+        if (s_pCompilerData->bProfile && dbase + (s_pCompilerData->stack_requirement << 2) > profile_table_address)
+        {
+            fprintf(GetStdout(), "ERROR: profile table at $%04X overlapped by %d longs.\n", profile_table_address,
+                    (dbase + (s_pCompilerData->stack_requirement << 2) - profile_table_address) >> 2);
+            return false;
+        }
+
         if (bBinary)
         {
            // reset ram
@@ -475,6 +969,250 @@ bool ComposeRAM(unsigned char** ppBuffer, int& bufferSize, bool bDATonly, bool b
     return true;
 }
 
+// builds the output file for watch mode (-W), sub-objects still in the heap are not compiled again
+static bool BuildWatched(char* pFilename, const char* pOutputFilename, bool bDATonly, bool bBinary, unsigned int eeprom_size, void* definestate, int& programSize)
+{
+    // the compiler never clears its error flag (a build normally stops at the first error)
+    s_pCompilerData->error = false;
+    s_nObjStackPtr = 0;
+    // a name not found last time may exist now, or a new file may shadow one further along the include path
+    ClearResolvedPaths();
+    if (s_bUsePreprocessor)
+    {
+        pp_restore_define_state(&s_preprocessor, definestate);
+    }
+    if (!CompileRecursively(pFilename, true, false))
+    {
+        return false;
+    }
+
+    unsigned char* pBuffer = NULL;
+    int bufferSize = 0;
+    if (!ComposeRAM(&pBuffer, bufferSize, bDATonly, bBinary, eeprom_size))
+    {
+        return false;
+    }
+    FILE* pFile = fopen(pOutputFilename, "wb");
+    if (pFile)
+    {
+        fwrite(pBuffer, bufferSize, 1, pFile);
+        fclose(pFile);
+    }
+    delete [] pBuffer;
+
+    programSize = bufferSize;
+    return true;
+}
+
+// build, then build again each time a file the build read changes (-W), only returns on an error
+static int WatchAndBuild(char* pFilename, const char* pOutputFilename, bool bQuiet, bool bDATonly, bool bBinary, unsigned int eeprom_size)
+{
+    if (!StartWatching())
+    {
+        fprintf(GetStdout(), "%s : error : Watching for changes is not supported on this system.\n", pFilename);
+        return 1;
+    }
+
+    // the command line defines, each build starts from these
+    void* definestate = 0;
+    if (s_bUsePreprocessor)
+    {
+        definestate = pp_get_define_state(&s_preprocessor);
+    }
+
+    for (;;)
+    {
+        struct timeval startTime;
+        gettimeofday(&startTime, NULL);
+        int programSize = 0;
+        if (BuildWatched(pFilename, pOutputFilename, bDATonly, bBinary, eeprom_size, definestate, programSize) && !bQuiet)
+        {
+            struct timeval finishTime;
+            gettimeofday(&finishTime, NULL);
+            double milliseconds = (finishTime.tv_sec - startTime.tv_sec) * 1000.0 + (finishTime.tv_usec - startTime.tv_usec) / 1000.0;
+            fprintf(GetStdout(), "%s : built in %.1f ms, program size is %d bytes\n", pFilename, milliseconds, programSize);
+        }
+        fflush(GetStdout());
+
+        if (!WaitForWatchedChanges())
+        {
+            fprintf(GetStdout(), "%s : error : Can not watch the files of the build.\n", pFilename);
+            return 1;
+        }
+        const char** ppStale = NULL;
+        int staleCount = GetStaleObjects(&ppStale);
+        for (int i = 0; i < staleCount; i++)
+        {
+            RemoveObjectFromHeap((char*)ppStale[i]);
+        }
+    }
+}
+
+// the preprocessor only keeps its defines for the first file it reads (the top object), so each build sets them up
+static bool DefineSymbols(int argc, char* argv[])
+{
+    // go through the command line arguments again, this time only processing -D
+    for(int i = 1; i < argc; i++)
+    {
+        // handle switches
+        if(argv[i][0] == '-' && argv[i][1] == 'D')
+        {
+            const char* p = NULL;
+            if (argv[i][2])
+            {
+                p = &argv[i][2];
+            }
+            else if(++i < argc)
+            {
+                p = argv[i];
+            }
+            else
+            {
+                return false;
+            }
+            // add any predefined symbols here - note that when using the 
+            // "alternate" rules, these symbols have a null value - i.e.
+            // they are just "defined", but are not used in macro substitution
+            pp_define(&s_preprocessor, p, (s_bAlternatePreprocessorMode ? "" : "1"));
+        }
+    }
+
+    // add symbols with predefined values here
+    pp_define(&s_preprocessor, "__SPIN__", "1");
+    pp_define(&s_preprocessor, "__TARGET__", "P1");
+    return true;
+}
+
+// create the *.binary (or .eeprom/.dat) filename from a spin filename
+static bool MakeOutputFilename(const char* pSpinFilename, bool bDATonly, bool bBinary, char* pOutputFilename)
+{
+    strcpy(pOutputFilename, pSpinFilename);
+    const char* pTemp = strstr(pOutputFilename, ".spin");
+    if (pTemp == 0)
+    {
+        fprintf(GetStdout(), "ERROR: spinfile must have .spin extension. You passed in: %s\n", pSpinFilename);
+        return false;
+    }
+
+    int offset = (int) (pTemp - pOutputFilename);
+    pOutputFilename[offset+1] = 0;
+    if (bDATonly)
+    {
+        strcat(pOutputFilename, "dat");
+    }
+    else if (bBinary)
+    {
+        strcat(pOutputFilename, "binary");
+    }
+    else
+    {
+        strcat(pOutputFilename, "eeprom");
+    }
+    return true;
+}
+
+// builds one spin file of a batch, as a build of it on its own would (with the defines from its response file line)
+static bool BuildBatchTarget(const BatchTarget* pTarget, int argc, char* argv[], bool bQuiet, bool bDATonly, bool bBinary, unsigned int eeprom_size)
+{
+    char outputFilename[256];
+    if (pTarget->pOutputFilename)
+    {
+        strcpy(outputFilename, pTarget->pOutputFilename);
+    }
+    else if (!MakeOutputFilename(pTarget->pFilename, bDATonly, bBinary, outputFilename))
+    {
+        return false;
+    }
+
+    if (s_bUsePreprocessor)
+    {
+        pp_clear_define_state(&s_preprocessor);
+        DefineSymbols(argc, argv);
+        for (int i = 0; i < pTarget->defineCount; i++)
+        {
+            pp_define(&s_preprocessor, pTarget->ppDefines[i], (s_bAlternatePreprocessorMode ? "" : "1"));
+        }
+    }
+    else if (pTarget->defineCount > 0)
+    {
+        fprintf(GetStdout(), "%s : error : -D needs the preprocessor.\n", pTarget->pFilename);
+        return false;
+    }
+
+    if (!bQuiet)
+    {
+        fprintf(GetStdout(), "Compiling...\n%s\n", pTarget->pFilename);
+    }
+
+    // copy filename into obj_title, and chop off the .spin
+    strcpy(s_pCompilerData->obj_title, pTarget->pFilename);
+    char* pExtension = strstr(&s_pCompilerData->obj_title[0], ".spin");
+    if (pExtension != 0)
+    {
+        *pExtension = 0;
+    }
+
+    // the compiler never clears its error flag (a build normally stops at the first error)
+    s_pCompilerData->error = false;
+    s_nObjStackPtr = 0;
+    BeginBatchTarget();
+    bool bAddedPath = AddFilePath(pTarget->pFilename);
+    bool bBuilt = CompileRecursively(pTarget->pFilename, true, false);
+    if (bAddedPath)
+    {
+        RemoveLastPath();
+    }
+    if (!bBuilt)
+    {
+        return false;
+    }
+    if (!bQuiet)
+    {
+        fprintf(GetStdout(), "Done.\n");
+    }
+
+    unsigned char* pBuffer = NULL;
+    int bufferSize = 0;
+    if (!ComposeRAM(&pBuffer, bufferSize, bDATonly, bBinary, eeprom_size))
+    {
+        return false;
+    }
+    FILE* pFile = fopen(outputFilename, "wb");
+    if (pFile)
+    {
+        fwrite(pBuffer, bufferSize, 1, pFile);
+        fclose(pFile);
+    }
+    delete [] pBuffer;
+
+    if (!bQuiet)
+    {
+        fprintf(GetStdout(), "Program size is %d bytes\n", bufferSize);
+    }
+    return true;
+}
+
+// builds each spin file of the batch in turn, carrying on past the ones that fail
+static int BuildBatch(int argc, char* argv[], bool bQuiet, bool bDATonly, bool bBinary, unsigned int eeprom_size)
+{
+    int failedCount = 0;
+    for (int i = 0; i < GetBatchTargetCount(); i++)
+    {
+        if (!BuildBatchTarget(GetBatchTarget(i), argc, argv, bQuiet, bDATonly, bBinary, eeprom_size))
+        {
+            failedCount++;
+        }
+        fflush(GetStdout());
+    }
+
+    if (failedCount > 0)
+    {
+        fprintf(GetStdout(), "%d of %d builds failed.\n", failedCount, GetBatchTargetCount());
+        return 1;
+    }
+    return 0;
+}
+
 void CleanupMemory()
 {
     // cleanup
@@ -486,7 +1224,25 @@ void CleanupMemory()
         delete [] s_pCompilerData->source;
     }
     CleanObjectHeap();
+    CleanDatFileCache();
     CleanupPathEntries();
+    UnusedMethods_End();
+    CleanMemoryMap();
+    CleanPasmTiming();
+    CleanProfile();
+    CleanSymbolIndex();
+    CloseSymbolIndex();
+    CleanSearch();
+    CleanWatch();
+    CleanBatch();
+    delete [] s_filesAccessed;
+    s_filesAccessed = NULL;
+    s_nFilesAccessed = 0;
+    s_nFilesAccessedSize = 0;
+    delete s_pFilesAccessedIndex;
+    s_pFilesAccessedIndex = NULL;
+    delete s_pScannedObjects;
+    s_pScannedObjects = NULL;
     Cleanup();
     fflush(GetStdout());
     fflush(GetStderr());
@@ -506,12 +1262,37 @@ int mainOpenSpin(int argc, char* argv[])
     unsigned int  eeprom_size = 32768;
     s_bUsePreprocessor = true;
     s_bAlternatePreprocessorMode = false;
+    s_bFoldMethods = false;
+    s_bMemoryMap = false;
+    s_bSymbolIndex = false;
+    s_bWatch = false;
+    s_bBatch = false;
     s_nObjStackPtr = 0;
     s_nFilesAccessed = 0;
     s_pCompilerData = NULL;
     bool bFileTreeOutputOnly = false;
     bool bFileListOutputOnly = false;
     bool bDumpSymbols = false;
+    bool bOutline = false;
+    bool bOptimizeVarLayout = false;
+    bool bPeephole = false;
+    bool bStackAnalysis = false;
+    bool bEliminateUnusedMethods = false;
+    bool bPrintMemoryMap = false;
+    char* memoryMapJsonFilename = NULL;
+    bool bAsmTiming = false;
+    char* asmTimingJsonFilename = NULL;
+    long long runClocks = 0;
+    bool bProfile = false;
+    char* profileDumpFilename = NULL;
+    char* profileStacksFilename = NULL;
+    char* symbolIndexFilename = NULL;
+    char* symbolPrefix = NULL;
+    char* searchText = NULL;
+    bool bSearchWholeWord = false;
+    bool bDepFile = false;
+    char* depFilename = NULL;
+    char* manifestFilename = NULL;
     
     // Initialize standard and error out.
     InitOut();
@@ -544,6 +1325,32 @@ int mainOpenSpin(int argc, char* argv[])
                 break;
 
             case 'M':
+                // -MD, -MF and -MH are the dependency file and manifest, the eeprom size is always a number
+                if (argv[i][2] == 'D' && argv[i][3] == 0)
+                {
+                    bDepFile = true;
+                    break;
+                }
+                if (argv[i][2] == 'F' || argv[i][2] == 'H')
+                {
+                    char** ppFilename = (argv[i][2] == 'F') ? &depFilename : &manifestFilename;
+                    if (argv[i][3])
+                    {
+                        p = &argv[i][3];
+                    }
+                    else if (++i < argc)
+                    {
+                        p = argv[i];
+                    }
+                    else
+                    {
+                        Usage();
+                        CleanupMemory();
+                        return 1;
+                    }
+                    *ppFilename = p;
+                    break;
+                }
                 if (argv[i][2])
                 {
                     p = &argv[i][2];
@@ -655,14 +1462,30 @@ int mainOpenSpin(int argc, char* argv[])
                 bDumpSymbols = true;
                 break;
 
-            case 'r':
+            case 'l':
+                bOutline = true;
+                break;
+
+            case 'u':
+                bEliminateUnusedMethods = true;
+                break;
+
+            case 'S':
+                bStackAnalysis = true;
+                break;
+
+            case 'm':
+                bPrintMemoryMap = true;
+                break;
+
+            case 'j':
                 if(argv[i][2])
                 {
-                    p = &argv[i][2];
+                    memoryMapJsonFilename = &argv[i][2];
                 }
                 else if(++i < argc)
                 {
-                    p = argv[i];
+                    memoryMapJsonFilename = argv[i];
                 }
                 else
                 {
@@ -670,10 +1493,31 @@ int mainOpenSpin(int argc, char* argv[])
                     CleanupMemory();
                     return 1;
                 }
-                SetStdout(fopen(p, "w"));
                 break;
-                
-            case 'R':
+
+            case 'P':
+                bAsmTiming = true;
+                break;
+
+            case 'T':
+                if(argv[i][2])
+                {
+                    asmTimingJsonFilename = &argv[i][2];
+                }
+                else if(++i < argc)
+                {
+                    asmTimingJsonFilename = argv[i];
+                }
+                else
+                {
+                    Usage();
+                    CleanupMemory();
+                    return 1;
+                }
+                bAsmTiming = true;
+                break;
+
+            case 'X':
                 if(argv[i][2])
                 {
                     p = &argv[i][2];
@@ -688,38 +1532,284 @@ int mainOpenSpin(int argc, char* argv[])
                     CleanupMemory();
                     return 1;
                 }
-                SetStderr(fopen(p, "w"));
-                break;
-                
-            case 'h':
-            default:
+                sscanf(p, "%lld", &runClocks);
+                if (runClocks <= 0)
+                {
+                    Usage();
+                    CleanupMemory();
+                    return 1;
+                }
+                break;
+
+            case 'Q':
+                bProfile = true;
+                break;
+
+            case 'H':
+                if(argv[i][2])
+                {
+                    profileDumpFilename = &argv[i][2];
+                }
+                else if(++i < argc)
+                {
+                    profileDumpFilename = argv[i];
+                }
+                else
+                {
+                    Usage();
+                    CleanupMemory();
+                    return 1;
+                }
+                bProfile = true;
+                break;
+
+            case 'G':
+                if(argv[i][2])
+                {
+                    profileStacksFilename = &argv[i][2];
+                }
+                else if(++i < argc)
+                {
+                    profileStacksFilename = argv[i];
+                }
+                else
+                {
+                    Usage();
+                    CleanupMemory();
+                    return 1;
+                }
+                bProfile = true;
+                break;
+
+            case 'i':
+                if(argv[i][2])
+                {
+                    symbolIndexFilename = &argv[i][2];
+                }
+                else if(++i < argc)
+                {
+                    symbolIndexFilename = argv[i];
+                }
+                else
+                {
+                    Usage();
+                    CleanupMemory();
+                    return 1;
+                }
+                break;
+
+            case 'k':
+                if(argv[i][2])
+                {
+                    symbolPrefix = &argv[i][2];
+                }
+                else if(++i < argc)
+                {
+                    symbolPrefix = argv[i];
+                }
+                else
+                {
+                    Usage();
+                    CleanupMemory();
+                    return 1;
+                }
+                break;
+
+            case 'F':
+                if(argv[i][2])
+                {
+                    searchText = &argv[i][2];
+                }
+                else if(++i < argc)
+                {
+                    searchText = argv[i];
+                }
+                else
+                {
+                    Usage();
+                    CleanupMemory();
+                    return 1;
+                }
+                break;
+
+            case 'w':
+                bSearchWholeWord = true;
+                break;
+
+            case 'W':
+                s_bWatch = true;
+                break;
+
+            case 'O':
+                if(argv[i][2])
+                {
+                    p = &argv[i][2];
+                }
+                else if(++i < argc)
+                {
+                    p = argv[i];
+                }
+                else
+                {
+                    Usage();
+                    CleanupMemory();
+                    return 1;
+                }
+                for (; *p; p++)
+                {
+                    switch (*p)
+                    {
+                    case 'v':
+                        bOptimizeVarLayout = true;
+                        break;
+                    case 'p':
+                        bPeephole = true;
+                        break;
+                    case 'f':
+                        s_bFoldMethods = true;
+                        break;
+                    default:
+                        Usage();
+                        CleanupMemory();
+                        return 1;
+                    }
+                }
+                break;
+
+            case 'r':
+                if(argv[i][2])
+                {
+                    p = &argv[i][2];
+                }
+                else if(++i < argc)
+                {
+                    p = argv[i];
+                }
+                else
+                {
+                    Usage();
+                    CleanupMemory();
+                    return 1;
+                }
+                SetStdout(fopen(p, "w"));
+                break;
+                
+            case 'R':
+                if(argv[i][2])
+                {
+                    p = &argv[i][2];
+                }
+                else if(++i < argc)
+                {
+                    p = argv[i];
+                }
+                else
+                {
+                    Usage();
+                    CleanupMemory();
+                    return 1;
+                }
+                SetStderr(fopen(p, "w"));
+                break;
+                
+            case 'h':
+            default:
                 Usage();
                 CleanupMemory();
                 return 1;
                 break;
             }
         }
-        else // handle the input filename
+        else if (argv[i][0] == '@') // a response file listing the spin files of a batch
         {
-            if (infile)
+            if (!ReadBatchResponseFile(&argv[i][1]))
             {
-                Usage();
                 CleanupMemory();
                 return 1;
             }
-            infile = argv[i];
+            s_bBatch = true;
         }
+        else // handle the input filename
+        {
+            AddBatchTarget(argv[i]);
+        }
+    }
+
+    // more than one spin file is a batch, they are built in turn
+    if (GetBatchTargetCount() > 1)
+    {
+        s_bBatch = true;
+    }
+    if (GetBatchTargetCount() > 0)
+    {
+        infile = GetBatchTarget(0)->pFilename;
+    }
+
+    // looking up symbols needs an index, and without a spin file that is all there is to do
+    if (symbolPrefix && !symbolIndexFilename)
+    {
+        Usage();
+        CleanupMemory();
+        return 1;
+    }
+    if (symbolPrefix && !infile)
+    {
+        int result = LookupSymbols(symbolIndexFilename, symbolPrefix) ? 0 : 1;
+        CleanupMemory();
+        return result;
+    }
+
+    // must have input file, and the profile has to come from somewhere
+    if (!infile || (profileStacksFilename && !profileDumpFilename && runClocks == 0))
+    {
+        Usage();
+        CleanupMemory();
+        return 1;
+    }
+
+    // watch mode only keeps the output file up to date
+    if (s_bWatch && (bFileTreeOutputOnly || bFileListOutputOnly || searchText || bDumpSymbols || bOutline || symbolIndexFilename ||
+                     bEliminateUnusedMethods || bStackAnalysis || bPrintMemoryMap || memoryMapJsonFilename || bAsmTiming ||
+                     runClocks > 0 || bProfile || bVerbose || bDocMode))
+    {
+        Usage();
+        CleanupMemory();
+        return 1;
+    }
+
+    // the dependency file and manifest are written when a build finishes, and the manifest
+    // can only stand in for a build whose results are all in files
+    if ((bDepFile || depFilename || manifestFilename) && (s_bWatch || bOutline))
+    {
+        Usage();
+        CleanupMemory();
+        return 1;
+    }
+    if (manifestFilename && (bFileTreeOutputOnly || bFileListOutputOnly || searchText || bDumpSymbols || runClocks > 0 || profileDumpFilename))
+    {
+        Usage();
+        CleanupMemory();
+        return 1;
     }
 
-    // must have input file
-    if (!infile)
+    // a batch builds the output file of each spin file and nothing else
+    if (s_bBatch && (outfile || bFileTreeOutputOnly || bFileListOutputOnly || searchText || bDumpSymbols || bOutline || s_bWatch ||
+                     symbolIndexFilename || bEliminateUnusedMethods || bStackAnalysis || bPrintMemoryMap || memoryMapJsonFilename ||
+                     bAsmTiming || runClocks > 0 || bProfile || profileDumpFilename || s_bFoldMethods || bVerbose || bDocMode ||
+                     bDepFile || depFilename || manifestFilename))
     {
         Usage();
         CleanupMemory();
         return 1;
     }
 
-    if (bFileTreeOutputOnly || bFileListOutputOnly || bDumpSymbols)
+    // searching only needs to know which files the build reads, so it is treated like -f
+    if (searchText)
+    {
+        bFileListOutputOnly = true;
+    }
+
+    if (bFileTreeOutputOnly || bFileListOutputOnly || bDumpSymbols || bOutline)
     {
         bQuiet = true;
     }
@@ -727,96 +1817,85 @@ int mainOpenSpin(int argc, char* argv[])
     if (s_bUsePreprocessor)
     {
         pp_init(&s_preprocessor, s_bAlternatePreprocessorMode);
-
-        // go through the command line arguments again, this time only processing -D
-        for(int i = 1; i < argc; i++)
+        if (!DefineSymbols(argc, argv))
         {
-            // handle switches
-            if(argv[i][0] == '-')
-            {
-                if (argv[i][1] == 'D')
-                {
-                    if (s_bUsePreprocessor)
-                    {
-                        if (argv[i][2])
-                        {
-                            p = &argv[i][2];
-                        }
-                        else if(++i < argc)
-                        {
-                            p = argv[i];
-                        }
-                        else
-                        {
-                            Usage();
-                            CleanupMemory();
-                            return 1;
-                        }
-                        // add any predefined symbols here - note that when using the 
-                        // "alternate" rules, these symbols have a null value - i.e.
-                        // they are just "defined", but are not used in macro substitution
-                        pp_define(&s_preprocessor, p, (s_bAlternatePreprocessorMode ? "" : "1"));
-                    }
-                    else
-                    {
-                        Usage();
-                        CleanupMemory();
-                        return 1;
-                    }
-                }
-            }
+            Usage();
+            CleanupMemory();
+            return 1;
         }
-
-        // add symbols with predefined values here
-        pp_define(&s_preprocessor, "__SPIN__", "1");
-        pp_define(&s_preprocessor, "__TARGET__", "P1");
-
         pp_setcomments(&s_preprocessor, "\'", "{", "}");
     }
 
-    // finish the include path
-    AddFilePath(infile);
+    // finish the include path (each build of a batch adds its own)
+    if (!s_bBatch)
+    {
+        AddFilePath(infile);
+    }
+
+    if (bOutline)
+    {
+        s_pCompilerData = InitStruct();
+        int result = PrintOutline(infile) ? 0 : 1;
+        CleanupMemory();
+        return result;
+    }
 
     char outputFilename[256];
-    if (!outfile)
+    if (s_bBatch)
     {
-        // create *.binary filename from user passed in spin filename
-        strcpy(&outputFilename[0], infile);
-        const char* pTemp = strstr(&outputFilename[0], ".spin");
-        if (pTemp == 0)
+        // each build of the batch names its own
+        outputFilename[0] = 0;
+    }
+    else if (!outfile)
+    {
+        if (!MakeOutputFilename(infile, bDATonly, bBinary, outputFilename))
         {
-            fprintf(GetStdout(), "ERROR: spinfile must have .spin extension. You passed in: %s\n", infile);
             Usage();
             CleanupMemory();
             return 1;
         }
-        else
-        {
-            int offset = (int) (pTemp - &outputFilename[0]);
-            outputFilename[offset+1] = 0;
-            if (bDATonly)
-            {
-                strcat(&outputFilename[0], "dat");
-            }
-            else if (bBinary)
-            {
-                strcat(&outputFilename[0], "binary");
-            }
-            else 
-            {
-                strcat(&outputFilename[0], "eeprom");
-            }
-        }
     }
     else // use filename specified with -o
     {
         strcpy(outputFilename, outfile);
     }
 
+    // -MD puts the dependency file next to the output, with a .d extension
+    char depFilenameBuffer[256+2];
+    if (bDepFile && !depFilename)
+    {
+        strcpy(depFilenameBuffer, outputFilename);
+        char* pExtension = strrchr(depFilenameBuffer, '.');
+        if (pExtension && !strchr(pExtension, DIR_SEP))
+        {
+            *pExtension = 0;
+        }
+        strcat(depFilenameBuffer, ".d");
+        depFilename = depFilenameBuffer;
+    }
+
+    unsigned long long optionsHash = 0;
+    if (manifestFilename)
+    {
+        optionsHash = HashOptions(argc, argv);
+        if (IsUpToDate(manifestFilename, optionsHash))
+        {
+            if (!bQuiet)
+            {
+                fprintf(GetStdout(), "%s is up to date.\n", outputFilename);
+            }
+            CleanupMemory();
+            return 0;
+        }
+    }
+
     if (!bQuiet)
     {
         Banner();
-        fprintf(GetStdout(), "Compiling...\n%s\n", infile);
+        if (!s_bBatch)
+        {
+            fprintf(GetStdout(), "Compiling...\n%s\n", infile);
+        }
     }
 
     if (bFileTreeOutputOnly)
@@ -844,6 +1923,11 @@ int mainOpenSpin(int argc, char* argv[])
     s_pCompilerData->bDATonly = bDATonly;
     s_pCompilerData->bBinary = bBinary;
     s_pCompilerData->eeprom_size = eeprom_size;
+    s_pCompilerData->bOptimizeVarLayout = bOptimizeVarLayout;
+    s_pCompilerData->bPeephole = bPeephole;
+    s_pCompilerData->bStackAnalysis = bStackAnalysis;
+    s_pCompilerData->bAsmTiming = bAsmTiming && !bFileTreeOutputOnly && !bFileListOutputOnly;
+    s_pCompilerData->bProfile = bProfile && !bFileTreeOutputOnly && !bFileListOutputOnly && !bDATonly;
 
     // allocate space for obj based on eeprom size command line option
     s_pCompilerData->obj_limit = eeprom_size > min_obj_limit ? eeprom_size : min_obj_limit;
@@ -857,7 +1941,71 @@ int mainOpenSpin(int argc, char* argv[])
         *pExtension = 0;
     }
 
-    if (!CompileRecursively(infile, bQuiet, bFileTreeOutputOnly))
+    s_bSymbolIndex = (symbolIndexFilename != NULL);
+    s_bMemoryMap = (bPrintMemoryMap || memoryMapJsonFilename != NULL) && !bFileTreeOutputOnly && !bFileListOutputOnly && !bDumpSymbols;
+
+    if (s_bWatch)
+    {
+        int result = WatchAndBuild(infile, outputFilename, bQuiet, bDATonly, bBinary, eeprom_size);
+        CleanupMemory();
+        return result;
+    }
+    if (s_bBatch)
+    {
+        int result = BuildBatch(argc, argv, bQuiet, bDATonly, bBinary, eeprom_size);
+        CleanupMemory();
+        return result;
+    }
+
+    // -t, -f, and -c don't use the PUB/PRI methods, so there is nothing to remove
+    if (bEliminateUnusedMethods && !bFileTreeOutputOnly && !bFileListOutputOnly && !bDATonly)
+    {
+        void *definestate = 0;
+        if (s_bUsePreprocessor)
+        {
+            definestate = pp_get_define_state(&s_preprocessor);
+        }
+
+        // compile the whole tree once to find the methods that can be reached from the first PUB
+        UnusedMethods_Begin();
+        if (!CompileRecursively(infile, true, false))
+        {
+            CleanupMemory();
+            return 1;
+        }
+        unsigned int fullSize = s_pCompilerData->psize;
+        int unusedCount = UnusedMethods_Resolve(infile);
+
+        // then compile it again without them, starting from scratch
+        CleanObjectHeap();
+        CleanProfile();
+        CleanSymbolIndex();
+        s_nObjStackPtr = 0;
+        if (s_bUsePreprocessor)
+        {
+            pp_restore_define_state(&s_preprocessor, definestate);
+        }
+        if (!CompileRecursively(infile, bQuiet, bFileTreeOutputOnly))
+        {
+            CleanupMemory();
+            return 1;
+        }
+        UnusedMethods_End();
+
+        if (!bQuiet)
+        {
+            fprintf(GetStdout(), "Removed %d unused methods, saving %d bytes\n", unusedCount, fullSize - s_pCompilerData->psize);
+        }
+    }
+    else if ((bFileTreeOutputOnly || bFileListOutputOnly) && !bDumpSymbols && !symbolIndexFilename && !s_pCompilerData->bProfile)
+    {
+        if (!ScanRecursively(infile, bFileTreeOutputOnly))
+        {
+            CleanupMemory();
+            return 1;
+        }
+    }
+    else if (!CompileRecursively(infile, bQuiet, bFileTreeOutputOnly))
     {
         CleanupMemory();
         return 1;
@@ -880,6 +2028,12 @@ int mainOpenSpin(int argc, char* argv[])
                 fwrite(pBuffer, bufferSize, 1, pFile);
                 fclose(pFile);
             }
+            if (runClocks > 0 && !bDATonly && !RunImage(infile, pBuffer, bufferSize, runClocks))
+            {
+                delete [] pBuffer;
+                CleanupMemory();
+                return 1;
+            }
         }
         else
         {
@@ -893,6 +2047,65 @@ int mainOpenSpin(int argc, char* argv[])
         }
 
         delete [] pBuffer;
+
+        if (s_bMemoryMap && !bDATonly)
+        {
+            if (!BuildMemoryMap(infile, s_pCompilerData))
+            {
+                fprintf(GetStdout(), "%s : error : Can not build the memory map.\n", infile);
+                CleanupMemory();
+                return 1;
+            }
+            if (bPrintMemoryMap)
+            {
+                PrintMemoryMap(GetStdout());
+            }
+            if (memoryMapJsonFilename && !WriteMemoryMapJson(memoryMapJsonFilename))
+            {
+                fprintf(GetStdout(), "%s : error : Can not write %s.\n", infile, memoryMapJsonFilename);
+                CleanupMemory();
+                return 1;
+            }
+        }
+    }
+
+    if (s_pCompilerData->bProfile && (runClocks > 0 || profileDumpFilename))
+    {
+        if (profileDumpFilename && !ReadProfileFile(profileDumpFilename))
+        {
+            fprintf(GetStdout(), "%s : error : Can not read the profile table from %s.\n", infile, profileDumpFilename);
+            CleanupMemory();
+            return 1;
+        }
+        PrintProfile(GetStdout());
+        if (profileStacksFilename && !WriteProfileFoldedStacks(profileStacksFilename))
+        {
+            fprintf(GetStdout(), "%s : error : Can not write %s.\n", infile, profileStacksFilename);
+            CleanupMemory();
+            return 1;
+        }
+    }
+
+    if (symbolIndexFilename)
+    {
+        if (!WriteSymbolIndex(symbolIndexFilename))
+        {
+            fprintf(GetStdout(), "%s : error : Can not write %s.\n", infile, symbolIndexFilename);
+            CleanupMemory();
+            return 1;
+        }
+        if (symbolPrefix && !LookupSymbols(symbolIndexFilename, symbolPrefix))
+        {
+            CleanupMemory();
+            return 1;
+        }
+    }
+
+    if (asmTimingJsonFilename && s_pCompilerData->bAsmTiming && !WritePasmTimingJson(asmTimingJsonFilename))
+    {
+        fprintf(GetStdout(), "%s : error : Can not write %s.\n", infile, asmTimingJsonFilename);
+        CleanupMemory();
+        return 1;
     }
 
     if (bDumpSymbols)
@@ -951,26 +2164,43 @@ int mainOpenSpin(int argc, char* argv[])
         }
     }
 
-    if (bFileListOutputOnly)
+    if (searchText)
+    {
+        SearchAccessedFiles(searchText, bSearchWholeWord);
+    }
+    else if (bFileListOutputOnly)
     {
+        // s_filesAccessed only holds unique paths
         for (int i = 0; i < s_nFilesAccessed; i++)
         {
-            for (int j = i+1; j < s_nFilesAccessed; j++)
-            {
-                if (strcmp(s_filesAccessed[i], s_filesAccessed[j]) == 0)
-                {
-                    s_filesAccessed[j][0] = 0;
-                }
-            }
+            fprintf(GetStdout(), "%s\n", s_filesAccessed[i]);
         }
+    }
 
-        for (int i = 0; i < s_nFilesAccessed; i++)
+    if (depFilename && !WriteDepFile(depFilename, outputFilename, s_filesAccessed, s_nFilesAccessed))
+    {
+        fprintf(GetStdout(), "%s : error : Can not write %s.\n", infile, depFilename);
+        CleanupMemory();
+        return 1;
+    }
+    if (manifestFilename)
+    {
+        // everything the build wrote, so a missing or changed output means building again
+        const char* outputs[] = { outputFilename, depFilename, memoryMapJsonFilename, symbolIndexFilename, asmTimingJsonFilename, profileStacksFilename };
+        int outputCount = 0;
+        for (int i = 0; i < (int)(sizeof(outputs) / sizeof(outputs[0])); i++)
         {
-            if (s_filesAccessed[i][0] != 0)
+            if (outputs[i])
             {
-                fprintf(GetStdout(), "%s\n", s_filesAccessed[i]);
+                outputs[outputCount++] = outputs[i];
             }
         }
+        if (!WriteManifest(manifestFilename, optionsHash, s_filesAccessed, s_nFilesAccessed, outputs, outputCount))
+        {
+            fprintf(GetStdout(), "%s : error : Can not write %s.\n", infile, manifestFilename);
+            CleanupMemory();
+            return 1;
+        }
     }
 
     if (bVerbose && !bQuiet && !bDATonly)
@@ -0,0 +1,278 @@
+///////////////////////////////////////////////////////////////
+//                                                           //
+// Propeller Spin/PASM Compiler Command Line Tool 'OpenSpin' //
+// (c)2012-2013 Parallax Inc. DBA Parallax Semiconductor.    //
+// See end of file for terms of use.                         //
+//                                                           //
+///////////////////////////////////////////////////////////////
+//
+// pasmtiming.cpp
+//
+// The compiler only keeps the estimates of the object it compiled last,
+// so they are copied out (with the source lines they refer to) after
+// each Compile2(). An object compiled again (e.g. by -u) replaces what
+// was recorded for it.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../PropellerCompiler/PropellerCompiler.h"
+#include "../PropellerCompiler/Utilities.h"
+#include "memorymap.h"
+#include "pasmtiming.h"
+
+// what a Compile2() of one object file left behind
+class PasmTimingObject : public Hashable
+{
+public:
+    char*                   m_pFilename;
+    AsmTimingInstruction*   m_pInstructions;
+    char**                  m_pLines;       // source line of each instruction
+    char**                  m_pLabels;      // label of each instruction ("" if none)
+    int                     m_instructionCount;
+    AsmTimingBlock*         m_pBlocks;
+    int                     m_blockCount;
+
+    PasmTimingObject(const char* pFilename)
+        : m_pInstructions(NULL)
+        , m_pLines(NULL)
+        , m_pLabels(NULL)
+        , m_instructionCount(0)
+        , m_pBlocks(NULL)
+        , m_blockCount(0)
+    {
+        m_pFilename = new char[strlen(pFilename) + 1];
+        strcpy(m_pFilename, pFilename);
+    }
+    virtual ~PasmTimingObject()
+    {
+        Clear();
+        delete [] m_pFilename;
+    }
+
+    void Clear()
+    {
+        for (int i = 0; i < m_instructionCount; i++)
+        {
+            delete [] m_pLines[i];
+            delete [] m_pLabels[i];
+        }
+        delete [] m_pLines;
+        m_pLines = NULL;
+        delete [] m_pLabels;
+        m_pLabels = NULL;
+        delete [] m_pInstructions;
+        m_pInstructions = NULL;
+        m_instructionCount = 0;
+        delete [] m_pBlocks;
+        m_pBlocks = NULL;
+        m_blockCount = 0;
+    }
+};
+
+static HashTable* s_pObjects = NULL;
+
+static PasmTimingObject* FindObject(const char* pFilename, bool bCreate)
+{
+    if (!s_pObjects)
+    {
+        if (!bCreate)
+        {
+            return NULL;
+        }
+        s_pObjects = new HashTable(PasmTimingIndexSize);
+    }
+
+    int hash = s_pObjects->GetStringHashUppercase(pFilename);
+    for (HashNode* pNode = s_pObjects->FindFirst(hash); pNode != 0; pNode = pNode->pNext)
+    {
+        if (pNode->key == hash && _stricmp(((PasmTimingObject*)pNode->pValue)->m_pFilename, pFilename) == 0)
+        {
+            return (PasmTimingObject*)pNode->pValue;
+        }
+    }
+
+    if (!bCreate)
+    {
+        return NULL;
+    }
+    PasmTimingObject* pObject = new PasmTimingObject(pFilename);
+    s_pObjects->Insert(hash, pObject);
+    return pObject;
+}
+
+// copies source, tabs become spaces and trailing spaces are dropped
+static char* CopySource(const char* pSource, int start, int finish)
+{
+    int length = finish - start;
+    char* pCopy = new char[length + 1];
+    for (int i = 0; i < length; i++)
+    {
+        pCopy[i] = (pSource[start + i] == 9) ? ' ' : pSource[start + i];
+    }
+    while (length > 0 && pCopy[length - 1] == ' ')
+    {
+        length--;
+    }
+    pCopy[length] = 0;
+    return pCopy;
+}
+
+void EnterObjectIntoPasmTiming(const char* pFilename, CompilerData* pCompilerData)
+{
+    PasmTimingObject* pObject = FindObject(pFilename, true);
+    pObject->Clear();
+
+    int count = AsmTiming_GetInstructionCount();
+    if (count > 0)
+    {
+        pObject->m_pInstructions = new AsmTimingInstruction[count];
+        pObject->m_pLines = new char*[count];
+        pObject->m_pLabels = new char*[count];
+        for (int i = 0; i < count; i++)
+        {
+            const AsmTimingInstruction* pInstruction = AsmTiming_GetInstruction(i);
+            pObject->m_pInstructions[i] = *pInstruction;
+            pObject->m_pLines[i] = CopySource(pCompilerData->source, pInstruction->lineStart, pInstruction->lineFinish);
+            pObject->m_pLabels[i] = CopySource(pCompilerData->source, pInstruction->labelStart, pInstruction->labelFinish);
+        }
+        pObject->m_instructionCount = count;
+    }
+
+    count = AsmTiming_GetBlockCount();
+    if (count > 0)
+    {
+        pObject->m_pBlocks = new AsmTimingBlock[count];
+        for (int i = 0; i < count; i++)
+        {
+            pObject->m_pBlocks[i] = *AsmTiming_GetBlock(i);
+        }
+        pObject->m_blockCount = count;
+    }
+}
+
+static void FormatCycles(char* pBuffer, int minCycles, int maxCycles)
+{
+    if (maxCycles == asm_timing_waits)
+    {
+        sprintf(pBuffer, "%d+", minCycles);
+    }
+    else if (minCycles == maxCycles)
+    {
+        sprintf(pBuffer, "%d", minCycles);
+    }
+    else
+    {
+        sprintf(pBuffer, "%d..%d", minCycles, maxCycles);
+    }
+}
+
+void PrintPasmTiming(FILE* pFile, const char* pFilename)
+{
+    PasmTimingObject* pObject = FindObject(pFilename, false);
+    if (!pObject || pObject->m_instructionCount == 0)
+    {
+        return;
+    }
+
+    fprintf(pFile, "%s : %d PASM instructions\n", pFilename, pObject->m_instructionCount);
+    for (int i = 0; i < pObject->m_blockCount; i++)
+    {
+        const AsmTimingBlock& block = pObject->m_pBlocks[i];
+        char cycles[32];
+        FormatCycles(cycles, block.minCycles, block.maxCycles);
+        const char* pLabel = pObject->m_pLabels[block.first];
+        fprintf(pFile, "    %s %s%s%03X-%03X : %s cycles%s\n", block.bLoop ? "loop " : "block", pLabel, pLabel[0] ? " " : "",
+                pObject->m_pInstructions[block.first].cogAddress, pObject->m_pInstructions[block.first + block.count - 1].cogAddress,
+                cycles, block.bLoop ? " per pass" : "");
+    }
+}
+
+static void WriteJsonCycles(FILE* pFile, int minCycles, int maxCycles)
+{
+    if (maxCycles == asm_timing_waits)
+    {
+        fprintf(pFile, "\"min_cycles\": %d, \"max_cycles\": null", minCycles);
+    }
+    else
+    {
+        fprintf(pFile, "\"min_cycles\": %d, \"max_cycles\": %d", minCycles, maxCycles);
+    }
+}
+
+bool WritePasmTimingJson(const char* pPath)
+{
+    FILE* pFile = fopen(pPath, "w");
+    if (!pFile)
+    {
+        return false;
+    }
+
+    fprintf(pFile, "{\n  \"objects\": [");
+    int objectCount = 0;
+    for (HashNode* pNode = s_pObjects ? s_pObjects->First() : NULL; pNode != 0; pNode = s_pObjects->Next(pNode))
+    {
+        PasmTimingObject* pObject = (PasmTimingObject*)pNode->pValue;
+        fprintf(pFile, "%s\n    {\"name\": ", objectCount++ > 0 ? "," : "");
+        WriteJsonString(pFile, pObject->m_pFilename);
+
+        fprintf(pFile, ",\n     \"instructions\": [");
+        for (int i = 0; i < pObject->m_instructionCount; i++)
+        {
+            const AsmTimingInstruction& instruction = pObject->m_pInstructions[i];
+            fprintf(pFile, "%s\n       {\"cog\": %d, \"offset\": %d, \"instruction\": \"%08X\", ", i > 0 ? "," : "",
+                    instruction.cogAddress, instruction.objOffset, instruction.instruction);
+            WriteJsonCycles(pFile, instruction.minCycles, instruction.maxCycles);
+            fprintf(pFile, ", \"label\": ");
+            WriteJsonString(pFile, pObject->m_pLabels[i]);
+            fprintf(pFile, ", \"source\": ");
+            WriteJsonString(pFile, pObject->m_pLines[i]);
+            fprintf(pFile, "}");
+        }
+        fprintf(pFile, "],\n     \"blocks\": [");
+        for (int i = 0; i < pObject->m_blockCount; i++)
+        {
+            const AsmTimingBlock& block = pObject->m_pBlocks[i];
+            fprintf(pFile, "%s\n       {\"label\": ", i > 0 ? "," : "");
+            WriteJsonString(pFile, pObject->m_pLabels[block.first]);
+            fprintf(pFile, ", \"loop\": %s, \"first\": %d, \"count\": %d, \"cog\": %d, ", block.bLoop ? "true" : "false",
+                    block.first, block.count, pObject->m_pInstructions[block.first].cogAddress);
+            WriteJsonCycles(pFile, block.minCycles, block.maxCycles);
+            fprintf(pFile, "}");
+        }
+        fprintf(pFile, "]}");
+    }
+    fprintf(pFile, "\n  ]\n}\n");
+
+    fclose(pFile);
+    return true;
+}
+
+void CleanPasmTiming()
+{
+    delete s_pObjects;
+    s_pObjects = NULL;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
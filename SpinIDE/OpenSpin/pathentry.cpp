@@ -18,9 +18,12 @@
 //
 #include <dirent.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <sys/stat.h>
 
+#include "../PropellerCompiler/Utilities.h"
 #include "pathentry.h"
 
 #define CASE_SENSITIVE 0
@@ -30,6 +33,72 @@ static PathEntry **pNextPathEntry = &path;
 
 static char lastfullpath[PATH_MAX];
 
+#define ResolvedPathIndexSize   256
+
+// cached result of searching for a file name, found or not
+class ResolvedPath : public Hashable
+{
+public:
+    char* m_pName;          // name as requested
+    char* m_pPath;          // path to open, NULL if the name was not found
+    char* m_pAccessedPath;  // path to report as accessed (full path when possible)
+
+    ResolvedPath(const char* pName, const char* pPath, const char* pAccessedPath)
+    {
+        m_pName = StrDup(pName);
+        m_pPath = pPath ? StrDup(pPath) : NULL;
+        m_pAccessedPath = StrDup(pAccessedPath);
+    }
+    virtual ~ResolvedPath()
+    {
+        delete [] m_pName;
+        delete [] m_pPath;
+        delete [] m_pAccessedPath;
+    }
+
+private:
+    static char* StrDup(const char* pString)
+    {
+        char* pCopy = new char[strlen(pString) + 1];
+        strcpy(pCopy, pString);
+        return pCopy;
+    }
+};
+
+static HashTable* s_pResolvedPaths = NULL;
+
+#define CaseNameIndexSize       64
+
+// a file name in an include directory, found by its case-folded hash
+class CaseName : public Hashable
+{
+public:
+    char* m_pName;
+
+    CaseName(const char* pName)
+    {
+        m_pName = new char[strlen(pName) + 1];
+        strcpy(m_pName, pName);
+    }
+    virtual ~CaseName()
+    {
+        delete [] m_pName;
+    }
+};
+
+// forget any cached results, they are stale once the path list changes (or files are added between watched builds)
+void ClearResolvedPaths()
+{
+    delete s_pResolvedPaths;
+    s_pResolvedPaths = NULL;
+
+    for (PathEntry* entry = path; entry != NULL; entry = entry->next)
+    {
+        delete entry->caseNames;
+        entry->caseNames = NULL;
+    }
+}
+
 int strcasecmp(char const *a, char const *b)
 {
     for (;; a++, b++) {
@@ -39,34 +108,148 @@ int strcasecmp(char const *a, char const *b)
     }
 }
 
+// reads the directory of an entry once, so each new name is matched without scanning it again
+static HashTable *GetCaseNames(PathEntry *entry)
+{
+    if (!entry->caseNames)
+    {
+        entry->caseNames = new HashTable(CaseNameIndexSize);
+
+        DIR *dir;
+        struct dirent *ent;
+        if ((dir = opendir(entry->path)) != NULL) {
+            while ((ent = readdir (dir)) != NULL) {
+                int hash = entry->caseNames->GetStringHashUppercase(ent->d_name);
+                HashNode* pNode = entry->caseNames->FindFirst(hash);
+                for (; pNode != 0; pNode = pNode->pNext)
+                {
+                    CaseName* pCaseName = (CaseName*)pNode->pValue;
+                    if (pNode->key == hash && strcasecmp(pCaseName->m_pName, ent->d_name) == 0)
+                    {
+                        // the last name that differs only in case wins, as it did when scanning
+                        delete pNode->pValue;
+                        pNode->pValue = new CaseName(ent->d_name);
+                        break;
+                    }
+                }
+                if (!pNode)
+                {
+                    entry->caseNames->Insert(hash, new CaseName(ent->d_name));
+                }
+            }
+            closedir (dir);
+        }
+    }
+    return entry->caseNames;
+}
+
 const char *MakeNextPath(PathEntry **entry, const char *name)
 {
-    if (!*entry)
+    for (;;)
     {
-        *entry = path;
+        if (!*entry)
+        {
+            *entry = path;
+        }
+        else
+        {
+            *entry = (*entry)->next;
+        }
+        if (!*entry)
+        {
+            return NULL;
+        }
+
+        const char *caseName = name;
+        if (!CASE_SENSITIVE) {
+            HashTable *caseNames = GetCaseNames(*entry);
+            int hash = caseNames->GetStringHashUppercase(name);
+            for (HashNode* pNode = caseNames->FindFirst(hash); pNode != 0; pNode = pNode->pNext)
+            {
+                CaseName* pCaseName = (CaseName*)pNode->pValue;
+                if (pNode->key == hash && strcasecmp(pCaseName->m_pName, name) == 0)
+                {
+                    caseName = pCaseName->m_pName;
+                    break;
+                }
+            }
+        }
+        // a path that does not fit can not name a file, try the next entry
+        if (snprintf(lastfullpath, sizeof(lastfullpath), "%s%c%s", (*entry)->path, DIR_SEP, caseName) < (int)sizeof(lastfullpath))
+        {
+            return lastfullpath;
+        }
     }
-    else
+}
+
+static bool FileExists(const char *name)
+{
+    struct stat statBuffer;
+    return (stat(name, &statBuffer) == 0) && !S_ISDIR(statBuffer.st_mode);
+}
+
+const char *ResolvePath(const char *name, const char **ppAccessedPath)
+{
+    if (!s_pResolvedPaths)
     {
-        *entry = (*entry)->next;
+        s_pResolvedPaths = new HashTable(ResolvedPathIndexSize);
     }
-    if (*entry)
+
+    // have we already looked for this name?
+    int hash = s_pResolvedPaths->GetStringHash(name);
+    for (HashNode* pNode = s_pResolvedPaths->FindFirst(hash); pNode != 0; pNode = pNode->pNext)
     {
-        char *caseName = (char *) name;
-        if (!CASE_SENSITIVE) {
-            DIR *dir;
-            struct dirent *ent;
-            if ((dir = opendir((*entry)->path)) != NULL) {
-                while ((ent = readdir (dir)) != NULL) {
-                    if (strcasecmp(ent->d_name, name) == 0)
-                        caseName = ent->d_name;
-                }
-                closedir (dir);
+        ResolvedPath* pResolved = (ResolvedPath*)pNode->pValue;
+        if (pNode->key == hash && strcmp(pResolved->m_pName, name) == 0)
+        {
+            *ppAccessedPath = pResolved->m_pAccessedPath;
+            return pResolved->m_pPath;
+        }
+    }
+
+    // try the name as given, then each entry in the include path
+    const char* pPath = NULL;
+    const char* pTryPath = NULL;
+    if (FileExists(name))
+    {
+        pPath = name;
+    }
+    else
+    {
+        PathEntry* entry = NULL;
+        while ((pTryPath = MakeNextPath(&entry, name)) != NULL)
+        {
+            if (FileExists(pTryPath))
+            {
+                pPath = pTryPath;
+                break;
             }
         }
-        sprintf(lastfullpath, "%s%c%s", (*entry)->path, DIR_SEP, caseName);
-        return lastfullpath;
     }
-    return NULL;
+
+    // files found in the include path are reported by that path, otherwise use the full path of the name
+    char accessedPath[PATH_MAX];
+    if (pTryPath)
+    {
+        strcpy(accessedPath, pTryPath);
+    }
+    else
+    {
+#ifdef WIN32
+        if (_fullpath(accessedPath, name, PATH_MAX) == NULL)
+#else
+        if (realpath(name, accessedPath) == NULL)
+#endif
+        {
+            strcpy(accessedPath, name);
+        }
+    }
+
+    ResolvedPath* pResolved = new ResolvedPath(name, pPath, accessedPath);
+    s_pResolvedPaths->Insert(hash, pResolved);
+
+    *ppAccessedPath = pResolved->m_pAccessedPath;
+    return pResolved->m_pPath;
 }
 
 bool AddPath(const char *path)
@@ -80,6 +263,8 @@ bool AddPath(const char *path)
     *pNextPathEntry = entry;
     pNextPathEntry = &entry->next;
     entry->next = NULL;
+    entry->caseNames = NULL;
+    ClearResolvedPaths();
     return true;
 }
 
@@ -101,12 +286,34 @@ bool AddFilePath(const char *name)
     *pNextPathEntry = entry;
     pNextPathEntry = &entry->next;
     entry->next = NULL;
+    entry->caseNames = NULL;
+    ClearResolvedPaths();
 
     return true;
 }
 
+// takes off the entry added last (batch builds add the directory of each spin file in turn)
+void RemoveLastPath()
+{
+    if (!path)
+    {
+        return;
+    }
+    PathEntry **ppEntry = &path;
+    while ((*ppEntry)->next != NULL)
+    {
+        ppEntry = &(*ppEntry)->next;
+    }
+    ClearResolvedPaths();
+    delete [] *ppEntry;
+    *ppEntry = NULL;
+    pNextPathEntry = ppEntry;
+}
+
 void CleanupPathEntries()
 {
+    ClearResolvedPaths();
+
     PathEntry *entry = path;
     while (entry != NULL)
     {
@@ -25,16 +25,24 @@
 #define DIR_SEP_STR "/"
 #endif
 
+class HashTable;
+
 struct PathEntry
 {
     PathEntry *next;
+    HashTable *caseNames; // case-folded listing of the directory, read on first use and dropped with the resolved paths
     char path[1];
 };
 
 const char *MakeNextPath(PathEntry **entry, const char *name); // pass the address of an entry that is NULL to get first path, keep calling with same entry to walk list
+const char *ResolvePath(const char *name, const char **ppAccessedPath); // returns path to open name with (or NULL if not found), results are cached until CleanupPathEntries()
 bool AddPath(const char *path);
 bool AddFilePath(const char *name);
+void RemoveLastPath();
 void CleanupPathEntries();
+void ClearResolvedPaths(); // forgets what ResolvePath() found (or did not find), files may have come or gone since
+const char *FindFileInPath(const char *name); // the path ResolvePath() gives, the file is recorded as read by the build (in openspin.cpp)
+FILE *OpenFileInPath(const char *name, const char *mode); // opens the path ResolvePath() gives, the file is recorded as read by the build (in openspin.cpp)
 
 ///////////////////////////////////////////////////////////////////////////////////////////
 //                           TERMS OF USE: MIT License                                   //
@@ -281,28 +281,8 @@ pp_push_file(struct preprocess *pp, const char *name)
 {
     FILE *f;
 
-    f = fopen(name, "rb");
-    if (!f)
-    {
-       // try opening file using path
-        PathEntry* entry = NULL;
-        while(!f)
-        {
-            const char* pTryPath = MakeNextPath(&entry, name);
-            if (pTryPath)
-            {
-                f = fopen(pTryPath, "rb");
-                if (f != NULL)
-                {
-                    break;
-                }
-            }
-            else
-            {
-                break;
-            }
-        }
-    }
+    // the name as given or along the path, includes are recorded with the other files the build reads
+    f = OpenFileInPath(name, "rb");
     if (!f) {
         doerror(pp, "Unable to open file %s", name);
         return;
@@ -0,0 +1,316 @@
+///////////////////////////////////////////////////////////////
+//                                                           //
+// Propeller Spin/PASM Compiler Command Line Tool 'OpenSpin' //
+// (c)2012-2013 Parallax Inc. DBA Parallax Semiconductor.    //
+// See end of file for terms of use.                         //
+//                                                           //
+///////////////////////////////////////////////////////////////
+//
+// profile.cpp
+//
+// Every Compile2() with bProfile set numbers the methods of the object
+// from profile_first_method on, so each compile takes the next free
+// numbers and records what they are (object, method and the source lines
+// it spans). The table of the running image only holds numbers, these
+// give them names again.
+//
+// Each method only remembers the method that called it last, so the
+// folded stacks are built by following those back to the top, a method
+// called from more than one place is shown under its last caller. A
+// recursive call doesn't replace the caller, so a recursive method is
+// shown under the method that called it from outside.
+//
+// The inclusive clocks of a recursive method count the time of each
+// nested call again in every call around it, so they can add up to more
+// than the whole run.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../PropellerCompiler/PropellerCompiler.h"
+#include "../PropellerCompiler/Utilities.h"
+#include "profile.h"
+
+#define ProfileDepthLimit       64      // callers followed for a folded stack
+
+struct ProfileMethod
+{
+    char*           pObject;        // filename without the path and .spin
+    char*           pFilename;
+    char*           pName;
+    int             firstLine;
+    int             lastLine;
+    unsigned int    calls;
+    unsigned int    cycles;
+    unsigned int    childCycles;
+    int             caller;
+};
+
+static ProfileMethod s_methods[profile_method_limit];
+static int s_nextMethod = 1;
+static int s_current = 0;           // running method when the table was read
+static bool s_bRead = false;
+
+static char* CopyString(const char* pString, int length)
+{
+    char* pCopy = new char[length + 1];
+    memcpy(pCopy, pString, length);
+    pCopy[length] = 0;
+    return pCopy;
+}
+
+static int LineOf(const char* pSource, int offset)
+{
+    int line = 1;
+    for (int i = 0; i < offset; i++)
+    {
+        if (pSource[i] == 13)
+        {
+            line++;
+        }
+    }
+    return line;
+}
+
+static void ClearMethod(ProfileMethod& method)
+{
+    delete [] method.pObject;
+    delete [] method.pFilename;
+    delete [] method.pName;
+    memset(&method, 0, sizeof(ProfileMethod));
+}
+
+int GetNextProfileMethod()
+{
+    return s_nextMethod;
+}
+
+void EnterObjectIntoProfile(const char* pFilename, CompilerData* pCompilerData)
+{
+    const char* pObject = strrchr(pFilename, '/');
+    pObject = pObject ? pObject + 1 : pFilename;
+    const char* pExtension = strstr(pObject, ".spin");
+    int objectLength = pExtension ? (int)(pExtension - pObject) : (int)strlen(pObject);
+
+    int first = pCompilerData->profile_first_method;
+    for (int i = 0; i < pCompilerData->info_count; i++)
+    {
+        if (pCompilerData->info_type[i] != info_pub && pCompilerData->info_type[i] != info_pri)
+        {
+            continue;
+        }
+        int index = first + (pCompilerData->info_data4[i] & 0xFFFF);
+        if (index <= 0 || index >= profile_method_limit)
+        {
+            continue;
+        }
+        ProfileMethod& method = s_methods[index];
+        ClearMethod(method);
+        method.pObject = CopyString(pObject, objectLength);
+        method.pFilename = CopyString(pFilename, (int)strlen(pFilename));
+        method.pName = CopyString(&pCompilerData->source[pCompilerData->info_data2[i]], pCompilerData->info_data3[i] - pCompilerData->info_data2[i]);
+        method.firstLine = LineOf(pCompilerData->source, pCompilerData->info_start[i]);
+        method.lastLine = LineOf(pCompilerData->source, pCompilerData->info_finish[i] - 1); // finish is at the start of the next block
+        if (index >= s_nextMethod)
+        {
+            s_nextMethod = index + 1;
+        }
+    }
+}
+
+static unsigned int ReadLong(const unsigned char* pData)
+{
+    return (unsigned int)pData[0] | ((unsigned int)pData[1] << 8) | ((unsigned int)pData[2] << 16) | ((unsigned int)pData[3] << 24);
+}
+
+bool ReadProfile(const unsigned char* pData, int size)
+{
+    if (size >= profile_table_address + profile_table_size)
+    {
+        pData += profile_table_address;
+    }
+    else if (size != profile_table_size)
+    {
+        return false;
+    }
+
+    s_current = (int)ReadLong(&pData[profile_current]);
+    for (int i = 1; i < s_nextMethod; i++)
+    {
+        const unsigned char* pEntry = &pData[i * profile_entry_size];
+        s_methods[i].calls = ReadLong(&pEntry[profile_entry_calls]);
+        s_methods[i].cycles = ReadLong(&pEntry[profile_entry_cycles]);
+        s_methods[i].childCycles = ReadLong(&pEntry[profile_entry_child]);
+        s_methods[i].caller = (int)ReadLong(&pEntry[profile_entry_caller]);
+    }
+    s_bRead = true;
+    return true;
+}
+
+bool ReadProfileFile(const char* pPath)
+{
+    FILE* pFile = fopen(pPath, "rb");
+    if (!pFile)
+    {
+        return false;
+    }
+    fseek(pFile, 0, SEEK_END);
+    int size = (int)ftell(pFile);
+    fseek(pFile, 0, SEEK_SET);
+    if (size <= 0)
+    {
+        fclose(pFile);
+        return false;
+    }
+    unsigned char* pData = new unsigned char[size];
+    bool bResult = (fread(pData, 1, size, pFile) == (size_t)size) && ReadProfile(pData, size);
+    fclose(pFile);
+    delete [] pData;
+    return bResult;
+}
+
+// clocks spent in the method itself, what its callees took is in childCycles
+static unsigned int SelfCycles(const ProfileMethod& method)
+{
+    return (method.cycles > method.childCycles) ? method.cycles - method.childCycles : 0;
+}
+
+static bool IsValidMethod(int index)
+{
+    return index > 0 && index < s_nextMethod && s_methods[index].pName != NULL;
+}
+
+static int CompareSelfCycles(const void* pLeft, const void* pRight)
+{
+    const ProfileMethod& left = s_methods[*(const int*)pLeft];
+    const ProfileMethod& right = s_methods[*(const int*)pRight];
+    unsigned int leftSelf = SelfCycles(left);
+    unsigned int rightSelf = SelfCycles(right);
+    if (leftSelf != rightSelf)
+    {
+        return (leftSelf > rightSelf) ? -1 : 1;
+    }
+    if (left.calls != right.calls)
+    {
+        return (left.calls > right.calls) ? -1 : 1;
+    }
+    return *(const int*)pLeft - *(const int*)pRight;
+}
+
+void PrintProfile(FILE* pFile)
+{
+    if (!s_bRead)
+    {
+        return;
+    }
+
+    int order[profile_method_limit];
+    int count = 0;
+    double totalSelf = 0;
+    for (int i = 1; i < s_nextMethod; i++)
+    {
+        if (IsValidMethod(i) && s_methods[i].calls > 0)
+        {
+            order[count++] = i;
+            totalSelf += SelfCycles(s_methods[i]);
+        }
+    }
+    qsort(order, count, sizeof(int), CompareSelfCycles);
+
+    fprintf(pFile, "Profile of %d called methods (clocks from CNT, sorted by self):\n", count);
+    fprintf(pFile, "(inclusive counts the clocks of a recursive call again in each call it is nested in)\n");
+    fprintf(pFile, "        self  self%%   inclusive       calls    per call  method\n");
+    for (int i = 0; i < count; i++)
+    {
+        const ProfileMethod& method = s_methods[order[i]];
+        unsigned int self = SelfCycles(method);
+        fprintf(pFile, "  %10u %5.1f%% %11u %11u %11u  %s.%s (%s:%d-%d)\n", self, totalSelf > 0 ? (self * 100.0) / totalSelf : 0.0,
+                method.cycles, method.calls, method.cycles / method.calls, method.pObject, method.pName, method.pFilename, method.firstLine, method.lastLine);
+    }
+
+    // methods that haven't returned yet have only been counted
+    if (IsValidMethod(s_current))
+    {
+        fprintf(pFile, "  still running (not timed):");
+        for (int i = s_current, depth = 0; IsValidMethod(i) && depth < ProfileDepthLimit; i = s_methods[i].caller, depth++)
+        {
+            fprintf(pFile, " %s%s.%s", depth > 0 ? "<- " : "", s_methods[i].pObject, s_methods[i].pName);
+        }
+        fprintf(pFile, "\n");
+    }
+}
+
+bool WriteProfileFoldedStacks(const char* pPath)
+{
+    FILE* pFile = fopen(pPath, "w");
+    if (!pFile)
+    {
+        return false;
+    }
+
+    for (int i = 1; i < s_nextMethod; i++)
+    {
+        if (!IsValidMethod(i) || s_methods[i].calls == 0)
+        {
+            continue;
+        }
+
+        // the stack is found from the method up, then written from the top down
+        int stack[ProfileDepthLimit];
+        int depth = 0;
+        for (int caller = i; IsValidMethod(caller) && depth < ProfileDepthLimit; caller = s_methods[caller].caller)
+        {
+            bool bRecursive = false;
+            for (int j = 0; j < depth; j++)
+            {
+                bRecursive |= (stack[j] == caller);
+            }
+            if (bRecursive)
+            {
+                break;
+            }
+            stack[depth++] = caller;
+        }
+        for (int j = depth - 1; j >= 0; j--)
+        {
+            fprintf(pFile, "%s.%s%s", s_methods[stack[j]].pObject, s_methods[stack[j]].pName, j > 0 ? ";" : "");
+        }
+        fprintf(pFile, " %u\n", SelfCycles(s_methods[i]));
+    }
+
+    fclose(pFile);
+    return true;
+}
+
+void CleanProfile()
+{
+    for (int i = 0; i < profile_method_limit; i++)
+    {
+        ClearMethod(s_methods[i]);
+    }
+    s_nextMethod = 1;
+    s_current = 0;
+    s_bRead = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
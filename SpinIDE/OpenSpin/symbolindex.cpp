@@ -0,0 +1,605 @@
+///////////////////////////////////////////////////////////////
+//                                                           //
+// Propeller Spin/PASM Compiler Command Line Tool 'OpenSpin' //
+// (c)2012-2013 Parallax Inc. DBA Parallax Semiconductor.    //
+// See end of file for terms of use.                         //
+//                                                           //
+///////////////////////////////////////////////////////////////
+//
+// symbolindex.cpp
+//
+// The symbols come from the info records each Compile2() leaves behind,
+// the same ones -s prints, so the index costs nothing more than the
+// build that writes it. Names are only stored once in the strings.
+//
+// Looking up never touches the compiler. The written file is mapped and
+// the symbols are in uppercased name order, so a prefix is a binary
+// search for the first match and another for the one past the last.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifndef WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "../PropellerCompiler/PropellerCompiler.h"
+#include "../PropellerCompiler/Utilities.h"
+#include "symbolindex.h"
+
+#define SymbolIndexObjectsSize      64      // hash table sizes
+#define SymbolIndexStringsSize      1024
+#define SymbolIndexInitialSymbols   256     // these grow as needed
+#define SymbolIndexInitialFiles     16
+#define SymbolIndexInitialStrings   4096
+
+class IndexedObject : public Hashable
+{
+public:
+    char* m_pPath;
+
+    IndexedObject(const char* pPath)
+    {
+        m_pPath = new char[strlen(pPath) + 1];
+        strcpy(m_pPath, pPath);
+    }
+    virtual ~IndexedObject()
+    {
+        delete [] m_pPath;
+    }
+};
+
+class IndexedString : public Hashable
+{
+public:
+    int m_offset;
+
+    IndexedString(int offset)
+        : m_offset(offset)
+    {
+    }
+};
+
+// being built
+static HashTable* s_pObjects = NULL;
+static HashTable* s_pStrings = NULL;
+static SymbolIndexFile* s_pFiles = NULL;
+static int s_fileCount = 0;
+static int s_fileSize = 0;
+static SymbolIndexEntry* s_pSymbols = NULL;
+static int s_symbolCount = 0;
+static int s_symbolSize = 0;
+static char* s_pStringData = NULL;
+static int s_stringsLength = 0;
+static int s_stringsSize = 0;
+
+// opened
+static unsigned char* s_pIndex = NULL;
+static int s_indexSize = 0;
+static bool s_bMapped = false;
+static const SymbolIndexHeader* s_pHeader = NULL;
+static const SymbolIndexFile* s_pIndexFiles = NULL;
+static const SymbolIndexEntry* s_pIndexSymbols = NULL;
+static const char* s_pIndexStrings = NULL;
+
+static int AddString(const char* pString, int length)
+{
+    char string[symbol_limit + 1];
+    if (length < 0)
+    {
+        length = 0;
+    }
+    if (length > symbol_limit)
+    {
+        length = symbol_limit;
+    }
+    strncpy(string, pString, length);
+    string[length] = 0;
+
+    int hash = s_pStrings->GetStringHash(string);
+    for (HashNode* pNode = s_pStrings->FindFirst(hash); pNode != 0; pNode = pNode->pNext)
+    {
+        if (pNode->key == hash && strcmp(&s_pStringData[((IndexedString*)pNode->pValue)->m_offset], string) == 0)
+        {
+            return ((IndexedString*)pNode->pValue)->m_offset;
+        }
+    }
+
+    if (s_stringsLength + length + 1 > s_stringsSize)
+    {
+        int newSize = s_stringsSize * 2;
+        while (s_stringsLength + length + 1 > newSize)
+        {
+            newSize *= 2;
+        }
+        char* pNewData = new char[newSize];
+        memcpy(pNewData, s_pStringData, s_stringsLength);
+        delete [] s_pStringData;
+        s_pStringData = pNewData;
+        s_stringsSize = newSize;
+    }
+    int offset = s_stringsLength;
+    memcpy(&s_pStringData[offset], string, length + 1);
+    s_stringsLength += length + 1;
+    s_pStrings->Insert(hash, new IndexedString(offset));
+    return offset;
+}
+
+static SymbolIndexEntry& AddSymbol()
+{
+    if (s_symbolCount >= s_symbolSize)
+    {
+        int newSize = (s_symbolSize > 0) ? s_symbolSize * 2 : SymbolIndexInitialSymbols;
+        SymbolIndexEntry* pNewSymbols = new SymbolIndexEntry[newSize];
+        if (s_pSymbols)
+        {
+            memcpy(pNewSymbols, s_pSymbols, s_symbolCount * sizeof(SymbolIndexEntry));
+            delete [] s_pSymbols;
+        }
+        s_pSymbols = pNewSymbols;
+        s_symbolSize = newSize;
+    }
+    SymbolIndexEntry& entry = s_pSymbols[s_symbolCount++];
+    memset(&entry, 0, sizeof(SymbolIndexEntry));
+    return entry;
+}
+
+static void BeginSymbolIndex()
+{
+    if (!s_pObjects)
+    {
+        s_pObjects = new HashTable(SymbolIndexObjectsSize);
+        s_pStrings = new HashTable(SymbolIndexStringsSize);
+        s_stringsSize = SymbolIndexInitialStrings;
+        s_pStringData = new char[s_stringsSize];
+        s_pStringData[0] = 0;
+        s_stringsLength = 1;
+    }
+}
+
+// returns the index of the new file, or -1 if the path is already in
+static int AddFile(const char* pPath)
+{
+    BeginSymbolIndex();
+
+    int hash = s_pObjects->GetStringHashUppercase(pPath);
+    for (HashNode* pNode = s_pObjects->FindFirst(hash); pNode != 0; pNode = pNode->pNext)
+    {
+        if (pNode->key == hash && _stricmp(((IndexedObject*)pNode->pValue)->m_pPath, pPath) == 0)
+        {
+            return -1;
+        }
+    }
+    s_pObjects->Insert(hash, new IndexedObject(pPath));
+
+    if (s_fileCount >= s_fileSize)
+    {
+        int newSize = (s_fileSize > 0) ? s_fileSize * 2 : SymbolIndexInitialFiles;
+        SymbolIndexFile* pNewFiles = new SymbolIndexFile[newSize];
+        if (s_pFiles)
+        {
+            memcpy(pNewFiles, s_pFiles, s_fileCount * sizeof(SymbolIndexFile));
+            delete [] s_pFiles;
+        }
+        s_pFiles = pNewFiles;
+        s_fileSize = newSize;
+    }
+
+    const char* pObject = strrchr(pPath, '/');
+    pObject = pObject ? pObject + 1 : pPath;
+    const char* pExtension = strstr(pObject, ".spin");
+    SymbolIndexFile& file = s_pFiles[s_fileCount];
+    file.path = AddString(pPath, (int)strlen(pPath));
+    file.object = AddString(pObject, pExtension ? (int)(pExtension - pObject) : (int)strlen(pObject));
+    return s_fileCount++;
+}
+
+// sets the line and column of a source offset, pLineStarts holds the offset of each line
+static void SetPosition(SymbolIndexEntry& entry, const int* pLineStarts, int lineCount, int offset)
+{
+    int low = 0;
+    int high = lineCount - 1;
+    while (low < high)
+    {
+        int middle = (low + high + 1) / 2;
+        if (pLineStarts[middle] <= offset)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle - 1;
+        }
+    }
+    entry.line = low + 1;
+    entry.column = (unsigned short)(offset - pLineStarts[low] + 1);
+}
+
+void EnterObjectIntoSymbolIndex(const char* pPath, CompilerData* pCompilerData)
+{
+    int file = AddFile(pPath);
+    if (file < 0)
+    {
+        return;
+    }
+
+    const char* pSource = pCompilerData->source;
+    int lineCount = 1;
+    for (const char* pChar = pSource; *pChar != 0; pChar++)
+    {
+        if (*pChar == 13)
+        {
+            lineCount++;
+        }
+    }
+    int* pLineStarts = new int[lineCount];
+    pLineStarts[0] = 0;
+    lineCount = 1;
+    for (int i = 0; pSource[i] != 0; i++)
+    {
+        if (pSource[i] == 13)
+        {
+            pLineStarts[lineCount++] = i + 1;
+        }
+    }
+
+    for (int i = 0; i < pCompilerData->info_count; i++)
+    {
+        int type = pCompilerData->info_type[i];
+        int start = pCompilerData->info_start[i];
+        int finish = pCompilerData->info_finish[i];
+        int kind = 0;
+        int value = pCompilerData->info_data0[i];
+        int params = 0;
+        int owner = 0;
+        switch (type)
+        {
+            case info_con:
+                kind = symbol_index_con;
+                break;
+            case info_con_float:
+                kind = symbol_index_con_float;
+                break;
+            case info_dat_symbol:
+                kind = symbol_index_dat;
+                params = pCompilerData->info_data1[i];
+                break;
+            case info_pub:
+            case info_pri:
+                // the record spans the whole method, the name is in data2/3
+                kind = (type == info_pub) ? symbol_index_pub : symbol_index_pri;
+                start = pCompilerData->info_data2[i];
+                finish = pCompilerData->info_data3[i];
+                value = pCompilerData->info_data4[i] & 0xFFFF;
+                params = pCompilerData->info_data4[i] >> 16;
+                break;
+            case info_pub_param:
+            case info_pri_param:
+                kind = symbol_index_param;
+                value = pCompilerData->info_data1[i];
+                owner = AddString(&pSource[pCompilerData->info_data2[i]], pCompilerData->info_data3[i] - pCompilerData->info_data2[i]);
+                break;
+            default:
+                continue;
+        }
+        if (finish <= start)
+        {
+            continue;
+        }
+
+        SymbolIndexEntry& entry = AddSymbol();
+        entry.name = AddString(&pSource[start], finish - start);
+        entry.owner = owner;
+        entry.value = value;
+        SetPosition(entry, pLineStarts, lineCount, start);
+        entry.file = (unsigned short)file;
+        entry.kind = (unsigned char)kind;
+        entry.params = (unsigned char)params;
+        entry.length = (unsigned short)(finish - start);
+    }
+
+    delete [] pLineStarts;
+}
+
+// compares the uppercased names, only up to length characters if length isn't -1
+static int CompareNames(const char* pLeft, const char* pRight, int length)
+{
+    for (int i = 0; length < 0 || i < length; i++)
+    {
+        unsigned char left = (unsigned char)Uppercase(pLeft[i]);
+        unsigned char right = (unsigned char)Uppercase(pRight[i]);
+        if (left != right)
+        {
+            return (left < right) ? -1 : 1;
+        }
+        if (left == 0)
+        {
+            break;
+        }
+    }
+    return 0;
+}
+
+static int CompareSymbols(const void* pLeft, const void* pRight)
+{
+    const SymbolIndexEntry* pLeftSymbol = (const SymbolIndexEntry*)pLeft;
+    const SymbolIndexEntry* pRightSymbol = (const SymbolIndexEntry*)pRight;
+    int result = CompareNames(&s_pStringData[pLeftSymbol->name], &s_pStringData[pRightSymbol->name], -1);
+    if (result == 0)
+    {
+        result = pLeftSymbol->file - pRightSymbol->file;
+    }
+    if (result == 0)
+    {
+        result = pLeftSymbol->line - pRightSymbol->line;
+    }
+    if (result == 0)
+    {
+        result = pLeftSymbol->column - pRightSymbol->column;
+    }
+    return result;
+}
+
+bool WriteSymbolIndex(const char* pPath)
+{
+    BeginSymbolIndex();
+    if (s_symbolCount > 1)
+    {
+        qsort(s_pSymbols, s_symbolCount, sizeof(SymbolIndexEntry), CompareSymbols);
+    }
+
+    SymbolIndexHeader header;
+    header.magic = SymbolIndexMagic;
+    header.version = SymbolIndexVersion;
+    header.fileCount = s_fileCount;
+    header.symbolCount = s_symbolCount;
+    header.filesOffset = sizeof(SymbolIndexHeader);
+    header.symbolsOffset = header.filesOffset + s_fileCount * sizeof(SymbolIndexFile);
+    header.stringsOffset = header.symbolsOffset + s_symbolCount * sizeof(SymbolIndexEntry);
+    header.stringsSize = s_stringsLength;
+
+    FILE* pFile = fopen(pPath, "wb");
+    if (!pFile)
+    {
+        return false;
+    }
+    bool bResult = fwrite(&header, sizeof(SymbolIndexHeader), 1, pFile) == 1;
+    bResult = bResult && (s_fileCount == 0 || fwrite(s_pFiles, sizeof(SymbolIndexFile), s_fileCount, pFile) == (size_t)s_fileCount);
+    bResult = bResult && (s_symbolCount == 0 || fwrite(s_pSymbols, sizeof(SymbolIndexEntry), s_symbolCount, pFile) == (size_t)s_symbolCount);
+    bResult = bResult && fwrite(s_pStringData, 1, s_stringsLength, pFile) == (size_t)s_stringsLength;
+    if (fclose(pFile) != 0)
+    {
+        bResult = false;
+    }
+    return bResult;
+}
+
+void CleanSymbolIndex()
+{
+    delete s_pObjects;
+    s_pObjects = NULL;
+    delete s_pStrings;
+    s_pStrings = NULL;
+    delete [] s_pFiles;
+    s_pFiles = NULL;
+    s_fileCount = 0;
+    s_fileSize = 0;
+    delete [] s_pSymbols;
+    s_pSymbols = NULL;
+    s_symbolCount = 0;
+    s_symbolSize = 0;
+    delete [] s_pStringData;
+    s_pStringData = NULL;
+    s_stringsLength = 0;
+    s_stringsSize = 0;
+}
+
+bool OpenSymbolIndex(const char* pPath)
+{
+    CloseSymbolIndex();
+
+    struct stat statBuffer;
+    if (stat(pPath, &statBuffer) != 0 || statBuffer.st_size < (off_t)sizeof(SymbolIndexHeader))
+    {
+        return false;
+    }
+    s_indexSize = (int)statBuffer.st_size;
+
+#ifndef WIN32
+    int fd = open(pPath, O_RDONLY);
+    if (fd >= 0)
+    {
+        void* pMap = mmap(NULL, (size_t)s_indexSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (pMap != MAP_FAILED)
+        {
+            s_pIndex = (unsigned char*)pMap;
+            s_bMapped = true;
+        }
+    }
+#endif
+    if (!s_pIndex)
+    {
+        // no mapping available, so read it in
+        FILE* pFile = fopen(pPath, "rb");
+        if (!pFile)
+        {
+            return false;
+        }
+        s_pIndex = new unsigned char[s_indexSize];
+        bool bRead = (fread(s_pIndex, 1, (size_t)s_indexSize, pFile) == (size_t)s_indexSize);
+        fclose(pFile);
+        if (!bRead)
+        {
+            CloseSymbolIndex();
+            return false;
+        }
+    }
+
+    // make sure everything it points at is inside the file
+    const SymbolIndexHeader* pHeader = (const SymbolIndexHeader*)s_pIndex;
+    if (pHeader->magic != SymbolIndexMagic || pHeader->version != SymbolIndexVersion ||
+        pHeader->fileCount < 0 || pHeader->symbolCount < 0 || pHeader->stringsSize < 1 ||
+        pHeader->filesOffset != (int)sizeof(SymbolIndexHeader) ||
+        pHeader->symbolsOffset != pHeader->filesOffset + pHeader->fileCount * (int)sizeof(SymbolIndexFile) ||
+        pHeader->stringsOffset != pHeader->symbolsOffset + pHeader->symbolCount * (int)sizeof(SymbolIndexEntry) ||
+        pHeader->stringsOffset + pHeader->stringsSize != s_indexSize ||
+        s_pIndex[s_indexSize - 1] != 0)
+    {
+        CloseSymbolIndex();
+        return false;
+    }
+    s_pHeader = pHeader;
+    s_pIndexFiles = (const SymbolIndexFile*)&s_pIndex[pHeader->filesOffset];
+    s_pIndexSymbols = (const SymbolIndexEntry*)&s_pIndex[pHeader->symbolsOffset];
+    s_pIndexStrings = (const char*)&s_pIndex[pHeader->stringsOffset];
+    return true;
+}
+
+int FindSymbolIndexPrefix(const char* pPrefix, int& first)
+{
+    first = 0;
+    if (!s_pHeader)
+    {
+        return 0;
+    }
+    int length = (int)strlen(pPrefix);
+
+    // first symbol not before the prefix
+    int low = 0;
+    int high = s_pHeader->symbolCount;
+    while (low < high)
+    {
+        int middle = (low + high) / 2;
+        if (CompareNames(GetSymbolIndexString(s_pIndexSymbols[middle].name), pPrefix, length) < 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    first = low;
+
+    // first symbol after the ones starting with it
+    high = s_pHeader->symbolCount;
+    while (low < high)
+    {
+        int middle = (low + high) / 2;
+        if (CompareNames(GetSymbolIndexString(s_pIndexSymbols[middle].name), pPrefix, length) <= 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low - first;
+}
+
+const SymbolIndexEntry* GetSymbolIndexEntry(int index)
+{
+    return (s_pHeader && index >= 0 && index < s_pHeader->symbolCount) ? &s_pIndexSymbols[index] : NULL;
+}
+
+const SymbolIndexFile* GetSymbolIndexFile(int file)
+{
+    return (s_pHeader && file >= 0 && file < s_pHeader->fileCount) ? &s_pIndexFiles[file] : NULL;
+}
+
+const char* GetSymbolIndexString(int offset)
+{
+    return (s_pHeader && offset >= 0 && offset < s_pHeader->stringsSize) ? &s_pIndexStrings[offset] : "";
+}
+
+void PrintSymbolIndexEntry(FILE* pFile, int index)
+{
+    static const char* s_kinds[] = { "PUB", "PRI", "PARAM", "CON", "CONF", "DAT" };
+    const SymbolIndexEntry* pEntry = GetSymbolIndexEntry(index);
+    if (!pEntry || pEntry->kind > symbol_index_dat)
+    {
+        return;
+    }
+    const SymbolIndexFile* pIndexFile = GetSymbolIndexFile(pEntry->file);
+    const char* pPath = pIndexFile ? GetSymbolIndexString(pIndexFile->path) : "";
+    const char* pObject = pIndexFile ? GetSymbolIndexString(pIndexFile->object) : "";
+
+    fprintf(pFile, "%s(%d:%d) : %s, %s.%s", pPath, pEntry->line, pEntry->column, s_kinds[pEntry->kind], pObject, GetSymbolIndexString(pEntry->name));
+    switch (pEntry->kind)
+    {
+        case symbol_index_pub:
+        case symbol_index_pri:
+            fprintf(pFile, ", %d params\n", pEntry->params);
+            break;
+        case symbol_index_param:
+            fprintf(pFile, ", of %s, %d\n", GetSymbolIndexString(pEntry->owner), pEntry->value);
+            break;
+        case symbol_index_con:
+            fprintf(pFile, ", %d\n", pEntry->value);
+            break;
+        case symbol_index_con_float:
+            {
+                // the value holds the bits of the float
+                float floatValue;
+                memcpy(&floatValue, &pEntry->value, sizeof(floatValue));
+                fprintf(pFile, ", %f\n", floatValue);
+            }
+            break;
+        case symbol_index_dat:
+            fprintf(pFile, ", $%04X\n", pEntry->value);
+            break;
+    }
+}
+
+void CloseSymbolIndex()
+{
+    if (s_pIndex)
+    {
+#ifndef WIN32
+        if (s_bMapped)
+        {
+            munmap(s_pIndex, (size_t)s_indexSize);
+        }
+        else
+#endif
+        {
+            delete [] s_pIndex;
+        }
+    }
+    s_pIndex = NULL;
+    s_indexSize = 0;
+    s_bMapped = false;
+    s_pHeader = NULL;
+    s_pIndexFiles = NULL;
+    s_pIndexSymbols = NULL;
+    s_pIndexStrings = NULL;
+}
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
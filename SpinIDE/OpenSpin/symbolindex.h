@@ -0,0 +1,102 @@
+///////////////////////////////////////////////////////////////
+//                                                           //
+// Propeller Spin/PASM Compiler Command Line Tool 'OpenSpin' //
+// (c)2012-2013 Parallax Inc. DBA Parallax Semiconductor.    //
+// See end of file for terms of use.                         //
+//                                                           //
+///////////////////////////////////////////////////////////////
+//
+// symbolindex.h
+//
+
+//
+// index of the PUB/PRI, parameter, CON and DAT symbols of every object in a build (-i and -k options)
+//
+// the file is laid out to be used straight from a memory mapping (values are in the byte order of the host that wrote it):
+//
+//      SymbolIndexHeader
+//      SymbolIndexFile     files[fileCount]
+//      SymbolIndexEntry    symbols[symbolCount]    ; sorted by uppercased name, then file, then line
+//      char                strings[stringsSize]    ; zero terminated, offset 0 is ""
+//
+
+#define SymbolIndexMagic        0x58495053      // 'SPIX'
+#define SymbolIndexVersion      1
+
+enum symbolIndexKind
+{
+    symbol_index_pub = 0,       // value = method index in the object (from 0), params = parameter count
+    symbol_index_pri,
+    symbol_index_param,         // owner = the PUB/PRI, value = parameter index (from 0)
+    symbol_index_con,           // value = the constant
+    symbol_index_con_float,     // value = the float constant's bits
+    symbol_index_dat            // value = offset in the object, params = size (0 = byte, 1 = word, 2 = long)
+};
+
+struct SymbolIndexHeader
+{
+    int             magic;
+    int             version;
+    int             fileCount;
+    int             symbolCount;
+    int             filesOffset;
+    int             symbolsOffset;
+    int             stringsOffset;
+    int             stringsSize;
+};
+
+struct SymbolIndexFile
+{
+    int             path;           // string offset of the path the object was read from
+    int             object;         // string offset of the object name (no path or .spin)
+};
+
+struct SymbolIndexEntry
+{
+    int             name;           // string offset, spelled as it is in the source
+    int             owner;          // string offset of the method a parameter belongs to, 0 for the others
+    int             value;
+    int             line;           // from 1
+    unsigned short  column;         // from 1, tabs count as one
+    unsigned short  file;           // index into the files
+    unsigned char   kind;           // symbolIndexKind
+    unsigned char   params;
+    unsigned short  length;         // of the name
+};
+
+// building, during the compile
+void EnterObjectIntoSymbolIndex(const char* pPath, CompilerData* pCompilerData); // call after each Compile2(), each path is only entered once
+bool WriteSymbolIndex(const char* pPath);
+void CleanSymbolIndex();
+
+// looking up, from the written file (mapped, or read in on WIN32)
+bool OpenSymbolIndex(const char* pPath);
+int FindSymbolIndexPrefix(const char* pPrefix, int& first); // returns how many symbols start with pPrefix (any case), first is the first of them
+const SymbolIndexEntry* GetSymbolIndexEntry(int index);
+const SymbolIndexFile* GetSymbolIndexFile(int file);
+const char* GetSymbolIndexString(int offset);
+void PrintSymbolIndexEntry(FILE* pFile, int index);
+void CloseSymbolIndex();
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
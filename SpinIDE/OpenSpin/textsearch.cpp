@@ -0,0 +1,394 @@
+///////////////////////////////////////////////////////////////
+//                                                           //
+// Propeller Spin/PASM Compiler Command Line Tool 'OpenSpin' //
+// (c)2012-2013 Parallax Inc. DBA Parallax Semiconductor.    //
+// See end of file for terms of use.                         //
+//                                                           //
+///////////////////////////////////////////////////////////////
+//
+// textsearch.cpp
+//
+// Most of a search is looking for the first byte of the pattern. When
+// case matters that is memchr, otherwise both cases of it are looked for
+// eight bytes at a time in a 64 bit word, and only a word holding one of
+// them is looked at byte by byte. Each candidate is then compared in full
+// (memcmp, or through the case folding table) and checked for word
+// boundaries.
+//
+// Line numbers are only counted up to each match as it is found, so a
+// file with no matches is never scanned for line ends.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../PropellerCompiler/Utilities.h"
+#include "textconvert.h"
+#include "textsearch.h"
+
+#define SearchInitialMatches    256     // grows as needed
+
+typedef unsigned long long SearchWord;
+
+#define SearchWordOnes          0x0101010101010101ULL
+#define SearchWordHighs         0x8080808080808080ULL
+
+static char*            s_pPattern = NULL;          // through s_fold
+static int              s_nPatternLength = 0;
+static int              s_nFlags = 0;
+static unsigned char    s_fold[256];
+static unsigned char    s_firstLower = 0;           // the two cases of the first byte (the same if it isn't a letter, or case matters)
+static unsigned char    s_firstUpper = 0;
+static SearchWord       s_firstLowerWord = 0;       // ... in every byte of a word
+static SearchWord       s_firstUpperWord = 0;
+static bool             s_bStopped = false;
+
+static char*            s_pReadBuffer = NULL;       // reused for each file SearchFiles() reads
+static int              s_nReadBufferSize = 0;
+static char*            s_pSourceBuffer = NULL;
+static int              s_nSourceBufferSize = 0;
+
+static int*             s_pMatches = NULL;          // ReplaceAllInBuffer() collects the match offsets first
+static int              s_nMatchesSize = 0;
+
+bool SetSearchPattern(const char* pPattern, int length, int flags)
+{
+    delete [] s_pPattern;
+    s_pPattern = NULL;
+    s_nPatternLength = 0;
+    if (length <= 0)
+    {
+        return false;
+    }
+
+    s_nFlags = flags;
+    for (int i = 0; i < 256; i++)
+    {
+        s_fold[i] = (flags & SearchMatchCase) ? (unsigned char)i : (unsigned char)Uppercase((char)i);
+    }
+
+    s_pPattern = new char[length];
+    for (int i = 0; i < length; i++)
+    {
+        s_pPattern[i] = s_fold[(unsigned char)pPattern[i]];
+    }
+    s_nPatternLength = length;
+
+    s_firstUpper = (unsigned char)s_pPattern[0];
+    s_firstLower = s_firstUpper;
+    if (!(flags & SearchMatchCase) && s_firstUpper >= 'A' && s_firstUpper <= 'Z')
+    {
+        s_firstLower = s_firstUpper + ('a' - 'A');
+    }
+    s_firstLowerWord = SearchWordOnes * s_firstLower;
+    s_firstUpperWord = SearchWordOnes * s_firstUpper;
+
+    return true;
+}
+
+// the high bit of a byte is set where word has a zero byte (it can also be set in the bytes above one, but never
+// when there isn't one, so it is exact for telling if the word has any)
+static inline SearchWord ZeroBytes(SearchWord word)
+{
+    return (word - SearchWordOnes) & ~word & SearchWordHighs;
+}
+
+// offset of the first byte in [offset, end) that is either case of the first byte of the pattern, -1 if there isn't one
+static int FindFirstByte(const unsigned char* pSource, int offset, int end)
+{
+    if (s_firstLower == s_firstUpper)
+    {
+        const unsigned char* pFound = (const unsigned char*)memchr(pSource + offset, s_firstUpper, end - offset);
+        return pFound ? (int)(pFound - pSource) : -1;
+    }
+
+    const unsigned char* p = pSource + offset;
+    const unsigned char* pEnd = pSource + end;
+    while (pEnd - p >= (int)sizeof(SearchWord))
+    {
+        SearchWord word;
+        memcpy(&word, p, sizeof(SearchWord)); // no alignment needed, this compiles to a load
+        if (ZeroBytes(word ^ s_firstLowerWord) | ZeroBytes(word ^ s_firstUpperWord))
+        {
+            break; // it is in this word, find which byte below
+        }
+        p += sizeof(SearchWord);
+    }
+    for (; p < pEnd; p++)
+    {
+        if (*p == s_firstLower || *p == s_firstUpper)
+        {
+            return (int)(p - pSource);
+        }
+    }
+    return -1;
+}
+
+static bool CheckCandidate(const unsigned char* pSource, int length, int offset)
+{
+    if (s_nFlags & SearchMatchCase)
+    {
+        if (memcmp(pSource + offset, s_pPattern, s_nPatternLength) != 0)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        const unsigned char* p = pSource + offset;
+        for (int i = 1; i < s_nPatternLength; i++)
+        {
+            if (s_fold[p[i]] != (unsigned char)s_pPattern[i])
+            {
+                return false;
+            }
+        }
+    }
+
+    if (s_nFlags & SearchWholeWord)
+    {
+        if (offset > 0 && CheckWordChar(Uppercase(pSource[offset - 1])))
+        {
+            return false;
+        }
+        if (offset + s_nPatternLength < length && CheckWordChar(Uppercase(pSource[offset + s_nPatternLength])))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// offset of the next match at or after offset, -1 if there isn't one
+static int FindNextMatch(const unsigned char* pSource, int length, int offset)
+{
+    int end = length - s_nPatternLength + 1; // one past the last offset a match can start at
+    while (offset < end)
+    {
+        int candidate = FindFirstByte(pSource, offset, end);
+        if (candidate < 0)
+        {
+            break;
+        }
+        if (CheckCandidate(pSource, length, candidate))
+        {
+            return candidate;
+        }
+        offset = candidate + 1;
+    }
+    return -1;
+}
+
+// matches don't overlap, the search carries on after the end of each one (as replacing them would)
+int SearchBuffer(const char* pSource, int length, const char* pPath, SearchFoundFunc pFound, void* pContext)
+{
+    s_bStopped = false;
+    if (s_nPatternLength == 0)
+    {
+        return 0;
+    }
+
+    const unsigned char* pText = (const unsigned char*)pSource;
+    int count = 0;
+    int line = 1;
+    int lineStart = 0;
+    int scanned = 0; // line ends before here have been counted
+    int offset = FindNextMatch(pText, length, 0);
+    while (offset >= 0)
+    {
+        // a line ends with 0x0D (PASCII), 0x0A, or both
+        for (; scanned < offset; scanned++)
+        {
+            if (pText[scanned] == 0x0D || (pText[scanned] == 0x0A && (scanned == 0 || pText[scanned - 1] != 0x0D)))
+            {
+                line++;
+            }
+            if (pText[scanned] == 0x0D || pText[scanned] == 0x0A)
+            {
+                lineStart = scanned + 1;
+            }
+        }
+
+        count++;
+        if (pFound && !pFound(pContext, pPath, pSource, length, offset, line, offset - lineStart + 1))
+        {
+            s_bStopped = true;
+            break;
+        }
+        offset = FindNextMatch(pText, length, offset + s_nPatternLength);
+    }
+    return count;
+}
+
+// reads pPath into s_pSourceBuffer as PASCII, returns the length or -1
+static int ReadSource(const char* pPath)
+{
+    FILE* pFile = fopen(pPath, "rb");
+    if (pFile == NULL)
+    {
+        return -1;
+    }
+    fseek(pFile, 0, SEEK_END);
+    int length = (int)ftell(pFile);
+    fseek(pFile, 0, SEEK_SET);
+    if (length <= 0)
+    {
+        fclose(pFile);
+        return -1;
+    }
+
+    // the encoding check looks at the first two bytes, so keep two zeros after the file
+    if (length + 2 > s_nReadBufferSize)
+    {
+        delete [] s_pReadBuffer;
+        s_nReadBufferSize = length + 2;
+        s_pReadBuffer = new char[s_nReadBufferSize];
+    }
+    if (length + 1 > s_nSourceBufferSize)
+    {
+        delete [] s_pSourceBuffer;
+        s_nSourceBufferSize = length + 1;
+        s_pSourceBuffer = new char[s_nSourceBufferSize];
+    }
+
+    int readLength = (int)fread(s_pReadBuffer, 1, length, pFile);
+    fclose(pFile);
+    if (readLength != length)
+    {
+        return -1;
+    }
+    s_pReadBuffer[length] = 0;
+    s_pReadBuffer[length + 1] = 0;
+
+    if (!UnicodeToPASCII(s_pReadBuffer, length, s_pSourceBuffer, false))
+    {
+        return -1;
+    }
+    return (int)strlen(s_pSourceBuffer);
+}
+
+int SearchFiles(const char** ppPaths, int pathCount, SearchFoundFunc pFound, void* pContext)
+{
+    int count = 0;
+    for (int i = 0; i < pathCount; i++)
+    {
+        int length = ReadSource(ppPaths[i]);
+        if (length > 0)
+        {
+            count += SearchBuffer(s_pSourceBuffer, length, ppPaths[i], pFound, pContext);
+            if (s_bStopped)
+            {
+                break;
+            }
+        }
+    }
+    return count;
+}
+
+char* ReplaceAllInBuffer(const char* pSource, int length, const char* pReplacement, int replacementLength, int* pnNewLength, int* pnCount)
+{
+    *pnNewLength = length;
+    *pnCount = 0;
+    if (s_nPatternLength == 0)
+    {
+        return NULL;
+    }
+
+    const unsigned char* pText = (const unsigned char*)pSource;
+    int count = 0;
+    for (int offset = FindNextMatch(pText, length, 0); offset >= 0; offset = FindNextMatch(pText, length, offset + s_nPatternLength))
+    {
+        if (count >= s_nMatchesSize)
+        {
+            int newSize = (s_nMatchesSize > 0) ? s_nMatchesSize * 2 : SearchInitialMatches;
+            int* pNewMatches = new int[newSize];
+            if (s_pMatches)
+            {
+                memcpy(pNewMatches, s_pMatches, count * sizeof(int));
+                delete [] s_pMatches;
+            }
+            s_pMatches = pNewMatches;
+            s_nMatchesSize = newSize;
+        }
+        s_pMatches[count++] = offset;
+    }
+    if (count == 0)
+    {
+        return NULL;
+    }
+
+    // everything between the matches is copied over in one piece
+    int newLength = length + count * (replacementLength - s_nPatternLength);
+    char* pNew = new char[newLength + 1];
+    char* pOut = pNew;
+    int copied = 0;
+    for (int i = 0; i < count; i++)
+    {
+        memcpy(pOut, pSource + copied, s_pMatches[i] - copied);
+        pOut += s_pMatches[i] - copied;
+        memcpy(pOut, pReplacement, replacementLength);
+        pOut += replacementLength;
+        copied = s_pMatches[i] + s_nPatternLength;
+    }
+    memcpy(pOut, pSource + copied, length - copied);
+    pNew[newLength] = 0;
+
+    *pnNewLength = newLength;
+    *pnCount = count;
+    return pNew;
+}
+
+void GetSearchLine(const char* pSource, int length, int offset, int* pnStart, int* pnFinish)
+{
+    int start = offset;
+    while (start > 0 && pSource[start - 1] != 0x0D && pSource[start - 1] != 0x0A)
+    {
+        start--;
+    }
+    int finish = offset;
+    while (finish < length && pSource[finish] != 0x0D && pSource[finish] != 0x0A)
+    {
+        finish++;
+    }
+    *pnStart = start;
+    *pnFinish = finish;
+}
+
+void CleanSearch()
+{
+    delete [] s_pPattern;
+    s_pPattern = NULL;
+    s_nPatternLength = 0;
+    delete [] s_pReadBuffer;
+    s_pReadBuffer = NULL;
+    s_nReadBufferSize = 0;
+    delete [] s_pSourceBuffer;
+    s_pSourceBuffer = NULL;
+    s_nSourceBufferSize = 0;
+    delete [] s_pMatches;
+    s_pMatches = NULL;
+    s_nMatchesSize = 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,53 @@
+///////////////////////////////////////////////////////////////
+//                                                           //
+// Propeller Spin/PASM Compiler Command Line Tool 'OpenSpin' //
+// (c)2012-2013 Parallax Inc. DBA Parallax Semiconductor.    //
+// See end of file for terms of use.                         //
+//                                                           //
+///////////////////////////////////////////////////////////////
+//
+// textsearch.h
+//
+
+//
+// finds text in spin sources (-F and -w options), without regard to case the way the
+// compiler reads names, and optionally only as a whole word (CheckWordChar on either side)
+//
+
+#define SearchMatchCase         0x01
+#define SearchWholeWord         0x02
+
+// called for each match, in order, stop the search by returning false
+// offset is into pSource (length bytes), line and column are from 1 (tabs count as one)
+typedef bool (*SearchFoundFunc)(void* pContext, const char* pPath, const char* pSource, int length, int offset, int line, int column);
+
+bool SetSearchPattern(const char* pPattern, int length, int flags); // false if the pattern is empty
+int SearchBuffer(const char* pSource, int length, const char* pPath, SearchFoundFunc pFound, void* pContext); // returns the number of matches
+int SearchFiles(const char** ppPaths, int pathCount, SearchFoundFunc pFound, void* pContext); // each file is read as PASCII, files that can't be read are skipped
+char* ReplaceAllInBuffer(const char* pSource, int length, const char* pReplacement, int replacementLength, int* pnNewLength, int* pnCount); // returns a new[] buffer, NULL if nothing matched
+void GetSearchLine(const char* pSource, int length, int offset, int* pnStart, int* pnFinish); // the line a match is on, without its line end
+void CleanSearch();
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,479 @@
+///////////////////////////////////////////////////////////////
+//                                                           //
+// Propeller Spin/PASM Compiler Command Line Tool 'OpenSpin' //
+// (c)2012-2013 Parallax Inc. DBA Parallax Semiconductor.    //
+// See end of file for terms of use.                         //
+//                                                           //
+///////////////////////////////////////////////////////////////
+//
+// watch.cpp
+//
+// Each object remembers the files it read (its source, #includes and DAT
+// files) and the sub-objects it used. When files change, the objects that
+// read them are stale, and so is every object above a stale one. Only
+// those are taken out of the object heap, the rest are used from it as
+// they are by the next build.
+//
+// The directories the files are in are watched rather than the files, so
+// saves that write a new file and rename it over the old one are seen.
+// A new file with the name of one the build read (or failed to find) is
+// taken as a change to it, it may come first in the include path now.
+//
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+#include "../PropellerCompiler/PropellerCompiler.h"
+#include "../PropellerCompiler/Utilities.h"
+#include "watch.h"
+
+#define WatchDepthLimit         16      // ObjFileStackLimit in openspin.cpp
+#define WatchListInitialSize    8       // grows as needed
+
+// a list of pointers, each only added once
+class WatchList
+{
+public:
+    void**  m_ppItems;
+    int     m_count;
+    int     m_size;
+
+    WatchList()
+        : m_ppItems(NULL)
+        , m_count(0)
+        , m_size(0)
+    {
+    }
+    ~WatchList()
+    {
+        delete [] m_ppItems;
+    }
+    void Add(void* pItem)
+    {
+        for (int i = 0; i < m_count; i++)
+        {
+            if (m_ppItems[i] == pItem)
+            {
+                return;
+            }
+        }
+        if (m_count >= m_size)
+        {
+            int newSize = (m_size > 0) ? m_size * 2 : WatchListInitialSize;
+            void** ppNewItems = new void*[newSize];
+            if (m_ppItems)
+            {
+                memcpy(ppNewItems, m_ppItems, m_count * sizeof(void*));
+                delete [] m_ppItems;
+            }
+            m_ppItems = ppNewItems;
+            m_size = newSize;
+        }
+        m_ppItems[m_count++] = pItem;
+    }
+};
+
+class WatchedDir : public Hashable
+{
+public:
+    char*   m_pPath;
+    int     m_wd;           // inotify watch, -1 until it is added
+
+    WatchedDir(const char* pPath)
+        : m_wd(-1)
+    {
+        m_pPath = new char[strlen(pPath) + 1];
+        strcpy(m_pPath, pPath);
+    }
+    virtual ~WatchedDir()
+    {
+        delete [] m_pPath;
+    }
+};
+
+class WatchedFile : public Hashable
+{
+public:
+    char*       m_pPath;
+    const char* m_pName;    // in m_pPath, after the directory
+    bool        m_bChanged;
+
+    WatchedFile(const char* pPath)
+        : m_bChanged(false)
+    {
+        m_pPath = new char[strlen(pPath) + 1];
+        strcpy(m_pPath, pPath);
+        const char* pSlash = strrchr(m_pPath, '/');
+        m_pName = pSlash ? pSlash + 1 : m_pPath;
+    }
+    virtual ~WatchedFile()
+    {
+        delete [] m_pPath;
+    }
+};
+
+class WatchedObject : public Hashable
+{
+public:
+    char*       m_pName;
+    WatchList   m_files;    // WatchedFile*
+    WatchList   m_children; // WatchedObject*
+    bool        m_bStale;
+
+    WatchedObject(const char* pName)
+        : m_bStale(false)
+    {
+        m_pName = new char[strlen(pName) + 1];
+        strcpy(m_pName, pName);
+    }
+    virtual ~WatchedObject()
+    {
+        delete [] m_pName;
+    }
+};
+
+static HashTable* s_pObjects = NULL;        // by name, without regard to case (like the object heap)
+static HashTable* s_pFiles = NULL;          // by path
+static HashTable* s_pDirs = NULL;           // by path
+static WatchedObject* s_pStack[WatchDepthLimit];
+static WatchList s_stale;                   // names handed back by GetStaleObjects()
+#ifdef __linux__
+static int s_watchFd = -1;
+#endif
+
+static WatchedObject* FindWatchedObject(const char* pName)
+{
+    if (!s_pObjects)
+    {
+        s_pObjects = new HashTable(WatchIndexSize);
+    }
+    int hash = s_pObjects->GetStringHashUppercase(pName);
+    for (HashNode* pNode = s_pObjects->FindFirst(hash); pNode != 0; pNode = pNode->pNext)
+    {
+        if (pNode->key == hash && _stricmp(((WatchedObject*)pNode->pValue)->m_pName, pName) == 0)
+        {
+            return (WatchedObject*)pNode->pValue;
+        }
+    }
+    WatchedObject* pObject = new WatchedObject(pName);
+    s_pObjects->Insert(hash, pObject);
+    return pObject;
+}
+
+static WatchedDir* FindWatchedDir(const char* pPath)
+{
+    if (!s_pDirs)
+    {
+        s_pDirs = new HashTable(WatchIndexSize);
+    }
+    int hash = s_pDirs->GetStringHash(pPath);
+    for (HashNode* pNode = s_pDirs->FindFirst(hash); pNode != 0; pNode = pNode->pNext)
+    {
+        if (pNode->key == hash && strcmp(((WatchedDir*)pNode->pValue)->m_pPath, pPath) == 0)
+        {
+            return (WatchedDir*)pNode->pValue;
+        }
+    }
+    WatchedDir* pDir = new WatchedDir(pPath);
+    s_pDirs->Insert(hash, pDir);
+    return pDir;
+}
+
+// bCreate is false when looking up a path from a change
+static WatchedFile* FindWatchedFile(const char* pPath, bool bCreate)
+{
+    if (!s_pFiles)
+    {
+        s_pFiles = new HashTable(WatchIndexSize);
+    }
+    int hash = s_pFiles->GetStringHash(pPath);
+    for (HashNode* pNode = s_pFiles->FindFirst(hash); pNode != 0; pNode = pNode->pNext)
+    {
+        if (pNode->key == hash && strcmp(((WatchedFile*)pNode->pValue)->m_pPath, pPath) == 0)
+        {
+            return (WatchedFile*)pNode->pValue;
+        }
+    }
+    if (!bCreate)
+    {
+        return NULL;
+    }
+    WatchedFile* pFile = new WatchedFile(pPath);
+
+    // the directory is watched from the next wait on
+    char dir[PATH_MAX] = ".";
+    if (pFile->m_pName > pFile->m_pPath)
+    {
+        int length = (int)(pFile->m_pName - pFile->m_pPath) - 1;
+        memcpy(dir, pPath, (length > 0) ? length : 1);
+        dir[(length > 0) ? length : 1] = 0;
+    }
+    FindWatchedDir(dir);
+    s_pFiles->Insert(hash, pFile);
+    return pFile;
+}
+
+static void AddChild(WatchedObject* pObject, int depth)
+{
+    if (depth < 1 || depth > WatchDepthLimit)
+    {
+        return;
+    }
+    if (depth > 1)
+    {
+        s_pStack[depth - 2]->m_children.Add(pObject);
+    }
+    s_pStack[depth - 1] = pObject;
+}
+
+void WatchObject(const char* pName, int depth)
+{
+    WatchedObject* pObject = FindWatchedObject(pName);
+    pObject->m_files.m_count = 0;
+    pObject->m_children.m_count = 0;
+    pObject->m_bStale = false;
+    AddChild(pObject, depth);
+}
+
+void WatchObjectFromHeap(const char* pName, int depth)
+{
+    AddChild(FindWatchedObject(pName), depth);
+}
+
+void WatchFile(const char* pPath, int depth)
+{
+    if (depth < 1 || depth > WatchDepthLimit)
+    {
+        return;
+    }
+    s_pStack[depth - 1]->m_files.Add(FindWatchedFile(pPath, true));
+}
+
+bool StartWatching()
+{
+#ifdef __linux__
+    if (s_watchFd < 0)
+    {
+        s_watchFd = inotify_init();
+    }
+    return s_watchFd >= 0;
+#else
+    return false;
+#endif
+}
+
+#ifdef __linux__
+static void MarkChanged(const struct inotify_event* pEvent)
+{
+    if (pEvent->mask & IN_Q_OVERFLOW)
+    {
+        // events were lost, so everything might have changed
+        for (HashNode* pNode = s_pFiles->First(); pNode != 0; pNode = s_pFiles->Next(pNode))
+        {
+            ((WatchedFile*)pNode->pValue)->m_bChanged = true;
+        }
+        return;
+    }
+    if (pEvent->len == 0)
+    {
+        return;
+    }
+    for (HashNode* pNode = s_pDirs->First(); pNode != 0; pNode = s_pDirs->Next(pNode))
+    {
+        WatchedDir* pDir = (WatchedDir*)pNode->pValue;
+        if (pDir->m_wd == pEvent->wd)
+        {
+            char path[PATH_MAX];
+            if (strcmp(pDir->m_pPath, ".") == 0)
+            {
+                snprintf(path, sizeof(path), "%s", pEvent->name);
+            }
+            else if (strcmp(pDir->m_pPath, "/") == 0)
+            {
+                snprintf(path, sizeof(path), "/%s", pEvent->name);
+            }
+            else
+            {
+                snprintf(path, sizeof(path), "%s/%s", pDir->m_pPath, pEvent->name);
+            }
+            WatchedFile* pFile = FindWatchedFile(path, false);
+            if (pFile)
+            {
+                pFile->m_bChanged = true;
+            }
+            else
+            {
+                // a new file may be one the build could not find, or one that comes before it in the include path
+                for (HashNode* pFileNode = s_pFiles->First(); pFileNode != 0; pFileNode = s_pFiles->Next(pFileNode))
+                {
+                    pFile = (WatchedFile*)pFileNode->pValue;
+                    if (_stricmp(pFile->m_pName, pEvent->name) == 0)
+                    {
+                        pFile->m_bChanged = true;
+                    }
+                }
+            }
+        }
+    }
+}
+#endif
+
+bool WaitForWatchedChanges()
+{
+#ifdef __linux__
+    if (s_watchFd < 0 || !s_pFiles)
+    {
+        return false;
+    }
+
+    // directories of files read since the last wait
+    for (HashNode* pNode = s_pDirs->First(); pNode != 0; pNode = s_pDirs->Next(pNode))
+    {
+        WatchedDir* pDir = (WatchedDir*)pNode->pValue;
+        if (pDir->m_wd < 0)
+        {
+            pDir->m_wd = inotify_add_watch(s_watchFd, pDir->m_pPath, IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE);
+        }
+    }
+
+    // wait for the first change to a file of the build, then until they stop for a moment
+    bool bChanged = false;
+    for (;;)
+    {
+        struct pollfd poller;
+        poller.fd = s_watchFd;
+        poller.events = POLLIN;
+        poller.revents = 0;
+        int ready = poll(&poller, 1, bChanged ? WatchSettleTime : -1);
+        if (ready < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (ready <= 0)
+        {
+            return ready == 0;
+        }
+
+        char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+        int length = (int)read(s_watchFd, buffer, sizeof(buffer));
+        if (length <= 0)
+        {
+            return false;
+        }
+        for (int offset = 0; offset < length; )
+        {
+            const struct inotify_event* pEvent = (const struct inotify_event*)&buffer[offset];
+            MarkChanged(pEvent);
+            offset += sizeof(struct inotify_event) + pEvent->len;
+        }
+
+        for (HashNode* pNode = s_pFiles->First(); pNode != 0 && !bChanged; pNode = s_pFiles->Next(pNode))
+        {
+            bChanged = ((WatchedFile*)pNode->pValue)->m_bChanged;
+        }
+    }
+#else
+    return false;
+#endif
+}
+
+int GetStaleObjects(const char*** pppNames)
+{
+    s_stale.m_count = 0;
+    *pppNames = (const char**)s_stale.m_ppItems;
+    if (!s_pObjects)
+    {
+        return 0;
+    }
+
+    for (HashNode* pNode = s_pObjects->First(); pNode != 0; pNode = s_pObjects->Next(pNode))
+    {
+        WatchedObject* pObject = (WatchedObject*)pNode->pValue;
+        for (int i = 0; i < pObject->m_files.m_count && !pObject->m_bStale; i++)
+        {
+            pObject->m_bStale = ((WatchedFile*)pObject->m_files.m_ppItems[i])->m_bChanged;
+        }
+    }
+
+    // objects above a stale one are stale, go over them until no more are found
+    bool bFound = true;
+    while (bFound)
+    {
+        bFound = false;
+        for (HashNode* pNode = s_pObjects->First(); pNode != 0; pNode = s_pObjects->Next(pNode))
+        {
+            WatchedObject* pObject = (WatchedObject*)pNode->pValue;
+            for (int i = 0; i < pObject->m_children.m_count && !pObject->m_bStale; i++)
+            {
+                if (((WatchedObject*)pObject->m_children.m_ppItems[i])->m_bStale)
+                {
+                    pObject->m_bStale = true;
+                    bFound = true;
+                }
+            }
+        }
+    }
+
+    for (HashNode* pNode = s_pObjects->First(); pNode != 0; pNode = s_pObjects->Next(pNode))
+    {
+        WatchedObject* pObject = (WatchedObject*)pNode->pValue;
+        if (pObject->m_bStale)
+        {
+            s_stale.Add(pObject->m_pName);
+        }
+    }
+    for (HashNode* pNode = s_pFiles->First(); pNode != 0; pNode = s_pFiles->Next(pNode))
+    {
+        ((WatchedFile*)pNode->pValue)->m_bChanged = false;
+    }
+
+    *pppNames = (const char**)s_stale.m_ppItems;
+    return s_stale.m_count;
+}
+
+void CleanWatch()
+{
+    delete s_pObjects;
+    s_pObjects = NULL;
+    delete s_pFiles;
+    s_pFiles = NULL;
+    delete s_pDirs;
+    s_pDirs = NULL;
+    s_stale.m_count = 0;
+#ifdef __linux__
+    if (s_watchFd >= 0)
+    {
+        close(s_watchFd);
+        s_watchFd = -1;
+    }
+#endif
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
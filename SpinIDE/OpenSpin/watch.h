@@ -0,0 +1,51 @@
+///////////////////////////////////////////////////////////////
+//                                                           //
+// Propeller Spin/PASM Compiler Command Line Tool 'OpenSpin' //
+// (c)2012-2013 Parallax Inc. DBA Parallax Semiconductor.    //
+// See end of file for terms of use.                         //
+//                                                           //
+///////////////////////////////////////////////////////////////
+//
+// watch.h
+//
+
+//
+// watch mode (-W option): which objects read which files, and waiting for those files to change (inotify, so Linux only)
+//
+
+#define WatchIndexSize          256
+#define WatchSettleTime         10      // ms without another change before the changes are handed back (saves often take a few writes)
+
+// the recording is done as the build runs, depth is the object nesting (1 = the top object)
+void WatchObject(const char* pName, int depth);         // pName is being compiled, what it read before is forgotten
+void WatchObjectFromHeap(const char* pName, int depth); // pName is used as it was compiled before
+void WatchFile(const char* pPath, int depth);           // the object at depth read pPath
+
+bool StartWatching();                                   // false if it isn't supported here
+bool WaitForWatchedChanges();                           // blocks until a file read by the build changes, false on an error
+int GetStaleObjects(const char*** pppNames);            // the objects that read a changed file, and the objects above them
+void CleanWatch();
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
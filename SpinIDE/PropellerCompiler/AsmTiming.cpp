@@ -0,0 +1,457 @@
+//////////////////////////////////////////////////////////////
+//                                                          //
+// Propeller Spin/PASM Compiler                             //
+// (c)2012 Parallax Inc. DBA Parallax Semiconductor.        //
+// Adapted from Chip Gracey's x86 asm code by Roy Eltham    //
+// See end of file for terms of use.                        //
+//                                                          //
+//////////////////////////////////////////////////////////////
+//
+// AsmTiming.cpp
+//
+// optional cycle estimates for the assembled PASM instructions
+//
+// CompileDatBlocks() records every instruction (and the labels)
+// on its final pass, then each one gets its cost in clocks:
+// 4 for most, 4 or 8 for DJNZ/TJZ/TJNZ (jump or not), 8..23 for
+// hub instructions depending on where the hub window is, and a
+// minimum for the WAITxxx ones. A hub instruction that follows
+// a known number of clocks after the last one gets an exact cost
+// (the window comes around every 16 clocks).
+//
+// instructions are summed in blocks (from a label to the next
+// label, or a break in the cog addresses) and in loops (from
+// the target of a jump back to the jump), loops are summed per
+// pass once the hub window has settled.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include "Utilities.h"
+#include "PropellerCompilerInternal.h"
+#include "SymbolEngine.h"
+
+#define asm_timing_hub_min          8
+#define asm_timing_hub_max          23
+#define asm_timing_hub_period       16
+#define asm_timing_settle_limit     4       // passes over a loop to let the hub window settle
+#define asm_timing_line_limit       64      // source shown in the listing
+
+#define asm_op_djnz                 0x39
+#define asm_op_tjnz                 0x3A
+#define asm_op_tjz                  0x3B
+#define asm_op_waitpeq              0x3C
+#define asm_op_waitvid              0x3F
+#define asm_op_jmp                  0x17
+
+struct AsmTimingLabel
+{
+    int     objOffset;
+    int     sourceStart;
+    int     sourceFinish;
+};
+
+static AsmTimingInstruction* s_pInstructions = 0;
+static int s_instructionCount = 0;
+static int s_instructionSize = 0;
+static AsmTimingLabel* s_pLabels = 0;
+static int s_labelCount = 0;
+static int s_labelSize = 0;
+static AsmTimingBlock* s_pBlocks = 0;
+static int s_blockCount = 0;
+static int s_blockSize = 0;
+
+template <typename T> static T* AsmTiming_Grow(T* pArray, int count, int& size)
+{
+    if (count < size)
+    {
+        return pArray;
+    }
+    int newSize = (size > 0) ? size * 2 : 256;
+    T* pNewArray = new T[newSize];
+    if (pArray)
+    {
+        memcpy(pNewArray, pArray, count * sizeof(T));
+        delete [] pArray;
+    }
+    size = newSize;
+    return pNewArray;
+}
+
+void AsmTiming_Reset()
+{
+    s_instructionCount = 0;
+    s_labelCount = 0;
+    s_blockCount = 0;
+}
+
+void AsmTiming_Cleanup()
+{
+    delete [] s_pInstructions;
+    s_pInstructions = 0;
+    s_instructionSize = 0;
+    delete [] s_pLabels;
+    s_pLabels = 0;
+    s_labelSize = 0;
+    delete [] s_pBlocks;
+    s_pBlocks = 0;
+    s_blockSize = 0;
+    AsmTiming_Reset();
+}
+
+// called for each label in the DAT blocks (before any alignment)
+void AsmTiming_EnterLabel(int objOffset, int sourceStart, int sourceFinish)
+{
+    s_pLabels = AsmTiming_Grow(s_pLabels, s_labelCount, s_labelSize);
+    s_pLabels[s_labelCount].objOffset = objOffset;
+    s_pLabels[s_labelCount].sourceStart = sourceStart;
+    s_pLabels[s_labelCount].sourceFinish = sourceFinish;
+    s_labelCount++;
+}
+
+// called for each instruction just before it is entered, lineStart is the first element on its line
+void AsmTiming_EnterInstruction(int objOffset, int cogAddress, unsigned int instruction, int lineStart)
+{
+    // the line goes up to the end of line (comments included)
+    int lineFinish = lineStart;
+    while (g_pCompilerData->source[lineFinish] != 0 &&
+           g_pCompilerData->source[lineFinish] != 13 &&
+           g_pCompilerData->source[lineFinish] != 10)
+    {
+        lineFinish++;
+    }
+
+    s_pInstructions = AsmTiming_Grow(s_pInstructions, s_instructionCount, s_instructionSize);
+    AsmTimingInstruction& entry = s_pInstructions[s_instructionCount++];
+    entry.objOffset = objOffset;
+    entry.cogAddress = cogAddress;
+    entry.instruction = instruction;
+    entry.lineStart = lineStart;
+    entry.lineFinish = lineFinish;
+    entry.labelStart = 0;
+    entry.labelFinish = 0;
+    entry.minCycles = 0;
+    entry.maxCycles = 0;
+}
+
+static bool AsmTiming_IsHub(unsigned int instruction)
+{
+    return (instruction >> 26) <= 0x03; // RDxxxx/WRxxxx and the hub instructions (CLKSET, COGID, COGINIT, COGSTOP, LOCKxxx)
+}
+
+static bool AsmTiming_IsAlways(unsigned int instruction)
+{
+    return ((instruction >> 18) & 0x0F) == if_always;
+}
+
+// cog address a jump goes to, or -1 if it isn't a jump with an immediate target (or doesn't ever jump)
+static int AsmTiming_JumpTarget(unsigned int instruction)
+{
+    int op = instruction >> 26;
+    if (((instruction >> 18) & 0x0F) == if_never || (instruction & 0x00400000) == 0)
+    {
+        return -1;
+    }
+    if ((op == asm_op_jmp && (instruction & 0x00800000) == 0) || // JMP (JMPRET/CALL write the return)
+        op == asm_op_djnz || op == asm_op_tjnz || op == asm_op_tjz)
+    {
+        return instruction & 0x1FF;
+    }
+    return -1;
+}
+
+// clocks for one instruction, hubPhase is the clocks since the last hub instruction finished (-1 if not known)
+static void AsmTiming_Cost(unsigned int instruction, int hubPhase, bool bTaken, int& minCycles, int& maxCycles)
+{
+    int op = instruction >> 26;
+    minCycles = 4;
+    maxCycles = 4;
+
+    if (((instruction >> 18) & 0x0F) == if_never)
+    {
+        return;
+    }
+
+    if (AsmTiming_IsHub(instruction))
+    {
+        if (hubPhase >= 0)
+        {
+            // the next window is a multiple of the period after the last one
+            minCycles = asm_timing_hub_min + ((asm_timing_hub_period - ((hubPhase + asm_timing_hub_min) % asm_timing_hub_period)) % asm_timing_hub_period);
+            maxCycles = minCycles;
+        }
+        else
+        {
+            minCycles = asm_timing_hub_min;
+            maxCycles = asm_timing_hub_max;
+        }
+    }
+    else if (op == asm_op_djnz || op == asm_op_tjnz || op == asm_op_tjz)
+    {
+        maxCycles = bTaken ? 4 : 8;
+    }
+    else if (op >= asm_op_waitpeq)
+    {
+        minCycles = (op == asm_op_waitvid) ? 4 : 6;
+        maxCycles = asm_timing_waits;
+    }
+
+    if (!AsmTiming_IsAlways(instruction))
+    {
+        minCycles = 4; // skipped
+    }
+}
+
+// hub phase after an instruction
+static int AsmTiming_Phase(unsigned int instruction, int hubPhase, int minCycles, int maxCycles)
+{
+    if (AsmTiming_IsHub(instruction) && ((instruction >> 18) & 0x0F) != if_never)
+    {
+        return AsmTiming_IsAlways(instruction) ? 0 : -1;
+    }
+    if (hubPhase < 0 || minCycles != maxCycles)
+    {
+        return -1;
+    }
+    return (hubPhase + minCycles) % asm_timing_hub_period;
+}
+
+// sums a run of instructions, the last one jumps back to the first when bLoop is set
+static void AsmTiming_Sum(int first, int count, bool bLoop, bool bStore, int& hubPhase, int& minCycles, int& maxCycles)
+{
+    minCycles = 0;
+    maxCycles = 0;
+    for (int i = first; i < first + count; i++)
+    {
+        AsmTimingInstruction& entry = s_pInstructions[i];
+        int minCost = 0;
+        int maxCost = 0;
+        AsmTiming_Cost(entry.instruction, hubPhase, bLoop && i == first + count - 1, minCost, maxCost);
+        hubPhase = AsmTiming_Phase(entry.instruction, hubPhase, minCost, maxCost);
+        if (bStore)
+        {
+            entry.minCycles = minCost;
+            entry.maxCycles = maxCost;
+        }
+        minCycles += minCost;
+        if (maxCycles != asm_timing_waits)
+        {
+            maxCycles = (maxCost == asm_timing_waits) ? asm_timing_waits : maxCycles + maxCost;
+        }
+    }
+}
+
+static void AsmTiming_EnterBlock(int first, int count, bool bLoop)
+{
+    for (int i = 0; i < s_blockCount; i++)
+    {
+        if (s_pBlocks[i].first == first && s_pBlocks[i].count == count && s_pBlocks[i].bLoop == bLoop)
+        {
+            return;
+        }
+    }
+
+    int hubPhase = -1;
+    int minCycles = 0;
+    int maxCycles = 0;
+    AsmTiming_Sum(first, count, bLoop, !bLoop, hubPhase, minCycles, maxCycles);
+    if (bLoop)
+    {
+        // go around again from where the hub window ended up until it settles
+        for (int pass = 0; pass < asm_timing_settle_limit && hubPhase >= 0; pass++)
+        {
+            int entryPhase = hubPhase;
+            AsmTiming_Sum(first, count, true, false, hubPhase, minCycles, maxCycles);
+            if (hubPhase == entryPhase)
+            {
+                break;
+            }
+        }
+    }
+
+    s_pBlocks = AsmTiming_Grow(s_pBlocks, s_blockCount, s_blockSize);
+    AsmTimingBlock& block = s_pBlocks[s_blockCount++];
+    block.first = first;
+    block.count = count;
+    block.bLoop = bLoop;
+    block.minCycles = minCycles;
+    block.maxCycles = maxCycles;
+}
+
+// true if instruction index doesn't follow straight on from the one before it (data or an ORG in between)
+static bool AsmTiming_IsBreak(int index)
+{
+    return s_pInstructions[index].cogAddress != s_pInstructions[index - 1].cogAddress + 1 ||
+           s_pInstructions[index].objOffset != s_pInstructions[index - 1].objOffset + 4;
+}
+
+// called after the final pass of CompileDatBlocks()
+void AsmTiming_Determine()
+{
+    s_blockCount = 0;
+
+    // attach the labels, a label goes with the instruction at its (long aligned) offset
+    int label = 0;
+    for (int i = 0; i < s_instructionCount; i++)
+    {
+        AsmTimingInstruction& entry = s_pInstructions[i];
+        while (label < s_labelCount && s_pLabels[label].objOffset <= entry.objOffset)
+        {
+            if (((s_pLabels[label].objOffset + 3) & ~3) == entry.objOffset && entry.labelFinish == 0 &&
+                (i == 0 || s_pLabels[label].objOffset > s_pInstructions[i - 1].objOffset))
+            {
+                entry.labelStart = s_pLabels[label].sourceStart;
+                entry.labelFinish = s_pLabels[label].sourceFinish;
+            }
+            label++;
+        }
+    }
+
+    // straight line blocks
+    int blockStart = 0;
+    for (int i = 1; i <= s_instructionCount; i++)
+    {
+        if (i == s_instructionCount || AsmTiming_IsBreak(i) || s_pInstructions[i].labelFinish != 0)
+        {
+            AsmTiming_EnterBlock(blockStart, i - blockStart, false);
+            blockStart = i;
+        }
+    }
+
+    // loops, a jump back to an instruction in the same run
+    int runStart = 0;
+    for (int i = 0; i < s_instructionCount; i++)
+    {
+        if (i > 0 && AsmTiming_IsBreak(i))
+        {
+            runStart = i;
+        }
+        int target = AsmTiming_JumpTarget(s_pInstructions[i].instruction);
+        if (target < 0 || target > s_pInstructions[i].cogAddress || target < s_pInstructions[runStart].cogAddress)
+        {
+            continue;
+        }
+        int first = i - (s_pInstructions[i].cogAddress - target);
+        AsmTiming_EnterBlock(first, i - first + 1, true);
+    }
+}
+
+static void AsmTiming_FormatCycles(char* pBuffer, int minCycles, int maxCycles)
+{
+    if (maxCycles == asm_timing_waits)
+    {
+        sprintf(pBuffer, "%d+", minCycles);
+    }
+    else if (minCycles == maxCycles)
+    {
+        sprintf(pBuffer, "%d", minCycles);
+    }
+    else
+    {
+        sprintf(pBuffer, "%d..%d", minCycles, maxCycles);
+    }
+}
+
+static void AsmTiming_CopySource(char* pBuffer, int start, int finish, int limit)
+{
+    int length = 0;
+    for (int i = start; i < finish && length < limit; i++)
+    {
+        char theChar = g_pCompilerData->source[i];
+        pBuffer[length++] = (theChar == 9) ? ' ' : theChar;
+    }
+    while (length > 0 && pBuffer[length - 1] == ' ')
+    {
+        length--;
+    }
+    pBuffer[length] = 0;
+}
+
+// adds the timing to the listing
+bool AsmTiming_Print()
+{
+    if (s_instructionCount == 0)
+    {
+        return true;
+    }
+
+    char tempStr[256];
+    char cycles[32];
+    char source[asm_timing_line_limit + 1];
+    if (!PrintString("\rPASM cycles:\r\rCOG OBJ  INSTRUCTION CYCLES  SOURCE\r"))
+    {
+        return false;
+    }
+    for (int i = 0; i < s_instructionCount; i++)
+    {
+        const AsmTimingInstruction& entry = s_pInstructions[i];
+        AsmTiming_FormatCycles(cycles, entry.minCycles, entry.maxCycles);
+        AsmTiming_CopySource(source, entry.lineStart, entry.lineFinish, asm_timing_line_limit);
+        sprintf(tempStr, "%03X %04X %08X    %-7s %s\r", entry.cogAddress, entry.objOffset, entry.instruction, cycles, source);
+        if (!PrintString(tempStr))
+        {
+            return false;
+        }
+    }
+
+    if (!PrintChr(13))
+    {
+        return false;
+    }
+    for (int i = 0; i < s_blockCount; i++)
+    {
+        const AsmTimingBlock& block = s_pBlocks[i];
+        const AsmTimingInstruction& first = s_pInstructions[block.first];
+        const AsmTimingInstruction& last = s_pInstructions[block.first + block.count - 1];
+        AsmTiming_FormatCycles(cycles, block.minCycles, block.maxCycles);
+        AsmTiming_CopySource(source, first.labelStart, first.labelFinish, symbol_limit);
+        sprintf(tempStr, "%s %s%s%03X-%03X: %s cycles%s\r", block.bLoop ? "Loop " : "Block", source, source[0] != 0 ? " " : "",
+                first.cogAddress, last.cogAddress, cycles, block.bLoop ? " per pass" : "");
+        if (!PrintString(tempStr))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int AsmTiming_GetInstructionCount()
+{
+    return s_instructionCount;
+}
+
+const AsmTimingInstruction* AsmTiming_GetInstruction(int index)
+{
+    return (index >= 0 && index < s_instructionCount) ? &s_pInstructions[index] : 0;
+}
+
+int AsmTiming_GetBlockCount()
+{
+    return s_blockCount;
+}
+
+const AsmTimingBlock* AsmTiming_GetBlock(int index)
+{
+    return (index >= 0 && index < s_blockCount) ? &s_pBlocks[index] : 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
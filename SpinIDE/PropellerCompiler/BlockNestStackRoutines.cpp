@@ -90,6 +90,8 @@ bool BlockStack_CompileConstant()
 {
     int value = BlockStack_Read(0);
 
+    Peephole_EnterAddressConstant();
+
     if (value >= 0x100)
     {
         // two byte
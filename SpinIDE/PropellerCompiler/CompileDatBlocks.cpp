@@ -20,6 +20,12 @@
 #include "Elementizer.h"
 #include "ErrorStrings.h"
 
+// these are in AsmTiming.cpp
+extern void AsmTiming_Reset();
+extern void AsmTiming_EnterLabel(int objOffset, int sourceStart, int sourceFinish);
+extern void AsmTiming_EnterInstruction(int objOffset, int cogAddress, unsigned int instruction, int lineStart);
+extern void AsmTiming_Determine();
+
 void CompileDatBlocks_EnterInfo(int datstart, int objstart)
 {
     g_pCompilerData->inf_start = datstart;
@@ -63,6 +69,19 @@ bool CompileDatBlocks_EnterByte(unsigned char value)
     return false;
 }
 
+bool CompileDatBlocks_EnterBytes(const unsigned char* pData, int length)
+{
+    if (EnterObjBytes(pData, length))
+    {
+        if (g_pCompilerData->orgx == 0)
+        {
+            g_pCompilerData->cog_org += length;
+        }
+        return true;
+    }
+    return false;
+}
+
 bool CompileDatBlocks_Enter(int value, int count, int size)
 {
     int numBytesPer = 1 << size;
@@ -217,18 +236,15 @@ bool CompileDatBlocks_File(bool bSymbol, bool bResSymbol, int& size)
         return false;
     }
 
-    // find the file in the dat_data array and copy it into obj
+    // find the file in the dat_binaries array and copy it into obj
     for (int i = 0; i < g_pCompilerData->dat_files; i++)
     {
         if (strcmp(&(g_pCompilerData->dat_filenames[256*i]), g_pCompilerData->filename) == 0)
         {
-            // copy dat data into obj (RPE: this should be optimized)
-            for (int j = 0; j < g_pCompilerData->dat_lengths[i]; j++)
+            // copy dat data into obj
+            if (!CompileDatBlocks_EnterBytes(g_pCompilerData->dat_binaries[i], g_pCompilerData->dat_lengths[i]))
             {
-                if (!CompileDatBlocks_EnterByte(g_pCompilerData->dat_data[g_pCompilerData->dat_offsets[i] + j]))
-                {
-                    return false;
-                }
+                return false;
             }
             if (!g_pElementizer->GetElement(type_end))
             {
@@ -682,6 +698,11 @@ bool CompileDatBlocks_AsmInstruction(bool& bEof, int pass, bool bSymbol, bool bR
             break;
         }
     }
+    if (pass == 1 && g_pCompilerData->bAsmTiming)
+    {
+        AsmTiming_EnterInstruction(g_pCompilerData->obj_ptr, g_pCompilerData->cog_org >> 2, instruction, g_pCompilerData->inf_start);
+    }
+
     // enter instruction as 1 long
     if (!CompileDatBlocks_Enter(instruction, 1, 2))
     {
@@ -731,6 +752,8 @@ bool CompileDatBlocks()
     int datstart = 0;
     int objstart = 0;
 
+    AsmTiming_Reset();
+
     for (int pass = 0; pass < 2; pass++)
     {
         g_pCompilerData->obj_ptr = ptr;
@@ -828,6 +851,11 @@ bool CompileDatBlocks()
                             g_pCompilerData->error_msg = g_pErrorStrings[error_siad];
                             return false;
                         }
+                        if (g_pCompilerData->bAsmTiming)
+                        {
+                            // labels are only seen as already defined, on the final pass
+                            AsmTiming_EnterLabel(g_pCompilerData->obj_ptr, g_pCompilerData->inf_start, g_pCompilerData->inf_finish);
+                        }
                         if (!g_pElementizer->GetNext(bEof))
                         {
                             return false;
@@ -907,6 +935,11 @@ bool CompileDatBlocks()
             CompileDatBlocks_EnterInfo(datstart, objstart);
         }
     }
+
+    if (g_pCompilerData->bAsmTiming)
+    {
+        AsmTiming_Determine();
+    }
     return true;
 }
 
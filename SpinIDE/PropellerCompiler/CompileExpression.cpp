@@ -290,6 +290,8 @@ bool CompileTerm_FloatRoundTrunc()
 
 bool CompileTerm_Sub(unsigned char anchor, int value)
 {
+    UnusedMethods_AddCall(-1, value & 0xFF);
+
     if (!EnterObj(anchor)) // drop anchor
     {
         return false;
@@ -333,6 +335,7 @@ bool CompileTerm_ObjPub(unsigned char anchor, int value)
     }
 
     int objPubValue = g_pElementizer->GetValue();
+    UnusedMethods_AddCall((value & 0x0000FF00) >> 8, objPubValue & 0xFF);
 
     // compile any paramaters the pub has
     if (!CompileParameters((objPubValue & 0x0000FF00) >> 8))
@@ -551,6 +554,7 @@ bool CompileTerm_CogNew(int value)
     if (g_pElementizer->GetType() == type_sub)
     {
         int subConstant = g_pElementizer->GetValue();
+        UnusedMethods_AddCall(-1, subConstant & 0xFF);
         // it is a sub, so compile as cognew(subname(params),stack)
         if (!CompileParameters((g_pElementizer->GetValue() & 0x0000FF00) >> 8))
         {
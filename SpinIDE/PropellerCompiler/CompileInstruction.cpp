@@ -125,6 +125,10 @@ bool CompileInst_AbortReturn(int value)
         }
         value |= 0x01; // +value
     }
+    if (!Profiling_CompileReturn())
+    {
+        return false;
+    }
     return EnterObj((unsigned char)(value & 0xFF));
 }
 
@@ -186,6 +190,7 @@ bool CompileInst_CogInit(int value)
 
     // compile subroutine 'cognew' (push params+index)
     int subConstant = g_pElementizer->GetValue();
+    UnusedMethods_AddCall(-1, subConstant & 0xFF);
     if (!CompileParameters((g_pElementizer->GetValue() & 0x0000FF00) >> 8))
     {
         return false;
@@ -472,17 +472,14 @@ bool CompileParameters(int numParameters)
     return true;
 }
 
-bool CompileConstant(int value)
+// Encode the shortest constant bytecode sequence for value into pBytes (up to 5 bytes), returns the length
+int EncodeConstant(int value, unsigned char* pBytes)
 {
     if (value >= -1 && value <= 1)
     {
         // constant is -1, 0, or 1, so compiles to a single bytecode
-        unsigned char byteCode = (unsigned char)(value+1) | 0x34;
-        if (!EnterObj(byteCode))
-        {
-            return false;
-        }
-        return true;
+        pBytes[0] = (unsigned char)(value+1) | 0x34;
+        return 1;
     }
 
     // see if it's a mask
@@ -506,15 +503,9 @@ bool CompileConstant(int value)
 
         if (testVal == value)
         {
-            if (!EnterObj(0x37)) // (constant mask)
-            {
-                return false;
-            }
-            if (!EnterObj(i))
-            {
-                return false;
-            }
-            return true;
+            pBytes[0] = 0x37; // (constant mask)
+            pBytes[1] = i;
+            return 2;
         }
     }
 
@@ -522,43 +513,19 @@ bool CompileConstant(int value)
     if ((value & 0xFFFFFF00) == 0xFFFFFF00)
     {
         // one byte constant using 'not'
-        if (!EnterObj(0x38))
-        {
-            return false;
-        }
-        unsigned char byteCode = (unsigned char)(value & 0xFF);
-        if (!EnterObj(~byteCode))
-        {
-            return false;
-        }
-        if (!EnterObj(0xE7)) // (bitwise bot)
-        {
-            return false;
-        }
-        return true;
+        pBytes[0] = 0x38;
+        pBytes[1] = ~(unsigned char)(value & 0xFF);
+        pBytes[2] = 0xE7; // (bitwise bot)
+        return 3;
     }
     else if ((value & 0xFFFF0000) == 0xFFFF0000)
     {
         // two byte constant using 'not'
-        if (!EnterObj(0x39))
-        {
-            return false;
-        }
-        unsigned char byteCode = (unsigned char)((value >> 8) & 0xFF);
-        if (!EnterObj(~byteCode))
-        {
-            return false;
-        }
-        byteCode = (unsigned char)(value & 0xFF);
-        if (!EnterObj(~byteCode))
-        {
-            return false;
-        }
-        if (!EnterObj(0xE7)) // (bitwise bot)
-        {
-            return false;
-        }
-        return true;
+        pBytes[0] = 0x39;
+        pBytes[1] = ~(unsigned char)((value >> 8) & 0xFF);
+        pBytes[2] = ~(unsigned char)(value & 0xFF);
+        pBytes[3] = 0xE7; // (bitwise bot)
+        return 4;
     }
 
     // 1 to 4 byte constant
@@ -575,20 +542,19 @@ bool CompileConstant(int value)
     {
         size = 2;
     }
-    unsigned char byteCode = 0x37 + size; // (constant 1..4 bytes)
-    if (!EnterObj(byteCode))
-    {
-        return false;
-    }
+    pBytes[0] = 0x37 + size; // (constant 1..4 bytes)
     for (unsigned char i = size; i > 0; i--)
     {
-        byteCode = (unsigned char)((value >> ((i - 1) * 8)) & 0xFF);
-        if (!EnterObj(byteCode))
-        {
-            return false;
-        }
+        pBytes[1 + size - i] = (unsigned char)((value >> ((i - 1) * 8)) & 0xFF);
     }
-    return true;
+    return 1 + size;
+}
+
+bool CompileConstant(int value)
+{
+    unsigned char bytes[5];
+    int length = EncodeConstant(value, bytes);
+    return EnterObjBytes(bytes, length);
 }
 
 bool CompileOutOfSequenceExpression(int sourcePtr)
@@ -27,6 +27,7 @@ extern bool CompileVariable_PreSignExtendOrRandom(unsigned char vOperator);
 extern bool CompileVariable_IncOrDec(unsigned char vOperator, unsigned char type, unsigned char size, int address, int indexSourcePtr);
 extern bool CompileVariable_PreIncOrDec(unsigned char vOperator);
 extern bool CompileParameters(int numParameters);
+extern int EncodeConstant(int value, unsigned char* pBytes);
 extern bool CompileConstant(int value);
 extern bool CompileOutOfSequenceExpression(int sourcePtr);
 extern bool CompileOutOfSequenceRange(int sourcePtr, bool& bRange);
@@ -56,6 +57,19 @@ extern int BlockStack_Read(int address);
 extern bool BlockStack_CompileAddress(int address);
 extern bool BlockStack_CompileConstant();
 
+// these are in PeepholeOptimizer.cpp
+extern void Peephole_Begin();
+extern void Peephole_EnterAddressConstant();
+extern bool Peephole_Optimize();
+
+// these are in UnusedMethods.cpp
+extern void UnusedMethods_EnterMethod(const char* pName);
+extern void UnusedMethods_BeginMethod(int subIndex);
+extern void UnusedMethods_AddCall(int objFileIndex, int subIndex);
+extern bool UnusedMethods_IsUnused(const char* pName);
+
+extern bool Profiling_CompileReturn(); // in Profiling.cpp
+
 #endif // _COMPILEUTILITIES_H_
 
 ///////////////////////////////////////////////////////////////////////////////////////////
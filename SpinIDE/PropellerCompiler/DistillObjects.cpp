@@ -21,6 +21,7 @@
 #include "SymbolEngine.h"
 #include "Elementizer.h"
 #include "ErrorStrings.h"
+#include "SpinBytecode.h"
 
 bool DistillSetup_Enter(unsigned short value)
 {
@@ -285,6 +286,271 @@ void DistillReconnect(int disPtr = 0)
     }
 }
 
+//
+// method folding (optional, bFoldMethods)
+//
+// a PUB/PRI body only depends on the pbase/vbase/dbase it runs with, so identical bodies
+// in different objects (or the same object) can share one copy, with the index table
+// entries of the others pointing at it. The offset in an index table entry is added to
+// pbase by the interpreter and hub addresses wrap at 16 bits, so the shared copy can be
+// before or after the object.
+//
+// this only works for bodies that hold no addresses of their own, case/lookup address
+// constants and string addresses are pbase relative and point into the body, so any
+// body with a constant that could be one of those, or with a pbase relative variable
+// (string() compiles to @byte[pbase][offset]) at or after its start, is left alone.
+// The DAT data before the bodies stays where it is and each object keeps its own
+// pbase, so DAT variables don't stop a body from being shared. Removing a body moves
+// the bodies after it in the object, so that is only done if they don't hold addresses
+// either.
+//
+
+struct DistillMethod
+{
+    int     disPtr;         // distiller record of the object
+    int     index;          // index table slot
+    int     start;          // offset of the body in the object
+    int     region;         // bytes up to the next body (or the end of the object)
+    int     length;         // bytes compared (region without the long alignment padding on the last body)
+    int     hash;
+    bool    bRelocatable;   // holds no addresses of its own, so it can be shared and moved
+    int     shared;         // s_distillMethods index of the copy used instead, or -1
+};
+
+static DistillMethod* s_distillMethods = 0;
+static int s_distillMethodCount = 0;
+
+// Jenkins One-at-a-time hash of a body
+static int DistillFold_Hash(const unsigned char* pBody, int length)
+{
+    int hash = 0;
+    for (int i = 0; i < length; i++)
+    {
+        hash += pBody[i];
+        hash += (hash << 10);
+        hash ^= (hash >> 6);
+    }
+    hash += (hash << 3);
+    hash ^= (hash >> 11);
+    hash += (hash << 15);
+    return hash;
+}
+
+// decode the whole body, it must not branch outside itself, push a constant that could be an address inside itself
+// or reach into the bodies pbase relative
+static bool DistillFold_IsRelocatable(const unsigned char* pObj, int start, int end)
+{
+    int pos = start;
+    while (pos < end)
+    {
+        SpinInstruction instruction;
+        if (!DecodeSpinInstruction(pObj, pos, end, instruction))
+        {
+            return false;
+        }
+        if (instruction.bBranch && (instruction.branchTarget < start || instruction.branchTarget > end))
+        {
+            return false;
+        }
+        if (instruction.bConstant && instruction.constantValue >= start && instruction.constantValue < end)
+        {
+            return false;
+        }
+        if (instruction.bVariable && instruction.varBase == spin_base_obj && instruction.varAddress >= start)
+        {
+            // a string (or anything else in the method bodies), the DAT data before the bodies doesn't move
+            return false;
+        }
+        pos += instruction.length;
+    }
+    return true;
+}
+
+// add the bodies of one object to s_distillMethods
+static void DistillFold_AddObject(int disPtr)
+{
+    int objectOffset = g_pCompilerData->dis[disPtr + 1];
+    unsigned char* pObj = &(g_pCompilerData->obj[objectOffset]);
+    int objLength = *((unsigned short*)pObj);
+    int subCount = pObj[2] - 1;
+    int firstBody = (pObj[2] + pObj[3]) * 4;
+
+    // the bodies must follow the index in index order, otherwise the object is left alone
+    int lastStart = firstBody - 1;
+    for (int i = 0; i < subCount; i++)
+    {
+        int start = *((unsigned short*)&(pObj[4 + (i * 4)]));
+        if (start <= lastStart || start >= objLength)
+        {
+            return;
+        }
+        lastStart = start;
+    }
+
+    for (int i = 0; i < subCount; i++)
+    {
+        DistillMethod& method = s_distillMethods[s_distillMethodCount++];
+        method.disPtr = disPtr;
+        method.index = i;
+        method.start = *((unsigned short*)&(pObj[4 + (i * 4)]));
+        int end = (i < subCount - 1) ? *((unsigned short*)&(pObj[4 + ((i + 1) * 4)])) : objLength;
+        method.region = end - method.start;
+        method.length = method.region;
+        if (i == subCount - 1)
+        {
+            // the last body always ends with a return, anything after that is padding
+            int length = method.length;
+            while (length > method.length - 3 && length > 0 && pObj[method.start + length - 1] == 0)
+            {
+                length--;
+            }
+            if (length > 0 && pObj[method.start + length - 1] == 0x32)
+            {
+                method.length = length;
+            }
+        }
+        method.hash = DistillFold_Hash(&pObj[method.start], method.length);
+        method.bRelocatable = DistillFold_IsRelocatable(pObj, method.start, method.start + method.length);
+        method.shared = -1;
+    }
+}
+
+// remove the shared bodies from one object, returns the number of bytes removed
+static int DistillFold_Compact(int disPtr)
+{
+    int objectOffset = g_pCompilerData->dis[disPtr + 1];
+    unsigned char* pObj = &(g_pCompilerData->obj[objectOffset]);
+    int objLength = *((unsigned short*)pObj);
+    int newLength = objLength;
+
+    // from the last body back, so the starts of the ones still to do don't change
+    for (int i = s_distillMethodCount - 1; i >= 0; i--)
+    {
+        DistillMethod& method = s_distillMethods[i];
+        if (method.disPtr != disPtr || method.shared == -1)
+        {
+            continue;
+        }
+        int end = method.start + method.region;
+        memmove(&pObj[method.start], &pObj[end], (size_t)(newLength - end));
+        newLength -= method.region;
+
+        // move the index entries of the bodies after it
+        for (int j = i + 1; j < s_distillMethodCount && s_distillMethods[j].disPtr == disPtr; j++)
+        {
+            unsigned short* pEntry = (unsigned short*)&(pObj[4 + (s_distillMethods[j].index * 4)]);
+            if (s_distillMethods[j].shared == -1)
+            {
+                *pEntry = (unsigned short)(*pEntry - method.region);
+            }
+        }
+    }
+
+    if (newLength != objLength)
+    {
+        // keep the object long aligned
+        while (newLength & 3)
+        {
+            pObj[newLength++] = 0;
+        }
+        *((unsigned short*)pObj) = (unsigned short)newLength;
+    }
+    return objLength - newLength;
+}
+
+// find the identical bodies and remove all but one copy of each, returns the number of bytes removed
+int DistillFold()
+{
+    if (!g_pCompilerData->bFoldMethods)
+    {
+        return 0;
+    }
+
+    // every object has fewer than 256 bodies
+    int objectCount = 0;
+    int disPtr = 0;
+    while (disPtr < g_pCompilerData->dis_ptr)
+    {
+        objectCount++;
+        disPtr += (3 + g_pCompilerData->dis[disPtr + 2]);
+    }
+    s_distillMethods = new DistillMethod[objectCount * 256];
+    s_distillMethodCount = 0;
+
+    disPtr = 0;
+    while (disPtr < g_pCompilerData->dis_ptr)
+    {
+        DistillFold_AddObject(disPtr);
+        disPtr += (3 + g_pCompilerData->dis[disPtr + 2]);
+    }
+
+    // a body can only be removed if everything after it in its object can move
+    int removed = 0;
+    for (int i = 0; i < s_distillMethodCount; i++)
+    {
+        DistillMethod& method = s_distillMethods[i];
+        if (!method.bRelocatable)
+        {
+            continue;
+        }
+        bool bCanMove = true;
+        for (int j = i + 1; j < s_distillMethodCount && s_distillMethods[j].disPtr == method.disPtr; j++)
+        {
+            if (!s_distillMethods[j].bRelocatable)
+            {
+                bCanMove = false;
+                break;
+            }
+        }
+        if (!bCanMove)
+        {
+            continue;
+        }
+
+        for (int j = 0; j < i; j++)
+        {
+            DistillMethod& other = s_distillMethods[j];
+            if (other.shared == -1 && other.bRelocatable && other.hash == method.hash && other.length == method.length &&
+                memcmp(&(g_pCompilerData->obj[g_pCompilerData->dis[other.disPtr + 1] + other.start]),
+                       &(g_pCompilerData->obj[g_pCompilerData->dis[method.disPtr + 1] + method.start]), (size_t)method.length) == 0)
+            {
+                method.shared = j;
+                break;
+            }
+        }
+    }
+
+    disPtr = 0;
+    while (disPtr < g_pCompilerData->dis_ptr)
+    {
+        removed += DistillFold_Compact(disPtr);
+        disPtr += (3 + g_pCompilerData->dis[disPtr + 2]);
+    }
+    return removed;
+}
+
+// after the rebuild, point the index entries of the removed bodies at the shared copies
+void DistillFold_Reconnect()
+{
+    for (int i = 0; i < s_distillMethodCount; i++)
+    {
+        DistillMethod& method = s_distillMethods[i];
+        if (method.shared == -1)
+        {
+            continue;
+        }
+        DistillMethod& shared = s_distillMethods[method.shared];
+        unsigned short objectOffset = g_pCompilerData->dis[method.disPtr + 1];
+        unsigned short sharedObjectOffset = g_pCompilerData->dis[shared.disPtr + 1];
+        unsigned short sharedStart = *((unsigned short*)&(g_pCompilerData->obj[sharedObjectOffset + 4 + (shared.index * 4)]));
+        *((unsigned short*)&(g_pCompilerData->obj[objectOffset + 4 + (method.index * 4)])) = (unsigned short)(sharedObjectOffset + sharedStart - objectOffset);
+    }
+
+    delete [] s_distillMethods;
+    s_distillMethods = 0;
+    s_distillMethodCount = 0;
+}
+
 bool DistillObjects()
 {
     int saved_obj_ptr = g_pCompilerData->obj_ptr;
@@ -294,10 +560,13 @@ bool DistillObjects()
         return false;
     }
     DistillEliminate();
+    int foldedBytes = DistillFold();
     DistillRebuild();
     DistillReconnect();
+    DistillFold_Reconnect();
 
-    g_pCompilerData->distilled_longs = (saved_obj_ptr - g_pCompilerData->obj_ptr) >> 2;
+    g_pCompilerData->folded_longs = foldedBytes >> 2;
+    g_pCompilerData->distilled_longs = ((saved_obj_ptr - g_pCompilerData->obj_ptr) >> 2) - g_pCompilerData->folded_longs;
 
     char tempStr[64];
     sprintf(tempStr, "\rDistilled longs: %d", g_pCompilerData->distilled_longs);
@@ -305,6 +574,14 @@ bool DistillObjects()
     {
         return false;
     }
+    if (g_pCompilerData->bFoldMethods)
+    {
+        sprintf(tempStr, "\rFolded method longs: %d", g_pCompilerData->folded_longs);
+        if (!PrintString(tempStr))
+        {
+            return false;
+        }
+    }
     return PrintChr(13);
 }
 
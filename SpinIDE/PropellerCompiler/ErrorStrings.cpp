@@ -123,6 +123,7 @@ const char* g_pErrorStrings[] =
     "Symbols _STACK and _FREE can only be used as integer constants",
     "Symbol table is full",
     "This instruction is only allowed within a REPEAT block",
+    "Too many methods to profile",
     "Too many string constants",
     "Too many string constant characters",
     "Too much variable space is declared",
@@ -127,6 +127,7 @@ enum errorType
     error_ssaf,
     error_stif,
     error_tioawarb,
+    error_tmmtp,
     error_tmsc,
     error_tmscc,
     error_tmvsid,
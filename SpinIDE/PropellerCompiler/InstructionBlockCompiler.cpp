@@ -40,6 +40,7 @@ bool CompileTopBlock()
     g_pCompilerData->bnest_ptr = 0;
     g_pCompilerData->bstack_ptr = 0;
     StringConstant_PreProcess();
+    Peephole_Begin();
 
     if (!CompileBlock(0))
     {
@@ -47,7 +48,12 @@ bool CompileTopBlock()
     }
 
     // enter a return into obj
-    if (!EnterObj(0x32)) // 0x32 = 00110010b
+    if (!Profiling_CompileReturn() || !EnterObj(0x32)) // 0x32 = 00110010b
+    {
+        return false;
+    }
+
+    if (!Peephole_Optimize())
     {
         return false;
     }
@@ -0,0 +1,228 @@
+//////////////////////////////////////////////////////////////
+//                                                          //
+// Propeller Spin/PASM Compiler                             //
+// (c)2012 Parallax Inc. DBA Parallax Semiconductor.        //
+// Adapted from Chip Gracey's x86 asm code by Roy Eltham    //
+// See end of file for terms of use.                        //
+//                                                          //
+//////////////////////////////////////////////////////////////
+//
+// Outline.cpp
+//
+// block/method outline of the source for navigating it
+//
+// this goes through the elements once, start to end, the same way
+// GetNextBlock() finds blocks, and only looks at the first element
+// of each line: a block keyword, a PUB/PRI name (the rest of the
+// line is its signature), an OBJ name (the string after the : is
+// its file), or a DAT label. Nothing is entered in the symbol table,
+// so every user symbol comes back type_undefined, and no expression
+// is resolved or code generated.
+//
+
+#include <string.h>
+#include "Utilities.h"
+#include "PropellerCompilerInternal.h"
+#include "SymbolEngine.h"
+#include "Elementizer.h"
+
+static OutlineEntry* s_pEntries = 0;
+static int s_entryCount = 0;
+static int s_entrySize = 0;
+static int s_lineOffset = 0;        // line counting only ever goes forward
+static int s_line = 1;
+
+void Outline_Cleanup()
+{
+    delete [] s_pEntries;
+    s_pEntries = 0;
+    s_entryCount = 0;
+    s_entrySize = 0;
+}
+
+int Outline_GetEntryCount()
+{
+    return s_entryCount;
+}
+
+const OutlineEntry* Outline_GetEntry(int index)
+{
+    return (index >= 0 && index < s_entryCount) ? &s_pEntries[index] : 0;
+}
+
+static int Outline_LineOf(int offset)
+{
+    for (; s_lineOffset < offset; s_lineOffset++)
+    {
+        if (g_pCompilerData->source[s_lineOffset] == 13)
+        {
+            s_line++;
+        }
+    }
+    return s_line;
+}
+
+static OutlineEntry& Outline_Enter(int type, int blockType)
+{
+    if (s_entryCount == s_entrySize)
+    {
+        int newSize = (s_entrySize > 0) ? s_entrySize * 2 : 256;
+        OutlineEntry* pNewEntries = new OutlineEntry[newSize];
+        if (s_pEntries)
+        {
+            memcpy(pNewEntries, s_pEntries, s_entryCount * sizeof(OutlineEntry));
+            delete [] s_pEntries;
+        }
+        s_pEntries = pNewEntries;
+        s_entrySize = newSize;
+    }
+    OutlineEntry& entry = s_pEntries[s_entryCount++];
+    memset(&entry, 0, sizeof(OutlineEntry));
+    entry.type = type;
+    entry.blockType = blockType;
+    entry.start = g_pCompilerData->source_start;
+    entry.finish = g_pCompilerData->source_finish;
+    entry.line = Outline_LineOf(entry.start);
+    return entry;
+}
+
+// reads the rest of the line, detailStart/detailFinish span the elements from the next one on
+static bool Outline_ScanDetail(OutlineEntry& entry, bool& bEof)
+{
+    while (!bEof)
+    {
+        if (!g_pElementizer->GetNext(bEof))
+        {
+            return false;
+        }
+        if (g_pElementizer->GetType() == type_end)
+        {
+            break;
+        }
+        if (entry.detailFinish == 0)
+        {
+            entry.detailStart = g_pCompilerData->source_start;
+        }
+        entry.detailFinish = g_pCompilerData->source_finish;
+    }
+    return true;
+}
+
+const char* CompileOutline()
+{
+    g_pElementizer->Reset();
+    g_pSymbolEngine->Reset();
+    g_pCompilerData->doc_mode = false;
+    s_entryCount = 0;
+    s_lineOffset = 0;
+    s_line = 1;
+
+    int blockType = block_con;      // the source starts out in a CON block
+    int blockEntry = -1;
+    bool bLineStart = true;
+    bool bEof = false;
+    while (!bEof)
+    {
+        if (!g_pElementizer->GetNext(bEof))
+        {
+            return g_pCompilerData->error_msg;
+        }
+        int type = g_pElementizer->GetType();
+        if (type == type_end)
+        {
+            bLineStart = true;
+            continue;
+        }
+        if (!bLineStart)
+        {
+            continue;
+        }
+        bLineStart = false;
+
+        if (type == type_block)
+        {
+            // the last block runs up to this one
+            if (blockEntry >= 0)
+            {
+                s_pEntries[blockEntry].finish = g_pCompilerData->source_start;
+            }
+            blockType = g_pElementizer->GetValue();
+            blockEntry = s_entryCount;
+            OutlineEntry& entry = Outline_Enter(outline_block, blockType);
+            if (blockType == block_pub || blockType == block_pri)
+            {
+                // PUB/PRI name, then the parameters, result and locals
+                if (!g_pElementizer->GetNext(bEof))
+                {
+                    return g_pCompilerData->error_msg;
+                }
+                if (g_pElementizer->GetType() == type_end)
+                {
+                    bLineStart = true;
+                    continue;
+                }
+                entry.nameStart = g_pCompilerData->source_start;
+                entry.nameFinish = g_pCompilerData->source_finish;
+                if (!Outline_ScanDetail(entry, bEof))
+                {
+                    return g_pCompilerData->error_msg;
+                }
+                bLineStart = true;
+            }
+        }
+        else if (type == type_undefined && blockType == block_obj)
+        {
+            // name[count] : "file"
+            OutlineEntry& entry = Outline_Enter(outline_obj, blockType);
+            entry.nameStart = entry.start;
+            entry.nameFinish = entry.finish;
+            while (!bEof && g_pElementizer->GetType() != type_colon && g_pElementizer->GetType() != type_end)
+            {
+                if (!g_pElementizer->GetNext(bEof))
+                {
+                    return g_pCompilerData->error_msg;
+                }
+            }
+            if (g_pElementizer->GetType() == type_colon && !Outline_ScanDetail(entry, bEof))
+            {
+                return g_pCompilerData->error_msg;
+            }
+            bLineStart = true;
+        }
+        else if (type == type_undefined && blockType == block_dat)
+        {
+            OutlineEntry& entry = Outline_Enter(outline_dat_label, blockType);
+            entry.nameStart = entry.start;
+            entry.nameFinish = entry.finish;
+        }
+    }
+
+    if (blockEntry >= 0)
+    {
+        s_pEntries[blockEntry].finish = (int)strlen(g_pCompilerData->source);
+    }
+    g_pCompilerData->source_start = 0;
+    g_pCompilerData->source_finish = 0;
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
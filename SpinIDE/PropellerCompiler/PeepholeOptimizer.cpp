@@ -0,0 +1,681 @@
+//////////////////////////////////////////////////////////////
+//                                                          //
+// Propeller Spin/PASM Compiler                             //
+// (c)2012 Parallax Inc. DBA Parallax Semiconductor.        //
+// Adapted from Chip Gracey's x86 asm code by Roy Eltham    //
+// See end of file for terms of use.                        //
+//                                                          //
+//////////////////////////////////////////////////////////////
+//
+// PeepholeOptimizer.cpp
+//
+// optional pass over the bytecode of each PUB/PRI, run after
+// the method is compiled and before its string constants are
+// placed, the method is then laid out again with all branch
+// addresses, case/lookup address constants, and string
+// address patches fixed up
+//
+
+#include <string.h>
+#include "Utilities.h"
+#include "PropellerCompilerInternal.h"
+#include "SymbolEngine.h"
+#include "Elementizer.h"
+#include "CompileUtilities.h"
+#include "SpinBytecode.h"
+
+#define peephole_address_limit  256 // address constants per method
+#define peephole_pass_limit     16
+#define peephole_hop_limit      16
+
+enum peepholeKind
+{
+    peep_plain = 0,
+    peep_branch,    // code is followed by a relative address
+    peep_address    // case/lookup address constant, code is generated
+};
+
+struct PeepholeInstruction
+{
+    SpinInstruction decoded;
+    unsigned char   code[8];        // bytes, not including a branch address or address constant
+    int             codeLength;
+    int             kind;
+    int             target;         // instruction index of the branch/address target
+    int             addressLength;  // size of the branch address or the address constant value
+    int             strIndex;       // string constant patched inside code, or -1
+    int             strOffset;
+    int             newPos;
+    bool            bDeleted;
+    bool            bTarget;
+};
+
+static int s_methodStart = 0;
+static int s_addressConstants[peephole_address_limit];
+static int s_addressSources[peephole_address_limit];
+static int s_addressConstantCount = 0;
+static bool s_bAddressConstantOverflow = false;
+
+static PeepholeInstruction* s_pInst = 0;
+static int s_instCount = 0;
+
+// called at the start of each method
+void Peephole_Begin()
+{
+    s_methodStart = g_pCompilerData->obj_ptr;
+    s_addressConstantCount = 0;
+    s_bAddressConstantOverflow = false;
+}
+
+// called by BlockStack_CompileConstant() before entering an address constant
+void Peephole_EnterAddressConstant()
+{
+    // skipped code is thrown away, so don't record it (same as string patches)
+    if (!g_pCompilerData->bPeephole || !g_pCompilerData->str_patch_enable)
+    {
+        return;
+    }
+
+    // blocks can be compiled more than once (see OptimizeBlock), so like string constants
+    // these are keyed by source position and the last one compiled is the one that stays
+    int sourcePtr = g_pElementizer->GetSourcePtr();
+    int index = 0;
+    for (; index < s_addressConstantCount; index++)
+    {
+        if (s_addressSources[index] == sourcePtr)
+        {
+            break;
+        }
+    }
+    if (index == s_addressConstantCount)
+    {
+        if (s_addressConstantCount == peephole_address_limit)
+        {
+            s_bAddressConstantOverflow = true;
+            return;
+        }
+        s_addressConstantCount++;
+    }
+    s_addressSources[index] = sourcePtr;
+    s_addressConstants[index] = g_pCompilerData->obj_ptr;
+}
+
+//////////////////////////////////////////
+// instruction list helpers
+//
+
+static int NextLive(int index)
+{
+    for (index++; index < s_instCount; index++)
+    {
+        if (!s_pInst[index].bDeleted)
+        {
+            return index;
+        }
+    }
+    return -1;
+}
+
+// deleted instructions pass their labels on to the next live one
+static int ResolveTarget(int index)
+{
+    while (index < s_instCount && s_pInst[index].bDeleted)
+    {
+        index++;
+    }
+    return index;
+}
+
+static void ComputeTargets()
+{
+    for (int i = 0; i < s_instCount; i++)
+    {
+        s_pInst[i].bTarget = false;
+    }
+    for (int i = 0; i < s_instCount; i++)
+    {
+        if (!s_pInst[i].bDeleted && s_pInst[i].kind != peep_plain)
+        {
+            int target = ResolveTarget(s_pInst[i].target);
+            if (target < s_instCount)
+            {
+                s_pInst[target].bTarget = true;
+            }
+        }
+    }
+}
+
+static void SetCode(PeepholeInstruction& inst, const unsigned char* pCode, int length)
+{
+    memcpy(inst.code, pCode, length);
+    inst.codeLength = length;
+    DecodeSpinInstruction(inst.code, 0, length, inst.decoded);
+}
+
+static void SetConstant(PeepholeInstruction& inst, int value)
+{
+    unsigned char bytes[5];
+    int length = EncodeConstant(value, bytes);
+    memcpy(inst.code, bytes, length);
+    inst.codeLength = length;
+
+    // the 'not' forms decode as two instructions, so fill in the whole value by hand
+    memset(&inst.decoded, 0, sizeof(SpinInstruction));
+    inst.decoded.opcode = bytes[0];
+    inst.decoded.length = length;
+    inst.decoded.bConstant = true;
+    inst.decoded.constantValue = value;
+}
+
+static bool IsPlain(int index)
+{
+    return index >= 0 && s_pInst[index].kind == peep_plain && s_pInst[index].strIndex < 0;
+}
+
+// plain VAR, local, or DAT variable, not indexed
+static bool IsSimpleVariable(int index, unsigned char varOperation)
+{
+    if (!IsPlain(index))
+    {
+        return false;
+    }
+    SpinInstruction& decoded = s_pInst[index].decoded;
+    return decoded.bVariable && !decoded.bAssignOp && decoded.varOperation == varOperation &&
+           !decoded.bVarIndexed && decoded.varBase != spin_base_mem;
+}
+
+static bool IsSameVariable(int index1, int index2)
+{
+    SpinInstruction& decoded1 = s_pInst[index1].decoded;
+    SpinInstruction& decoded2 = s_pInst[index2].decoded;
+    return decoded1.varBase == decoded2.varBase && decoded1.varSize == decoded2.varSize && decoded1.varAddress == decoded2.varAddress;
+}
+
+static bool IsConstant(int index)
+{
+    return IsPlain(index) && s_pInst[index].decoded.bConstant;
+}
+
+// pushes a value without side effects
+static bool IsSimplePush(int index)
+{
+    return IsConstant(index) || IsSimpleVariable(index, spin_var_push);
+}
+
+static bool IsMathOp(int index, bool bUnary)
+{
+    return IsPlain(index) && s_pInst[index].decoded.bMathOp && IsUnaryMathOp(s_pInst[index].decoded.mathOp) == bUnary;
+}
+
+// turn the variable access in code into a using operation with the given assign operator
+static void SetUsing(PeepholeInstruction& inst, const PeepholeInstruction& variable, unsigned char assignOp)
+{
+    unsigned char code[8];
+    int length = variable.decoded.varBytes;
+    memcpy(code, variable.code, length);
+    code[0] = (code[0] & 0xFC) | spin_var_using;
+    code[length++] = assignOp;
+    SetCode(inst, code, length);
+}
+
+//////////////////////////////////////////
+// patterns
+//
+
+// var := var + 1  ->  ++var  (also - 1 and + -1)
+static bool Peephole_IncDec(int i)
+{
+    int j = NextLive(i);
+    int k = (j >= 0) ? NextLive(j) : -1;
+    int l = (k >= 0) ? NextLive(k) : -1;
+    if (l < 0 || !IsSimpleVariable(i, spin_var_push) || !IsConstant(j) || !IsMathOp(k, false) || !IsSimpleVariable(l, spin_var_pop) ||
+        !IsSameVariable(i, l) || s_pInst[j].bTarget || s_pInst[k].bTarget || s_pInst[l].bTarget)
+    {
+        return false;
+    }
+
+    int value = s_pInst[j].decoded.constantValue;
+    unsigned char mathOp = s_pInst[k].decoded.mathOp;
+    if ((value != 1 && value != -1) || (mathOp != 0x0C && mathOp != 0x0D))
+    {
+        return false;
+    }
+    bool bInc = (mathOp == 0x0C) == (value == 1);
+    unsigned char assignOp = (bInc ? 0x20 : 0x30) | (((s_pInst[i].decoded.varSize + 1) & 3) << 1); // pre-inc/dec
+
+    SetUsing(s_pInst[i], s_pInst[l], assignOp);
+    s_pInst[j].bDeleted = true;
+    s_pInst[k].bDeleted = true;
+    s_pInst[l].bDeleted = true;
+    return true;
+}
+
+// var := var op simple  ->  var op= simple
+static bool Peephole_AssignMath(int i)
+{
+    int j = NextLive(i);
+    int k = (j >= 0) ? NextLive(j) : -1;
+    int l = (k >= 0) ? NextLive(k) : -1;
+    if (l < 0 || !IsSimpleVariable(i, spin_var_push) || !IsSimplePush(j) || !IsMathOp(k, false) || !IsSimpleVariable(l, spin_var_pop) ||
+        !IsSameVariable(i, l) || s_pInst[j].bTarget || s_pInst[k].bTarget || s_pInst[l].bTarget)
+    {
+        return false;
+    }
+
+    unsigned char assignOp = 0x40 | s_pInst[k].decoded.mathOp; // assign math w/swapargs
+    PeepholeInstruction variable = s_pInst[l];
+    memcpy(s_pInst[i].code, s_pInst[j].code, s_pInst[j].codeLength);
+    s_pInst[i].codeLength = s_pInst[j].codeLength;
+    s_pInst[i].decoded = s_pInst[j].decoded;
+    SetUsing(s_pInst[j], variable, assignOp);
+    s_pInst[k].bDeleted = true;
+    s_pInst[l].bDeleted = true;
+    return true;
+}
+
+// constant op constant  ->  constant
+static bool Peephole_FoldBinary(int i)
+{
+    int j = NextLive(i);
+    int k = (j >= 0) ? NextLive(j) : -1;
+    if (k < 0 || !IsConstant(i) || !IsConstant(j) || !IsMathOp(k, false) || s_pInst[j].bTarget || s_pInst[k].bTarget)
+    {
+        return false;
+    }
+
+    int value = 0;
+    if (!EvaluateMathOp(s_pInst[k].decoded.mathOp, s_pInst[i].decoded.constantValue, s_pInst[j].decoded.constantValue, value))
+    {
+        return false;
+    }
+    unsigned char bytes[5];
+    if (EncodeConstant(value, bytes) >= s_pInst[i].codeLength + s_pInst[j].codeLength + s_pInst[k].codeLength)
+    {
+        return false;
+    }
+
+    SetConstant(s_pInst[i], value);
+    s_pInst[j].bDeleted = true;
+    s_pInst[k].bDeleted = true;
+    return true;
+}
+
+// op constant  ->  constant
+static bool Peephole_FoldUnary(int i)
+{
+    int j = NextLive(i);
+    if (j < 0 || !IsConstant(i) || !IsMathOp(j, true) || s_pInst[j].bTarget)
+    {
+        return false;
+    }
+
+    int value = 0;
+    if (!EvaluateMathOp(s_pInst[j].decoded.mathOp, s_pInst[i].decoded.constantValue, 0, value))
+    {
+        return false;
+    }
+    unsigned char bytes[5];
+    if (EncodeConstant(value, bytes) >= s_pInst[i].codeLength + s_pInst[j].codeLength)
+    {
+        return false;
+    }
+
+    SetConstant(s_pInst[i], value);
+    s_pInst[j].bDeleted = true;
+    return true;
+}
+
+// var := ...  var  ->  (var := ...)  for longs that need an address byte
+static bool Peephole_PopPush(int i)
+{
+    int j = NextLive(i);
+    if (j < 0 || !IsSimpleVariable(i, spin_var_pop) || !IsSimpleVariable(j, spin_var_push) || !IsSameVariable(i, j) ||
+        s_pInst[i].decoded.varSize != 2 || s_pInst[i].decoded.varBytes < 2 || s_pInst[j].bTarget)
+    {
+        return false;
+    }
+
+    SetUsing(s_pInst[i], s_pInst[i], 0x80); // assign write w/push
+    s_pInst[j].bDeleted = true;
+    return true;
+}
+
+// jumps to jumps, and jumps to the next instruction
+static bool Peephole_Jumps()
+{
+    bool bChanged = false;
+    for (int i = 0; i < s_instCount; i++)
+    {
+        PeepholeInstruction& inst = s_pInst[i];
+        if (inst.bDeleted || inst.kind != peep_branch)
+        {
+            continue;
+        }
+
+        int target = ResolveTarget(inst.target);
+        for (int hops = 0; hops < peephole_hop_limit && target < s_instCount && target != i; hops++)
+        {
+            PeepholeInstruction& targetInst = s_pInst[target];
+            if (targetInst.kind != peep_branch || targetInst.codeLength != 1 || targetInst.code[0] != 0x04)
+            {
+                break;
+            }
+            target = ResolveTarget(targetInst.target);
+        }
+        if (target != ResolveTarget(inst.target) && target < s_instCount)
+        {
+            inst.target = target;
+            bChanged = true;
+        }
+
+        if (inst.codeLength == 1 && inst.code[0] == 0x04 && ResolveTarget(inst.target) == NextLive(i))
+        {
+            inst.bDeleted = true;
+            bChanged = true;
+        }
+    }
+    return bChanged;
+}
+
+//////////////////////////////////////////
+// decode, optimize, and lay out the method
+//
+
+static int FindAddressConstant(int pos)
+{
+    for (int i = 0; i < s_addressConstantCount; i++)
+    {
+        if (s_addressConstants[i] == pos)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool Peephole_Decode(int start, int end, int* pIndexOf)
+{
+    const unsigned char* pObj = g_pCompilerData->obj;
+    s_instCount = 0;
+    for (int pos = start; pos < end; )
+    {
+        PeepholeInstruction& inst = s_pInst[s_instCount];
+        memset(&inst, 0, sizeof(PeepholeInstruction));
+        inst.strIndex = -1;
+        if (!DecodeSpinInstruction(pObj, pos, end, inst.decoded))
+        {
+            return false;
+        }
+        pIndexOf[pos - start] = s_instCount;
+        inst.newPos = pos; // used as the old position until the layout pass
+
+        if (FindAddressConstant(pos) >= 0)
+        {
+            if (inst.decoded.opcode != 0x38 && inst.decoded.opcode != 0x39)
+            {
+                return false;
+            }
+            inst.kind = peep_address;
+            inst.target = inst.decoded.constantValue;
+            inst.codeLength = 0;
+        }
+        else if (inst.decoded.bBranch)
+        {
+            inst.kind = peep_branch;
+            inst.target = inst.decoded.branchTarget;
+            inst.codeLength = inst.decoded.branchAddressPos - pos;
+            memcpy(inst.code, &pObj[pos], inst.codeLength);
+        }
+        else
+        {
+            inst.kind = peep_plain;
+            inst.codeLength = inst.decoded.length;
+            memcpy(inst.code, &pObj[pos], inst.codeLength);
+        }
+        inst.addressLength = 1;
+
+        pos += inst.decoded.length;
+        s_instCount++;
+    }
+
+    // turn target offsets into instruction indexes
+    for (int i = 0; i < s_instCount; i++)
+    {
+        PeepholeInstruction& inst = s_pInst[i];
+        if (inst.kind != peep_plain)
+        {
+            if (inst.target < start || inst.target >= end || pIndexOf[inst.target - start] < 0)
+            {
+                return false;
+            }
+            inst.target = pIndexOf[inst.target - start];
+        }
+    }
+
+    // find the string address patches
+    for (int strIndex = 0; strIndex < g_pCompilerData->str_count; strIndex++)
+    {
+        int patch = g_pCompilerData->str_patch[strIndex];
+        int i = 0;
+        for (; i < s_instCount; i++)
+        {
+            PeepholeInstruction& inst = s_pInst[i];
+            if (patch >= inst.newPos && patch + 2 <= inst.newPos + inst.codeLength && inst.kind == peep_plain && inst.strIndex < 0)
+            {
+                inst.strIndex = strIndex;
+                inst.strOffset = patch - inst.newPos;
+                break;
+            }
+        }
+        if (i == s_instCount)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static int InstructionSize(const PeepholeInstruction& inst)
+{
+    switch (inst.kind)
+    {
+        case peep_branch:
+            return inst.codeLength + inst.addressLength;
+        case peep_address:
+            return 1 + inst.addressLength;
+    }
+    return inst.codeLength;
+}
+
+// assign new positions, growing addresses until they all fit, returns the new end
+static int Peephole_Layout(int start)
+{
+    int end = start;
+    for (int pass = 0; pass < 32; pass++)
+    {
+        int pos = start;
+        for (int i = 0; i < s_instCount; i++)
+        {
+            if (!s_pInst[i].bDeleted)
+            {
+                s_pInst[i].newPos = pos;
+                pos += InstructionSize(s_pInst[i]);
+            }
+        }
+        end = pos;
+
+        bool bGrew = false;
+        for (int i = 0; i < s_instCount; i++)
+        {
+            PeepholeInstruction& inst = s_pInst[i];
+            if (inst.bDeleted || inst.kind == peep_plain)
+            {
+                continue;
+            }
+            int targetPos = s_pInst[ResolveTarget(inst.target)].newPos;
+            int need = 1;
+            if (inst.kind == peep_branch)
+            {
+                int relative = targetPos - (inst.newPos + inst.codeLength + 1);
+                need = (relative >= -64 && relative < 64) ? 1 : 2;
+            }
+            else if (targetPos >= 0x100)
+            {
+                need = 2;
+            }
+            if (need > inst.addressLength)
+            {
+                inst.addressLength = need;
+                bGrew = true;
+            }
+        }
+        if (!bGrew)
+        {
+            return end;
+        }
+    }
+    return -1;
+}
+
+static void Peephole_Emit(unsigned char* pOut, int start)
+{
+    for (int i = 0; i < s_instCount; i++)
+    {
+        PeepholeInstruction& inst = s_pInst[i];
+        if (inst.bDeleted)
+        {
+            continue;
+        }
+        unsigned char* pCode = &pOut[inst.newPos - start];
+        int targetPos = (inst.kind != peep_plain) ? s_pInst[ResolveTarget(inst.target)].newPos : 0;
+        memcpy(pCode, inst.code, inst.codeLength);
+        pCode += inst.codeLength;
+
+        if (inst.kind == peep_branch)
+        {
+            // same encoding as CompileAddress()
+            int address = targetPos - (inst.newPos + inst.codeLength) - 1;
+            if (inst.addressLength == 1)
+            {
+                pCode[0] = (unsigned char)(address & 0x7F);
+            }
+            else
+            {
+                address--;
+                pCode[0] = (unsigned char)((address >> 8) | 0x80);
+                pCode[1] = (unsigned char)(address & 0xFF);
+            }
+        }
+        else if (inst.kind == peep_address)
+        {
+            // same encoding as BlockStack_CompileConstant()
+            if (inst.addressLength == 1)
+            {
+                pCode[0] = 0x38;
+                pCode[1] = (unsigned char)(targetPos & 0xFF);
+            }
+            else
+            {
+                pCode[0] = 0x39;
+                pCode[1] = (unsigned char)((targetPos >> 8) & 0xFF);
+                pCode[2] = (unsigned char)(targetPos & 0xFF);
+            }
+        }
+    }
+}
+
+// called before StringConstant_PostProcess() on each method
+bool Peephole_Optimize()
+{
+    int start = s_methodStart;
+    int end = g_pCompilerData->obj_ptr;
+    if (!g_pCompilerData->bPeephole || s_bAddressConstantOverflow || end <= start)
+    {
+        return true;
+    }
+
+    int length = end - start;
+    s_pInst = new PeepholeInstruction[length];
+    int* pIndexOf = new int[length];
+    for (int i = 0; i < length; i++)
+    {
+        pIndexOf[i] = -1;
+    }
+
+    // anything that can't be decoded is left alone
+    if (Peephole_Decode(start, end, pIndexOf))
+    {
+        for (int pass = 0; pass < peephole_pass_limit; pass++)
+        {
+            bool bChanged = false;
+            ComputeTargets();
+            for (int i = 0; i < s_instCount; i++)
+            {
+                if (s_pInst[i].bDeleted)
+                {
+                    continue;
+                }
+                if (Peephole_IncDec(i) || Peephole_AssignMath(i) || Peephole_FoldBinary(i) || Peephole_FoldUnary(i) || Peephole_PopPush(i))
+                {
+                    bChanged = true;
+                    ComputeTargets();
+                }
+            }
+            if (Peephole_Jumps())
+            {
+                bChanged = true;
+            }
+            if (!bChanged)
+            {
+                break;
+            }
+        }
+
+        int newEnd = Peephole_Layout(start);
+        if (newEnd > start && newEnd < end && newEnd < 0x10000)
+        {
+            unsigned char* pOut = new unsigned char[newEnd - start];
+            Peephole_Emit(pOut, start);
+            memcpy(&g_pCompilerData->obj[start], pOut, newEnd - start);
+            delete [] pOut;
+
+            for (int i = 0; i < s_instCount; i++)
+            {
+                if (!s_pInst[i].bDeleted && s_pInst[i].strIndex >= 0)
+                {
+                    g_pCompilerData->str_patch[s_pInst[i].strIndex] = s_pInst[i].newPos + s_pInst[i].strOffset;
+                }
+            }
+            g_pCompilerData->obj_ptr = newEnd;
+            g_pCompilerData->peephole_saved += end - newEnd;
+        }
+    }
+
+    delete [] pIndexOf;
+    delete [] s_pInst;
+    s_pInst = 0;
+    s_instCount = 0;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,183 @@
+//////////////////////////////////////////////////////////////
+//                                                          //
+// Propeller Spin/PASM Compiler                             //
+// (c)2012 Parallax Inc. DBA Parallax Semiconductor.        //
+// Adapted from Chip Gracey's x86 asm code by Roy Eltham    //
+// See end of file for terms of use.                        //
+//                                                          //
+//////////////////////////////////////////////////////////////
+//
+// Profiling.cpp
+//
+// optional instrumentation of the PUB/PRI methods (bProfile)
+//
+// every method gets a number, profile_first_method + its sub
+// index, and an entry in the table at profile_table_address
+// (see PropellerCompiler.h for the layout). The prologue counts
+// the call, remembers the method that was running (the caller)
+// and reads CNT, every return/abort adds the CNT delta to the
+// method's entry and to the caller's child cycles, then makes
+// the caller the running method again.
+//
+// the caller in the entry is only set when it isn't the method
+// itself, so a recursive method still shows who called it first.
+//
+// the start CNT and the caller are kept in two hidden locals
+// after the method's own (CompileSubBlocksId_Compile() adds
+// profile_locals to the locals in the index).
+//
+
+#include "Utilities.h"
+#include "PropellerCompilerInternal.h"
+#include "SymbolEngine.h"
+#include "ErrorStrings.h"
+#include "CompileUtilities.h"
+
+static int s_method = 0;        // number of the method being compiled, 0 if it isn't instrumented
+static int s_startLocal = 0;    // offsets of the hidden locals
+static int s_callerLocal = 0;
+
+static bool Profiling_Local(int operation, int address)
+{
+    return CompileVariable((unsigned char)operation, 0, type_loc_byte, 2, address, 0);
+}
+
+// long[address] with the address already pushed
+static bool Profiling_Long(unsigned char operation)
+{
+    return EnterObj(0xC0 | operation);
+}
+
+static bool Profiling_ReadCnt()
+{
+    return CompileVariable(0, 0, type_reg, 2, 0x11, 0); // CNT
+}
+
+static bool Profiling_Address(int method, int field)
+{
+    return CompileConstant(profile_table_address + (method * profile_entry_size) + field);
+}
+
+//////////////////////////////////////////
+// exported functions
+//
+
+bool Profiling_BeginMethod(int subIndex, int localsOffset)
+{
+    s_method = 0;
+    if (!g_pCompilerData->bProfile)
+    {
+        return true;
+    }
+
+    int method = g_pCompilerData->profile_first_method + subIndex;
+    if (method >= profile_method_limit)
+    {
+        g_pCompilerData->error = true;
+        g_pCompilerData->error_msg = g_pErrorStrings[error_tmmtp];
+        return false;
+    }
+    s_method = method;
+    s_startLocal = localsOffset;
+    s_callerLocal = localsOffset + 4;
+
+    // long[entry].calls++
+    if (!Profiling_Address(s_method, profile_entry_calls) ||
+        !Profiling_Long(2) || !EnterObj(0x26)) // using, ++ (long)
+    {
+        return false;
+    }
+
+    // caller := long[table].current
+    if (!CompileConstant(profile_table_address + profile_current) || !Profiling_Long(0) ||
+        !Profiling_Local(1, s_callerLocal))
+    {
+        return false;
+    }
+
+    // if caller <> method, long[entry].caller := caller (a recursive call keeps the caller from outside)
+    if (!Profiling_Local(0, s_callerLocal) || !CompileConstant(s_method) ||
+        !EnterObj(0xE0 | op_cmp_ne) || !EnterObj(0x0A)) // jz
+    {
+        return false;
+    }
+    int jumpOffset = g_pCompilerData->obj_ptr;
+    if (!EnterObj(0) ||
+        !Profiling_Local(0, s_callerLocal) ||
+        !Profiling_Address(s_method, profile_entry_caller) || !Profiling_Long(1))
+    {
+        return false;
+    }
+    g_pCompilerData->obj[jumpOffset] = (unsigned char)(g_pCompilerData->obj_ptr - (jumpOffset + 1)); // forward and under 64 bytes, so one byte
+
+    // long[table].current := method
+    if (!CompileConstant(s_method) ||
+        !CompileConstant(profile_table_address + profile_current) || !Profiling_Long(1))
+    {
+        return false;
+    }
+
+    // start := cnt
+    return Profiling_ReadCnt() && Profiling_Local(1, s_startLocal);
+}
+
+bool Profiling_CompileReturn()
+{
+    if (s_method == 0)
+    {
+        return true;
+    }
+
+    // start := cnt - start
+    if (!Profiling_ReadCnt() || !Profiling_Local(0, s_startLocal) ||
+        !EnterObj(0xED) || !Profiling_Local(1, s_startLocal)) // sub
+    {
+        return false;
+    }
+
+    // long[entry].cycles += start
+    if (!Profiling_Local(0, s_startLocal) ||
+        !Profiling_Address(s_method, profile_entry_cycles) || !Profiling_Long(2) || !EnterObj(0x4C)) // using, +=
+    {
+        return false;
+    }
+
+    // long[table + caller << 4].child += start
+    if (!Profiling_Local(0, s_startLocal) || !Profiling_Local(0, s_callerLocal) ||
+        !CompileConstant(profile_entry_shift) || !EnterObj(0xE3) || // shl
+        !Profiling_Address(0, profile_entry_child) || !EnterObj(0xEC) || // add
+        !Profiling_Long(2) || !EnterObj(0x4C)) // using, +=
+    {
+        return false;
+    }
+
+    // long[table].current := caller
+    return Profiling_Local(0, s_callerLocal) &&
+           CompileConstant(profile_table_address + profile_current) && Profiling_Long(1);
+}
+
+void Profiling_EndMethod()
+{
+    s_method = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
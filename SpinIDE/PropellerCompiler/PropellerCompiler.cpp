@@ -47,6 +47,30 @@ bool CompileDoc();
 extern bool DistillObjects(); // in DistillObjects.cpp
 extern bool CompileTopBlock(); // in InstructionBlockCompiler.cpp
 
+// these are in VariableLayout.cpp
+extern void VarLayout_Reset();
+extern void VarLayout_Enter(const char* pSymbol, int address, int size);
+extern bool VarLayout_Optimize(int symbolType, int base, bool bWholeSource);
+
+// these are in UnusedMethods.cpp
+extern void UnusedMethods_EnterMethod(const char* pName);
+extern void UnusedMethods_BeginMethod(int subIndex);
+extern bool UnusedMethods_IsUnused(const char* pName);
+
+// these are in StackAnalysis.cpp
+extern bool StackAnalysis_Determine(int& stackLongs);
+
+// these are in Profiling.cpp
+extern bool Profiling_BeginMethod(int subIndex, int localsOffset);
+extern void Profiling_EndMethod();
+
+// these are in AsmTiming.cpp
+extern void AsmTiming_Cleanup();
+extern bool AsmTiming_Print();
+
+// these are in Outline.cpp
+extern void Outline_Cleanup();
+
 // globals used by the compiler
 CompilerDataInternal* g_pCompilerData = 0;
 SymbolEngine* g_pSymbolEngine         = 0;
@@ -72,6 +96,8 @@ CompilerData* InitStruct()
 
 void Cleanup()
 {
+    AsmTiming_Cleanup();
+    Outline_Cleanup();
     delete g_pElementizer;
     g_pElementizer = 0;
     delete g_pSymbolEngine;
@@ -107,7 +133,7 @@ void Cleanup()
 //              byte    'CONn', 16, values              ;CON names and values
 //
 
-const char* Compile1()
+static void ResetForCompile1()
 {
     g_pElementizer->Reset();
     g_pSymbolEngine->Reset();
@@ -128,6 +154,11 @@ const char* Compile1()
     }
 
     SetPrint(g_pCompilerData->list, g_pCompilerData->list_limit);
+}
+
+const char* Compile1()
+{
+    ResetForCompile1();
 
     if (!CompileDevBlocks())
     {
@@ -155,6 +186,30 @@ const char* Compile1()
     return 0;
 }
 
+// only what Compile1 needs to fill in obj_filenames and dat_filenames, the CON
+// symbols are resolved for OBJ counts, the rest of the source isn't looked at
+const char* CompileDependencies()
+{
+    ResetForCompile1();
+
+    if (!CompileConBlocks(0))
+    {
+        return g_pCompilerData->error_msg;
+    }
+    if (!CompileObjBlocksId())
+    {
+        return g_pCompilerData->error_msg;
+    }
+    if (!CompileDatBlocksFileNames())
+    {
+        return g_pCompilerData->error_msg;
+    }
+
+    g_pCompilerData->source_start = 0;
+    g_pCompilerData->source_finish = 0;
+    return 0;
+}
+
 const char* Compile2()
 {
     if (!CompileObjSymbols())
@@ -223,6 +278,10 @@ const char* Compile2()
         {
             return g_pCompilerData->error_msg;
         }
+        if (g_pCompilerData->bAsmTiming && !AsmTiming_Print())
+        {
+            return g_pCompilerData->error_msg;
+        }
 
         g_pCompilerData->list_length = g_pCompilerData->print_length;
 
@@ -488,6 +547,14 @@ bool CompileSubBlocksId_Compile(int blockType, bool &bFirst)
                 // save a copy of the symbol
                 g_pElementizer->BackupSymbol();
 
+                if (UnusedMethods_IsUnused(g_pCompilerData->symbolBackup))
+                {
+                    // unreachable, so it gets no symbol or index entry
+                    // (it still counts as the pub that error_nprf checks for)
+                    bFirst = true;
+                    continue;
+                }
+
                 if (g_pCompilerData->obj_ptr < 256*4)
                 {
                     params = 0;
@@ -636,9 +703,15 @@ bool CompileSubBlocksId_Compile(int blockType, bool &bFirst)
                     value <<= 8;
                     value |= (g_pCompilerData->obj_ptr >> 2) & 0xFF;
                     g_pSymbolEngine->AddSymbol(g_pCompilerData->symbolBackup, type_sub, value, blockType);
+                    UnusedMethods_EnterMethod(g_pCompilerData->symbolBackup);
 #ifdef RPE_DEBUG
                     fprintf(StdOut(), "Pub/Pri %s %d (%d, %d)\n", g_pCompilerData->symbolBackup, value, params, g_pCompilerData->obj_ptr);
 #endif
+                    if (g_pCompilerData->bProfile)
+                    {
+                        // room for the hidden locals of the profiling code
+                        locals += profile_locals;
+                    }
                     if (!g_pCompilerData->bDATonly)
                     {
                         // enter locals count into index
@@ -908,7 +981,7 @@ bool CompileObjSymbols()
     int nFile;
     for (nFile = 0; nFile < g_pCompilerData->obj_files; nFile++)
     {
-        unsigned char* pData = &(g_pCompilerData->obj_data[g_pCompilerData->obj_offsets[nFile]]);
+        const unsigned char* pData = g_pCompilerData->obj_binaries[nFile];
 
         // do checksum of obj
         unsigned char uChecksum = 0;
@@ -917,7 +990,7 @@ bool CompileObjSymbols()
             uChecksum += pData[i];
         }
 
-        unsigned char* pDataEnd = pData + g_pCompilerData->obj_lengths[nFile];
+        const unsigned char* pDataEnd = pData + g_pCompilerData->obj_lengths[nFile];
 
         short vsize = pData[0] | ((short)pData[1] << 8);// *((short*)(&pData[0]));
         short psize = pData[2] | ((short)pData[3] << 8);// *((short*)(&pData[2]));
@@ -990,6 +1063,7 @@ bool CompileVarBlocks()
     g_pCompilerData->var_byte = 0;
     g_pCompilerData->var_word = 0;
     g_pCompilerData->var_long = 0;
+    VarLayout_Reset();
 
     bool bEof = false;
     g_pElementizer->Reset();
@@ -1075,6 +1149,11 @@ bool CompileVarBlocks()
                             return false;
                         }
 
+                        if (nSize == 2)
+                        {
+                            VarLayout_Enter(g_pCompilerData->symbolBackup, nValue, nCount << 2);
+                        }
+
                         // add the symbol
                         g_pSymbolEngine->AddSymbol(g_pCompilerData->symbolBackup, (nSize == 0) ? type_var_byte : ((nSize == 1) ? type_var_word : type_var_long), nValue);
 #ifdef RPE_DEBUG
@@ -1114,6 +1193,15 @@ bool CompileVarBlocks()
         }
     }
 
+    if (g_pCompilerData->bOptimizeVarLayout && !g_pCompilerData->bDATonly)
+    {
+        // VAR longs start at address 0
+        if (!VarLayout_Optimize(type_var_long, 0, true))
+        {
+            return false;
+        }
+    }
+
     return true;
 }
 
@@ -1136,6 +1224,13 @@ bool CompileSubBlocks_Compile(int blockType, int &subCount)
                     return false;
                 }
 
+                if (UnusedMethods_IsUnused(g_pElementizer->GetCurrentSymbol()))
+                {
+                    // unreachable, so skip to the next block
+                    continue;
+                }
+                UnusedMethods_BeginMethod(subCount + 1);
+
                 int saved_inf_data2 = g_pCompilerData->source_start;
                 int saved_inf_data3 = g_pCompilerData->source_finish;
 
@@ -1236,6 +1331,7 @@ bool CompileSubBlocks_Compile(int blockType, int &subCount)
                 }
 
                 // check for locals
+                VarLayout_Reset();
                 bool bPipe = false;
                 if(!GetPipeOrEnd(bPipe))
                 {
@@ -1276,6 +1372,7 @@ bool CompileSubBlocks_Compile(int blockType, int &subCount)
                                 }
                             }
 
+                            VarLayout_Enter(g_pCompilerData->symbolBackup, locals, sizeOfThisLocal);
                             g_pSymbolEngine->AddSymbol(g_pCompilerData->symbolBackup, type_loc_long, locals, 0, true); // add to temp symbols
 #ifdef RPE_DEBUG
                             if (sizeOfThisLocal > 4)
@@ -1310,13 +1407,28 @@ bool CompileSubBlocks_Compile(int blockType, int &subCount)
                     }
                 }
 
+                if (g_pCompilerData->bOptimizeVarLayout)
+                {
+                    // the result and parameters stay put, only the locals after them move
+                    if (!VarLayout_Optimize(type_loc_long, 4 + (paramCount * 4), false))
+                    {
+                        return false;
+                    }
+                }
+
                 // enter sub offset into index
                 *((short*)&(g_pCompilerData->obj[4 + (subCount * 4)])) = (short)g_pCompilerData->obj_ptr;
 
+                if (!Profiling_BeginMethod(subCount, locals))
+                {
+                    return false;
+                }
+
                 if (!CompileTopBlock()) // instruction block compiler
                 {
                     return false;
                 }
+                Profiling_EndMethod();
 
                 g_pCompilerData->inf_start = saved_inf_start;
                 g_pCompilerData->inf_finish = g_pElementizer->GetSourcePtr();
@@ -1351,6 +1463,8 @@ bool CompileSubBlocks_Compile(int blockType, int &subCount)
 
 bool CompileSubBlocks()
 {
+    g_pCompilerData->peephole_saved = 0;
+
     int subCount = 0;
     if (!CompileSubBlocks_Compile(block_pub, subCount))
     {
@@ -1409,7 +1523,7 @@ bool CompileObjBlocks()
     {
         objptr[i] = g_pCompilerData->obj_ptr;
 
-        unsigned char* pObj = &(g_pCompilerData->obj_data[g_pCompilerData->obj_offsets[i]]);
+        const unsigned char* pObj = g_pCompilerData->obj_binaries[i];
 
         // get vsize and save in objvar[i]
         //objvar[i] = (int)(*((unsigned short*)(pObj)));
@@ -1421,22 +1535,21 @@ bool CompileObjBlocks()
         unsigned short psize = (unsigned short)pObj[0] | ((unsigned short)pObj[1] << 8);
         pObj += 2;
 
-        for (unsigned short j = 0; j < psize; j++)
+        if (!EnterObjBytes(pObj, psize))
         {
-            if (!EnterObj(pObj[j]))
-            {
-                return false;
-            }
+            return false;
         }
     }
 
     // get start of object index
     unsigned short* pIndex = (unsigned short*)&(g_pCompilerData->obj[g_pCompilerData->obj_start]);
 
+    g_pCompilerData->obj_entry_count = g_pCompilerData->obj_count;
     for (int i = 0; i < g_pCompilerData->obj_count; i++)
     {
         // get file number from index
         int index = *((int*)pIndex);
+        g_pCompilerData->obj_entry_files[i] = (unsigned char)index;
 
         // write objptr back to index
         *pIndex = (unsigned short)(objptr[index]);
@@ -1485,13 +1598,10 @@ bool CompileFinal()
             return false;
         }
 
-        // copy pubcon_list into obj (RPE: this could be optimized)
-        for (int i = 0; i < g_pCompilerData->pubcon_list_size; i++)
+        // copy pubcon_list into obj
+        if (!EnterObjBytes(g_pCompilerData->pubcon_list, g_pCompilerData->pubcon_list_size))
         {
-            if (!EnterObj(g_pCompilerData->pubcon_list[i]))
-            {
-                return false;
-            }
+            return false;
         }
 
         if (!EnterObjLong(0)) // allocate space for vsize/psize long
@@ -1500,7 +1610,8 @@ bool CompileFinal()
         }
 
         // shift contents of obj up 4 bytes (to insert vsize/psize at front)
-        memmove(&(g_pCompilerData->obj[4]), &(g_pCompilerData->obj[0]), g_pCompilerData->obj_limit - 4);
+        // only the bytes before the vsize/psize long just allocated are live
+        memmove(&(g_pCompilerData->obj[4]), &(g_pCompilerData->obj[0]), g_pCompilerData->obj_ptr - 4);
         // insert vsize_psize at beginning on obj
         *((int*)(&g_pCompilerData->obj[0])) = vsize_psize;
         // also store them separately in case they are larger than 65536
@@ -1570,6 +1681,19 @@ bool DetermineStack()
     {
         stackRequired = g_pElementizer->GetValue();
     }
+    if (g_pCompilerData->bStackAnalysis)
+    {
+        // a declared _STACK is still honored if it asks for more
+        int stackLongs = 0;
+        if (!StackAnalysis_Determine(stackLongs))
+        {
+            return false;
+        }
+        if (stackLongs >= 0 && (!bFound || stackLongs > stackRequired))
+        {
+            stackRequired = stackLongs;
+        }
+    }
     if (!Determine_GetSymbol("_FREE", error_ssaf, bFound))
     {
         return false;
@@ -66,7 +66,9 @@ enum infoType
     info_pub,           // data0/1 = obj start/finish, data2/3 = name start/finish
     info_pri,           // data0/1 = obj start/finish, data2/3 = name start/finish
     info_pub_param,     // data0 = pub index, data3 = param index, data2/3 = pub name start/finish
-    info_pri_param      // data0 = pri index, data3 = param index, data2/3 = pri name start/finish
+    info_pri_param,     // data0 = pri index, data3 = param index, data2/3 = pri name start/finish
+    info_pub_stack,     // start/finish = pub name, data0 = sub index, data1 = stack longs (-1 = recursive, -2 = not analyzed, -3 = calls either), data2 = params, data3 = locals, data4 = peak above locals
+    info_pri_stack      // start/finish = pri name, data0 = sub index, data1 = stack longs (-1 = recursive, -2 = not analyzed, -3 = calls either), data2 = params, data3 = locals, data4 = peak above locals
 };
 
 // Propeller Compiler Interface Structure
@@ -97,9 +99,8 @@ struct CompilerData
     char            obj_filenames[file_limit*256];  // Object filenames
     int             obj_name_start[file_limit];     // Starting char of each filename
     int             obj_name_finish[file_limit];    // Ending character (+1) of each filename
-    int             obj_offsets[file_limit];        // Offsets of final objects in ObjData
-    int             obj_lengths[file_limit];        // Lengths of final objects in ObjData
-    unsigned char   obj_data[data_limit];           // Final top-level object binary
+    const unsigned char* obj_binaries[file_limit];  // Final object binaries (owned by the caller's object heap, not copied)
+    int             obj_lengths[file_limit];        // Lengths of final object binaries
     int             obj_instances[file_limit];      // Instances per filename
     char            obj_title[256];                 // Object Filename (without path)
 
@@ -107,9 +108,8 @@ struct CompilerData
     char            dat_filenames[file_limit*256];  // DAT filenames
     int             dat_name_start[file_limit];     // Starting char of each filename
     int             dat_name_finish[file_limit];    // Ending character (+1) of each filename
-    int             dat_offsets[file_limit];        // Offsets of final objects in DatData
-    int             dat_lengths[file_limit];        // Lengths of final objects in DatData
-    unsigned char   dat_data[data_limit];           // Binary data
+    const unsigned char* dat_binaries[file_limit];  // DAT file data (owned by the caller's DAT file cache, not copied)
+    int             dat_lengths[file_limit];        // Lengths of DAT file data
 
     int             pre_files;                      // Number of Precompile files referenced by source
     char            pre_filenames[file_limit*256];  // Precompile filenames
@@ -149,6 +149,22 @@ struct CompilerData
     unsigned int    vsize;                          // used to hold last vsize (in case it is greater than 65536)
     unsigned int    psize;                          // used to hold last psize (in case it is greater than 65536)
 
+    bool            bOptimizeVarLayout;             // reorder VAR longs and locals so the most used get compact bytecodes
+    bool            bPeephole;                      // run the peephole optimizer over each PUB/PRI
+    int             peephole_saved;                 // bytes removed by the peephole optimizer from the last object compiled
+
+    bool            bFoldMethods;                   // share identical PUB/PRI bodies between objects when distilling (only set for the top object)
+    int             folded_longs;                   // Total longs saved by sharing identical PUB/PRI bodies (not included in distilled_longs)
+    bool            bStackAnalysis;                 // work out stack_requirement from the compiled methods (a larger _STACK still wins)
+
+    int             obj_entry_count;                // Number of OBJ entries in the object's index (one per instance)
+    unsigned char   obj_entry_files[256];           // Index into obj_filenames of each OBJ entry, in index order
+
+    bool            bAsmTiming;                     // estimate the cycles of the PASM instructions (listed after the object)
+
+    bool            bProfile;                       // count the calls and clocks of each PUB/PRI in the table at profile_table_address
+    int             profile_first_method;           // number (1 or more) given to the first PUB of the object, the others follow in index order
+
 };
 
 // public functions
@@ -156,8 +172,90 @@ extern CompilerData* InitStruct();
 extern void Cleanup();
 extern const char* Compile1();
 extern const char* Compile2();
+extern const char* CompileDependencies();       // instead of Compile1, when only obj_filenames/dat_filenames are wanted
 extern bool GetErrorInfo(int& lineNumber, int& column, int& offsetToStartOfLine, int& offsetToEndOfLine, int& offendingItemStart, int& offendingItemEnd);
 
+// unused method elimination (in UnusedMethods.cpp)
+//  Call UnusedMethods_Begin
+//  Compile the object tree, calling UnusedMethods_SetObject before each Compile1
+//  Call UnusedMethods_Resolve with the top object filename
+//  Compile the object tree again the same way (unreachable PUBs/PRIs are left out)
+//  Call UnusedMethods_End
+extern void UnusedMethods_Begin();
+extern void UnusedMethods_SetObject(const char* pFilename);
+extern int UnusedMethods_Resolve(const char* pTopFilename);
+extern void UnusedMethods_End();
+
+// method profiling (in Profiling.cpp), when bProfile is set every PUB/PRI updates its entry in
+// a table at the top of hub RAM (the boot loader leaves it zeroed), entry 0 holds the running method
+#define profile_table_size      0x1000
+#define profile_table_address   (0x8000 - profile_table_size)
+#define profile_entry_size      16
+#define profile_entry_shift     4
+#define profile_method_limit    (profile_table_size / profile_entry_size)
+#define profile_locals          8       // hidden locals for the start CNT and the caller
+#define profile_current         0       // in entry 0: number of the running method
+#define profile_entry_calls     0
+#define profile_entry_cycles    4       // clocks from entry to return, including the methods it called
+#define profile_entry_child     8       // clocks spent in the methods it called
+#define profile_entry_caller    12      // number of the method that called it last, other than itself
+
+// PASM cycle estimates (in AsmTiming.cpp), filled in by Compile2 when bAsmTiming is set
+#define asm_timing_waits    -1      // maxCycles of something that includes a WAITxxx
+
+struct AsmTimingInstruction
+{
+    int             objOffset;      // offset of the instruction in the object
+    int             cogAddress;     // long address in the cog
+    unsigned int    instruction;
+    int             lineStart;      // source of the line it is on
+    int             lineFinish;
+    int             labelStart;     // source of the label it is at (both 0 if none)
+    int             labelFinish;
+    int             minCycles;
+    int             maxCycles;      // asm_timing_waits if it waits
+};
+
+struct AsmTimingBlock
+{
+    int             first;          // index of the first instruction
+    int             count;
+    bool            bLoop;          // the last instruction jumps back to the first, cycles are per pass
+    int             minCycles;
+    int             maxCycles;      // asm_timing_waits if it waits
+};
+
+extern int AsmTiming_GetInstructionCount();
+extern const AsmTimingInstruction* AsmTiming_GetInstruction(int index);
+extern int AsmTiming_GetBlockCount();
+extern const AsmTimingBlock* AsmTiming_GetBlock(int index);
+
+// block/method outline (in Outline.cpp), call CompileOutline instead of Compile1/Compile2 (the source
+// is elementized once, nothing is resolved or compiled), the entries are in source order
+enum outlineType
+{
+    outline_block = 0,  // CON/VAR/OBJ/PUB/PRI/DAT/DEV keyword up to the next one, name/detail = PUB/PRI name and signature
+    outline_obj,        // OBJ declaration line, name/detail = object name and filename
+    outline_dat_label   // DAT label, name = the label
+};
+
+struct OutlineEntry
+{
+    int             type;           // outlineType
+    int             blockType;      // block it is in (or starts)
+    int             start;          // source span
+    int             finish;
+    int             line;           // of start (from 1)
+    int             nameStart;      // source span of the name (both 0 if none)
+    int             nameFinish;
+    int             detailStart;    // source span of the rest of the line (both 0 if none)
+    int             detailFinish;
+};
+
+extern const char* CompileOutline();
+extern int Outline_GetEntryCount();
+extern const OutlineEntry* Outline_GetEntry(int index);
+
 #endif // _PROPELLER_COMPILER_H_
 
 ///////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,388 @@
+//////////////////////////////////////////////////////////////
+//                                                          //
+// Propeller Spin/PASM Compiler                             //
+// (c)2012 Parallax Inc. DBA Parallax Semiconductor.        //
+// Adapted from Chip Gracey's x86 asm code by Roy Eltham    //
+// See end of file for terms of use.                        //
+//                                                          //
+//////////////////////////////////////////////////////////////
+//
+// SpinBytecode.cpp
+//
+
+#include <string.h>
+#include "SpinBytecode.h"
+
+// Decode a relative address as compiled by CompileAddress(), returns the offset
+// relative to the end of the address bytes, length gets 1 or 2 (0 if out of range)
+int DecodeSpinAddress(const unsigned char* pCode, int pos, int end, int& length)
+{
+    length = 0;
+    if (pos >= end)
+    {
+        return 0;
+    }
+    int offset = pCode[pos];
+    if (offset & 0x80)
+    {
+        if (pos + 1 >= end)
+        {
+            return 0;
+        }
+        offset = ((offset & 0x7F) << 8) | pCode[pos + 1];
+        if (offset & 0x4000)
+        {
+            offset -= 0x8000;
+        }
+        length = 2;
+    }
+    else
+    {
+        if (offset & 0x40)
+        {
+            offset -= 0x80;
+        }
+        length = 1;
+    }
+    return offset;
+}
+
+// decode the assign operator following a using operation at pos
+static bool DecodeAssignOp(const unsigned char* pCode, int start, int pos, int end, SpinInstruction& instruction)
+{
+    if (pos >= end)
+    {
+        return false;
+    }
+    instruction.bAssignOp = true;
+    instruction.assignOp = pCode[pos++];
+    instruction.length = pos - start;
+
+    // repeat-var and repeat-var w/step are followed by a reverse address
+    if (instruction.assignOp == 0x02 || instruction.assignOp == 0x06)
+    {
+        int length = 0;
+        int offset = DecodeSpinAddress(pCode, pos, end, length);
+        if (length == 0)
+        {
+            return false;
+        }
+        instruction.bBranch = true;
+        instruction.branchAddressPos = pos;
+        instruction.branchTarget = pos + length + offset;
+        instruction.length = (pos + length) - start;
+    }
+    return true;
+}
+
+// Decode the instruction at pos, returns false if it is not valid or runs past end
+bool DecodeSpinInstruction(const unsigned char* pCode, int pos, int end, SpinInstruction& instruction)
+{
+    memset(&instruction, 0, sizeof(SpinInstruction));
+    if (pos >= end)
+    {
+        return false;
+    }
+
+    unsigned char opcode = pCode[pos];
+    instruction.opcode = opcode;
+    instruction.length = 1;
+
+    if (opcode >= 0xE0)
+    {
+        instruction.bMathOp = true;
+        instruction.mathOp = opcode & 0x1F;
+        return true;
+    }
+
+    if (opcode >= 0x40)
+    {
+        int p = pos + 1;
+        instruction.bVariable = true;
+        instruction.varOperation = opcode & 0x03;
+        if (opcode < 0x80)
+        {
+            // compact long VAR or local
+            instruction.varBase = (opcode & 0x20) ? spin_base_loc : spin_base_var;
+            instruction.varSize = 2;
+            instruction.varAddress = opcode & 0x1C;
+        }
+        else
+        {
+            instruction.varSize = (opcode >> 5) & 0x03;
+            instruction.bVarIndexed = (opcode & 0x10) != 0;
+            instruction.varBase = (opcode >> 2) & 0x03;
+            if (instruction.varBase != spin_base_mem)
+            {
+                if (p >= end)
+                {
+                    return false;
+                }
+                instruction.varAddress = pCode[p++];
+                if (instruction.varAddress & 0x80)
+                {
+                    if (p >= end)
+                    {
+                        return false;
+                    }
+                    instruction.varAddress = ((instruction.varAddress & 0x7F) << 8) | pCode[p++];
+                }
+            }
+        }
+        instruction.varBytes = p - pos;
+        instruction.length = p - pos;
+        if (instruction.varOperation == spin_var_using)
+        {
+            return DecodeAssignOp(pCode, pos, p, end, instruction);
+        }
+        return (p <= end);
+    }
+
+    switch (opcode)
+    {
+        case 0x04: // jmp
+        case 0x08: // tjz
+        case 0x09: // djnz
+        case 0x0A: // jz
+        case 0x0B: // jnz
+        case 0x0D: // case value
+        case 0x0E: // case range
+            {
+                int length = 0;
+                int offset = DecodeSpinAddress(pCode, pos + 1, end, length);
+                if (length == 0)
+                {
+                    return false;
+                }
+                instruction.bBranch = true;
+                instruction.branchAddressPos = pos + 1;
+                instruction.branchTarget = pos + 1 + length + offset;
+                instruction.length = 1 + length;
+            }
+            return true;
+
+        case 0x05: // call sub
+            instruction.length = 2;
+            break;
+
+        case 0x06: // call obj.sub
+        case 0x07: // call obj[].sub
+            instruction.length = 3;
+            break;
+
+        case 0x26: // using spr
+            return DecodeAssignOp(pCode, pos, pos + 1, end, instruction);
+
+        case 0x34: // constant -1, 0, 1
+        case 0x35:
+        case 0x36:
+            instruction.bConstant = true;
+            instruction.constantValue = (int)opcode - 0x35;
+            break;
+
+        case 0x37: // constant mask
+            if (pos + 1 >= end)
+            {
+                return false;
+            }
+            {
+                unsigned char mask = pCode[pos + 1];
+                int value = 2;
+                value <<= (mask & 0x1F);
+                if (mask & 0x20)
+                {
+                    value--;
+                }
+                if (mask & 0x40)
+                {
+                    value = ~value;
+                }
+                instruction.bConstant = true;
+                instruction.constantValue = value;
+                instruction.length = 2;
+            }
+            break;
+
+        case 0x38: // constant 1..4 bytes
+        case 0x39:
+        case 0x3A:
+        case 0x3B:
+            {
+                int size = opcode - 0x37;
+                if (pos + size >= end)
+                {
+                    return false;
+                }
+                int value = 0;
+                for (int i = 1; i <= size; i++)
+                {
+                    value = (value << 8) | pCode[pos + i];
+                }
+                instruction.bConstant = true;
+                instruction.constantValue = value;
+                instruction.length = 1 + size;
+            }
+            break;
+
+        case 0x3C: // not used
+            return false;
+
+        case 0x3D: // register[bit]
+        case 0x3E: // register[bit..bit]
+        case 0x3F: // register
+            if (pos + 1 >= end || (pCode[pos + 1] & 0x80) == 0)
+            {
+                return false;
+            }
+            instruction.length = 2;
+            if (((pCode[pos + 1] >> 5) & 0x03) == spin_var_using)
+            {
+                return DecodeAssignOp(pCode, pos, pos + 2, end, instruction);
+            }
+            break;
+
+        default:
+            // all the rest are single byte
+            break;
+    }
+
+    return (pos + instruction.length <= end);
+}
+
+bool IsUnaryMathOp(unsigned char mathOp)
+{
+    switch (mathOp & 0x1F)
+    {
+        case 0x06: // -
+        case 0x07: // !
+        case 0x09: // ||
+        case 0x11: // >|
+        case 0x13: // |<
+        case 0x18: // ^^
+        case 0x1F: // NOT
+            return true;
+    }
+    return false;
+}
+
+// Evaluate a math operator the way the interpreter does at run time (value2 is ignored for unary operators)
+// returns false for the operators that are not handled here (><, **, /, //, ^^)
+bool EvaluateMathOp(unsigned char mathOp, int value1, int value2, int& result)
+{
+    unsigned int uValue1 = (unsigned int)value1;
+    int shift = value2 & 0x1F;
+
+    switch (mathOp & 0x1F)
+    {
+        case 0x00: // ->
+            result = (int)((uValue1 >> shift) | (shift ? (uValue1 << (32 - shift)) : 0));
+            break;
+        case 0x01: // <-
+            result = (int)((uValue1 << shift) | (shift ? (uValue1 >> (32 - shift)) : 0));
+            break;
+        case 0x02: // >>
+            result = (int)(uValue1 >> shift);
+            break;
+        case 0x03: // <<
+            result = (int)(uValue1 << shift);
+            break;
+        case 0x04: // #>
+            result = (value1 < value2) ? value2 : value1;
+            break;
+        case 0x05: // <#
+            result = (value1 > value2) ? value2 : value1;
+            break;
+        case 0x06: // -
+            result = (int)(0 - uValue1);
+            break;
+        case 0x07: // !
+            result = ~value1;
+            break;
+        case 0x08: // &
+            result = value1 & value2;
+            break;
+        case 0x09: // ||
+            result = (value1 < 0) ? (int)(0 - uValue1) : value1;
+            break;
+        case 0x0A: // |
+            result = value1 | value2;
+            break;
+        case 0x0B: // ^
+            result = value1 ^ value2;
+            break;
+        case 0x0C: // +
+            result = (int)(uValue1 + (unsigned int)value2);
+            break;
+        case 0x0D: // -
+            result = (int)(uValue1 - (unsigned int)value2);
+            break;
+        case 0x0E: // ~>
+            result = (value1 < 0) ? ~(int)(~uValue1 >> shift) : (int)(uValue1 >> shift);
+            break;
+        case 0x10: // AND
+            result = (value1 != 0 && value2 != 0) ? -1 : 0;
+            break;
+        case 0x11: // >|
+            result = 0;
+            while (uValue1 != 0)
+            {
+                result++;
+                uValue1 >>= 1;
+            }
+            break;
+        case 0x12: // OR
+            result = (value1 != 0 || value2 != 0) ? -1 : 0;
+            break;
+        case 0x13: // |<
+            result = (int)(1u << (value1 & 0x1F));
+            break;
+        case 0x14: // *
+            result = (int)(uValue1 * (unsigned int)value2);
+            break;
+        case 0x19: // <
+            result = (value1 < value2) ? -1 : 0;
+            break;
+        case 0x1A: // >
+            result = (value1 > value2) ? -1 : 0;
+            break;
+        case 0x1B: // <>
+            result = (value1 != value2) ? -1 : 0;
+            break;
+        case 0x1C: // ==
+            result = (value1 == value2) ? -1 : 0;
+            break;
+        case 0x1D: // =<
+            result = (value1 <= value2) ? -1 : 0;
+            break;
+        case 0x1E: // =>
+            result = (value1 >= value2) ? -1 : 0;
+            break;
+        case 0x1F: // NOT
+            result = (value1 == 0) ? -1 : 0;
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,90 @@
+//////////////////////////////////////////////////////////////
+//                                                          //
+// Propeller Spin/PASM Compiler                             //
+// (c)2012 Parallax Inc. DBA Parallax Semiconductor.        //
+// Adapted from Chip Gracey's x86 asm code by Roy Eltham    //
+// See end of file for terms of use.                        //
+//                                                          //
+//////////////////////////////////////////////////////////////
+//
+// SpinBytecode.h
+//
+// decoding of compiled Spin bytecode, used by passes that
+// work on the bytecode after it has been compiled
+//
+
+#ifndef _SPINBYTECODE_H_
+#define _SPINBYTECODE_H_
+
+// variable spaces used by SpinInstruction::varBase
+enum spinVarBase
+{
+    spin_base_mem = 0,      // address is on the stack
+    spin_base_obj,          // pbase relative (DAT)
+    spin_base_var,          // vbase relative (VAR)
+    spin_base_loc           // dbase relative (locals)
+};
+
+// variable operations used by SpinInstruction::varOperation
+enum spinVarOperation
+{
+    spin_var_push = 0,
+    spin_var_pop,
+    spin_var_using,         // followed by an assign operator
+    spin_var_reference      // push address
+};
+
+struct SpinInstruction
+{
+    int             length;             // total length in bytes
+    unsigned char   opcode;             // first byte
+
+    bool            bBranch;            // has a relative address (jmp, jz, jnz, tjz, djnz, case, repeat-var)
+    int             branchTarget;       // absolute offset of the branch target
+    int             branchAddressPos;   // offset of the relative address bytes (always at the end of the instruction)
+
+    bool            bConstant;          // pushes a constant (0x34-0x3B)
+    int             constantValue;
+
+    bool            bMathOp;            // 0xE0-0xFF
+    unsigned char   mathOp;             // low 5 bits
+
+    bool            bVariable;          // compact or memory variable access (0x40-0xDF)
+    unsigned char   varOperation;       // spinVarOperation
+    unsigned char   varBase;            // spinVarBase
+    unsigned char   varSize;            // 0 = byte, 1 = word, 2 = long
+    bool            bVarIndexed;
+    int             varAddress;
+    int             varBytes;           // number of bytes making up the variable access (without assign operator)
+
+    bool            bAssignOp;          // a using operation (variable, spr or register) was followed by an assign operator
+    unsigned char   assignOp;
+};
+
+extern bool DecodeSpinInstruction(const unsigned char* pCode, int pos, int end, SpinInstruction& instruction);
+extern int DecodeSpinAddress(const unsigned char* pCode, int pos, int end, int& length);
+extern bool IsUnaryMathOp(unsigned char mathOp);
+extern bool EvaluateMathOp(unsigned char mathOp, int value1, int value2, int& result);
+
+#endif // _SPINBYTECODE_H_
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
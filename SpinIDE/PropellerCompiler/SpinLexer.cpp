@@ -0,0 +1,588 @@
+//////////////////////////////////////////////////////////////
+//                                                          //
+// Propeller Spin/PASM Compiler                             //
+// (c)2012 Parallax Inc. DBA Parallax Semiconductor.        //
+// Adapted from Chip Gracey's x86 asm code by Roy Eltham    //
+// See end of file for terms of use.                        //
+//                                                          //
+//////////////////////////////////////////////////////////////
+//
+// SpinLexer.cpp
+//
+// the rules follow Elementizer::GetNext(), using the same character
+// checks and the SymbolEngine's predefined symbols, but the text is
+// taken as it is in the editor (CR, LF, or CR LF ends a line) and
+// lexing never stops at an error, the element gets spin_token_error
+//
+// an edit relexes the lines it touches, then carries on down the
+// lines after it only while the state at the start of the next line
+// comes out different from what it was before the edit (a { opened
+// or closed, or a block started or removed)
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include "Utilities.h"
+#include "PropellerCompiler.h"
+#include "SymbolEngine.h"
+#include "SpinLexer.h"
+
+#define lex_text_initial            4096        // these grow as needed
+#define lex_lines_initial           256
+#define lex_tokens_initial          8
+
+static void FreeLine(SpinLexLine& line)
+{
+    delete [] line.pTokens;
+    line.pTokens = 0;
+    line.tokenCount = 0;
+    line.tokenSize = 0;
+}
+
+SpinLexer::SpinLexer()
+    : m_length(0)
+    , m_lineCount(0)
+    , m_changedFirst(0)
+    , m_changedCount(0)
+{
+    m_pSymbolEngine = new SymbolEngine;
+    m_textSize = lex_text_initial;
+    m_pText = new char[m_textSize + 1];
+    m_pText[0] = 0;
+    m_lineSize = lex_lines_initial;
+    m_pLines = new SpinLexLine[m_lineSize];
+    SetText("", 0);
+}
+
+SpinLexer::~SpinLexer()
+{
+    for (int i = 0; i < m_lineCount; i++)
+    {
+        FreeLine(m_pLines[i]);
+    }
+    delete [] m_pLines;
+    delete [] m_pText;
+    delete m_pSymbolEngine;
+}
+
+void SpinLexer::SetText(const char* pText, int length)
+{
+    // start again from an empty text (in a CON block, same as the compiler) and insert it all
+    for (int i = 0; i < m_lineCount; i++)
+    {
+        FreeLine(m_pLines[i]);
+    }
+    memset(&m_pLines[0], 0, sizeof(SpinLexLine));
+    m_pLines[0].state = block_con << spin_lex_block_shift;
+    m_lineCount = 1;
+    m_length = 0;
+    m_pText[0] = 0;
+    Edit(0, 0, pText, length);
+}
+
+bool SpinLexer::Edit(int offset, int removedLength, const char* pInserted, int insertedLength)
+{
+    if (offset < 0 || removedLength < 0 || insertedLength < 0 || offset + removedLength > m_length)
+    {
+        return false;
+    }
+
+    // a CR at the end of the line before can join up with an LF at the start of the edit
+    int firstLine = FindLine((offset > 0) ? offset - 1 : 0);
+
+    int lengthChange = insertedLength - removedLength;
+    if (m_length + lengthChange > m_textSize)
+    {
+        while (m_length + lengthChange > m_textSize)
+        {
+            m_textSize *= 2;
+        }
+        char* pText = new char[m_textSize + 1];
+        memcpy(pText, m_pText, m_length);
+        delete [] m_pText;
+        m_pText = pText;
+    }
+    memmove(&m_pText[offset + insertedLength], &m_pText[offset + removedLength], m_length - (offset + removedLength));
+    memcpy(&m_pText[offset], pInserted, insertedLength);
+    m_length += lengthChange;
+    m_pText[m_length] = 0;
+
+    Relex(firstLine, offset + insertedLength, offset + removedLength, lengthChange);
+    return true;
+}
+
+void SpinLexer::Update(const char* pText, int length)
+{
+    int limit = (length < m_length) ? length : m_length;
+    int prefix = 0;
+    while (prefix < limit && pText[prefix] == m_pText[prefix])
+    {
+        prefix++;
+    }
+    int suffix = 0;
+    while (suffix < limit - prefix && pText[length - 1 - suffix] == m_pText[m_length - 1 - suffix])
+    {
+        suffix++;
+    }
+    if (prefix == length && prefix == m_length)
+    {
+        // nothing changed
+        m_changedFirst = 0;
+        m_changedCount = 0;
+        return;
+    }
+    Edit(prefix, m_length - prefix - suffix, &pText[prefix], length - prefix - suffix);
+}
+
+const SpinLexLine* SpinLexer::GetLine(int line)
+{
+    return (line >= 0 && line < m_lineCount) ? &m_pLines[line] : 0;
+}
+
+int SpinLexer::GetLineBlock(int line)
+{
+    if (line < 0 || line >= m_lineCount)
+    {
+        return block_con;
+    }
+    const SpinLexLine& lexLine = m_pLines[line];
+    if (lexLine.tokenCount > 0 && lexLine.pTokens[0].kind == spin_token_block)
+    {
+        return lexLine.pTokens[0].type;
+    }
+    return (lexLine.state & spin_lex_block_mask) >> spin_lex_block_shift;
+}
+
+int SpinLexer::FindLine(int offset)
+{
+    int low = 0;
+    int high = m_lineCount - 1;
+    while (low < high)
+    {
+        int middle = (low + high + 1) / 2;
+        if (m_pLines[middle].start <= offset)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle - 1;
+        }
+    }
+    return low;
+}
+
+//////////////////////////////////////////
+// private
+//
+
+void SpinLexer::Relex(int firstLine, int newFinish, int oldFinish, int lengthChange)
+{
+    // the lines starting after the old end of the edit have the same text, they just move
+    int keep = FindLine(oldFinish) + 1;
+
+    // lex from the first line until a line starts after the new end of the edit
+    int newSize = lex_lines_initial;
+    SpinLexLine* pNew = new SpinLexLine[newSize];
+    int newCount = 0;
+    unsigned int state = m_pLines[firstLine].state;
+    int start = m_pLines[firstLine].start;
+    while (start >= 0)
+    {
+        if (newCount == newSize)
+        {
+            SpinLexLine* pGrown = new SpinLexLine[newSize * 2];
+            memcpy(pGrown, pNew, newSize * sizeof(SpinLexLine));
+            delete [] pNew;
+            pNew = pGrown;
+            newSize *= 2;
+        }
+        SpinLexLine& line = pNew[newCount++];
+        memset(&line, 0, sizeof(SpinLexLine));
+        start = LexLine(start, state, line);
+        if (start > newFinish)
+        {
+            break;
+        }
+    }
+    if (start < 0)
+    {
+        // got to the end of the text, so there is nothing to keep
+        keep = m_lineCount;
+    }
+
+    // swap the new lines in for the old ones
+    for (int i = firstLine; i < keep; i++)
+    {
+        FreeLine(m_pLines[i]);
+    }
+    int lineCount = firstLine + newCount + (m_lineCount - keep);
+    if (lineCount > m_lineSize)
+    {
+        while (lineCount > m_lineSize)
+        {
+            m_lineSize *= 2;
+        }
+        SpinLexLine* pLines = new SpinLexLine[m_lineSize];
+        memcpy(pLines, m_pLines, firstLine * sizeof(SpinLexLine));
+        memcpy(&pLines[firstLine + newCount], &m_pLines[keep], (m_lineCount - keep) * sizeof(SpinLexLine));
+        delete [] m_pLines;
+        m_pLines = pLines;
+    }
+    else
+    {
+        memmove(&m_pLines[firstLine + newCount], &m_pLines[keep], (m_lineCount - keep) * sizeof(SpinLexLine));
+    }
+    memcpy(&m_pLines[firstLine], pNew, newCount * sizeof(SpinLexLine));
+    delete [] pNew;
+    m_lineCount = lineCount;
+
+    int next = firstLine + newCount;
+    for (int i = next; i < m_lineCount; i++)
+    {
+        m_pLines[i].start += lengthChange;
+    }
+
+    // carry on while the state at the start of a line is different
+    while (next < m_lineCount && m_pLines[next].state != state)
+    {
+        SpinLexLine& line = m_pLines[next++];
+        line.tokenCount = 0;
+        LexLine(line.start, state, line);
+    }
+
+    m_changedFirst = firstLine;
+    m_changedCount = next - firstLine;
+}
+
+bool SpinLexer::IsLineEnd(int offset)
+{
+    return offset < m_length && (m_pText[offset] == 13 || m_pText[offset] == 10);
+}
+
+// returns where the next line starts
+int SpinLexer::SkipLineEnd(int offset)
+{
+    if (m_pText[offset] == 13 && offset + 1 < m_length && m_pText[offset + 1] == 10)
+    {
+        return offset + 2;
+    }
+    return offset + 1;
+}
+
+void SpinLexer::AddToken(SpinLexLine& line, int start, int finish, int kind, int type)
+{
+    if (line.tokenCount == line.tokenSize)
+    {
+        int tokenSize = (line.tokenSize > 0) ? line.tokenSize * 2 : lex_tokens_initial;
+        SpinToken* pTokens = new SpinToken[tokenSize];
+        if (line.tokenCount > 0)
+        {
+            memcpy(pTokens, line.pTokens, line.tokenCount * sizeof(SpinToken));
+        }
+        delete [] line.pTokens;
+        line.pTokens = pTokens;
+        line.tokenSize = tokenSize;
+    }
+    SpinToken& token = line.pTokens[line.tokenCount++];
+    token.start = start - line.start;
+    token.length = finish - start;
+    token.kind = (unsigned char)kind;
+    token.type = (unsigned char)type;
+}
+
+// lexes the line at start, state goes in as the state at the start of the line and comes back as
+// the state at the start of the next one, returns where the next line starts (-1 if this is the last)
+int SpinLexer::LexLine(int start, unsigned int& state, SpinLexLine& line)
+{
+    line.start = start;
+    line.state = state;
+
+    int offset = start;
+    if (state & spin_lex_depth_mask)
+    {
+        // still in a { } comment
+        offset = LexComment(offset, offset, state, line);
+    }
+
+    while (offset < m_length && !IsLineEnd(offset))
+    {
+        int tokenStart = offset;
+        char currentChar = m_pText[offset++];
+
+        if (currentChar <= ' ')
+        {
+            // space or tab (or anything else the Elementizer skips)
+            continue;
+        }
+        else if (currentChar == '\'')
+        {
+            bool bDocComment = (m_pText[offset] == '\'');
+            while (offset < m_length && !IsLineEnd(offset))
+            {
+                offset++;
+            }
+            AddToken(line, tokenStart, offset, bDocComment ? spin_token_doc_comment : spin_token_comment);
+        }
+        else if (currentChar == '{')
+        {
+            state &= ~(spin_lex_depth_mask | spin_lex_doc_comment);
+            state |= 1;
+            if (m_pText[offset] == '{')
+            {
+                offset++;
+                state |= spin_lex_doc_comment;
+            }
+            offset = LexComment(tokenStart, offset, state, line);
+        }
+        else if (currentChar == '}')
+        {
+            // unmatched brace comment end
+            AddToken(line, tokenStart, offset, spin_token_error);
+        }
+        else if (currentChar == '\"')
+        {
+            // no empty strings, and it has to end on this line
+            bool bError = (m_pText[offset] == '\"');
+            while (offset < m_length && !IsLineEnd(offset) && m_pText[offset] != '\"')
+            {
+                offset++;
+            }
+            if (offset < m_length && m_pText[offset] == '\"')
+            {
+                offset++;
+            }
+            else
+            {
+                bError = true;
+            }
+            AddToken(line, tokenStart, offset, bError ? spin_token_error : spin_token_string);
+        }
+        else if (currentChar == '%')
+        {
+            // binary, or %% double binary
+            int base = 2;
+            if (m_pText[offset] == '%')
+            {
+                offset++;
+                base = 4;
+            }
+            char digitValue;
+            bool bError = !CheckDigit(m_pText[offset], digitValue, (char)base);
+            if (!bError)
+            {
+                offset = LexNumber(offset, base, bError);
+            }
+            AddToken(line, tokenStart, offset, bError ? spin_token_error : spin_token_number);
+        }
+        else if (currentChar == '$')
+        {
+            // hex, or the PASM $ on its own
+            char digitValue;
+            if (CheckDigit(m_pText[offset], digitValue, 16))
+            {
+                bool bError = false;
+                offset = LexNumber(offset, 16, bError);
+                AddToken(line, tokenStart, offset, bError ? spin_token_error : spin_token_number);
+            }
+            else
+            {
+                AddToken(line, tokenStart, offset, spin_token_operator, type_asm_org);
+            }
+        }
+        else if (currentChar >= '0' && currentChar <= '9')
+        {
+            bool bError = false;
+            offset = LexNumber(tokenStart, 10, bError);
+            AddToken(line, tokenStart, offset, bError ? spin_token_error : spin_token_number);
+        }
+        else if (CheckWordChar(Uppercase(currentChar)))
+        {
+            char symbol[symbol_limit + 2];
+            int symbolLength = 0;
+            offset = tokenStart;
+            while (offset < m_length && CheckWordChar(Uppercase(m_pText[offset])))
+            {
+                if (symbolLength <= symbol_limit)
+                {
+                    symbol[symbolLength++] = Uppercase(m_pText[offset]);
+                }
+                offset++;
+            }
+            if (symbolLength > symbol_limit)
+            {
+                AddToken(line, tokenStart, offset, spin_token_error);
+                continue;
+            }
+            symbol[symbolLength] = 0;
+
+            SymbolTableEntry* pSymbol = m_pSymbolEngine->FindSymbol(symbol);
+            if (pSymbol == 0)
+            {
+                AddToken(line, tokenStart, offset, spin_token_name);
+            }
+            else if (pSymbol->m_data.type != type_block)
+            {
+                AddToken(line, tokenStart, offset, spin_token_reserved, pSymbol->m_data.type);
+            }
+            else if (tokenStart == start)
+            {
+                // blocks have to start in the first column
+                AddToken(line, tokenStart, offset, spin_token_block, pSymbol->m_data.value);
+                state = (state & ~spin_lex_block_mask) | (pSymbol->m_data.value << spin_lex_block_shift);
+            }
+            else
+            {
+                AddToken(line, tokenStart, offset, spin_token_error);
+            }
+        }
+        else
+        {
+            unsigned char type = 0;
+            offset = LexOperator(tokenStart, type);
+            AddToken(line, tokenStart, offset, (type != 0) ? spin_token_operator : spin_token_error, type);
+        }
+    }
+
+    if (offset >= m_length)
+    {
+        return -1;
+    }
+    return SkipLineEnd(offset);
+}
+
+// lexes the rest of a { } comment up to where it ends, or to the end of the line
+int SpinLexer::LexComment(int tokenStart, int offset, unsigned int& state, SpinLexLine& line)
+{
+    bool bDocComment = (state & spin_lex_doc_comment) != 0;
+    int level = state & spin_lex_depth_mask;
+    while (level > 0 && offset < m_length && !IsLineEnd(offset))
+    {
+        char currentChar = m_pText[offset++];
+        if (bDocComment)
+        {
+            // {{ }} comments don't nest, a single } is just text
+            if (currentChar == '}' && m_pText[offset] == '}')
+            {
+                offset++;
+                level = 0;
+            }
+        }
+        else if (currentChar == '{')
+        {
+            if (level < spin_lex_depth_mask)
+            {
+                level++;
+            }
+        }
+        else if (currentChar == '}')
+        {
+            level--;
+        }
+    }
+    if (offset > tokenStart)
+    {
+        AddToken(line, tokenStart, offset, bDocComment ? spin_token_doc_comment : spin_token_comment);
+    }
+    state &= ~(spin_lex_depth_mask | spin_lex_doc_comment);
+    if (level > 0)
+    {
+        state |= level | (bDocComment ? spin_lex_doc_comment : 0);
+    }
+    return offset;
+}
+
+// returns the end of the constant at offset (a float if it turns out to be one)
+int SpinLexer::LexNumber(int offset, int base, bool& bError)
+{
+    int numberStart = offset;
+    char digitValue;
+    while (m_pText[offset] == '_' || CheckDigit(m_pText[offset], digitValue, (char)base))
+    {
+        offset++;
+    }
+
+    char currentChar = m_pText[offset];
+    bool bDot = (base == 10 && currentChar == '.' && CheckDigit(m_pText[offset + 1], digitValue, 10));
+    if (bDot || currentChar == 'e' || currentChar == 'E')
+    {
+        // float, read as GetFloat() does
+        if (base != 10)
+        {
+            bError = true;
+        }
+        bool bGotDot = false;
+        bool bGotE = false;
+        bool bGotSign = false;
+        offset = numberStart;
+        while (offset < m_length)
+        {
+            currentChar = m_pText[offset];
+            if (currentChar == '_' || (currentChar >= '0' && currentChar <= '9'))
+            {
+            }
+            else if (!bGotDot && currentChar == '.')
+            {
+                bGotDot = true;
+            }
+            else if (!bGotE && (currentChar == 'e' || currentChar == 'E'))
+            {
+                bGotE = true;
+            }
+            else if (bGotE && !bGotSign && (currentChar == '+' || currentChar == '-'))
+            {
+                bGotSign = true;
+            }
+            else
+            {
+                break;
+            }
+            offset++;
+        }
+    }
+    return offset;
+}
+
+// finds the longest operator (up to 3 characters) at offset, type is 0 if there isn't one
+int SpinLexer::LexOperator(int offset, unsigned char& type)
+{
+    char symbol[4];
+    symbol[0] = m_pText[offset];
+    symbol[1] = m_pText[offset + 1];
+    symbol[2] = (symbol[1] > ' ') ? m_pText[offset + 2] : 0;
+    symbol[3] = 0;
+
+    for (int length = (symbol[1] > ' ') ? 3 : 1; length > 0; length--)
+    {
+        symbol[length] = 0;
+        SymbolTableEntry* pSymbol = m_pSymbolEngine->FindSymbol(symbol);
+        if (pSymbol != 0)
+        {
+            type = (unsigned char)pSymbol->m_data.type;
+            return offset + length;
+        }
+    }
+    type = 0;
+    return offset + 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,129 @@
+//////////////////////////////////////////////////////////////
+//                                                          //
+// Propeller Spin/PASM Compiler                             //
+// (c)2012 Parallax Inc. DBA Parallax Semiconductor.        //
+// Adapted from Chip Gracey's x86 asm code by Roy Eltham    //
+// See end of file for terms of use.                        //
+//                                                          //
+//////////////////////////////////////////////////////////////
+//
+// SpinLexer.h
+//
+// restartable tokenizer for editors, splits source into the same
+// elements the Elementizer does (comments, strings, constants,
+// symbols, operators) a line at a time
+//
+
+#ifndef _SPIN_LEXER_H_
+#define _SPIN_LEXER_H_
+
+class SymbolEngine;
+
+enum spinTokenKind
+{
+    spin_token_comment = 0,         // ' and { } comments
+    spin_token_doc_comment,         // '' and {{ }} comments
+    spin_token_string,
+    spin_token_number,              // decimal, float, $hex, %binary, %%quaternary
+    spin_token_name,                // a symbol the compiler doesn't predefine
+    spin_token_reserved,            // a predefined word symbol (type is its symbolType)
+    spin_token_block,               // CON, VAR, DAT, OBJ, PUB, PRI, DEV at the start of a line
+    spin_token_operator,            // a predefined non-word symbol, or $ on its own
+    spin_token_error                // something the Elementizer would stop at
+};
+
+struct SpinToken
+{
+    int             start;          // from the start of the line
+    int             length;
+    unsigned char   kind;           // spinTokenKind
+    unsigned char   type;           // symbolType of spin_token_reserved/spin_token_operator, blockType of spin_token_block
+};
+
+// the state at the start of a line, this is everything carried over from the lines before it
+// (a string can't go past the end of its line, so there is no string state)
+#define spin_lex_depth_mask         0x0000FFFF  // { } nesting of the comment the line starts in
+#define spin_lex_doc_comment        0x00010000  // the comment is a {{ }} one
+#define spin_lex_block_shift        20          // blockType of the section the line is in
+#define spin_lex_block_mask         0x00F00000
+
+struct SpinLexLine
+{
+    int             start;          // offset of the line in the text
+    unsigned int    state;
+    SpinToken*      pTokens;
+    int             tokenCount;
+    int             tokenSize;
+};
+
+class SpinLexer
+{
+    SymbolEngine*   m_pSymbolEngine;
+    char*           m_pText;
+    int             m_length;
+    int             m_textSize;
+    SpinLexLine*    m_pLines;
+    int             m_lineCount;
+    int             m_lineSize;
+    int             m_changedFirst;
+    int             m_changedCount;
+
+    int LexLine(int start, unsigned int& state, SpinLexLine& line);
+    int LexComment(int tokenStart, int offset, unsigned int& state, SpinLexLine& line);
+    int LexNumber(int offset, int base, bool& bError);
+    int LexOperator(int offset, unsigned char& type);
+    void AddToken(SpinLexLine& line, int start, int finish, int kind, int type = 0);
+    bool IsLineEnd(int offset);
+    int SkipLineEnd(int offset);
+    void Relex(int firstLine, int newFinish, int oldFinish, int lengthChange);
+
+public:
+    SpinLexer();
+    ~SpinLexer();
+
+    // replaces the whole text, pText doesn't have to stay around
+    void SetText(const char* pText, int length);
+
+    // replaces removedLength characters at offset with pInserted, only relexes from the line of the
+    // edit on until the line states match what they were before, returns false if the range is outside the text
+    bool Edit(int offset, int removedLength, const char* pInserted, int insertedLength);
+
+    // relexes as an Edit() covering whatever differs between the current text and pText
+    void Update(const char* pText, int length);
+
+    // lines relexed by the last SetText()/Edit()/Update() (the states or tokens of the others are unchanged,
+    // the ones after them may have moved)
+    int GetChangedFirstLine()           { return m_changedFirst; }
+    int GetChangedLineCount()           { return m_changedCount; }
+
+    int GetLineCount()                  { return m_lineCount; }
+    const SpinLexLine* GetLine(int line);
+    int GetLineBlock(int line);         // blockType of the section the line is in
+    int FindLine(int offset);           // line holding offset
+
+    const char* GetText()               { return m_pText; }
+    int GetLength()                     { return m_length; }
+};
+
+#endif // _SPIN_LEXER_H_
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,804 @@
+//////////////////////////////////////////////////////////////
+//                                                          //
+// Propeller Spin/PASM Compiler                             //
+// (c)2012 Parallax Inc. DBA Parallax Semiconductor.        //
+// Adapted from Chip Gracey's x86 asm code by Roy Eltham    //
+// See end of file for terms of use.                        //
+//                                                          //
+//////////////////////////////////////////////////////////////
+//
+// StackAnalysis.cpp
+//
+// optional worst case Spin stack usage, worked out from the
+// finished object (after CompileFinal) instead of _STACK
+//
+// each method is walked over every path through its bytecode
+// to find the deepest the stack gets, then the calls are
+// followed through the object tree, every call adds the
+// callee's locals and deepest point on top of the caller's
+// stack at the call (which already holds the return frame,
+// result, and parameters)
+//
+
+#include <stdio.h>
+#include <string.h>
+#include "Utilities.h"
+#include "PropellerCompilerInternal.h"
+#include "SymbolEngine.h"
+#include "Elementizer.h"
+#include "SpinBytecode.h"
+
+#define stack_methods_index_size    256
+#define stack_state_limit           64      // stack slots that track constants
+#define stack_anchor_limit          32      // nested calls within one expression
+#define stack_visit_limit           16      // times a position can be walked again with a deeper stack
+#define stack_frame_longs           3       // pbase/vbase/dbase/dcall words and the result long
+
+enum stackMethodState
+{
+    stack_method_new = 0,
+    stack_method_walked,
+    stack_method_in_progress,   // while the callees are being resolved
+    stack_method_done
+};
+
+struct StackCall
+{
+    int     depth;      // caller's stack at the call, in longs (includes the frame, result, and parameters)
+    int     key;        // callee
+};
+
+// a method of one object instance in the finished object
+class StackMethod : public Hashable
+{
+public:
+    int         m_key;
+    int         m_objectBase;       // offset of the object in obj
+    int         m_subIndex;
+    int         m_state;
+    bool        m_bUnknown;         // couldn't be walked
+    bool        m_bRecursive;       // calls itself (directly or not)
+    bool        m_bUnbounded;       // calls something unknown or recursive
+    int         m_locals;           // longs
+    int         m_peak;             // longs above the locals, including the calls made
+    StackCall*  m_pCalls;
+    int         m_callCount;
+    int         m_callSize;
+
+    StackMethod(int key, int objectBase, int subIndex)
+        : m_key(key)
+        , m_objectBase(objectBase)
+        , m_subIndex(subIndex)
+        , m_state(stack_method_new)
+        , m_bUnknown(false)
+        , m_bRecursive(false)
+        , m_bUnbounded(false)
+        , m_locals(0)
+        , m_peak(0)
+        , m_pCalls(0)
+        , m_callCount(0)
+        , m_callSize(0)
+    {
+    }
+    virtual ~StackMethod()
+    {
+        delete [] m_pCalls;
+    }
+
+    void AddCall(int depth, int key)
+    {
+        for (int i = 0; i < m_callCount; i++)
+        {
+            if (m_pCalls[i].key == key)
+            {
+                if (depth > m_pCalls[i].depth)
+                {
+                    m_pCalls[i].depth = depth;
+                }
+                return;
+            }
+        }
+        if (m_callCount >= m_callSize)
+        {
+            int newSize = (m_callSize > 0) ? m_callSize * 2 : 16;
+            StackCall* pNewCalls = new StackCall[newSize];
+            if (m_pCalls)
+            {
+                memcpy(pNewCalls, m_pCalls, m_callCount * sizeof(StackCall));
+                delete [] m_pCalls;
+            }
+            m_pCalls = pNewCalls;
+            m_callSize = newSize;
+        }
+        m_pCalls[m_callCount].depth = depth;
+        m_pCalls[m_callCount].key = key;
+        m_callCount++;
+    }
+
+    // longs used from the caller's stack pointer at the call
+    int Need()
+    {
+        return m_locals + m_peak;
+    }
+};
+
+// what is known about the stack at one point of a path
+struct StackState
+{
+    int     pos;
+    int     depth;
+    int     anchorCount;
+    int     anchorDepth[stack_anchor_limit];
+    bool    anchorPush[stack_anchor_limit];
+    bool    bKnown[stack_state_limit];
+    int     value[stack_state_limit];
+
+    void Push(bool bKnownValue, int knownValue)
+    {
+        if (depth >= 0 && depth < stack_state_limit)
+        {
+            bKnown[depth] = bKnownValue;
+            value[depth] = knownValue;
+        }
+        depth++;
+    }
+    void Push(int count)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            Push(false, 0);
+        }
+    }
+    bool GetKnown(int slot, int& knownValue)
+    {
+        if (slot < 0 || slot >= depth || slot >= stack_state_limit || !bKnown[slot])
+        {
+            return false;
+        }
+        knownValue = value[slot];
+        return true;
+    }
+};
+
+static HashTable* s_pStackMethods = 0;
+static StackMethod** s_pWalkList = 0;   // methods in the order found
+static int s_walkCount = 0;
+static int s_walkSize = 0;
+static int s_codeEnd = 0;               // end of the code in obj
+
+// per position bookkeeping for the walk of one method
+static int* s_pVisitDepth = 0;
+static unsigned char* s_pVisitCount = 0;
+static StackState* s_pPending = 0;
+static int s_pendingCount = 0;
+static int s_pendingSize = 0;
+
+static int StackAnalysis_Key(int objectBase, int subIndex)
+{
+    return (objectBase << 8) | subIndex;
+}
+
+static StackMethod* StackAnalysis_GetMethod(int objectBase, int subIndex)
+{
+    int key = StackAnalysis_Key(objectBase, subIndex);
+    for (HashNode* pNode = s_pStackMethods->FindFirst(key); pNode != 0; pNode = s_pStackMethods->FindNext(pNode))
+    {
+        if (((StackMethod*)pNode->pValue)->m_key == key)
+        {
+            return (StackMethod*)pNode->pValue;
+        }
+    }
+
+    StackMethod* pMethod = new StackMethod(key, objectBase, subIndex);
+    s_pStackMethods->Insert(key, pMethod);
+
+    if (s_walkCount >= s_walkSize)
+    {
+        int newSize = (s_walkSize > 0) ? s_walkSize * 2 : 64;
+        StackMethod** pNewList = new StackMethod*[newSize];
+        if (s_pWalkList)
+        {
+            memcpy(pNewList, s_pWalkList, s_walkCount * sizeof(StackMethod*));
+            delete [] s_pWalkList;
+        }
+        s_pWalkList = pNewList;
+        s_walkSize = newSize;
+    }
+    s_pWalkList[s_walkCount++] = pMethod;
+    return pMethod;
+}
+
+static StackMethod* StackAnalysis_FindMethod(int key)
+{
+    for (HashNode* pNode = s_pStackMethods->FindFirst(key); pNode != 0; pNode = s_pStackMethods->FindNext(pNode))
+    {
+        if (((StackMethod*)pNode->pValue)->m_key == key)
+        {
+            return (StackMethod*)pNode->pValue;
+        }
+    }
+    return 0;
+}
+
+// index table entries are added to the object base, wrapping at 16 bits like hub addresses do
+static int StackAnalysis_Target(int objectBase, int offset)
+{
+    return 4 + (((objectBase - 4) + offset) & 0xFFFF);
+}
+
+// queue a path at pos, unless it has already been walked with at least this much on the stack
+static bool StackAnalysis_Queue(StackState& state, int pos, int start, int end)
+{
+    if (pos < start || pos >= end)
+    {
+        return false;
+    }
+    int index = pos - start;
+    if (s_pVisitCount[index] > 0 && s_pVisitDepth[index] >= state.depth)
+    {
+        return true;
+    }
+    if (s_pVisitCount[index] >= stack_visit_limit)
+    {
+        return false;
+    }
+    s_pVisitCount[index]++;
+    s_pVisitDepth[index] = state.depth;
+
+    if (s_pendingCount >= s_pendingSize)
+    {
+        int newSize = (s_pendingSize > 0) ? s_pendingSize * 2 : 64;
+        StackState* pNewPending = new StackState[newSize];
+        if (s_pPending)
+        {
+            memcpy(pNewPending, s_pPending, s_pendingCount * sizeof(StackState));
+            delete [] s_pPending;
+        }
+        s_pPending = pNewPending;
+        s_pendingSize = newSize;
+    }
+    s_pPending[s_pendingCount] = state;
+    s_pPending[s_pendingCount].pos = pos;
+    s_pendingCount++;
+    return true;
+}
+
+// stack change of the assign operator after a using operation (not counting what the using operation popped)
+static int StackAnalysis_AssignChange(unsigned char assignOp)
+{
+    int change = (assignOp & 0x80) ? 1 : 0; // push result
+    assignOp &= 0x7F;
+    if (assignOp == 0x00)
+    {
+        change -= 1; // write
+    }
+    else if (assignOp == 0x02)
+    {
+        change -= 2; // repeat-var pops from and to
+    }
+    else if (assignOp == 0x06)
+    {
+        change -= 3; // repeat-var w/step pops from, to, and step
+    }
+    else if (assignOp >= 0x40 && assignOp < 0x60 && !IsUnaryMathOp(assignOp & 0x1F))
+    {
+        change -= 1; // math assign pops the other operand
+    }
+    return change;
+}
+
+// pops and pushes of the instructions in 0x15..0x2F, the ones that need more than this are handled by the caller
+static const signed char s_instructionChange[] =
+{
+    //  0x15    0x16    0x17    0x18    0x19    0x1A    0x1B    0x1C    0x1D    0x1E    0x1F
+        0,      0,      -1,     -3,     -3,     -3,     -3,     -3,     -3,     -3,     -3,
+    //  0x20    0x21    0x22    0x23    0x24    0x25    0x26    0x27    0x28    0x29    0x2A    0x2B    0x2C    0x2D    0x2E    0x2F
+        -2,     -1,     -1,     -1,     0,      -2,     -1,     -2,     -2,     1,      0,      0,      -3,     0,      -1,     -1
+};
+
+// walk every path of a method from its first instruction
+static bool StackAnalysis_Walk(StackMethod* pMethod)
+{
+    unsigned char* pObj = g_pCompilerData->obj;
+    int objectBase = pMethod->m_objectBase;
+    int subCount = pObj[objectBase + 2] - 1;
+    if (pMethod->m_subIndex < 1 || pMethod->m_subIndex > subCount)
+    {
+        return false;
+    }
+    unsigned short* pEntry = (unsigned short*)&(pObj[objectBase + (pMethod->m_subIndex * 4)]);
+    int start = StackAnalysis_Target(objectBase, pEntry[0]);
+    int end = s_codeEnd;
+    pMethod->m_locals = pEntry[1] >> 2;
+
+    if (start >= end)
+    {
+        return false;
+    }
+
+    memset(s_pVisitCount, 0, (size_t)(end - start));
+    s_pendingCount = 0;
+
+    StackState state;
+    memset(&state, 0, sizeof(StackState));
+    StackAnalysis_Queue(state, start, start, end);
+
+    int peak = 0;
+    while (s_pendingCount > 0)
+    {
+        state = s_pPending[--s_pendingCount];
+
+        // follow this path until it ends or joins one already walked
+        while (1)
+        {
+            int pos = state.pos;
+            SpinInstruction instruction;
+            if (!DecodeSpinInstruction(pObj, pos, end, instruction))
+            {
+                return false;
+            }
+            unsigned char opcode = instruction.opcode;
+            int next = pos + instruction.length;
+            bool bFallThrough = true;
+            StackState branch;
+            int branchTarget = instruction.branchTarget;
+            bool bBranch = false;
+
+            if (opcode <= 0x03)
+            {
+                // drop anchor, push return frame and result
+                if (state.anchorCount >= stack_anchor_limit)
+                {
+                    return false;
+                }
+                state.anchorDepth[state.anchorCount] = state.depth;
+                state.anchorPush[state.anchorCount] = (opcode & 0x01) == 0;   // 0x01/0x03 drop the result
+                state.anchorCount++;
+                state.Push(stack_frame_longs);
+            }
+            else if (opcode >= 0x05 && opcode <= 0x07)
+            {
+                // call sub, obj.sub, obj[].sub
+                if (state.anchorCount == 0)
+                {
+                    return false;
+                }
+                int calleeBase = objectBase;
+                int calleeIndex = pObj[pos + 1];
+                if (opcode != 0x05)
+                {
+                    calleeBase = objectBase + *((unsigned short*)&(pObj[objectBase + (pObj[pos + 1] * 4)]));
+                    calleeIndex = pObj[pos + 2];
+                    if (opcode == 0x07)
+                    {
+                        state.depth--; // instance index (all instances run the same object)
+                    }
+                    if (calleeBase >= s_codeEnd)
+                    {
+                        return false;
+                    }
+                }
+                StackMethod* pCallee = StackAnalysis_GetMethod(calleeBase, calleeIndex);
+                pMethod->AddCall(state.depth, pCallee->m_key);
+
+                state.anchorCount--;
+                state.depth = state.anchorDepth[state.anchorCount];
+                if (state.anchorPush[state.anchorCount])
+                {
+                    state.Push(1);
+                }
+            }
+            else if (opcode == 0x04 || (opcode >= 0x08 && opcode <= 0x0B) || opcode == 0x0D || opcode == 0x0E)
+            {
+                // jmp, tjz, djnz, jz, jnz, case value, case range
+                branch = state;
+                bBranch = true;
+                switch (opcode)
+                {
+                    case 0x04: bFallThrough = false;                    break;
+                    case 0x08: branch.depth -= 1;                       break; // tjz pops when it jumps
+                    case 0x09: state.depth -= 1;                        break; // djnz pops when it doesn't
+                    case 0x0E: branch.depth -= 2; state.depth -= 2;     break;
+                    default:   branch.depth -= 1; state.depth -= 1;     break;
+                }
+            }
+            else if (opcode == 0x0C)
+            {
+                // casedone, pops the case value and jumps to the address pushed below it
+                int address = 0;
+                if (!state.GetKnown(state.depth - 2, address))
+                {
+                    return false;
+                }
+                state.depth -= 2;
+                branch = state;
+                branchTarget = objectBase + address;
+                bBranch = true;
+                bFallThrough = false;
+            }
+            else if (opcode == 0x0F)
+            {
+                // lookdone, pops value and address, the base is replaced by the result
+                state.depth -= 2;
+            }
+            else if (opcode >= 0x10 && opcode <= 0x13)
+            {
+                // lookup/lookdown value or range, a match jumps to the address pushed below the value
+                // with the result in place of the base
+                state.depth -= (opcode & 0x02) ? 2 : 1;
+                int address = 0;
+                if (!state.GetKnown(state.depth - 2, address))
+                {
+                    return false;
+                }
+                branch = state;
+                branch.depth -= 2;
+                branchTarget = objectBase + address;
+                bBranch = true;
+            }
+            else if (opcode == 0x14)
+            {
+                // pop, the byte count is a constant on top
+                int count = 0;
+                if (!state.GetKnown(state.depth - 1, count) || (count & 3) != 0)
+                {
+                    return false;
+                }
+                state.depth -= 1 + (count >> 2);
+            }
+            else if (opcode == 0x15)
+            {
+                // run, pops the parameters, sub constant, and stack address, pushes the coginit values
+                int subConstant = 0;
+                if (!state.GetKnown(state.depth - 2, subConstant))
+                {
+                    return false;
+                }
+                state.depth -= ((subConstant >> 8) & 0xFF) + 2;
+                if (state.depth < 0)
+                {
+                    return false;
+                }
+                state.Push(3);
+            }
+            else if (opcode <= 0x2F)
+            {
+                int change = s_instructionChange[opcode - 0x15];
+                if (instruction.bAssignOp)
+                {
+                    change += StackAnalysis_AssignChange(instruction.assignOp);
+                }
+                if (change < 0)
+                {
+                    state.depth += change;
+                }
+                else
+                {
+                    state.Push(change);
+                }
+            }
+            else if (opcode <= 0x33)
+            {
+                // abort, return
+                bFallThrough = false;
+            }
+            else if (instruction.bConstant)
+            {
+                state.Push(true, instruction.constantValue);
+            }
+            else if (opcode <= 0x3F)
+            {
+                // register op, with a bit or range popped first
+                state.depth -= opcode == 0x3D ? 1 : (opcode == 0x3E ? 2 : 0);
+                switch ((pObj[pos + 1] >> 5) & 0x03)
+                {
+                    case spin_var_push: state.Push(1); break;
+                    case spin_var_pop:  state.depth -= 1; break;
+                    case spin_var_using:
+                        {
+                            int change = StackAnalysis_AssignChange(instruction.assignOp);
+                            if (change < 0)
+                            {
+                                state.depth += change;
+                            }
+                            else
+                            {
+                                state.Push(change);
+                            }
+                        }
+                        break;
+                    default: return false;
+                }
+            }
+            else if (instruction.bVariable)
+            {
+                if (instruction.bVarIndexed)
+                {
+                    state.depth--;
+                }
+                if (instruction.varBase == spin_base_mem && opcode >= 0x80)
+                {
+                    state.depth--;
+                }
+                switch (instruction.varOperation)
+                {
+                    case spin_var_push:
+                    case spin_var_reference:
+                        state.Push(1);
+                        break;
+                    case spin_var_pop:
+                        state.depth--;
+                        break;
+                    case spin_var_using:
+                        {
+                            int change = StackAnalysis_AssignChange(instruction.assignOp);
+                            if (change < 0)
+                            {
+                                state.depth += change;
+                            }
+                            else
+                            {
+                                state.Push(change);
+                            }
+                        }
+                        break;
+                }
+            }
+            else if (instruction.bMathOp)
+            {
+                if (!IsUnaryMathOp(instruction.mathOp))
+                {
+                    state.depth--;
+                }
+            }
+            else
+            {
+                return false;
+            }
+
+            if (instruction.bAssignOp && instruction.bBranch)
+            {
+                // repeat-var, loops back with the same stack
+                branch = state;
+                bBranch = true;
+            }
+            if (!instruction.bConstant && state.depth > 0 && state.depth <= stack_state_limit)
+            {
+                // whatever is on top now was worked out by the instruction
+                state.bKnown[state.depth - 1] = false;
+            }
+            if (bBranch && branch.depth > 0 && branch.depth <= stack_state_limit)
+            {
+                branch.bKnown[branch.depth - 1] = false;
+            }
+            if (state.depth < 0 || (bBranch && branch.depth < 0))
+            {
+                return false;
+            }
+            if (state.depth > peak)
+            {
+                peak = state.depth;
+            }
+
+            if (bBranch && !StackAnalysis_Queue(branch, branchTarget, start, end))
+            {
+                return false;
+            }
+            if (!bFallThrough)
+            {
+                break;
+            }
+
+            // carry on along this path, unless it joins one that was walked with at least this much on the stack
+            int index = next - start;
+            if (next >= end)
+            {
+                return false;
+            }
+            if (s_pVisitCount[index] > 0 && s_pVisitDepth[index] >= state.depth)
+            {
+                break;
+            }
+            if (s_pVisitCount[index] >= stack_visit_limit)
+            {
+                return false;
+            }
+            s_pVisitCount[index]++;
+            s_pVisitDepth[index] = state.depth;
+            state.pos = next;
+        }
+    }
+
+    pMethod->m_peak = peak;
+    return true;
+}
+
+// add the calls on top of the walked peaks, in call order so each callee is done first
+static void StackAnalysis_Resolve(StackMethod* pMethod)
+{
+    pMethod->m_state = stack_method_in_progress;
+    for (int i = 0; i < pMethod->m_callCount; i++)
+    {
+        StackMethod* pCallee = StackAnalysis_FindMethod(pMethod->m_pCalls[i].key);
+        if (pCallee->m_state == stack_method_in_progress)
+        {
+            pCallee->m_bRecursive = true;
+            pMethod->m_bUnbounded = true;
+            continue;
+        }
+        if (pCallee->m_state != stack_method_done)
+        {
+            StackAnalysis_Resolve(pCallee);
+        }
+        if (pCallee->m_bUnknown || pCallee->m_bRecursive || pCallee->m_bUnbounded)
+        {
+            pMethod->m_bUnbounded = true;
+            continue;
+        }
+        int depth = pMethod->m_pCalls[i].depth + pCallee->Need();
+        if (depth > pMethod->m_peak)
+        {
+            pMethod->m_peak = depth;
+        }
+    }
+    pMethod->m_state = stack_method_done;
+}
+
+static void StackAnalysis_Cleanup()
+{
+    delete s_pStackMethods;
+    s_pStackMethods = 0;
+    delete [] s_pWalkList;
+    s_pWalkList = 0;
+    s_walkCount = 0;
+    s_walkSize = 0;
+    delete [] s_pVisitDepth;
+    s_pVisitDepth = 0;
+    delete [] s_pVisitCount;
+    s_pVisitCount = 0;
+    delete [] s_pPending;
+    s_pPending = 0;
+    s_pendingCount = 0;
+    s_pendingSize = 0;
+}
+
+// find the name and parameter count of one of the methods of the object being compiled
+static bool StackAnalysis_GetMethodInfo(int subIndex, int& infoIndex)
+{
+    for (int i = 0; i < g_pCompilerData->info_count; i++)
+    {
+        if ((g_pCompilerData->info_type[i] == info_pub || g_pCompilerData->info_type[i] == info_pri) &&
+            (g_pCompilerData->info_data4[i] & 0xFFFF) == subIndex - 1)
+        {
+            infoIndex = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// works out the stack needed by each method of the object, enters an info_pub_stack/info_pri_stack
+// record and a listing line for each, and returns the longs needed by the first PUB in stackLongs,
+// or -1 if that can't be bounded (recursion, or bytecode that couldn't be followed)
+bool StackAnalysis_Determine(int& stackLongs)
+{
+    stackLongs = -1;
+    if (g_pCompilerData->compile_mode != 0 || g_pCompilerData->psize == 0)
+    {
+        return true;
+    }
+
+    // the finished object starts after the vsize/psize long
+    s_codeEnd = 4 + g_pCompilerData->psize;
+    s_pStackMethods = new HashTable(stack_methods_index_size);
+    s_pVisitDepth = new int[s_codeEnd];
+    s_pVisitCount = new unsigned char[s_codeEnd];
+
+    int subCount = g_pCompilerData->obj[4 + 2] - 1;
+    for (int i = 1; i <= subCount; i++)
+    {
+        StackAnalysis_GetMethod(4, i);
+    }
+    for (int i = 0; i < s_walkCount; i++)
+    {
+        StackMethod* pMethod = s_pWalkList[i];
+        if (!StackAnalysis_Walk(pMethod))
+        {
+            pMethod->m_bUnknown = true;
+        }
+        pMethod->m_state = stack_method_walked;
+    }
+    for (int i = 1; i <= subCount; i++)
+    {
+        StackMethod* pMethod = StackAnalysis_FindMethod(StackAnalysis_Key(4, i));
+        if (pMethod->m_state != stack_method_done)
+        {
+            StackAnalysis_Resolve(pMethod);
+        }
+    }
+
+    char tempStr[256];
+    bool bResult = true;
+    for (int i = 1; i <= subCount && bResult; i++)
+    {
+        StackMethod* pMethod = StackAnalysis_FindMethod(StackAnalysis_Key(4, i));
+
+        int infoIndex = 0;
+        int params = (i == 1) ? g_pCompilerData->first_pub_parameters : 0;
+        char name[symbol_limit + 1];
+        strcpy(name, "?");
+        g_pCompilerData->inf_type = (i == 1) ? info_pub_stack : info_pri_stack;
+        g_pCompilerData->inf_start = 0;
+        g_pCompilerData->inf_finish = 0;
+        if (StackAnalysis_GetMethodInfo(i, infoIndex))
+        {
+            params = g_pCompilerData->info_data4[infoIndex] >> 16;
+            g_pCompilerData->inf_type = (g_pCompilerData->info_type[infoIndex] == info_pub) ? info_pub_stack : info_pri_stack;
+            g_pCompilerData->inf_start = g_pCompilerData->info_data2[infoIndex];
+            g_pCompilerData->inf_finish = g_pCompilerData->info_data3[infoIndex];
+            int length = g_pCompilerData->inf_finish - g_pCompilerData->inf_start;
+            if (length > 0 && length <= symbol_limit)
+            {
+                strncpy(name, &(g_pCompilerData->source[g_pCompilerData->inf_start]), length);
+                name[length] = 0;
+            }
+        }
+
+        int longs = stack_frame_longs + params + pMethod->Need();
+        if (pMethod->m_bUnknown)
+        {
+            longs = -2;
+            snprintf(tempStr, sizeof(tempStr), "\rStack longs %s: not analyzed", name);
+        }
+        else if (pMethod->m_bRecursive || pMethod->m_bUnbounded)
+        {
+            longs = pMethod->m_bRecursive ? -1 : -3;
+            snprintf(tempStr, sizeof(tempStr), "\rStack longs %s: unbounded (%s)", name, pMethod->m_bRecursive ? "recursive" : "calls recursive or unknown method");
+        }
+        else
+        {
+            snprintf(tempStr, sizeof(tempStr), "\rStack longs %s: %d", name, longs);
+        }
+        if (i == 1)
+        {
+            stackLongs = longs < 0 ? -1 : longs;
+        }
+
+        g_pCompilerData->inf_data0 = i;
+        g_pCompilerData->inf_data1 = longs;
+        g_pCompilerData->inf_data2 = params;
+        g_pCompilerData->inf_data3 = pMethod->m_locals;
+        g_pCompilerData->inf_data4 = pMethod->m_peak;
+        EnterInfo();
+
+        bResult = PrintString(tempStr);
+    }
+    if (bResult)
+    {
+        bResult = PrintChr(13);
+    }
+
+    StackAnalysis_Cleanup();
+    return bResult;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
@@ -103,12 +103,9 @@ bool StringConstant_PostProcess()
         }
 
         // enter strings into obj
-        for (int i = 0; i < g_pCompilerData->str_buffer_ptr; i++)
+        if (!EnterObjBytes(g_pCompilerData->str_buffer, g_pCompilerData->str_buffer_ptr))
         {
-            if (!EnterObj(g_pCompilerData->str_buffer[i]))
-            {
-                return false;
-            }
+            return false;
         }
     }
     return true;
@@ -0,0 +1,335 @@
+//////////////////////////////////////////////////////////////
+//                                                          //
+// Propeller Spin/PASM Compiler                             //
+// (c)2012 Parallax Inc. DBA Parallax Semiconductor.        //
+// Adapted from Chip Gracey's x86 asm code by Roy Eltham    //
+// See end of file for terms of use.                        //
+//                                                          //
+//////////////////////////////////////////////////////////////
+//
+// UnusedMethods.cpp
+//
+// optional removal of PUBs/PRIs that can't be reached from the
+// first PUB of the top object
+//
+// the caller compiles the whole object tree once while the
+// call graph is recorded, then calls UnusedMethods_Resolve()
+// and compiles the tree again, this time the unreachable
+// methods are left out of the index tables and their bodies
+// are not compiled, so the remaining methods are renumbered
+// by the normal compile
+//
+
+#include <string.h>
+#include "Utilities.h"
+#include "PropellerCompilerInternal.h"
+#include "SymbolEngine.h"
+#include "Elementizer.h"
+
+#define unused_methods_index_size   64
+#define unused_methods_sub_limit    256 // sub index is a byte
+#define unused_methods_call_initial 64  // grows as needed
+
+enum unusedMethodsPhase
+{
+    unused_phase_off = 0,
+    unused_phase_record,    // recording methods and calls
+    unused_phase_eliminate  // leaving out the methods that weren't reached
+};
+
+class MethodObject;
+
+struct MethodCall
+{
+    int             from;       // sub index (1 based) of the calling method
+    MethodObject*   pTarget;    // object holding the called method
+    int             to;         // sub index (1 based) of the called method
+};
+
+// the methods of an object file and the calls made from them
+class MethodObject : public Hashable
+{
+public:
+    char*       m_pFilename;
+    char*       m_pNames[unused_methods_sub_limit];  // PUBs then PRIs, in index order
+    bool        m_bUsed[unused_methods_sub_limit];
+    int         m_methodCount;
+    MethodCall* m_pCalls;
+    int         m_callCount;
+    int         m_callSize;
+
+    MethodObject(const char* pFilename)
+        : m_methodCount(0)
+        , m_pCalls(0)
+        , m_callCount(0)
+        , m_callSize(0)
+    {
+        m_pFilename = new char[strlen(pFilename) + 1];
+        strcpy(m_pFilename, pFilename);
+    }
+    virtual ~MethodObject()
+    {
+        ClearMethods();
+        delete [] m_pCalls;
+        delete [] m_pFilename;
+    }
+
+    void ClearMethods()
+    {
+        for (int i = 0; i < m_methodCount; i++)
+        {
+            delete [] m_pNames[i];
+        }
+        m_methodCount = 0;
+    }
+
+    void AddCall(int from, MethodObject* pTarget, int to)
+    {
+        // the same code can be compiled more than once (OptimizeBlock, SkipBlock, etc.)
+        for (int i = 0; i < m_callCount; i++)
+        {
+            if (m_pCalls[i].from == from && m_pCalls[i].pTarget == pTarget && m_pCalls[i].to == to)
+            {
+                return;
+            }
+        }
+        if (m_callCount >= m_callSize)
+        {
+            int newSize = (m_callSize > 0) ? m_callSize * 2 : unused_methods_call_initial;
+            MethodCall* pNewCalls = new MethodCall[newSize];
+            if (m_pCalls)
+            {
+                memcpy(pNewCalls, m_pCalls, m_callCount * sizeof(MethodCall));
+                delete [] m_pCalls;
+            }
+            m_pCalls = pNewCalls;
+            m_callSize = newSize;
+        }
+        m_pCalls[m_callCount].from = from;
+        m_pCalls[m_callCount].pTarget = pTarget;
+        m_pCalls[m_callCount].to = to;
+        m_callCount++;
+    }
+};
+
+static int s_phase = unused_phase_off;
+static HashTable* s_pMethodObjects = 0;
+static MethodObject* s_pCurrentObject = 0;
+static int s_currentMethod = 0;
+
+static MethodObject* UnusedMethods_FindObject(const char* pFilename, bool bCreate)
+{
+    if (!s_pMethodObjects)
+    {
+        if (!bCreate)
+        {
+            return 0;
+        }
+        s_pMethodObjects = new HashTable(unused_methods_index_size);
+    }
+
+    int hash = s_pMethodObjects->GetStringHashUppercase(pFilename);
+    for (HashNode* pNode = s_pMethodObjects->FindFirst(hash); pNode != 0; pNode = pNode->pNext)
+    {
+        if (pNode->key == hash && _stricmp(((MethodObject*)pNode->pValue)->m_pFilename, pFilename) == 0)
+        {
+            return (MethodObject*)pNode->pValue;
+        }
+    }
+
+    if (!bCreate)
+    {
+        return 0;
+    }
+    MethodObject* pObject = new MethodObject(pFilename);
+    s_pMethodObjects->Insert(hash, pObject);
+    return pObject;
+}
+
+// start recording methods and calls, anything recorded before is dropped
+void UnusedMethods_Begin()
+{
+    delete s_pMethodObjects;
+    s_pMethodObjects = 0;
+    s_pCurrentObject = 0;
+    s_currentMethod = 0;
+    s_phase = unused_phase_record;
+}
+
+void UnusedMethods_End()
+{
+    delete s_pMethodObjects;
+    s_pMethodObjects = 0;
+    s_pCurrentObject = 0;
+    s_currentMethod = 0;
+    s_phase = unused_phase_off;
+}
+
+// call before Compile1() with the filename the object is known by
+// (the top filename, or the OBJ filename with .spin on the end)
+void UnusedMethods_SetObject(const char* pFilename)
+{
+    if (s_phase == unused_phase_record)
+    {
+        s_pCurrentObject = UnusedMethods_FindObject(pFilename, true);
+
+        // the method list is rebuilt by each Compile1()
+        s_pCurrentObject->ClearMethods();
+    }
+    else if (s_phase == unused_phase_eliminate)
+    {
+        s_pCurrentObject = UnusedMethods_FindObject(pFilename, false);
+    }
+    s_currentMethod = 0;
+}
+
+// called by CompileSubBlocksId() for each PUB/PRI, in index order
+void UnusedMethods_EnterMethod(const char* pName)
+{
+    if (s_phase != unused_phase_record || s_pCurrentObject == 0 || s_pCurrentObject->m_methodCount >= unused_methods_sub_limit)
+    {
+        return;
+    }
+    char* pCopy = new char[strlen(pName) + 1];
+    strcpy(pCopy, pName);
+    s_pCurrentObject->m_pNames[s_pCurrentObject->m_methodCount] = pCopy;
+    s_pCurrentObject->m_bUsed[s_pCurrentObject->m_methodCount] = false;
+    s_pCurrentObject->m_methodCount++;
+}
+
+// called by CompileSubBlocks() before compiling the sub with the given index (1 based)
+void UnusedMethods_BeginMethod(int subIndex)
+{
+    s_currentMethod = subIndex;
+}
+
+// record a call (or cognew/coginit) from the current method
+// objFileIndex is -1 for a sub in the current object, otherwise it's the index into obj_filenames
+void UnusedMethods_AddCall(int objFileIndex, int subIndex)
+{
+    if (s_phase != unused_phase_record || s_pCurrentObject == 0 || s_currentMethod == 0)
+    {
+        return;
+    }
+
+    MethodObject* pTarget = s_pCurrentObject;
+    if (objFileIndex >= 0)
+    {
+        // same name the caller gives the sub-object
+        char filename[256+8];
+        strcpy(filename, &(g_pCompilerData->obj_filenames[objFileIndex<<8]));
+        if (strstr(filename, ".spin") == NULL)
+        {
+            strcat(filename, ".spin");
+        }
+        pTarget = UnusedMethods_FindObject(filename, true);
+    }
+    s_pCurrentObject->AddCall(s_currentMethod, pTarget, subIndex);
+}
+
+// mark everything reachable from the first PUB of the top object and switch to eliminating
+// returns the number of methods that will be left out
+int UnusedMethods_Resolve(const char* pTopFilename)
+{
+    MethodObject* pTop = UnusedMethods_FindObject(pTopFilename, false);
+    if (s_phase != unused_phase_record || pTop == 0 || pTop->m_methodCount == 0)
+    {
+        UnusedMethods_End();
+        return 0;
+    }
+
+    int objectCount = 0;
+    for (HashNode* pNode = s_pMethodObjects->First(); pNode != 0; pNode = s_pMethodObjects->Next(pNode))
+    {
+        objectCount++;
+    }
+
+    // each method goes on the work stack at most once, when it is first marked used
+    MethodCall* pStack = new MethodCall[objectCount * unused_methods_sub_limit];
+    int stackPtr = 0;
+
+    pTop->m_bUsed[0] = true;
+    pStack[stackPtr].pTarget = pTop;
+    pStack[stackPtr].to = 1;
+    stackPtr++;
+
+    while (stackPtr > 0)
+    {
+        stackPtr--;
+        MethodObject* pObject = pStack[stackPtr].pTarget;
+        int method = pStack[stackPtr].to;
+
+        for (int i = 0; i < pObject->m_callCount; i++)
+        {
+            MethodCall& call = pObject->m_pCalls[i];
+            if (call.from != method || call.to < 1 || call.to > call.pTarget->m_methodCount)
+            {
+                continue;
+            }
+            if (!call.pTarget->m_bUsed[call.to - 1])
+            {
+                call.pTarget->m_bUsed[call.to - 1] = true;
+                pStack[stackPtr].pTarget = call.pTarget;
+                pStack[stackPtr].to = call.to;
+                stackPtr++;
+            }
+        }
+    }
+    delete [] pStack;
+
+    int unusedCount = 0;
+    for (HashNode* pNode = s_pMethodObjects->First(); pNode != 0; pNode = s_pMethodObjects->Next(pNode))
+    {
+        MethodObject* pObject = (MethodObject*)pNode->pValue;
+        for (int i = 0; i < pObject->m_methodCount; i++)
+        {
+            if (!pObject->m_bUsed[i])
+            {
+                unusedCount++;
+            }
+        }
+    }
+
+    s_phase = unused_phase_eliminate;
+    s_pCurrentObject = 0;
+    s_currentMethod = 0;
+    return unusedCount;
+}
+
+// true if the named method of the current object is to be left out
+bool UnusedMethods_IsUnused(const char* pName)
+{
+    if (s_phase != unused_phase_eliminate || s_pCurrentObject == 0)
+    {
+        return false;
+    }
+    for (int i = 0; i < s_pCurrentObject->m_methodCount; i++)
+    {
+        if (strcmp(s_pCurrentObject->m_pNames[i], pName) == 0)
+        {
+            return !s_pCurrentObject->m_bUsed[i];
+        }
+    }
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
@@ -597,6 +597,28 @@ bool EnterObj(unsigned char value)
     return true;
 }
 
+// enter a run of bytes into obj with a single limit check
+bool EnterObjBytes(const unsigned char* pData, int length)
+{
+    if (length <= 0)
+    {
+        return true;
+    }
+    if (g_pCompilerData->obj_ptr + length <= g_pCompilerData->obj_limit)
+    {
+        memcpy(&(g_pCompilerData->obj[g_pCompilerData->obj_ptr]), pData, (size_t)length);
+        g_pCompilerData->obj_ptr += length;
+    }
+    else
+    {
+        g_pCompilerData->error = true;
+        g_pCompilerData->error_msg = g_pErrorStrings[error_oex];
+        return false;
+    }
+
+    return true;
+}
+
 bool EnterObjLong(int value)
 {
     if (g_pCompilerData->obj_ptr+4 < g_pCompilerData->obj_limit)
@@ -53,6 +53,7 @@ extern bool GetFilename(int& filenameStart, int& filenameFinish);
 
 extern void EnterInfo();
 extern bool EnterObj(unsigned char value);
+extern bool EnterObjBytes(const unsigned char* pData, int length);
 extern bool EnterObjLong(int value);
 
 extern bool IncrementAsmLocal();
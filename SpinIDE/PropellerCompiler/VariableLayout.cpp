@@ -0,0 +1,208 @@
+//////////////////////////////////////////////////////////////
+//                                                          //
+// Propeller Spin/PASM Compiler                             //
+// (c)2012 Parallax Inc. DBA Parallax Semiconductor.        //
+// Adapted from Chip Gracey's x86 asm code by Roy Eltham    //
+// See end of file for terms of use.                        //
+//                                                          //
+//////////////////////////////////////////////////////////////
+//
+// VariableLayout.cpp
+//
+// optional reordering of VAR longs and method locals so that
+// the most used ones land in the first 8 longs, where
+// CompileVariable() can use the 1 byte compact bytecodes
+//
+
+#include <string.h>
+#include "Utilities.h"
+#include "PropellerCompilerInternal.h"
+#include "SymbolEngine.h"
+#include "Elementizer.h"
+
+#define var_layout_limit    128
+
+struct VarLayoutEntry
+{
+    char    name[symbol_limit+2];
+    int     address;
+    int     size;   // in bytes
+    int     uses;
+};
+
+static VarLayoutEntry s_varLayout[var_layout_limit];
+static int s_varLayoutCount = 0;
+static bool s_bVarLayoutOverflow = false;
+
+void VarLayout_Reset()
+{
+    s_varLayoutCount = 0;
+    s_bVarLayoutOverflow = false;
+}
+
+// record a long variable (or long array) that may be moved
+void VarLayout_Enter(const char* pSymbol, int address, int size)
+{
+    if (s_varLayoutCount == var_layout_limit)
+    {
+        // too many to track, so leave the layout alone
+        s_bVarLayoutOverflow = true;
+        return;
+    }
+    VarLayoutEntry& entry = s_varLayout[s_varLayoutCount++];
+    strcpy(entry.name, pSymbol);
+    entry.address = address;
+    entry.size = size;
+    entry.uses = 0;
+}
+
+static int VarLayout_Find(int address)
+{
+    for (int i = 0; i < s_varLayoutCount; i++)
+    {
+        if (s_varLayout[i].address == address)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// count the uses of each recorded variable of symbolType
+// if bWholeSource, the whole source is scanned, otherwise the scan runs from the current
+// source pointer to the next block and the source pointer is put back afterwards
+// bLayoutFixed is set if the code depends on the relative placement of the variables,
+// which is the case if the address of one is taken or if a non-array is indexed
+static bool VarLayout_CountUses(int symbolType, bool bWholeSource, bool& bLayoutFixed)
+{
+    int savedSourcePtr = g_pElementizer->GetSourcePtr();
+    if (bWholeSource)
+    {
+        g_pElementizer->Reset();
+    }
+
+    bool bEof = false;
+    int lastType = type_undefined;
+    int lastEntry = -1;
+    while (!bEof)
+    {
+        if (!g_pElementizer->GetNext(bEof))
+        {
+            return false;
+        }
+        int type = g_pElementizer->GetType();
+        if (type == type_block && !bWholeSource)
+        {
+            break;
+        }
+
+        // a variable followed by an index or a size override can reach past itself
+        if (lastType == symbolType && (type == type_leftb || type == type_dot))
+        {
+            if (lastEntry < 0 || s_varLayout[lastEntry].size == 4)
+            {
+                bLayoutFixed = true;
+            }
+        }
+
+        lastEntry = -1;
+        if (type == symbolType)
+        {
+            lastEntry = VarLayout_Find(g_pElementizer->GetValue());
+            if (lastType == type_at || lastType == type_atat)
+            {
+                bLayoutFixed = true;
+            }
+            if (lastEntry >= 0)
+            {
+                s_varLayout[lastEntry].uses++;
+            }
+        }
+        lastType = type;
+    }
+
+    if (bWholeSource)
+    {
+        g_pElementizer->Reset();
+    }
+    else
+    {
+        g_pElementizer->SetSourcePtr(savedSourcePtr);
+    }
+    return true;
+}
+
+// reorder the recorded variables of symbolType, starting at address base
+// single longs are placed first, most used first, then arrays in declaration order
+bool VarLayout_Optimize(int symbolType, int base, bool bWholeSource)
+{
+    if (s_varLayoutCount < 2 || s_bVarLayoutOverflow)
+    {
+        return true;
+    }
+
+    bool bLayoutFixed = false;
+    if (!VarLayout_CountUses(symbolType, bWholeSource, bLayoutFixed))
+    {
+        return false;
+    }
+    if (bLayoutFixed)
+    {
+        return true;
+    }
+
+    // stable insertion sort, singles by descending use count, arrays after
+    for (int i = 1; i < s_varLayoutCount; i++)
+    {
+        VarLayoutEntry entry = s_varLayout[i];
+        int j = i;
+        while (j > 0)
+        {
+            VarLayoutEntry& prev = s_varLayout[j - 1];
+            bool bBefore = (entry.size == 4) && (prev.size != 4 || entry.uses > prev.uses);
+            if (!bBefore)
+            {
+                break;
+            }
+            s_varLayout[j] = prev;
+            j--;
+        }
+        s_varLayout[j] = entry;
+    }
+
+    // hand out the new addresses
+    int address = base;
+    for (int i = 0; i < s_varLayoutCount; i++)
+    {
+        SymbolTableEntry* pSymbol = g_pSymbolEngine->FindSymbol(s_varLayout[i].name);
+        if (pSymbol != 0)
+        {
+            pSymbol->m_data.value = address;
+        }
+        s_varLayout[i].address = address;
+        address += s_varLayout[i].size;
+    }
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
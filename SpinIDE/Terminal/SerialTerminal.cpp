@@ -0,0 +1,440 @@
+//////////////////////////////////////////////////////////////
+//                                                          //
+// Propeller Serial Terminal (host side)                    //
+// See end of file for terms of use.                        //
+//                                                          //
+//////////////////////////////////////////////////////////////
+//
+// SerialTerminal.cpp
+//
+// Received bytes go through a single producer/single consumer ring, so
+// the network thread never waits on the one drawing. Each side only
+// writes its own index, the bytes are published by a release store of
+// the write index and handed back by one of the read index.
+//
+// Every byte value has an entry in the action table. A run of printable
+// bytes is copied onto the line in one go, the control codes are handled
+// one at a time. Positions past the end of a line are only filled with
+// spaces when something is written there.
+//
+// The view doesn't redraw per byte. The changed lines are gathered into
+// one range (along with a clear, scrolling and beeps) until it asks for
+// them with GetUpdate().
+//
+
+#include <string.h>
+#include "SerialTerminal.h"
+
+enum terminalAction
+{
+    terminal_print = 0,
+    terminal_clear,
+    terminal_home,
+    terminal_position,          // x, y follow
+    terminal_left,
+    terminal_right,
+    terminal_up,
+    terminal_down,
+    terminal_bell,
+    terminal_backspace,
+    terminal_tab,
+    terminal_line_end,
+    terminal_clear_to_end,
+    terminal_clear_below,
+    terminal_position_x,        // x follows
+    terminal_position_y         // y follows
+};
+
+// Parallax Serial Terminal control codes, everything from 17 up is printed
+static const unsigned char s_terminalActions[256] =
+{
+    terminal_clear,             // 0
+    terminal_home,              // 1
+    terminal_position,          // 2
+    terminal_left,              // 3
+    terminal_right,             // 4
+    terminal_up,                // 5
+    terminal_down,              // 6
+    terminal_bell,              // 7
+    terminal_backspace,         // 8
+    terminal_tab,               // 9
+    terminal_line_end,          // 10 LF
+    terminal_clear_to_end,      // 11
+    terminal_clear_below,       // 12
+    terminal_line_end,          // 13 CR
+    terminal_position_x,        // 14
+    terminal_position_y,        // 15
+    terminal_clear              // 16
+};
+
+// bytes that follow each action
+static const unsigned char s_terminalArguments[] = { 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1 };
+
+SerialTerminal::SerialTerminal()
+    : m_ringWrite(0)
+    , m_ringRead(0)
+    , m_dropped(0)
+{
+    m_pRing = new unsigned char[terminal_ring_size];
+    m_pText = new char[terminal_history * terminal_columns];
+    m_pLengths = new unsigned short[terminal_history];
+    m_update.bells = 0;
+    Clear();
+}
+
+SerialTerminal::~SerialTerminal()
+{
+    delete [] m_pRing;
+    delete [] m_pText;
+    delete [] m_pLengths;
+}
+
+int SerialTerminal::Receive(const unsigned char* pData, int length)
+{
+    unsigned int write = m_ringWrite;
+    unsigned int space = terminal_ring_size - (write - __atomic_load_n(&m_ringRead, __ATOMIC_ACQUIRE));
+    int count = (length < (int)space) ? length : (int)space;
+
+    int offset = write & (terminal_ring_size - 1);
+    int first = (count < terminal_ring_size - offset) ? count : terminal_ring_size - offset;
+    memcpy(&m_pRing[offset], pData, first);
+    memcpy(m_pRing, pData + first, count - first);
+    __atomic_store_n(&m_ringWrite, write + count, __ATOMIC_RELEASE);
+
+    if (count < length)
+    {
+        __atomic_store_n(&m_dropped, m_dropped + (length - count), __ATOMIC_RELAXED);
+    }
+    return count;
+}
+
+int SerialTerminal::Process(int maxBytes)
+{
+    unsigned int read = m_ringRead;
+    unsigned int available = __atomic_load_n(&m_ringWrite, __ATOMIC_ACQUIRE) - read;
+    int count = ((int)available < maxBytes) ? (int)available : maxBytes;
+
+    int offset = read & (terminal_ring_size - 1);
+    int first = (count < terminal_ring_size - offset) ? count : terminal_ring_size - offset;
+    Parse(&m_pRing[offset], first);
+    Parse(m_pRing, count - first);
+    __atomic_store_n(&m_ringRead, read + count, __ATOMIC_RELEASE);
+    return count;
+}
+
+void SerialTerminal::Write(const unsigned char* pData, int length)
+{
+    Parse(pData, length);
+}
+
+bool SerialTerminal::GetUpdate(TerminalUpdate& update)
+{
+    m_update.lineCount = m_lineCount;
+    m_update.cursorX = m_cursorX;
+    m_update.cursorY = m_cursorY;
+    update = m_update;
+
+    bool bChanged = m_update.bCleared || m_update.scrolledLines > 0 || m_update.firstLine < m_update.finishLine ||
+                    m_update.bells > 0 || m_cursorX != m_lastCursorX || m_cursorY != m_lastCursorY;
+
+    m_update.bCleared = false;
+    m_update.scrolledLines = 0;
+    m_update.firstLine = 0;
+    m_update.finishLine = 0;
+    m_update.bells = 0;
+    m_lastCursorX = m_cursorX;
+    m_lastCursorY = m_cursorY;
+    return bChanged;
+}
+
+void SerialTerminal::Clear()
+{
+    m_firstLine = 0;
+    m_lineCount = 1;
+    m_pLengths[0] = 0;
+    m_cursorX = 0;
+    m_cursorY = 0;
+    m_action = terminal_print;
+    m_argumentsNeeded = 0;
+    m_argumentX = 0;
+    m_lastChar = 0;
+
+    int bells = m_update.bells;
+    memset(&m_update, 0, sizeof(m_update));
+    m_update.bCleared = true;
+    m_update.bells = bells;
+    m_lastCursorX = 0;
+    m_lastCursorY = 0;
+}
+
+void SerialTerminal::Changed(int first, int finish)
+{
+    if (m_update.firstLine == m_update.finishLine)
+    {
+        m_update.firstLine = first;
+        m_update.finishLine = finish;
+    }
+    else
+    {
+        if (first < m_update.firstLine)
+        {
+            m_update.firstLine = first;
+        }
+        if (finish > m_update.finishLine)
+        {
+            m_update.finishLine = finish;
+        }
+    }
+}
+
+// adds an empty line at the end, dropping the first one if the history is full
+void SerialTerminal::AddLine()
+{
+    if (m_lineCount == terminal_history)
+    {
+        m_firstLine = (m_firstLine + 1) % terminal_history;
+        m_lineCount--;
+        m_update.scrolledLines++;
+        if (m_update.firstLine > 0)
+        {
+            m_update.firstLine--;
+        }
+        if (m_update.finishLine > 0)
+        {
+            m_update.finishLine--;
+        }
+        if (m_cursorY > 0)
+        {
+            m_cursorY--;
+        }
+    }
+    Length(m_lineCount) = 0;
+    Changed(m_lineCount, m_lineCount + 1);
+    m_lineCount++;
+}
+
+// lines are added to reach y, x can be past the end of the line
+void SerialTerminal::MoveTo(int x, int y)
+{
+    // y can go one line past the last, or to terminal_rows, so a line end always moves down
+    int yLimit = (m_lineCount > terminal_rows) ? m_lineCount : terminal_rows;
+    m_cursorX = (x < terminal_columns) ? x : terminal_columns;
+    m_cursorY = (y < yLimit) ? y : yLimit;
+    while (m_cursorY >= m_lineCount)
+    {
+        AddLine();
+    }
+}
+
+void SerialTerminal::NewLine()
+{
+    MoveTo(0, m_cursorY + 1);
+}
+
+// overwrites from the cursor, wrapping at terminal_columns
+void SerialTerminal::PutText(const unsigned char* pText, int length)
+{
+    while (length > 0)
+    {
+        if (m_cursorX >= terminal_columns)
+        {
+            NewLine();
+        }
+        char* pLine = Line(m_cursorY);
+        unsigned short& lineLength = Length(m_cursorY);
+        if (m_cursorX > lineLength)
+        {
+            memset(&pLine[lineLength], ' ', m_cursorX - lineLength);
+        }
+
+        int count = (length < terminal_columns - m_cursorX) ? length : terminal_columns - m_cursorX;
+        memcpy(&pLine[m_cursorX], pText, count);
+        m_cursorX += count;
+        if (m_cursorX > lineLength)
+        {
+            lineLength = (unsigned short)m_cursorX;
+        }
+        Changed(m_cursorY, m_cursorY + 1);
+        pText += count;
+        length -= count;
+    }
+}
+
+// x and y are only used by the positioning actions
+void SerialTerminal::Control(int action, int x, int y)
+{
+    switch (action)
+    {
+        case terminal_clear:
+            Clear();
+            break;
+
+        case terminal_home:
+            MoveTo(0, 0);
+            break;
+
+        case terminal_position:
+            MoveTo(x, y);
+            break;
+
+        case terminal_position_x:
+            MoveTo(x, m_cursorY);
+            break;
+
+        case terminal_position_y:
+            MoveTo(m_cursorX, y);
+            break;
+
+        case terminal_left:
+            if (m_cursorX > 0)
+            {
+                MoveTo(m_cursorX - 1, m_cursorY);
+            }
+            break;
+
+        case terminal_right:
+            MoveTo(m_cursorX + 1, m_cursorY);
+            break;
+
+        case terminal_up:
+            if (m_cursorY > 0)
+            {
+                MoveTo(m_cursorX, m_cursorY - 1);
+            }
+            break;
+
+        case terminal_down:
+            MoveTo(m_cursorX, m_cursorY + 1);
+            break;
+
+        case terminal_bell:
+            m_update.bells++;
+            break;
+
+        case terminal_backspace:
+            if (m_cursorX > 0)
+            {
+                // the rest of the line moves left over the deleted character
+                char* pLine = Line(m_cursorY);
+                unsigned short& lineLength = Length(m_cursorY);
+                m_cursorX--;
+                if (m_cursorX < lineLength)
+                {
+                    memmove(&pLine[m_cursorX], &pLine[m_cursorX + 1], lineLength - m_cursorX - 1);
+                    lineLength--;
+                    Changed(m_cursorY, m_cursorY + 1);
+                }
+            }
+            else if (m_cursorY > 0)
+            {
+                // back over the line end, to the end of the line before
+                m_cursorY--;
+                m_cursorX = Length(m_cursorY);
+            }
+            break;
+
+        case terminal_tab:
+            MoveTo(m_cursorX + terminal_tab_size - m_cursorX % terminal_tab_size, m_cursorY);
+            break;
+
+        case terminal_clear_to_end:
+            if (m_cursorX < Length(m_cursorY))
+            {
+                Length(m_cursorY) = (unsigned short)m_cursorX;
+                Changed(m_cursorY, m_cursorY + 1);
+            }
+            break;
+
+        case terminal_clear_below:
+            // this line is emptied as well, and the cursor goes to the start of it
+            Changed(m_cursorY, m_lineCount);
+            m_lineCount = m_cursorY + 1;
+            Length(m_cursorY) = 0;
+            m_cursorX = 0;
+            break;
+    }
+}
+
+void SerialTerminal::Parse(const unsigned char* pData, int length)
+{
+    int i = 0;
+    while (i < length)
+    {
+        if (m_argumentsNeeded > 0)
+        {
+            if (m_action == terminal_position && m_argumentsNeeded == 2)
+            {
+                m_argumentX = pData[i];
+            }
+            else if (m_action == terminal_position)
+            {
+                Control(m_action, m_argumentX, pData[i]);
+            }
+            else
+            {
+                Control(m_action, pData[i], pData[i]);
+            }
+            m_argumentsNeeded--;
+            i++;
+            continue;
+        }
+
+        int action = s_terminalActions[pData[i]];
+        if (action == terminal_print)
+        {
+            int finish = i + 1;
+            while (finish < length && s_terminalActions[pData[finish]] == terminal_print)
+            {
+                finish++;
+            }
+            PutText(&pData[i], finish - i);
+            m_lastChar = pData[finish - 1];
+            i = finish;
+            continue;
+        }
+
+        unsigned char ch = pData[i++];
+        if (action == terminal_line_end && ((m_lastChar == 10 && ch == 13) || (m_lastChar == 13 && ch == 10)))
+        {
+            // the second half of CR LF or LF CR, only the pair is eaten so CR LF CR LF is still two line ends
+            m_lastChar = 0;
+            continue;
+        }
+        m_lastChar = ch;
+
+        m_argumentsNeeded = s_terminalArguments[action];
+        if (m_argumentsNeeded > 0)
+        {
+            m_action = action;
+        }
+        else if (action == terminal_line_end)
+        {
+            NewLine();
+        }
+        else
+        {
+            Control(action, 0, 0);
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
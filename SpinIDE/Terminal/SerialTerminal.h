@@ -0,0 +1,116 @@
+//////////////////////////////////////////////////////////////
+//                                                          //
+// Propeller Serial Terminal (host side)                    //
+// See end of file for terms of use.                        //
+//                                                          //
+//////////////////////////////////////////////////////////////
+//
+// SerialTerminal.h
+//
+// the screen of the terminal pane, kept as lines of Latin-1 text with the
+// Parallax Serial Terminal control codes applied to it
+//
+// bytes from the board go in with Receive() on the thread they arrive on,
+// and once each display frame the view calls Process() then GetUpdate()
+// and redraws the lines the update says changed
+//
+
+#ifndef _SERIAL_TERMINAL_H_
+#define _SERIAL_TERMINAL_H_
+
+#define terminal_ring_size          0x40000     // bytes waiting to be processed (a power of 2)
+#define terminal_columns            256         // longer lines wrap
+#define terminal_rows               1024        // cursor positioning only adds lines up to this many (line ends always add one)
+#define terminal_history            8192        // lines kept, the oldest go when there are more
+#define terminal_tab_size           8
+
+// what changed since the last GetUpdate()
+struct TerminalUpdate
+{
+    bool            bCleared;           // the screen was cleared (redraw all of it)
+    int             scrolledLines;      // lines that went off the top of the history, the others moved up by this many
+    int             firstLine;          // lines [firstLine, finishLine) changed or were removed (lines at or past lineCount)
+    int             finishLine;
+    int             lineCount;
+    int             cursorX;
+    int             cursorY;
+    int             bells;              // number of BEEPs
+};
+
+class SerialTerminal
+{
+    // Receive() writes m_ringWrite and Process() writes m_ringRead, each only reads the other's
+    unsigned char*  m_pRing;
+    unsigned int    m_ringWrite;
+    unsigned int    m_ringRead;
+    unsigned int    m_dropped;          // bytes that didn't fit in the ring
+
+    char*           m_pText;            // terminal_history lines of terminal_columns, m_firstLine is line 0
+    unsigned short* m_pLengths;
+    int             m_firstLine;
+    int             m_lineCount;
+    int             m_cursorX;
+    int             m_cursorY;
+
+    int             m_action;           // control code waiting for its x/y bytes
+    int             m_argumentsNeeded;
+    int             m_argumentX;
+    unsigned char   m_lastChar;         // for treating CR LF and LF CR as one line end
+
+    TerminalUpdate  m_update;
+    int             m_lastCursorX;
+    int             m_lastCursorY;
+
+    char* Line(int y)                   { return &m_pText[((m_firstLine + y) % terminal_history) * terminal_columns]; }
+    unsigned short& Length(int y)       { return m_pLengths[(m_firstLine + y) % terminal_history]; }
+
+    void Changed(int first, int finish);
+    void AddLine();
+    void MoveTo(int x, int y);
+    void NewLine();
+    void PutText(const unsigned char* pText, int length);
+    void Control(int action, int x, int y);
+    void Parse(const unsigned char* pData, int length);
+
+public:
+    SerialTerminal();
+    ~SerialTerminal();
+
+    // producer side, from one thread at a time, returns the number of bytes taken (the rest are dropped)
+    int Receive(const unsigned char* pData, int length);
+
+    // consumer side, these are all called from one thread (the one drawing)
+    int Process(int maxBytes);          // returns the number of bytes processed
+    void Write(const unsigned char* pData, int length); // straight to the screen (echoed typing)
+    bool GetUpdate(TerminalUpdate& update); // false if nothing changed
+    void Clear();
+
+    int GetLineCount()                  { return m_lineCount; }
+    const char* GetLine(int y, int& length) { length = Length(y); return Line(y); }
+    int GetCursorX()                    { return m_cursorX; }
+    int GetCursorY()                    { return m_cursorY; }
+    unsigned int GetDroppedBytes()      { return __atomic_load_n(&m_dropped, __ATOMIC_RELAXED); }
+};
+
+#endif // _SERIAL_TERMINAL_H_
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//                           TERMS OF USE: MIT License                                   //
+///////////////////////////////////////////////////////////////////////////////////////////
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this  //
+// software and associated documentation files (the "Software"), to deal in the Software //
+// without restriction, including without limitation the rights to use, copy, modify,    //
+// merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    //
+// permit persons to whom the Software is furnished to do so, subject to the following   //
+// conditions:                                                                           //
+//                                                                                       //
+// The above copyright notice and this permission notice shall be included in all copies //
+// or substantial portions of the Software.                                              //
+//                                                                                       //
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   //
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         //
+// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    //
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     //
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        //
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                //
+///////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,147 @@
+//
+//  OpenSpinBatchTests.mm
+//  SpinIDETests
+//
+//	Builds two top files in one batch, each with its own child object of the same text that
+//	includes a DAT file of the same name with different contents, and checks that each binary
+//	is the one the top file builds to on its own, so the batch did not reuse the first child
+//	with the first DAT file for the second.
+//
+
+#import <XCTest/XCTest.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+extern "C" {
+#include "../SpinIDE/OpenSpin/openspin.h"
+}
+
+#define batch_binary_limit          0x8000
+
+static char s_failure[512];                     // what went wrong, for the assert message
+
+static const char* s_pTopText =
+    "OBJ\n"
+    "  c : \"child\"\n"
+    "PUB main\n"
+    "  return c.get\n";
+
+static const char* s_pChildText =
+    "PUB get\n"
+    "  return long[@d]\n"
+    "DAT\n"
+    "d file \"data.dat\"\n";
+
+static bool WriteFile(const char* pDirectory, const char* pName, const void* pData, int length)
+{
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s", pDirectory, pName);
+    FILE* pFile = fopen(path, "wb");
+    if (pFile == NULL)
+    {
+        snprintf(s_failure, sizeof(s_failure), "can not write %s", path);
+        return false;
+    }
+    bool bOk = (fwrite(pData, 1, length, pFile) == (size_t)length);
+    fclose(pFile);
+    return bOk;
+}
+
+static int ReadBinary(const char* pDirectory, unsigned char* pBinary)
+{
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/top.binary", pDirectory);
+    FILE* pFile = fopen(path, "rb");
+    if (pFile == NULL)
+    {
+        return 0;
+    }
+    int length = (int)fread(pBinary, 1, batch_binary_limit, pFile);
+    fclose(pFile);
+    remove(path);
+    return length;
+}
+
+// a directory with the top file, the child and a DAT file holding value
+static bool MakeProject(const char* pDirectory, int value)
+{
+    mkdir(pDirectory, 0755);
+    unsigned char data[4] = { (unsigned char)value, (unsigned char)(value >> 8), (unsigned char)(value >> 16), (unsigned char)(value >> 24) };
+    return WriteFile(pDirectory, "top.spin", s_pTopText, (int)strlen(s_pTopText)) &&
+           WriteFile(pDirectory, "child.spin", s_pChildText, (int)strlen(s_pChildText)) &&
+           WriteFile(pDirectory, "data.dat", data, sizeof(data));
+}
+
+static void RunOpenSpin(const char* pFirst, const char* pSecond)
+{
+    char first[1024];
+    char second[1024];
+    snprintf(first, sizeof(first), "%s/top.spin", pFirst);
+    if (pSecond != NULL)
+    {
+        snprintf(second, sizeof(second), "%s/top.spin", pSecond);
+    }
+    char* args[] = { (char*)"openspin", (char*)"-q", first, second };
+    mainOpenSpin((pSecond != NULL) ? 4 : 3, args);
+}
+
+// builds both directories in one batch and then each on its own, and compares the binaries
+static bool RunBatch(const char* pA, const char* pB)
+{
+    static unsigned char batchA[batch_binary_limit];
+    static unsigned char batchB[batch_binary_limit];
+    static unsigned char single[batch_binary_limit];
+
+    RunOpenSpin(pA, pB);
+    int lengthA = ReadBinary(pA, batchA);
+    int lengthB = ReadBinary(pB, batchB);
+    if (lengthA == 0 || lengthB == 0)
+    {
+        snprintf(s_failure, sizeof(s_failure), "the batch did not build both binaries");
+        return false;
+    }
+
+    RunOpenSpin(pA, NULL);
+    int length = ReadBinary(pA, single);
+    if (length != lengthA || memcmp(single, batchA, length) != 0)
+    {
+        snprintf(s_failure, sizeof(s_failure), "%s/top.binary differs from the batch build", pA);
+        return false;
+    }
+    RunOpenSpin(pB, NULL);
+    length = ReadBinary(pB, single);
+    if (length != lengthB || memcmp(single, batchB, length) != 0)
+    {
+        snprintf(s_failure, sizeof(s_failure), "%s/top.binary differs from the batch build", pB);
+        return false;
+    }
+    if (lengthA == lengthB && memcmp(batchA, batchB, lengthA) == 0)
+    {
+        snprintf(s_failure, sizeof(s_failure), "the binaries are the same, the DAT files were not both used");
+        return false;
+    }
+    return true;
+}
+
+@interface OpenSpinBatchTests : XCTestCase
+
+@end
+
+@implementation OpenSpinBatchTests
+
+- (void) testBatchDatFiles {
+    NSString *base = [NSTemporaryDirectory() stringByAppendingPathComponent: @"OpenSpinBatchTests"];
+    [[NSFileManager defaultManager] removeItemAtPath: base error: nil];
+    [[NSFileManager defaultManager] createDirectoryAtPath: base withIntermediateDirectories: YES attributes: nil error: nil];
+    NSString *a = [base stringByAppendingPathComponent: @"a"];
+    NSString *b = [base stringByAppendingPathComponent: @"b"];
+
+    s_failure[0] = 0;
+    XCTAssert(MakeProject([a UTF8String], 10) && MakeProject([b UTF8String], 20), @"%s", s_failure);
+    XCTAssert(RunBatch([a UTF8String], [b UTF8String]), @"%s", s_failure);
+    [[NSFileManager defaultManager] removeItemAtPath: base error: nil];
+}
+
+@end
@@ -0,0 +1,117 @@
+//
+//  OpenSpinFoldTests.mm
+//  SpinIDETests
+//
+//	Builds a top file with two objects that have the same method, one using string(), with
+//	and without method folding (-Of), runs both images on the host Spin interpreter (-X) and
+//	checks that they return the same value, so a body holding its own strings wasn't shared.
+//
+
+#import <XCTest/XCTest.h>
+
+#include <stdio.h>
+#include <string.h>
+extern "C" {
+#include "../SpinIDE/OpenSpin/openspin.h"
+}
+
+#define fold_output_limit           4096
+
+static char s_failure[512];                     // what went wrong, for the assert message
+
+static const char* s_pTopText =
+    "OBJ\n"
+    "  x : \"x\"\n"
+    "  y : \"y\"\n"
+    "PUB main\n"
+    "  return x.first * 1000 + y.first\n";
+
+// the first methods are the same, the second ones differ so the objects aren't the same object
+static const char* s_pFirstChildText =
+    "PUB first\n"
+    "  return byte[string(\"AB\")] + byte[string(\"AB\")+1]\n"
+    "PUB second\n"
+    "  return 1\n";
+
+static const char* s_pSecondChildText =
+    "PUB first\n"
+    "  return byte[string(\"AB\")] + byte[string(\"AB\")+1]\n"
+    "PUB second\n"
+    "  return 2\n";
+
+static bool WriteFile(const char* pDirectory, const char* pName, const char* pText)
+{
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s", pDirectory, pName);
+    FILE* pFile = fopen(path, "wb");
+    if (pFile == NULL)
+    {
+        snprintf(s_failure, sizeof(s_failure), "can not write %s", path);
+        return false;
+    }
+    bool bOk = (fwrite(pText, 1, strlen(pText), pFile) == strlen(pText));
+    fclose(pFile);
+    return bOk;
+}
+
+// builds and runs top.spin, returns false if it didn't get to return a value
+static bool RunTop(const char* pDirectory, const char* pOption, int& value)
+{
+    char top[1024];
+    char output[1024];
+    snprintf(top, sizeof(top), "%s/top.spin", pDirectory);
+    snprintf(output, sizeof(output), "%s/stdout.txt", pDirectory);
+    char* args[8] = { (char*)"openspin", (char*)"-q", (char*)"-r", output, (char*)"-X", (char*)"2000000" };
+    int count = 6;
+    if (pOption != NULL)
+    {
+        args[count++] = (char*)pOption;
+    }
+    args[count++] = top;
+    mainOpenSpin(count, args);
+
+    char text[fold_output_limit];
+    FILE* pFile = fopen(output, "rb");
+    if (pFile == NULL)
+    {
+        snprintf(s_failure, sizeof(s_failure), "no output from openspin %s", pOption ? pOption : "");
+        return false;
+    }
+    int length = (int)fread(text, 1, sizeof(text) - 1, pFile);
+    fclose(pFile);
+    text[length] = 0;
+    const char* pReturned = strstr(text, "returned ");
+    if (pReturned == NULL || sscanf(pReturned, "returned %d", &value) != 1)
+    {
+        snprintf(s_failure, sizeof(s_failure), "openspin %s did not run the image: %s", pOption ? pOption : "", text);
+        return false;
+    }
+    return true;
+}
+
+@interface OpenSpinFoldTests : XCTestCase
+
+@end
+
+@implementation OpenSpinFoldTests
+
+- (void) testFoldStrings {
+    NSString *base = [NSTemporaryDirectory() stringByAppendingPathComponent: @"OpenSpinFoldTests"];
+    [[NSFileManager defaultManager] removeItemAtPath: base error: nil];
+    [[NSFileManager defaultManager] createDirectoryAtPath: base withIntermediateDirectories: YES attributes: nil error: nil];
+    const char* pDirectory = [base UTF8String];
+
+    s_failure[0] = 0;
+    XCTAssert(WriteFile(pDirectory, "top.spin", s_pTopText) && WriteFile(pDirectory, "x.spin", s_pFirstChildText) &&
+              WriteFile(pDirectory, "y.spin", s_pSecondChildText), @"%s", s_failure);
+
+    int value = 0;
+    int foldedValue = 0;
+    XCTAssert(RunTop(pDirectory, NULL, value), @"%s", s_failure);
+    XCTAssert(RunTop(pDirectory, "-Of", foldedValue), @"%s", s_failure);
+    XCTAssertEqual(value, ('A' + 'B') * 1001);
+    XCTAssertEqual(foldedValue, value);
+    [[NSFileManager defaultManager] removeItemAtPath: base error: nil];
+}
+
+@end
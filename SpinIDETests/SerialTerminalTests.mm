@@ -0,0 +1,203 @@
+//
+//  SerialTerminalTests.mm
+//  SpinIDETests
+//
+//	Feeds megabytes of synthetic serial output through SerialTerminal, with a producer thread
+//	handing it to Receive() in packet sized pieces while this thread processes it and takes
+//	the updates, as the network thread and the view do. Checks that every byte arrives in
+//	order and that the lines in the history are the ones that were sent.
+//
+
+#import <XCTest/XCTest.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include "../SpinIDE/Terminal/SerialTerminal.h"
+
+#define output_packet_size          1460        // bytes per Receive(), like a network packet
+#define output_process_size         0x4000      // bytes per Process(), like one drawn frame
+#define output_bell_interval        1000        // lines between BEEPs
+#define output_line_limit           80
+
+static char s_failure[512];                     // what went wrong, for the assert message
+
+// the text of line n as the terminal shows it, the tab after the 8 character number is spaces
+static int MakeLine(int n, char* pLine)
+{
+    return snprintf(pLine, output_line_limit, "%7d:        the quick brown fox jumps over the lazy dog %08X", n, n * 0x9E3779B9);
+}
+
+// what a Propeller program printing lines would send, with the line ends varied
+static int MakeOutput(unsigned char* pOutput, int size, int& lineCount, int& bells)
+{
+    char line[output_line_limit];
+    int length = 0;
+    lineCount = 0;
+    bells = 0;
+    while (length + output_line_limit + 4 <= size)
+    {
+        int lineLength = MakeLine(lineCount, line);
+        memcpy(&pOutput[length], line, 8);
+        pOutput[length + 8] = 9;
+        memcpy(&pOutput[length + 9], &line[16], lineLength - 16);
+        length += lineLength - 7;
+        if (lineCount % output_bell_interval == 0)
+        {
+            pOutput[length++] = 7;
+            bells++;
+        }
+        switch (lineCount % 4)
+        {
+            case 0:     pOutput[length++] = 13; break;
+            case 1:     pOutput[length++] = 10; break;
+            case 2:     pOutput[length++] = 10; pOutput[length++] = 13; break;
+            default:    pOutput[length++] = 13; pOutput[length++] = 10; break;
+        }
+        lineCount++;
+    }
+    return length;
+}
+
+struct OutputProducer
+{
+    SerialTerminal*         pTerminal;
+    const unsigned char*    pOutput;
+    int                     length;
+    int                     sent;               // written by the producer, read by the consumer
+};
+
+// hands the output over a packet at a time, waiting for room in the ring rather than losing any
+static void* ProduceOutput(void* pArgument)
+{
+    OutputProducer* pProducer = (OutputProducer*)pArgument;
+    int sent = 0;
+    while (sent < pProducer->length)
+    {
+        int count = pProducer->length - sent;
+        if (count > output_packet_size)
+        {
+            count = output_packet_size;
+        }
+        int taken = pProducer->pTerminal->Receive(&pProducer->pOutput[sent], count);
+        sent += taken;
+        __atomic_store_n(&pProducer->sent, sent, __ATOMIC_RELEASE);
+        if (taken < count)
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+// runs the output through the terminal from another thread, and checks what ends up in the history
+static bool RunOutput(const unsigned char* pOutput, int length, int lineCount, int bells)
+{
+    SerialTerminal* pTerminal = new SerialTerminal();
+    OutputProducer producer;
+    producer.pTerminal = pTerminal;
+    producer.pOutput = pOutput;
+    producer.length = length;
+    producer.sent = 0;
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, ProduceOutput, &producer) != 0)
+    {
+        snprintf(s_failure, sizeof(s_failure), "can not start the producer thread");
+        delete pTerminal;
+        return false;
+    }
+
+    bool bOk = true;
+    int processed = 0;
+    int bellsSeen = 0;
+    TerminalUpdate update;
+    while (processed < length)
+    {
+        int count = pTerminal->Process(output_process_size);
+        processed += count;
+        if (processed > __atomic_load_n(&producer.sent, __ATOMIC_ACQUIRE))
+        {
+            snprintf(s_failure, sizeof(s_failure), "%d bytes processed, only %d were sent", processed, producer.sent);
+            bOk = false;
+            break;
+        }
+        if (pTerminal->GetUpdate(update))
+        {
+            bellsSeen += update.bells;
+            if (update.firstLine > update.finishLine || update.finishLine > terminal_history || update.lineCount > terminal_history ||
+                update.cursorY >= update.lineCount)
+            {
+                snprintf(s_failure, sizeof(s_failure), "update of lines %d to %d, with %d lines and the cursor on %d",
+                         update.firstLine, update.finishLine, update.lineCount, update.cursorY);
+                bOk = false;
+                break;
+            }
+        }
+        if (count == 0)
+        {
+            sched_yield();
+        }
+    }
+    pthread_join(thread, NULL);
+
+    // each line that was sent is in the history, the oldest ones scrolled off, and the cursor is on an empty line after them
+    int expectedLines = (lineCount + 1 < terminal_history) ? lineCount + 1 : terminal_history;
+    if (bOk && (bellsSeen != bells || pTerminal->GetLineCount() != expectedLines || pTerminal->GetCursorY() != expectedLines - 1))
+    {
+        snprintf(s_failure, sizeof(s_failure), "%d bells and %d lines with the cursor on %d, expected %d bells and %d lines",
+                 bellsSeen, pTerminal->GetLineCount(), pTerminal->GetCursorY(), bells, expectedLines);
+        bOk = false;
+    }
+    char line[output_line_limit];
+    for (int y = 0; y < expectedLines - 1 && bOk; y++)
+    {
+        int n = lineCount - (expectedLines - 1) + y;
+        int expectedLength = MakeLine(n, line);
+        int lineLength;
+        const char* pLine = pTerminal->GetLine(y, lineLength);
+        if (lineLength != expectedLength || memcmp(pLine, line, lineLength) != 0)
+        {
+            snprintf(s_failure, sizeof(s_failure), "line %d is '%.*s', expected '%s'", y, lineLength, pLine, line);
+            bOk = false;
+        }
+    }
+
+    delete pTerminal;
+    return bOk;
+}
+
+@interface SerialTerminalTests : XCTestCase
+
+@end
+
+@implementation SerialTerminalTests
+
+- (void) testReceiveAndProcess {
+    int size = 16*1024*1024;
+    unsigned char* pOutput = new unsigned char[size];
+    int lineCount;
+    int bells;
+    int length = MakeOutput(pOutput, size, lineCount, bells);
+
+    s_failure[0] = 0;
+    XCTAssert(RunOutput(pOutput, length, lineCount, bells), @"%s", s_failure);
+    delete [] pOutput;
+}
+
+- (void) testThroughput {
+    int size = 4*1024*1024;
+    unsigned char* pOutput = new unsigned char[size];
+    int lineCount;
+    int bells;
+    int length = MakeOutput(pOutput, size, lineCount, bells);
+
+    [self measureBlock:^{
+        s_failure[0] = 0;
+        XCTAssert(RunOutput(pOutput, length, lineCount, bells), @"%s", s_failure);
+    }];
+    delete [] pOutput;
+}
+
+@end
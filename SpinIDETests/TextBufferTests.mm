@@ -0,0 +1,426 @@
+//
+//  TextBufferTests.mm
+//  SpinIDETests
+//
+//	Checks TextBuffer against a plain character array that is edited the same way. Random
+//	inserts, deletes and replaces (some longer than a piece, so they are split) are checked
+//	against the model along with the line index, snapshots taken along the way, and undo
+//	and redo of the edit groups.
+//
+
+#import <XCTest/XCTest.h>
+
+#include <stdio.h>
+#include <string.h>
+#include "../SpinIDE/CodeView/TextBuffer.h"
+
+#define model_text_limit            6000        // edits delete more than they add past this
+#define model_undo_limit            4096        // undo groups the model keeps, new groups stop past this
+#define model_snapshot_count        8
+#define model_check_interval        500         // edits between checks of the whole text (and each snapshot)
+
+static char s_failure[512];                     // what went wrong, for the assert message
+
+// the text as a plain character array
+class ModelText
+{
+public:
+    char*   m_pText;
+    int     m_length;
+    int     m_size;
+
+    ModelText()
+        : m_pText(0)
+        , m_length(0)
+        , m_size(0)
+    {
+    }
+    ~ModelText()
+    {
+        delete [] m_pText;
+    }
+
+    void Set(const char* pText, int length)
+    {
+        m_length = 0;
+        Replace(0, 0, pText, length);
+    }
+    void Replace(int offset, int removedLength, const char* pText, int insertedLength)
+    {
+        int newLength = m_length - removedLength + insertedLength;
+        if (newLength > m_size)
+        {
+            int newSize = newLength * 2 + 64;
+            char* pNewText = new char[newSize];
+            if (m_pText)
+            {
+                memcpy(pNewText, m_pText, m_length);
+                delete [] m_pText;
+            }
+            m_pText = pNewText;
+            m_size = newSize;
+        }
+        memmove(&m_pText[offset + insertedLength], &m_pText[offset + removedLength], m_length - offset - removedLength);
+        memcpy(&m_pText[offset], pText, insertedLength);
+        m_length = newLength;
+    }
+    int LineCount() const
+    {
+        return LineOfOffset(m_length) + 1;
+    }
+    int LineStart(int line) const
+    {
+        if (line == 0)
+        {
+            return 0;
+        }
+        for (int i = 0; i < m_length; i++)
+        {
+            if (m_pText[i] == '\n' && --line == 0)
+            {
+                return i + 1;
+            }
+        }
+        return -1;
+    }
+    int LineOfOffset(int offset) const
+    {
+        int line = 0;
+        for (int i = 0; i < offset && i < m_length; i++)
+        {
+            line += (m_pText[i] == '\n');
+        }
+        return line;
+    }
+};
+
+// xorshift, so each seed gives the same run every time
+static unsigned int NextRandom(unsigned int& seed)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static void MakeText(unsigned int& seed, char* pText, int length)
+{
+    static const char s_letters[] = "abcdefghij    \n\n\t{}";
+    for (int i = 0; i < length; i++)
+    {
+        pText[i] = s_letters[NextRandom(seed) % (sizeof(s_letters) - 1)];
+    }
+}
+
+// the whole text, and the line index against counting \n in the model
+static bool CheckSnapshot(const TextSnapshot& snapshot, const ModelText& model, const char* pWhat, int step)
+{
+    if (snapshot.GetLength() != model.m_length)
+    {
+        snprintf(s_failure, sizeof(s_failure), "%s at step %d: length %d, expected %d", pWhat, step, snapshot.GetLength(), model.m_length);
+        return false;
+    }
+    char* pText = new char[model.m_length + 1];
+    int copied = snapshot.GetText(0, model.m_length, pText);
+    bool bSame = (copied == model.m_length && memcmp(pText, model.m_pText, model.m_length) == 0);
+    delete [] pText;
+    if (!bSame)
+    {
+        snprintf(s_failure, sizeof(s_failure), "%s at step %d: text differs", pWhat, step);
+        return false;
+    }
+
+    int lineCount = model.LineCount();
+    if (snapshot.GetLineCount() != lineCount)
+    {
+        snprintf(s_failure, sizeof(s_failure), "%s at step %d: %d lines, expected %d", pWhat, step, snapshot.GetLineCount(), lineCount);
+        return false;
+    }
+    int line = 0;
+    for (int offset = 0; offset <= model.m_length; offset++)
+    {
+        if (offset == 0 || model.m_pText[offset - 1] == '\n')
+        {
+            if (snapshot.GetLineStart(line) != offset)
+            {
+                snprintf(s_failure, sizeof(s_failure), "%s at step %d: line %d starts at %d, expected %d", pWhat, step, line, snapshot.GetLineStart(line), offset);
+                return false;
+            }
+        }
+        if (snapshot.GetLineOfOffset(offset) != line)
+        {
+            snprintf(s_failure, sizeof(s_failure), "%s at step %d: offset %d is on line %d, expected %d", pWhat, step, offset, snapshot.GetLineOfOffset(offset), line);
+            return false;
+        }
+        if (offset < model.m_length && model.m_pText[offset] == '\n')
+        {
+            line++;
+        }
+    }
+    if (snapshot.GetLineStart(lineCount) != -1 || snapshot.GetLineStart(-1) != -1)
+    {
+        snprintf(s_failure, sizeof(s_failure), "%s at step %d: a line outside the text has a start", pWhat, step);
+        return false;
+    }
+    if (snapshot.GetChar(-1) != 0 || snapshot.GetChar(model.m_length) != 0)
+    {
+        snprintf(s_failure, sizeof(s_failure), "%s at step %d: a character outside the text is not 0", pWhat, step);
+        return false;
+    }
+    return true;
+}
+
+// the cheap checks done after every edit
+static bool CheckBuffer(const TextBuffer& buffer, const ModelText& model, unsigned int& seed, int step)
+{
+    if (buffer.GetLength() != model.m_length || buffer.GetLineCount() != model.LineCount())
+    {
+        snprintf(s_failure, sizeof(s_failure), "step %d: length %d with %d lines, expected %d with %d lines", step,
+                 buffer.GetLength(), buffer.GetLineCount(), model.m_length, model.LineCount());
+        return false;
+    }
+    for (int i = 0; i < 4 && model.m_length > 0; i++)
+    {
+        int offset = NextRandom(seed) % model.m_length;
+        if (buffer.GetChar(offset) != model.m_pText[offset])
+        {
+            snprintf(s_failure, sizeof(s_failure), "step %d: character at %d differs", step, offset);
+            return false;
+        }
+        int line = model.LineOfOffset(offset);
+        if (buffer.GetLineOfOffset(offset) != line || buffer.GetLineStart(line) != model.LineStart(line))
+        {
+            snprintf(s_failure, sizeof(s_failure), "step %d: line of offset %d differs", step, offset);
+            return false;
+        }
+    }
+    return true;
+}
+
+// the range Undo() or Redo() hands back is where the texts before and after it differ
+static bool CheckUndoRange(const ModelText& before, const ModelText& after, int offset, int length, int step)
+{
+    int rest = after.m_length - offset - length;
+    if (offset < 0 || length < 0 || rest < 0 || rest > before.m_length - offset ||
+        memcmp(before.m_pText, after.m_pText, offset) != 0 ||
+        memcmp(&before.m_pText[before.m_length - rest], &after.m_pText[after.m_length - rest], rest) != 0)
+    {
+        snprintf(s_failure, sizeof(s_failure), "step %d: undo range %d, %d does not cover the change", step, offset, length);
+        return false;
+    }
+    return true;
+}
+
+// edits the buffer and the model the same way for a number of steps
+static bool RunModelTest(unsigned int seed, int steps)
+{
+    TextBuffer buffer;
+    ModelText model;
+
+    // the text before each undo group, and the one after it for redo
+    ModelText* pUndo = new ModelText[model_undo_limit + 1];
+    int undoCount = 0;
+    int undoTop = 0;
+    bool bNewGroup = true;
+
+    TextSnapshot snapshots[model_snapshot_count];
+    ModelText snapshotModels[model_snapshot_count];
+    int snapshotCount = 0;
+
+    char text[text_piece_limit * 3];
+    int length = 200 + NextRandom(seed) % 2000;
+    MakeText(seed, text, length);
+    buffer.SetText(text, length);
+    model.Set(text, length);
+    pUndo[0].Set(text, length);
+
+    int typingOffset = 0;
+    bool bOk = CheckSnapshot(buffer.GetSnapshot(), model, "SetText", 0);
+    for (int step = 1; step <= steps && bOk; step++)
+    {
+        int action = NextRandom(seed) % 100;
+        int offset = (model.m_length > 0) ? NextRandom(seed) % (model.m_length + 1) : 0;
+        bool bEdit = false;
+        int removedLength = 0;
+        int insertedLength = 0;
+
+        if (action < 40 && model.m_length < model_text_limit)
+        {
+            // typing mostly goes where the last typing went, now and then paste something big
+            if (NextRandom(seed) % 2 == 0 && typingOffset <= model.m_length)
+            {
+                offset = typingOffset;
+            }
+            insertedLength = (NextRandom(seed) % 16 == 0) ? text_piece_limit / 2 + NextRandom(seed) % (text_piece_limit * 2) : 1 + NextRandom(seed) % 8;
+            bEdit = true;
+        }
+        else if (action < 70)
+        {
+            removedLength = NextRandom(seed) % ((NextRandom(seed) % 16 == 0) ? text_piece_limit * 2 : 32);
+            if (removedLength > model.m_length - offset)
+            {
+                removedLength = model.m_length - offset;
+            }
+            bEdit = true;
+        }
+        else if (action < 78)
+        {
+            removedLength = NextRandom(seed) % 64;
+            if (removedLength > model.m_length - offset)
+            {
+                removedLength = model.m_length - offset;
+            }
+            insertedLength = NextRandom(seed) % 64;
+            bEdit = true;
+        }
+        else if (action < 84)
+        {
+            buffer.BeginUndoGroup();
+            bNewGroup = true;
+        }
+        else if (action < 90)
+        {
+            int undoOffset;
+            int undoLength;
+            if (buffer.CanUndo() != (undoCount > 0) || buffer.Undo(undoOffset, undoLength) != (undoCount > 0))
+            {
+                snprintf(s_failure, sizeof(s_failure), "step %d: undo with %d groups", step, undoCount);
+                bOk = false;
+            }
+            else if (undoCount > 0)
+            {
+                undoCount--;
+                bOk = CheckUndoRange(model, pUndo[undoCount], undoOffset, undoLength, step);
+                model.Set(pUndo[undoCount].m_pText, pUndo[undoCount].m_length);
+                bNewGroup = true;
+            }
+        }
+        else if (action < 95)
+        {
+            int redoOffset;
+            int redoLength;
+            if (buffer.CanRedo() != (undoCount < undoTop) || buffer.Redo(redoOffset, redoLength) != (undoCount < undoTop))
+            {
+                snprintf(s_failure, sizeof(s_failure), "step %d: redo with %d of %d groups", step, undoCount, undoTop);
+                bOk = false;
+            }
+            else if (undoCount < undoTop)
+            {
+                undoCount++;
+                bOk = CheckUndoRange(model, pUndo[undoCount], redoOffset, redoLength, step);
+                model.Set(pUndo[undoCount].m_pText, pUndo[undoCount].m_length);
+                bNewGroup = true;
+            }
+        }
+        else if (action < 98)
+        {
+            int index = snapshotCount++ % model_snapshot_count;
+            snapshots[index] = buffer.GetSnapshot();
+            snapshotModels[index].Set(model.m_pText, model.m_length);
+        }
+        else
+        {
+            // ranges outside the text are refused and change nothing
+            if (buffer.Insert(model.m_length + 1, "x", 1) || buffer.Delete(offset, model.m_length - offset + 1) || buffer.Insert(-1, "x", 1))
+            {
+                snprintf(s_failure, sizeof(s_failure), "step %d: an edit outside the text was taken", step);
+                bOk = false;
+            }
+        }
+
+        if (bEdit && (removedLength > 0 || insertedLength > 0))
+        {
+            if (bNewGroup && undoCount == model_undo_limit)
+            {
+                // the model is out of room, start over with this text
+                buffer.SetText(model.m_pText, model.m_length);
+                pUndo[0].Set(model.m_pText, model.m_length);
+                undoCount = 0;
+            }
+            MakeText(seed, text, insertedLength);
+            if (!buffer.Replace(offset, removedLength, text, insertedLength))
+            {
+                snprintf(s_failure, sizeof(s_failure), "step %d: replace of %d, %d was refused", step, offset, removedLength);
+                bOk = false;
+            }
+            model.Replace(offset, removedLength, text, insertedLength);
+            if (bNewGroup)
+            {
+                undoCount++;
+                bNewGroup = false;
+            }
+            pUndo[undoCount].Set(model.m_pText, model.m_length);
+            undoTop = undoCount;
+            typingOffset = offset + insertedLength;
+        }
+
+        if (bOk)
+        {
+            bOk = CheckBuffer(buffer, model, seed, step);
+        }
+        if (bOk && step % model_check_interval == 0)
+        {
+            bOk = CheckSnapshot(buffer.GetSnapshot(), model, "buffer", step);
+            for (int i = 0; i < snapshotCount && i < model_snapshot_count && bOk; i++)
+            {
+                bOk = CheckSnapshot(snapshots[i], snapshotModels[i], "snapshot", step);
+            }
+        }
+    }
+
+    // all the way back and forward again
+    int undoOffset;
+    int undoLength;
+    while (bOk && undoCount > 0)
+    {
+        bOk = buffer.Undo(undoOffset, undoLength);
+        undoCount--;
+    }
+    if (bOk)
+    {
+        bOk = !buffer.CanUndo() && CheckSnapshot(buffer.GetSnapshot(), pUndo[0], "undo all", steps);
+    }
+    while (bOk && undoCount < undoTop)
+    {
+        bOk = buffer.Redo(undoOffset, undoLength);
+        undoCount++;
+    }
+    if (bOk)
+    {
+        bOk = !buffer.CanRedo() && CheckSnapshot(buffer.GetSnapshot(), pUndo[undoTop], "redo all", steps);
+    }
+
+    delete [] pUndo;
+    return bOk;
+}
+
+@interface TextBufferTests : XCTestCase
+
+@end
+
+@implementation TextBufferTests
+
+- (void) testEditsMatchModel {
+    unsigned int seeds[] = { 0x2545F491, 0x9E3779B9, 0x12345678, 0xDEADBEEF };
+    for (int i = 0; i < (int)(sizeof(seeds)/sizeof(seeds[0])); i++) {
+        s_failure[0] = 0;
+        XCTAssert(RunModelTest(seeds[i], 5000), @"seed %08X: %s", seeds[i], s_failure);
+    }
+}
+
+- (void) testSnapshotOutlivesBuffer {
+    TextSnapshot snapshot;
+    {
+        TextBuffer buffer;
+        buffer.SetText("one\ntwo\nthree", 13);
+        buffer.Insert(4, "and a half\n", 11);
+        snapshot = buffer.GetSnapshot();
+        buffer.Delete(0, buffer.GetLength());
+    }
+    ModelText model;
+    model.Set("one\nand a half\ntwo\nthree", 24);
+    s_failure[0] = 0;
+    XCTAssert(CheckSnapshot(snapshot, model, "snapshot", 0), @"%s", s_failure);
+}
+
+@end